@@ -32,6 +32,7 @@
 										FALSE, // is signaled initially?
 										nullptr); // name
 		m_waiters = 0;
+		m_posted = false;
 		InitializeCriticalSection(&CSMutex);
 	}
 
@@ -79,6 +80,54 @@
 		LeaveCriticalSection(&CSMutex);
 	}
 
+	bool Condition::TimedWait(unsigned long usec)
+	{
+		EnterCriticalSection(&CSMutex);
+		m_waiters++;
+		LeaveCriticalSection(&CSMutex);
+
+		int result = WaitForMultipleObjects (_eventCount, m_events, FALSE, (usec + 999) / 1000);
+
+		EnterCriticalSection(&CSMutex);
+		m_waiters--;
+
+		if(m_waiters == 0 && result == (WAIT_OBJECT_0+BroadcastEvent))
+			ResetEvent(m_events[BroadcastEvent]);
+
+		LeaveCriticalSection(&CSMutex);
+		return result != WAIT_TIMEOUT;
+	}
+
+	void Condition::Post()
+	{
+		EnterCriticalSection(&CSMutex);
+		m_posted = true;
+		if(m_waiters > 0)
+			SetEvent(m_events[SignalEvent]);
+		LeaveCriticalSection(&CSMutex);
+	}
+
+	bool Condition::WaitForPost(unsigned long usec)
+	{
+		EnterCriticalSection(&CSMutex);
+		if(m_posted) {
+			m_posted = false;
+			LeaveCriticalSection(&CSMutex);
+			return true;
+		}
+		m_waiters++;
+		LeaveCriticalSection(&CSMutex);
+		int result = WaitForMultipleObjects (_eventCount, m_events, FALSE, (usec + 999) / 1000);
+		EnterCriticalSection(&CSMutex);
+		m_waiters--;
+		if(m_waiters == 0 && result == (WAIT_OBJECT_0+BroadcastEvent))
+			ResetEvent(m_events[BroadcastEvent]);
+		bool posted = m_posted;
+		m_posted = false;
+		LeaveCriticalSection(&CSMutex);
+		return posted;
+	}
+
 #else
 	#include <pthread.h>
 	#include <sys/time.h>
@@ -88,6 +137,7 @@
 	{
 		pthread_cond_init(&cond,nullptr);
 		pthread_mutex_init(&mutex,nullptr);
+		m_posted = false;
 	}
 
 	void Condition::Signal()
@@ -111,12 +161,6 @@
 		pthread_mutex_unlock(&mutex);
 	}
 
-	/*
-	I commented this specifically because I think it might be very
-	difficult to write a windows counterpart to it, so I would like
-	to discourage its use until we can confirm that it can be reasonably
-	implemented on windows.
-
 	bool Condition::TimedWait(unsigned long usec)
 	{
 	struct timeval now;
@@ -127,14 +171,37 @@
 		now.tv_usec+=usec;
 		timeout.tv_sec = now.tv_sec + (now.tv_usec/1000000);
 		timeout.tv_nsec = (now.tv_usec%1000000) *1000;
-		//cout << "now=" << now.tv_sec << "."<<now.tv_usec << endl;
-		//cout << "timeout=" << timeout.tv_sec << "."<<timeout.tv_nsec << endl;
 		retcode=pthread_cond_timedwait(&cond,&mutex,&timeout);
 		pthread_mutex_unlock(&mutex);
-
 		return retcode!=ETIMEDOUT;
 	}
-	*/
+
+	void Condition::Post()
+	{
+		pthread_mutex_lock(&mutex);
+		m_posted = true;
+		pthread_cond_signal(&cond);
+		pthread_mutex_unlock(&mutex);
+	}
+
+	bool Condition::WaitForPost(unsigned long usec)
+	{
+	struct timeval now;
+	struct timespec timeout;
+	int retcode=0;
+		pthread_mutex_lock(&mutex);
+		gettimeofday(&now,nullptr);
+		now.tv_usec+=usec;
+		timeout.tv_sec = now.tv_sec + (now.tv_usec/1000000);
+		timeout.tv_nsec = (now.tv_usec%1000000) *1000;
+		//spurious wakeups go back to waiting, only a post or the timeout ends it
+		while(!m_posted && retcode!=ETIMEDOUT)
+			retcode=pthread_cond_timedwait(&cond,&mutex,&timeout);
+		bool posted = m_posted;
+		m_posted = false;
+		pthread_mutex_unlock(&mutex);
+		return posted;
+	}
 
 	Condition::~Condition()
 	{
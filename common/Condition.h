@@ -43,12 +43,17 @@ class Condition {
 		pthread_cond_t cond;
 		pthread_mutex_t mutex;
 #endif
+		bool m_posted;
 	public:
 		Condition();
 		void Signal();
 		void SignalAll();
 		void Wait();
-//		bool TimedWait(unsigned long usec);
+		bool TimedWait(unsigned long usec);	//false if the wait timed out
+		//a Signal that isn't lost when nobody is waiting yet, the next WaitForPost sees it
+		void Post();
+		//returns at once if posted since the last call, false if it timed out instead
+		bool WaitForPost(unsigned long usec);
 		~Condition();
 };
 
@@ -196,6 +196,54 @@ void EQRawApplicationPacket::DumpRawHeaderNoTime(uint16 seq, FILE *to) const
 #endif
 }
 
+EQProtocolPacket::EQProtocolPacket(uint16 op, const unsigned char *buf, uint32 len)
+:	BasePacket(),
+	opcode(op)
+{
+	acked = false;
+	timestamp.tv_sec = 0;
+	block = PacketPool::AllocateBuffer(len, capacity);
+	pBuffer = block;
+	size = len;
+	if (len > 0) {
+		if (buf)
+			memcpy(pBuffer, buf, len);
+		else
+			memset(pBuffer, 0, len);
+	}
+}
+
+EQProtocolPacket::~EQProtocolPacket()
+{
+	PacketPool::FreeBuffer(block);
+	//so ~BasePacket leaves it alone
+	pBuffer = nullptr;
+}
+
+void EQProtocolPacket::Reallocate(uint32 length)
+{
+	uint32 newcap;
+	unsigned char *newblock = PacketPool::AllocateBuffer(length, newcap);
+	memcpy(newblock, pBuffer, size);
+	PacketPool::FreeBuffer(block);
+	block = pBuffer = newblock;
+	capacity = newcap;
+}
+
+unsigned char *EQProtocolPacket::SerializeInPlace()
+{
+	if (Headroom() < 2)
+		return nullptr;
+	unsigned char *dest = pBuffer - 2;
+	if (opcode>0xff) {
+		*(uint16 *)dest=opcode;
+	} else {
+		*(dest)=0;
+		*(dest+1)=opcode;
+	}
+	return dest;
+}
+
 uint32 EQProtocolPacket::serialize(unsigned char *dest) const
 {
 	if (opcode>0xff) {
@@ -209,7 +257,7 @@ uint32 EQProtocolPacket::serialize(unsigned char *dest) const
 	return size+2;
 }
 
-uint32 EQApplicationPacket::serialize(uint16 opcode, unsigned char *dest) const
+uint32 EQApplicationPacket::SerializeOpcode(uint16 opcode, unsigned char *dest) const
 {
 	uint8 OpCodeBytes = app_opcode_size;
 
@@ -227,6 +275,13 @@ uint32 EQApplicationPacket::serialize(uint16 opcode, unsigned char *dest) const
 		else
 			*(uint16 *)dest = opcode;
 	}
+
+	return OpCodeBytes;
+}
+
+uint32 EQApplicationPacket::serialize(uint16 opcode, unsigned char *dest) const
+{
+	uint32 OpCodeBytes = SerializeOpcode(opcode, dest);
 	memcpy(dest+OpCodeBytes,pBuffer,size);
 
 	return size+OpCodeBytes;
@@ -256,25 +311,28 @@ bool EQProtocolPacket::combine(const EQProtocolPacket *rhs)
 {
 bool result=false;
 	if (opcode==OP_Combined && size+rhs->size+5<256) {
-		unsigned char *tmpbuffer=new unsigned char [size+rhs->size+3];
-		memcpy(tmpbuffer,pBuffer,size);
-		uint32 offset=size;
-		tmpbuffer[offset++]=rhs->Size();
-		offset+=rhs->serialize(tmpbuffer+offset);
-		size=offset;
-		delete[] pBuffer;
-		pBuffer=tmpbuffer;
+		// append in place: length, opcode, payload
+		if (Tailroom() < rhs->size+3)
+			Reallocate(size+rhs->size+3);
+		pBuffer[size++]=rhs->Size();
+		size+=rhs->serialize(pBuffer+size);
 		result=true;
 	} else if (size+rhs->size+7<256) {
-		unsigned char *tmpbuffer=new unsigned char [size+rhs->size+6];
-		uint32 offset=0;
-		tmpbuffer[offset++]=Size();
-		offset+=serialize(tmpbuffer+offset);
-		tmpbuffer[offset++]=rhs->Size();
-		offset+=rhs->serialize(tmpbuffer+offset);
-		size=offset;
-		delete[] pBuffer;
-		pBuffer=tmpbuffer;
+		// our own length and opcode go in the headroom, rhs after us
+		uint8 length=Size();
+		if (Headroom() < 3 || Tailroom() < rhs->size+3)
+			Reallocate(size+rhs->size+6);
+		pBuffer-=3;
+		size+=3;
+		pBuffer[0]=length;
+		if (opcode>0xff) {
+			*(uint16 *)(pBuffer+1)=opcode;
+		} else {
+			pBuffer[1]=0;
+			pBuffer[2]=opcode;
+		}
+		pBuffer[size++]=rhs->Size();
+		size+=rhs->serialize(pBuffer+size);
 		opcode=OP_Combined;
 		result=true;
 	}
@@ -377,16 +435,22 @@ uint32 flag_offset=0;
 	return newlen;
 }
 
-uint32 EQProtocolPacket::Compress(const unsigned char *buffer, const uint32 length, unsigned char *newbuf, uint32 newbufsize) {
-uint32 flag_offset=1,newlength;
+uint32 EQProtocolPacket::Compress(const unsigned char *buffer, const uint32 length, unsigned char *newbuf, uint32 newbufsize, uint32 min_size, int level) {
+uint32 flag_offset=1,newlength=0;
 	//dump_message_column(buffer,length,"Before: ");
 	newbuf[0]=buffer[0];
 	if (buffer[0]==0) {
 		flag_offset=2;
 		newbuf[1]=buffer[1];
 	}
-	if (length>30) {
-		newlength=DeflatePacket(buffer+flag_offset,length-flag_offset,newbuf+flag_offset+1,newbufsize);
+	if (length>min_size && level!=0) {
+		//only worth it if it beats the stored form, which is length+1
+		uint32 room=length-flag_offset-1;
+		if (room > newbufsize-(flag_offset+1))
+			room=newbufsize-(flag_offset+1);
+		newlength=DeflatePacket(buffer+flag_offset,length-flag_offset,newbuf+flag_offset+1,room,level);
+	}
+	if (newlength) {
 		*(newbuf+flag_offset)=0x5a;
 		newlength+=flag_offset+1;
 	} else {
@@ -22,6 +22,8 @@
 #include "EQStreamType.h"
 #include "op_codes.h"
 #include "platform.h"
+#include "packet_pool.h"
+#include "packet_functions.h"
 
 #ifdef STATIC_OPCODE
 	typedef unsigned short EmuOpcode;
@@ -62,17 +64,29 @@ protected:
 
 class EQRawApplicationPacket;
 
+//never leaves EQStream, so both the object and its buffer come from the PacketPool.
+//pBuffer has PACKET_POOL_HEADROOM bytes in front of it to prepend headers into.
 class EQProtocolPacket : public BasePacket {
 	friend class EQStream;
 	friend class EQStreamPair;
 public:
-	EQProtocolPacket(uint16 op, const unsigned char *buf, uint32 len) : BasePacket(buf,len), opcode(op) { acked = false; }
+	EQProtocolPacket(uint16 op, const unsigned char *buf, uint32 len);
+	virtual ~EQProtocolPacket();
 //	EQProtocolPacket(const unsigned char *buf, uint32 len);
+	static void *operator new(size_t size) { return PacketPool::Allocate(size); }
+	static void operator delete(void *p) { PacketPool::Free(p); }
+
 	bool combine(const EQProtocolPacket *rhs);
 	uint32 serialize (unsigned char *dest) const;
+	//writes the opcode into the headroom and returns where the size+2 serialized bytes start, nullptr if there is no room
+	unsigned char *SerializeInPlace();
 	EQProtocolPacket *Copy() { return new EQProtocolPacket(opcode,pBuffer,size); }
 	EQRawApplicationPacket *MakeAppPacket() const;
 
+	static uint32 Decompress(const unsigned char *buffer, const uint32 length, unsigned char *newbuf, uint32 newbufsize);
+	//payloads no longer than min_size, level 0, or ones deflate can't shrink go out stored (0xa5)
+	static uint32 Compress(const unsigned char *buffer, const uint32 length, unsigned char *newbuf, uint32 newbufsize, uint32 min_size = 30, int level = DEFLATE_DEFAULT_LEVEL);
+
 	bool acked;
 
 	virtual void build_raw_header_dump(char *buffer, uint16 seq=0xffff) const;
@@ -83,8 +97,6 @@ public:
 protected:
 
 	static bool ValidateCRC(const unsigned char *buffer, int length, uint32 Key);
-	static uint32 Decompress(const unsigned char *buffer, const uint32 length, unsigned char *newbuf, uint32 newbufsize);
-	static uint32 Compress(const unsigned char *buffer, const uint32 length, unsigned char *newbuf, uint32 newbufsize);
 	static void ChatDecode(unsigned char *buffer, int size, int DecodeKey);
 	static void ChatEncode(unsigned char *buffer, int size, int EncodeKey);
 
@@ -94,6 +106,13 @@ protected:
 
 	//the actual raw EQ opcode
 	uint16 opcode;
+
+	unsigned char *block;	//from the pool, pBuffer can move back into the headroom before it
+	uint32 capacity;		//usable bytes from block on
+
+	uint32 Headroom() const { return uint32(pBuffer - (block - PACKET_POOL_HEADROOM)); }
+	uint32 Tailroom() const { return uint32(block + capacity - (pBuffer + size)); }
+	void Reallocate(uint32 length);
 };
 
 class EQApplicationPacket : public EQPacket {
@@ -110,6 +129,8 @@ public:
 		{ app_opcode_size = GetExecutablePlatform() == ExePlatformUCS ? 1 : 2; }
 	bool combine(const EQApplicationPacket *rhs);
 	uint32 serialize (uint16 opcode, unsigned char *dest) const;
+	//just the opcode bytes serialize() would write, at most 3
+	uint32 SerializeOpcode(uint16 opcode, unsigned char *dest) const;
 	uint32 Size() const { return size+app_opcode_size; }
 
 	virtual EQApplicationPacket *Copy() const;
@@ -23,6 +23,7 @@
 #include "Mutex.h"
 #include "op_codes.h"
 #include "CRC16.h"
+#include "rdtsc.h"
 
 #include <string>
 #include <iomanip>
@@ -75,6 +76,12 @@ void EQStream::init() {
 	BytesWritten=0;
 	SequencedBase = 0;
 	NextSequencedSend = 0;
+	OutboundSince = 0;
+	WriteNotify = nullptr;
+	WritePending = false;
+	compress_min = 30;
+	compress_level = DEFLATE_DEFAULT_LEVEL;
+	memset(&compress_stats, 0, sizeof(compress_stats));
 #ifdef RETRANSMITS
 	retransmittimer = Timer::GetCurrentTime();
 	retransmittimeout = 500 * RuleR(EQStream, RetransmitTimeoutMult); //use 500ms as base before we have connection stats
@@ -505,10 +512,8 @@ void EQStream::QueuePacket(const EQApplicationPacket *p, bool ack_req)
 	if(p == nullptr)
 		return;
 
-	EQApplicationPacket *newp = p->Copy();
-
-	if (newp != nullptr)
-		FastQueuePacket(&newp, ack_req);
+	//the protocol packets are built from the buffer, so the caller's packet is never kept or copied
+	PushApplicationPacket(p, ack_req);
 }
 
 void EQStream::FastQueuePacket(EQApplicationPacket **p, bool ack_req)
@@ -519,9 +524,14 @@ void EQStream::FastQueuePacket(EQApplicationPacket **p, bool ack_req)
 	if(pack == nullptr)
 		return;
 
+	PushApplicationPacket(pack, ack_req);
+	delete pack;
+}
+
+void EQStream::PushApplicationPacket(const EQApplicationPacket *pack, bool ack_req)
+{
 	if(OpMgr == nullptr || *OpMgr == nullptr) {
 		_log(NET__DEBUG, _L "Packet enqueued into a stream with no opcode manager, dropping." __L);
-		delete pack;
 		return;
 	}
 
@@ -541,13 +551,25 @@ void EQStream::FastQueuePacket(EQApplicationPacket **p, bool ack_req)
 
 	if (!ack_req) {
 		NonSequencedPush(new EQProtocolPacket(opcode, pack->pBuffer, pack->size));
-		delete pack;
 	} else {
 		SendPacket(opcode, pack);
 	}
 }
 
-void EQStream::SendPacket(uint16 opcode, EQApplicationPacket *p)
+//copies n bytes, starting at from, of an app packet serialized as its opcode bytes then payload
+static void CopySerialized(const unsigned char *op, uint32 oplen, const unsigned char *payload, uint32 from, uint32 n, unsigned char *dest)
+{
+	if (from < oplen) {
+		uint32 head = std::min(oplen - from, n);
+		memcpy(dest, op + from, head);
+		dest += head;
+		n -= head;
+		from = oplen;
+	}
+	memcpy(dest, payload + (from - oplen), n);
+}
+
+void EQStream::SendPacket(uint16 opcode, const EQApplicationPacket *p)
 {
 uint32 chunksize,used;
 uint32 length;
@@ -556,13 +578,15 @@ uint32 length;
 	if (p->size>(MaxLen-8)) { // proto-op(2), seq(2), app-op(2) ... data ... crc(2)
 		_log(NET__FRAGMENT, _L "Making oversized packet, len %d" __L, p->size);
 
-		unsigned char *tmpbuff=new unsigned char[p->size+3];
-		length=p->serialize(opcode, tmpbuff);
+		// fragments are cut straight out of the app packet, no serialized copy of the whole thing
+		unsigned char op[3];
+		uint32 oplen=p->SerializeOpcode(opcode, op);
+		length=oplen+p->size;
 
 		EQProtocolPacket *out=new EQProtocolPacket(OP_Fragment,nullptr,MaxLen-4);
 		*(uint32 *)(out->pBuffer+2)=htonl(p->Size());
 		used=MaxLen-10;
-		memcpy(out->pBuffer+6,tmpbuff,used);
+		CopySerialized(op,oplen,p->pBuffer,0,used,out->pBuffer+6);
 		_log(NET__FRAGMENT, _L "First fragment: used %d/%d. Put size %d in the packet" __L, used, p->size, p->Size());
 		SequencedPush(out);
 
@@ -570,24 +594,17 @@ uint32 length;
 		while (used<length) {
 			out=new EQProtocolPacket(OP_Fragment,nullptr,MaxLen-4);
 			chunksize=std::min(length-used,MaxLen-6);
-			memcpy(out->pBuffer+2,tmpbuff+used,chunksize);
+			CopySerialized(op,oplen,p->pBuffer,used,chunksize,out->pBuffer+2);
 			out->size=chunksize+2;
 			SequencedPush(out);
 			used+=chunksize;
 			_log(NET__FRAGMENT, _L "Subsequent fragment: len %d, used %d/%d." __L, chunksize, used, p->size);
 		}
-		delete p;
-		delete[] tmpbuff;
 	} else {
-
-		unsigned char *tmpbuff=new unsigned char[p->Size()+3];
-		length=p->serialize(opcode, tmpbuff+2) + 2;
-
-		EQProtocolPacket *out=new EQProtocolPacket(OP_Packet,tmpbuff,length);
-
-		delete[] tmpbuff;
+		// serialized right after the sequence number SequencedPush fills in
+		EQProtocolPacket *out=new EQProtocolPacket(OP_Packet,nullptr,p->Size()+3);
+		out->size=p->serialize(opcode, out->pBuffer+2) + 2;
 		SequencedPush(out);
-		delete p;
 	}
 }
 
@@ -608,6 +625,7 @@ if(NextSequencedSend > SequencedQueue.size()) {
 	*(uint16 *)(p->pBuffer)=htons(NextOutSeq);
 	SequencedQueue.push_back(p);
 	NextOutSeq++;
+	MarkOutbound();
 
 if(uint16(SequencedBase + SequencedQueue.size()) != NextOutSeq) {
 	_log(NET__ERROR, _L "Push Invalid Sequenced queue: BS %d + SQ %d != NOS %d" __L, SequencedBase, SequencedQueue.size(), NextOutSeq);
@@ -616,6 +634,7 @@ if(NextSequencedSend > SequencedQueue.size()) {
 	_log(NET__ERROR, _L "Push Next Send Sequence is beyond the end of the queue NSS %d > SQ %d" __L, NextSequencedSend, SequencedQueue.size());
 }
 	MOutboundQueue.unlock();
+	NotifyWriter();
 #endif
 }
 
@@ -624,13 +643,22 @@ void EQStream::NonSequencedPush(EQProtocolPacket *p)
 #ifdef COLLECTOR
 	delete p;
 #else
-	MOutboundQueue.lock();
 	_log(NET__APP_TRACE, _L "Pushing non-sequenced packet of length %d" __L, p->size);
-	NonSequencedQueue.push(p);
-	MOutboundQueue.unlock();
+	NonSequencedQueue.Push(p);
+	MarkOutbound();
+	NotifyWriter();
 #endif
 }
 
+void EQStream::MarkOutbound()
+{
+	//first push since the last write starts the latency clock
+	if (OutboundSince.load(std::memory_order_relaxed) == 0) {
+		uint64 none = 0;
+		OutboundSince.compare_exchange_strong(none, Timer::GetTimeMicroseconds());
+	}
+}
+
 void EQStream::SendAck(uint16 seq)
 {
 uint16 Seq=htons(seq);
@@ -646,11 +674,12 @@ uint16 Seq=htons(seq);
 	NonSequencedPush(new EQProtocolPacket(OP_OutOfOrderAck,(unsigned char *)&Seq,sizeof(uint16)));
 }
 
-void EQStream::Write(int eq_fd)
+uint32 EQStream::Write(int eq_fd, EQStreamWriteBatch *batch)
 {
 std::queue<EQProtocolPacket *> ReadyToSend;
 bool SeqEmpty=false,NonSeqEmpty=false;
 std::deque<EQProtocolPacket *>::iterator sitr;
+uint32 latency=0;
 
 	// Check our rate to make sure we can send more
 	MRate.lock();
@@ -658,7 +687,7 @@ std::deque<EQProtocolPacket *>::iterator sitr;
 	MRate.unlock();
 	if (BytesWritten > threshold) {
 		//cout << "Over threshold: " << BytesWritten << " > " << threshold << endl;
-		return;
+		return 0;
 	}
 
 	// If we got more packets to we need to ack, send an ack on the highest one
@@ -691,17 +720,17 @@ std::deque<EQProtocolPacket *>::iterator sitr;
 	while(!SeqEmpty || !NonSeqEmpty) {
 
 		// See if there are more non-sequenced packets left
-		if (!NonSequencedQueue.empty()) {
+		EQProtocolPacket *nonseq = nullptr;
+		if (NonSequencedQueue.Peek(nonseq)) {
 			if (!p) {
 				// If we don't have a packet to try to combine into, use this one as the base
 				// And remove it form the queue
-				p = NonSequencedQueue.front();
+				NonSequencedQueue.Pop(p);
 				_log(NET__NET_COMBINE, _L "Starting combined packet with non-seq packet of len %d" __L, p->size);
-				NonSequencedQueue.pop();
-			} else if (!p->combine(NonSequencedQueue.front())) {
+			} else if (!p->combine(nonseq)) {
 				// Tryint to combine this packet with the base didn't work (too big maybe)
 				// So just send the base packet (we'll try this packet again later)
-				_log(NET__NET_COMBINE, _L "Combined packet full at len %d, next non-seq packet is len %d" __L, p->size, (NonSequencedQueue.front())->size);
+				_log(NET__NET_COMBINE, _L "Combined packet full at len %d, next non-seq packet is len %d" __L, p->size, nonseq->size);
 				ReadyToSend.push(p);
 				BytesWritten+=p->size;
 				p=nullptr;
@@ -713,9 +742,9 @@ std::deque<EQProtocolPacket *>::iterator sitr;
 				}
 			} else {
 				// Combine worked, so just remove this packet and it's spot in the queue
-				_log(NET__NET_COMBINE, _L "Combined non-seq packet of len %d, yeilding %d combined." __L, (NonSequencedQueue.front())->size, p->size);
-				delete NonSequencedQueue.front();
-				NonSequencedQueue.pop();
+				_log(NET__NET_COMBINE, _L "Combined non-seq packet of len %d, yeilding %d combined." __L, nonseq->size, p->size);
+				NonSequencedQueue.Pop(nonseq);
+				delete nonseq;
 			}
 		} else {
 			// No more non-sequenced packets
@@ -787,6 +816,19 @@ if(NextSequencedSend > SequencedQueue.size()) {
 			SeqEmpty=true;
 		}
 	}
+
+	// Time how long the oldest new data sat in the queue, retransmits dont count
+	// A push racing with this can lose its latency sample, never its packet
+	uint64 since = OutboundSince.load();
+	if (since && (p || !ReadyToSend.empty())) {
+		uint64 now = Timer::GetTimeMicroseconds();
+		latency = now > since ? (uint32)(now - since) : 1;
+		if (NonSequencedQueue.Empty() && NextSequencedSend >= (long)SequencedQueue.size())
+			OutboundSince = 0;
+		else
+			OutboundSince = now;
+	}
+
 	// Unlock the queue
 	MOutboundQueue.unlock();
 
@@ -800,7 +842,7 @@ if(NextSequencedSend > SequencedQueue.size()) {
 	// Send all the packets we "made"
 	while(!ReadyToSend.empty()) {
 		p = ReadyToSend.front();
-		WritePacket(eq_fd,p);
+		WritePacket(eq_fd,p,batch);
 		delete p;
 		ReadyToSend.pop();
 	}
@@ -816,9 +858,11 @@ if(NextSequencedSend > SequencedQueue.size()) {
 			SetState(DISCONNECTING);
 		}
 	}
+
+	return latency;
 }
 
-void EQStream::WritePacket(int eq_fd, EQProtocolPacket *p)
+void EQStream::WritePacket(int eq_fd, EQProtocolPacket *p, EQStreamWriteBatch *batch)
 {
 uint32 length;
 sockaddr_in address;
@@ -837,12 +881,33 @@ sockaddr_in address;
 	p->DumpRaw();
 	cout << "-------------" << endl;
 #endif
-	length=p->serialize(buffer);
+	// the opcode goes in the packet's headroom, so compressing reads straight from the packet
+	const unsigned char *raw=p->SerializeInPlace();
+	length=p->size+2;
+	if (raw == nullptr) {
+		p->serialize(buffer);
+		raw=buffer;
+	}
 	if (p->opcode!=OP_SessionRequest && p->opcode!=OP_SessionResponse) {
 		if (compressed) {
-			uint32 newlen=EQProtocolPacket::Compress(buffer,length, _tempBuffer, 2048);
-			memcpy(buffer,_tempBuffer,newlen);
-			length=newlen;
+			int64 start=RDTSC_Timer::rdtsc();
+			uint32 in_length=length;
+			if (raw == buffer) {
+				uint32 newlen=EQProtocolPacket::Compress(buffer,length, _tempBuffer, 2048, compress_min, compress_level);
+				memcpy(buffer,_tempBuffer,newlen);
+				length=newlen;
+			} else {
+				length=EQProtocolPacket::Compress(raw,length, buffer, sizeof(buffer), compress_min, compress_level);
+			}
+			compress_stats.deflate_ticks+=RDTSC_Timer::rdtsc()-start;
+			compress_stats.deflate_in+=in_length;
+			compress_stats.deflate_out+=length;
+			if (buffer[buffer[0]==0 ? 2 : 1]==0x5a)
+				compress_stats.deflated++;
+			else
+				compress_stats.stored++;
+		} else if (raw != buffer) {
+			memcpy(buffer,raw,length);
 		}
 		if (encoded) {
 			EQProtocolPacket::ChatEncode(buffer,length,Key);
@@ -850,12 +915,92 @@ sockaddr_in address;
 
 		*(uint16 *)(buffer+length)=htons(CRC16(buffer,length,Key));
 		length+=2;
+	} else if (raw != buffer) {
+		memcpy(buffer,raw,length);
 	}
 	//dump_message_column(buffer,length,"Writer: ");
-	sendto(eq_fd,(char *)buffer,length,0,(sockaddr *)&address,sizeof(address));
+	if (batch)
+		batch->Add(eq_fd,buffer,length,address);
+	else
+		sendto(eq_fd,(char *)buffer,length,0,(sockaddr *)&address,sizeof(address));
 	AddBytesSent(length);
 }
 
+EQStreamWriteBatch::EQStreamWriteBatch()
+{
+	count=0;
+	datagrams=0;
+	send_calls=0;
+	buffers=new unsigned char[EQSTREAM_WRITER_BATCH * EQSTREAM_WRITER_SLOT];
+}
+
+EQStreamWriteBatch::~EQStreamWriteBatch()
+{
+	safe_delete_array(buffers);
+}
+
+void EQStreamWriteBatch::Add(int eq_fd, const unsigned char *data, uint32 length, const sockaddr_in &to)
+{
+	if (length > EQSTREAM_WRITER_SLOT) {
+		// Too big for a slot, flush first to keep ordering and send it on its own
+		Flush(eq_fd);
+		sendto(eq_fd,(const char *)data,length,0,(const sockaddr *)&to,sizeof(to));
+		datagrams++;
+		send_calls++;
+		return;
+	}
+
+	memcpy(buffers + count * EQSTREAM_WRITER_SLOT, data, length);
+	lengths[count]=length;
+	addrs[count]=to;
+	count++;
+
+	if (count == EQSTREAM_WRITER_BATCH)
+		Flush(eq_fd);
+}
+
+void EQStreamWriteBatch::Flush(int eq_fd)
+{
+uint32 i;
+
+	if (!count)
+		return;
+
+#ifdef EQEMU_USE_SENDMMSG
+	mmsghdr msgs[EQSTREAM_WRITER_BATCH];
+	iovec iovs[EQSTREAM_WRITER_BATCH];
+	uint32 sent=0;
+	int num;
+
+	memset(msgs, 0, sizeof(mmsghdr) * count);
+	for (i = 0; i < count; i++) {
+		iovs[i].iov_base = buffers + i * EQSTREAM_WRITER_SLOT;
+		iovs[i].iov_len = lengths[i];
+		msgs[i].msg_hdr.msg_name = &addrs[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	while (sent < count) {
+		num = sendmmsg(eq_fd, msgs + sent, count - sent, 0);
+		send_calls++;
+		// Socket buffer full or an error, whatever was dropped is treated like any other lost datagram
+		if (num <= 0)
+			break;
+		sent += num;
+	}
+#else
+	for (i = 0; i < count; i++) {
+		sendto(eq_fd,(const char *)(buffers + i * EQSTREAM_WRITER_SLOT),lengths[i],0,(const sockaddr *)&addrs[i],sizeof(sockaddr_in));
+		send_calls++;
+	}
+#endif
+
+	datagrams += count;
+	count = 0;
+}
+
 /*
 commented out since im not sure theres a lot of merit in it.
 Really it was bitterness towards allocating a 2k buffer on the stack each call.
@@ -942,9 +1087,7 @@ void EQStream::_SendDisconnect()
 
 void EQStream::InboundQueuePush(EQRawApplicationPacket *p)
 {
-	MInboundQueue.lock();
-	InboundQueue.push_back(p);
-	MInboundQueue.unlock();
+	InboundQueue.Push(p);
 }
 
 EQApplicationPacket *EQStream::PopPacket()
@@ -952,11 +1095,7 @@ EQApplicationPacket *EQStream::PopPacket()
 EQRawApplicationPacket *p=nullptr;
 
 	MInboundQueue.lock();
-	if (InboundQueue.size()) {
-		std::vector<EQRawApplicationPacket *>::iterator itr=InboundQueue.begin();
-		p=*itr;
-		InboundQueue.erase(itr);
-	}
+	InboundQueue.Pop(p);
 	MInboundQueue.unlock();
 
 	//resolve the opcode if we can.
@@ -980,11 +1119,7 @@ EQRawApplicationPacket *EQStream::PopRawPacket()
 EQRawApplicationPacket *p=nullptr;
 
 	MInboundQueue.lock();
-	if (InboundQueue.size()) {
-		std::vector<EQRawApplicationPacket *>::iterator itr=InboundQueue.begin();
-		p=*itr;
-		InboundQueue.erase(itr);
-	}
+	InboundQueue.Pop(p);
 	MInboundQueue.unlock();
 
 	//resolve the opcode if we can.
@@ -1008,10 +1143,7 @@ EQRawApplicationPacket *EQStream::PeekPacket()
 EQRawApplicationPacket *p=nullptr;
 
 	MInboundQueue.lock();
-	if (InboundQueue.size()) {
-		std::vector<EQRawApplicationPacket *>::iterator itr=InboundQueue.begin();
-		p=*itr;
-	}
+	InboundQueue.Peek(p);
 	MInboundQueue.unlock();
 
 	return p;
@@ -1019,19 +1151,13 @@ EQRawApplicationPacket *p=nullptr;
 
 void EQStream::InboundQueueClear()
 {
-EQApplicationPacket *p=nullptr;
+EQRawApplicationPacket *p=nullptr;
 
 	_log(NET__APP_TRACE, _L "Clearing inbound queue" __L);
 
 	MInboundQueue.lock();
-	if (!InboundQueue.empty()) {
-		std::vector<EQRawApplicationPacket *>::iterator itr;
-		for(itr=InboundQueue.begin();itr!=InboundQueue.end();itr++) {
-			p=*itr;
-			delete p;
-		}
-		InboundQueue.clear();
-	}
+	while (InboundQueue.Pop(p))
+		delete p;
 	MInboundQueue.unlock();
 }
 
@@ -1044,7 +1170,7 @@ bool flag;
 		return(false);
 
 	MOutboundQueue.lock();
-	flag=(!NonSequencedQueue.empty());
+	flag=(!NonSequencedQueue.Empty());
 	if (!flag) {
 		//not only wait until we send it all, but wait until they ack everything.
 		flag = !SequencedQueue.empty();
@@ -1067,10 +1193,8 @@ EQProtocolPacket *p=nullptr;
 	_log(NET__APP_TRACE, _L "Clearing outbound queue" __L);
 
 	MOutboundQueue.lock();
-	while(!NonSequencedQueue.empty()) {
-		delete NonSequencedQueue.front();
-		NonSequencedQueue.pop();
-	}
+	while(NonSequencedQueue.Pop(p))
+		delete p;
 	if(!SequencedQueue.empty()) {
 		std::deque<EQProtocolPacket *>::iterator itr;
 		for(itr=SequencedQueue.begin();itr!=SequencedQueue.end();itr++) {
@@ -1112,7 +1236,14 @@ static unsigned char newbuffer[2048];
 uint32 newlength=0;
 	if (EQProtocolPacket::ValidateCRC(buffer,length,Key)) {
 		if (compressed) {
+			int64 start=RDTSC_Timer::rdtsc();
 			newlength=EQProtocolPacket::Decompress(buffer,length,newbuffer,2048);
+			if (length>2 && buffer[buffer[0]==0 ? 2 : 1]==0x5a) {
+				compress_stats.inflate_ticks+=RDTSC_Timer::rdtsc()-start;
+				compress_stats.inflate_in+=length;
+				compress_stats.inflate_out+=newlength;
+				compress_stats.inflated++;
+			}
 		} else {
 			memcpy(newbuffer,buffer,length);
 			newlength=length;
@@ -1209,6 +1340,7 @@ void EQStream::SetNextAckToSend(uint32 seq)
 	_log(NET__NET_ACKS, _L "Set Next Ack To Send to %lu" __L, (unsigned long)seq);
 	NextAckToSend=seq;
 	MAcks.unlock();
+	NotifyWriter();
 }
 
 void EQStream::SetLastAckSent(uint32 seq)
@@ -1271,6 +1403,12 @@ void EQStream::SetStreamType(EQStreamType type)
 			app_opcode_size=2;
 			compressed=true;
 			encoded=false;
+#ifdef RETRANSMITS
+			compress_min=RuleI(EQStream, CompressMinSize);
+			compress_level=RuleI(EQStream, WorldCompressLevel);
+			if (StreamType==ZoneStream)
+				compress_level=RuleI(EQStream, ZoneCompressLevel);
+#endif
 			_log(NET__NET_TRACE, _L "World/Zone stream has app opcode size %d, is compressed, and is not encoded." __L, app_opcode_size);
 			break;
 	}
@@ -1417,13 +1555,10 @@ EQStream::MatchState EQStream::CheckSignature(const Signature *sig) {
 	MatchState res = MatchNotReady;
 
 	MInboundQueue.lock();
-	if (!InboundQueue.empty()) {
+	if (InboundQueue.Peek(p)) {
 		//this is already getting hackish...
-		p = InboundQueue.front();
 		if(sig->ignore_eq_opcode != 0 && p->opcode == sig->ignore_eq_opcode) {
-			if(InboundQueue.size() > 1) {
-				p = InboundQueue[1];
-			} else {
+			if(!InboundQueue.Peek(p, 1)) {
 				p = nullptr;
 			}
 		}
@@ -13,6 +13,7 @@
 #include "EQPacket.h"
 #include "EQStreamIntf.h"
 #include "Mutex.h"
+#include "lockfree_queue.h"
 #include "../common/opcodemgr.h"
 #include "../common/misc.h"
 #include "../common/Condition.h"
@@ -62,6 +63,38 @@ class OpcodeManager;
 //class EQStreamFactory;
 class EQStreamPair;
 class EQRawApplicationPacket;
+class EQStream;
+
+//implemented by the factory's event driven writer, a stream calls it whenever
+//it queues something so the writer does not have to poll every stream
+class EQStreamWriteNotify {
+	public:
+		virtual ~EQStreamWriteNotify() { }
+		virtual void StreamReady(EQStream *s) = 0;
+};
+
+//max datagrams handed to the kernel by one sendmmsg() in the event driven writer
+#define EQSTREAM_WRITER_BATCH	64
+#define EQSTREAM_WRITER_SLOT	2048
+
+//collects outgoing datagrams from any number of streams so they go out in as few calls as possible
+class EQStreamWriteBatch {
+	public:
+		EQStreamWriteBatch();
+		~EQStreamWriteBatch();
+
+		void Add(int eq_fd, const unsigned char *data, uint32 length, const sockaddr_in &to);
+		void Flush(int eq_fd);
+
+		uint64 datagrams;
+		uint64 send_calls;
+
+	private:
+		uint32 count;
+		unsigned char *buffers;
+		uint32 lengths[EQSTREAM_WRITER_BATCH];
+		sockaddr_in addrs[EQSTREAM_WRITER_BATCH];
+};
 
 class EQStream : public EQStreamInterface {
 	friend class EQStreamPair;	//for collector.
@@ -80,6 +113,9 @@ class EQStream : public EQStreamInterface {
 		uint8 app_opcode_size;
 		EQStreamType StreamType;
 		bool compressed,encoded;
+		uint32 compress_min;	//payloads this size or smaller are never deflated
+		int compress_level;		//zlib level, 0 stores everything
+		EQStreamCompressionStats compress_stats;	//deflate side written by the writer, inflate side by the reader
 		uint32 retransmittimer;
 		uint32 retransmittimeout;
 
@@ -90,8 +126,7 @@ class EQStream : public EQStreamInterface {
 		uint32 MaxLen;
 		uint16 MaxSends;
 
-		uint8 active_users;	//how many things are actively using this
-		Mutex MInUse;
+		std::atomic<uint32> active_users;	//how many things are actively using this
 
 		EQStreamState State;
 		Mutex MState;
@@ -110,19 +145,26 @@ class EQStream : public EQStreamInterface {
 
 		Mutex MAcks;
 
-		// Packets waiting to be sent (all protected by MOutboundQueue)
-		std::queue<EQProtocolPacket *> NonSequencedQueue;
+		// Packets waiting to be sent. Anyone can push a non-sequenced packet
+		// without a lock; taking them off and everything sequenced is
+		// protected by MOutboundQueue.
+		MPSCQueue<EQProtocolPacket *> NonSequencedQueue;
 		std::deque<EQProtocolPacket *> SequencedQueue;
 		uint16 NextOutSeq;
 		uint16 SequencedBase;	//the sequence number of SequencedQueue[0]
 		long NextSequencedSend;	//index into SequencedQueue
+		std::atomic<uint64> OutboundSince;	//usec timestamp of the oldest data not yet written once, 0 if none
 		Mutex MOutboundQueue;
 
+		EQStreamWriteNotify *WriteNotify;
+		void NotifyWriter() { if (WriteNotify) WriteNotify->StreamReady(this); }
+
 		//a buffer we use for compression/decompression
 		unsigned char _tempBuffer[2048];
 
-		// Packets waiting to be processed
-		std::vector<EQRawApplicationPacket *> InboundQueue;
+		// Packets waiting to be processed. Only the thread calling Process()
+		// pushes, without a lock; MInboundQueue only serializes the readers.
+		SPSCQueue<EQRawApplicationPacket *> InboundQueue;
 		std::map<unsigned short,EQProtocolPacket *> PacketQueue;		//not mutex protected, only accessed by caller of Process()
 		Mutex MInboundQueue;
 
@@ -142,7 +184,8 @@ class EQStream : public EQStreamInterface {
 		EQRawApplicationPacket *MakeApplicationPacket(EQProtocolPacket *p);
 		EQRawApplicationPacket *MakeApplicationPacket(const unsigned char *buf, uint32 len);
 		EQProtocolPacket *MakeProtocolPacket(const unsigned char *buf, uint32 len);
-		void SendPacket(uint16 opcode, EQApplicationPacket *p);
+		void SendPacket(uint16 opcode, const EQApplicationPacket *p);
+		void PushApplicationPacket(const EQApplicationPacket *p, bool ack_req);
 
 		void SetState(EQStreamState state);
 
@@ -153,8 +196,9 @@ class EQStream : public EQStreamInterface {
 		void QueuePacket(EQProtocolPacket *p);
 		void SendPacket(EQProtocolPacket *p);
 		void NonSequencedPush(EQProtocolPacket *p);
+		void MarkOutbound();
 		void SequencedPush(EQProtocolPacket *p);
-		void WritePacket(int fd,EQProtocolPacket *p);
+		void WritePacket(int fd,EQProtocolPacket *p,EQStreamWriteBatch *batch);
 
 
 		uint32 GetKey() { return Key; }
@@ -195,7 +239,10 @@ class EQStream : public EQStreamInterface {
 		virtual void Close();
 		virtual uint32 GetRemoteIP() const { return remote_ip; }
 		virtual uint16 GetRemotePort() const { return remote_port; }
-		virtual void ReleaseFromUse() { MInUse.lock(); if(active_users > 0) active_users--; MInUse.unlock(); }
+		virtual void ReleaseFromUse() {
+			uint32 users = active_users.load();
+			while(users > 0 && !active_users.compare_exchange_weak(users, users - 1)) { }
+		}
 		virtual void RemoveData() { InboundQueueClear(); OutboundQueueClear(); PacketQueueClear(); /*if (CombinedAppPacket) delete CombinedAppPacket;*/ }
 		virtual bool CheckState(EQStreamState state) { return GetState() == state; }
 		virtual std::string Describe() const { return("Direct EQStream"); }
@@ -206,11 +253,15 @@ class EQStream : public EQStreamInterface {
 		bool HasOutgoingData();
 		void Process(const unsigned char *data, const uint32 length);
 		void SetLastPacketTime(uint32 t) {LastPacket=t;}
-		void Write(int eq_fd);
+		//returns how long (usec) the oldest newly written data waited in the queue, 0 if nothing new went out
+		uint32 Write(int eq_fd, EQStreamWriteBatch *batch = nullptr);
+
+		void SetWriteNotify(EQStreamWriteNotify *n) { WriteNotify=n; }
+		bool WritePending;	//on the notify target's ready list, protected by the notify target
 
 		//
-		inline bool IsInUse() { bool flag; MInUse.lock(); flag=(active_users>0); MInUse.unlock(); return flag; }
-		inline void PutInUse() { MInUse.lock(); active_users++; MInUse.unlock(); }
+		inline bool IsInUse() { return active_users.load() > 0; }
+		inline void PutInUse() { active_users++; }
 
 		inline EQStreamState GetState() { EQStreamState s; MState.lock(); s=State; MState.unlock(); return s; }
 
@@ -242,6 +293,8 @@ class EQStream : public EQStreamInterface {
 			bytes_recv += bytes;
 		}
 
+		virtual bool GetCompressionStats(EQStreamCompressionStats &out) const { out = compress_stats; return compressed; }
+
 		virtual const uint32 GetBytesSent() const { return bytes_sent; }
 		virtual const uint32 GetBytesRecieved() const { return bytes_recv; }
 		virtual const uint32 GetBytesSentPerSecond() const
@@ -13,11 +13,15 @@
 	#include <netdb.h>
 	#include <pthread.h>
 #endif
+#ifdef EQEMU_USE_RECVMMSG
+	#include <sys/epoll.h>
+#endif
 #include <fcntl.h>
 #include <iostream>
 #include "op_codes.h"
 #include "EQStream.h"
 #include "logsys.h"
+#include "packet_functions.h"
 
 ThreadReturnType EQStreamFactoryReaderLoop(void *eqfs)
 {
@@ -27,7 +31,11 @@ EQStreamFactory *fs=(EQStreamFactory *)eqfs;
 	_log(COMMON__THREADS, "Starting EQStreamFactoryReaderLoop with thread ID %d", pthread_self());
 #endif
 
-	fs->ReaderLoop();
+	{
+		//reused by every stream this thread inflates for
+		ZlibThreadContext zlib;
+		fs->ReaderLoop();
+	}
 
 #ifndef WIN32
 	_log(COMMON__THREADS, "Ending EQStreamFactoryReaderLoop with thread ID %d", pthread_self());
@@ -44,7 +52,11 @@ ThreadReturnType EQStreamFactoryWriterLoop(void *eqfs)
 	_log(COMMON__THREADS, "Starting EQStreamFactoryWriterLoop with thread ID %d", pthread_self());
 #endif
 
-	fs->WriterLoop();
+	{
+		//reused by every stream this thread deflates for
+		ZlibThreadContext zlib;
+		fs->WriterLoop();
+	}
 
 #ifndef WIN32
 	_log(COMMON__THREADS, "Ending EQStreamFactoryWriterLoop with thread ID %d", pthread_self());
@@ -53,12 +65,38 @@ ThreadReturnType EQStreamFactoryWriterLoop(void *eqfs)
 	THREAD_RETURN(nullptr);
 }
 
+EQStreamFactory::EQStreamFactory(EQStreamType type, uint32 timeout)
+	: Timeoutable(5000), stream_timeout(timeout)
+{
+	ReaderRunning=false;
+	WriterRunning=false;
+	StreamType=type;
+	Port=0;
+	sock=-1;
+	BatchedReader=false;
+	EventWriter=false;
+	memset(&ReaderStats, 0, sizeof(ReaderStats));
+	memset(&WriterStats, 0, sizeof(WriterStats));
+	ReaderWindowStart=0;
+	ReaderWindowPackets=0;
+	InboundWake=nullptr;
+}
+
 EQStreamFactory::EQStreamFactory(EQStreamType type, int port, uint32 timeout)
 	: Timeoutable(5000), stream_timeout(timeout)
 {
+	ReaderRunning=false;
+	WriterRunning=false;
 	StreamType=type;
 	Port=port;
 	sock=-1;
+	BatchedReader=false;
+	EventWriter=false;
+	memset(&ReaderStats, 0, sizeof(ReaderStats));
+	memset(&WriterStats, 0, sizeof(WriterStats));
+	ReaderWindowStart=0;
+	ReaderWindowPackets=0;
+	InboundWake=nullptr;
 }
 
 void EQStreamFactory::Close()
@@ -144,7 +182,6 @@ void EQStreamFactory::Push(EQStream *s)
 void EQStreamFactory::ReaderLoop()
 {
 fd_set readset;
-std::map<std::string,EQStream *>::iterator stream_itr;
 int num;
 int length;
 unsigned char buffer[2048];
@@ -153,6 +190,13 @@ int socklen=sizeof(sockaddr_in);
 timeval sleep_time;
 //time_t now;
 
+#ifdef EQEMU_USE_RECVMMSG
+	if (BatchedReader) {
+		BatchedReaderLoop();
+		return;
+	}
+#endif
+
 	ReaderRunning=true;
 	while(sock!=-1) {
 		MReaderRunning.lock();
@@ -183,40 +227,161 @@ timeval sleep_time;
 			{
 				// What do we wanna do?
 			} else {
-				char temp[25];
-				sprintf(temp,"%u.%d",ntohl(from.sin_addr.s_addr),ntohs(from.sin_port));
-				MStreams.lock();
-				if ((stream_itr=Streams.find(temp))==Streams.end()) {
-					if (buffer[1]==OP_SessionRequest) {
-						EQStream *s = new EQStream(from);
-						s->SetStreamType(StreamType);
-						Streams[temp]=s;
-						WriterWork.Signal();
-						Push(s);
-						s->AddBytesRecv(length);
-						s->Process(buffer,length);
-						s->SetLastPacketTime(Timer::GetCurrentTime());
-					}
-					MStreams.unlock();
-				} else {
-					EQStream *curstream = stream_itr->second;
-					//dont bother processing incoming packets for closed connections
-					if(curstream->CheckClosed())
-						curstream = nullptr;
-					else
-						curstream->PutInUse();
-					MStreams.unlock();	//the in use flag prevents the stream from being deleted while we are using it.
-
-					if(curstream) {
-						curstream->AddBytesRecv(length);
-						curstream->Process(buffer,length);
-						curstream->SetLastPacketTime(Timer::GetCurrentTime());
-						curstream->ReleaseFromUse();
-					}
-				}
+				RecordReaderBatch(1, length);
+				RoutePacket(buffer, length, from);
+			}
+		}
+	}
+}
+
+#ifdef EQEMU_USE_RECVMMSG
+void EQStreamFactory::BatchedReaderLoop()
+{
+int epfd;
+int num;
+int i;
+uint32 bytes;
+epoll_event ev;
+mmsghdr msgs[EQSTREAM_READER_BATCH];
+iovec iovs[EQSTREAM_READER_BATCH];
+sockaddr_in froms[EQSTREAM_READER_BATCH];
+//one reusable ring of receive buffers, allocated once for the life of the reader
+unsigned char *buffers = new unsigned char[EQSTREAM_READER_BATCH * 2048];
+
+	memset(msgs, 0, sizeof(msgs));
+	for (i = 0; i < EQSTREAM_READER_BATCH; i++) {
+		iovs[i].iov_base = buffers + i * 2048;
+		iovs[i].iov_len = 2048;
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_name = &froms[i];
+	}
+
+	epfd = epoll_create(1);
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = sock;
+	if (epfd < 0 || epoll_ctl(epfd, EPOLL_CTL_ADD, sock, &ev) < 0) {
+		_log(COMMON__ERROR, "Unable to set up epoll for the batched reader, falling back to select.");
+		if (epfd >= 0)
+			close(epfd);
+		safe_delete_array(buffers);
+		BatchedReader = false;
+		ReaderLoop();
+		return;
+	}
+
+	ReaderRunning=true;
+	while(sock!=-1) {
+		MReaderRunning.lock();
+		if (!ReaderRunning)
+			break;
+		MReaderRunning.unlock();
+
+		//short timeout so a Close() from another thread is noticed promptly
+		if ((num=epoll_wait(epfd, &ev, 1, 1000)) <= 0)
+			continue;
+
+		if(sock == -1)
+			break;		//somebody closed us while we were sleeping.
+
+		//drain everything the kernel has queued before going back to epoll
+		do {
+			for (i = 0; i < EQSTREAM_READER_BATCH; i++)
+				msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+
+			num = recvmmsg(sock, msgs, EQSTREAM_READER_BATCH, MSG_DONTWAIT, nullptr);
+			if (num <= 0)
+				break;
+
+			bytes = 0;
+			for (i = 0; i < num; i++)
+				bytes += msgs[i].msg_len;
+			RecordReaderBatch(num, bytes);
+
+			for (i = 0; i < num; i++) {
+				if (msgs[i].msg_len < 2)
+					continue;
+				RoutePacket(buffers + i * 2048, msgs[i].msg_len, froms[i]);
 			}
+		} while (num == EQSTREAM_READER_BATCH && sock != -1);
+	}
+
+	close(epfd);
+	safe_delete_array(buffers);
+}
+#endif
+
+void EQStreamFactory::RoutePacket(const unsigned char *buffer, int length, const sockaddr_in &from)
+{
+std::unordered_map<uint64,EQStream *>::iterator stream_itr;
+uint64 key=MakeStreamKey(from.sin_addr.s_addr, from.sin_port);
+
+	MStreams.lock();
+	if ((stream_itr=Streams.find(key))==Streams.end()) {
+		if (buffer[1]==OP_SessionRequest) {
+			EQStream *s = new EQStream(from);
+			s->SetStreamType(StreamType);
+			if (EventWriter)
+				s->SetWriteNotify(this);
+			Streams[key]=s;
+			WriterWork.Signal();
+			Push(s);
+			s->AddBytesRecv(length);
+			s->Process(buffer,length);
+			s->SetLastPacketTime(Timer::GetCurrentTime());
 		}
+		MStreams.unlock();
+	} else {
+		EQStream *curstream = stream_itr->second;
+		//dont bother processing incoming packets for closed connections
+		if(curstream->CheckClosed())
+			curstream = nullptr;
+		else
+			curstream->PutInUse();
+		MStreams.unlock();	//the in use flag prevents the stream from being deleted while we are using it.
+
+		if(curstream) {
+			curstream->AddBytesRecv(length);
+			curstream->Process(buffer,length);
+			curstream->SetLastPacketTime(Timer::GetCurrentTime());
+			curstream->ReleaseFromUse();
+		}
+	}
+
+	if (InboundWake)
+		InboundWake->Post();
+}
+
+void EQStreamFactory::RecordReaderBatch(uint32 count, uint32 bytes)
+{
+uint32 bucket=0;
+uint32 now=Timer::GetCurrentTime();
+
+	while (bucket < EQSTREAM_READER_BUCKETS - 1 && (count >> (bucket + 1)))
+		bucket++;
+
+	MReaderStats.lock();
+	ReaderStats.packets += count;
+	ReaderStats.bytes += bytes;
+	ReaderStats.batches++;
+	ReaderStats.batch_sizes[bucket]++;
+	ReaderWindowPackets += count;
+	if (ReaderWindowStart == 0) {
+		ReaderWindowStart = now;
+	} else if (now - ReaderWindowStart >= 1000) {
+		ReaderStats.packets_per_second = ReaderWindowPackets * 1000 / (now - ReaderWindowStart);
+		ReaderWindowStart = now;
+		ReaderWindowPackets = 0;
 	}
+	MReaderStats.unlock();
+}
+
+void EQStreamFactory::GetReaderStats(EQStreamReaderStats &stats)
+{
+	MReaderStats.lock();
+	stats = ReaderStats;
+	MReaderStats.unlock();
 }
 
 void EQStreamFactory::CheckTimeout()
@@ -225,7 +390,7 @@ void EQStreamFactory::CheckTimeout()
 	MStreams.lock();
 
 	unsigned long now=Timer::GetCurrentTime();
-	std::map<std::string,EQStream *>::iterator stream_itr;
+	std::unordered_map<uint64,EQStream *>::iterator stream_itr;
 
 	for(stream_itr=Streams.begin();stream_itr!=Streams.end();) {
 		EQStream *s = stream_itr->second;
@@ -241,11 +406,9 @@ void EQStreamFactory::CheckTimeout()
 			} else {
 				//everybody is done, we can delete it now
 				//cout << "Removing connection" << endl;
-				std::map<std::string,EQStream *>::iterator temp=stream_itr;
-				stream_itr++;
 				//let whoever has the stream outside delete it
-				delete temp->second;
-				Streams.erase(temp);
+				delete stream_itr->second;
+				stream_itr = Streams.erase(stream_itr);
 				continue;
 			}
 		}
@@ -255,9 +418,60 @@ void EQStreamFactory::CheckTimeout()
 	MStreams.unlock();
 }
 
+void EQStreamFactory::StreamReady(EQStream *s)
+{
+bool signal=false;
+
+	MReadyStreams.lock();
+	if (!s->WritePending) {
+		//hold it in use so CheckTimeout cant delete it before the writer gets to it
+		s->WritePending=true;
+		s->PutInUse();
+		ReadyStreams.push_back(s);
+		signal=true;
+	}
+	MReadyStreams.unlock();
+
+	if (signal)
+		WriterWork.Signal();
+}
+
+void EQStreamFactory::RecordWriterLatency(uint32 usec)
+{
+uint32 bucket;
+
+	if (usec < 250)
+		bucket=0;
+	else if (usec < 1000)
+		bucket=1;
+	else if (usec < 5000)
+		bucket=2;
+	else if (usec < 10000)
+		bucket=3;
+	else if (usec < 20000)
+		bucket=4;
+	else
+		bucket=5;
+
+	MWriterStats.lock();
+	WriterStats.writes++;
+	WriterStats.latency_total+=usec;
+	if (usec > WriterStats.latency_max)
+		WriterStats.latency_max=usec;
+	WriterStats.latency[bucket]++;
+	MWriterStats.unlock();
+}
+
+void EQStreamFactory::GetWriterStats(EQStreamWriterStats &stats)
+{
+	MWriterStats.lock();
+	stats = WriterStats;
+	MWriterStats.unlock();
+}
+
 void EQStreamFactory::WriterLoop()
 {
-std::map<std::string,EQStream *>::iterator stream_itr;
+std::unordered_map<uint64,EQStream *>::iterator stream_itr;
 bool havework=true;
 std::vector<EQStream *> wants_write;
 std::vector<EQStream *>::iterator cur,end;
@@ -265,6 +479,12 @@ bool decay=false;
 uint32 stream_count;
 
 Timer DecayTimer(20);
+uint32 latency;
+
+	if (EventWriter) {
+		EventWriterLoop();
+		return;
+	}
 
 	WriterRunning=true;
 	DecayTimer.Enable();
@@ -292,7 +512,7 @@ Timer DecayTimer(20);
 
 			//bullshit checking, to see if this is really happening, GDB seems to think so...
 			if(stream_itr->second == nullptr) {
-				fprintf(stderr, "ERROR: nullptr Stream encountered in EQStreamFactory::WriterLoop for: %s", stream_itr->first.c_str());
+				fprintf(stderr, "ERROR: nullptr Stream encountered in EQStreamFactory::WriterLoop for: %llu", (unsigned long long)stream_itr->first);
 				continue;
 			}
 
@@ -304,11 +524,16 @@ Timer DecayTimer(20);
 		}
 		MStreams.unlock();
 
+		MWriterStats.lock();
+		WriterStats.scans++;
+		MWriterStats.unlock();
+
 		//do the actual writes
 		cur = wants_write.begin();
 		end = wants_write.end();
 		for(; cur != end; cur++) {
-			(*cur)->Write(sock);
+			if ((latency = (*cur)->Write(sock)))
+				RecordWriterLatency(latency);
 			(*cur)->ReleaseFromUse();
 		}
 
@@ -325,3 +550,89 @@ Timer DecayTimer(20);
 	}
 }
 
+void EQStreamFactory::EventWriterLoop()
+{
+std::unordered_map<uint64,EQStream *>::iterator stream_itr;
+std::vector<EQStream *> wants_write;
+std::vector<EQStream *>::iterator cur,end;
+EQStreamWriteBatch batch;
+uint64 datagrams=0,send_calls=0;
+uint32 latency;
+uint32 stream_count;
+bool idle;
+
+//the periodic pass still has to visit every stream, for rate decay, retransmits
+//of unacked packets, streams that hit their rate limit and streams that are closing
+Timer DecayTimer(20);
+
+	WriterRunning=true;
+	DecayTimer.Enable();
+	while(sock!=-1) {
+		MWriterRunning.lock();
+		if (!WriterRunning)
+			break;
+		MWriterRunning.unlock();
+
+		//take everything that announced outgoing data, they are already marked in use
+		MReadyStreams.lock();
+		wants_write.swap(ReadyStreams);
+		for(cur = wants_write.begin(); cur != wants_write.end(); cur++)
+			(*cur)->WritePending=false;
+		MReadyStreams.unlock();
+
+		if (DecayTimer.Check()) {
+			MStreams.lock();
+			for(stream_itr=Streams.begin();stream_itr!=Streams.end();stream_itr++) {
+				stream_itr->second->Decay();
+				if (stream_itr->second->HasOutgoingData()) {
+					stream_itr->second->PutInUse();
+					wants_write.push_back(stream_itr->second);
+				}
+			}
+			MStreams.unlock();
+
+			MWriterStats.lock();
+			WriterStats.scans++;
+			MWriterStats.unlock();
+		}
+
+		idle = wants_write.empty();
+
+		cur = wants_write.begin();
+		end = wants_write.end();
+		for(; cur != end; cur++) {
+			if ((latency = (*cur)->Write(sock, &batch)))
+				RecordWriterLatency(latency);
+		}
+		batch.Flush(sock);
+
+		for(cur = wants_write.begin(); cur != end; cur++)
+			(*cur)->ReleaseFromUse();
+		wants_write.clear();
+
+		MWriterStats.lock();
+		WriterStats.datagrams += batch.datagrams - datagrams;
+		WriterStats.send_calls += batch.send_calls - send_calls;
+		MWriterStats.unlock();
+		datagrams = batch.datagrams;
+		send_calls = batch.send_calls;
+
+		if (!idle)
+			continue;
+
+		MStreams.lock();
+		stream_count=Streams.size();
+		MStreams.unlock();
+		if (!stream_count) {
+			WriterWork.Wait();
+		} else {
+			//a signal sent between the swap above and this wait is missed, but
+			//the timeout bounds that to one decay period
+			MReadyStreams.lock();
+			idle = ReadyStreams.empty();
+			MReadyStreams.unlock();
+			if (idle)
+				WriterWork.TimedWait(20000);
+		}
+	}
+}
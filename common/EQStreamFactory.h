@@ -3,18 +3,47 @@
 #define _EQSTREAMFACTORY_H
 
 #include <queue>
-#include <map>
+#include <unordered_map>
 #include "../common/EQStream.h"
 #include "../common/Condition.h"
 #include "../common/timeoutmgr.h"
 #include "../common/opcodemgr.h"
 #include "../common/timer.h"
 
-class EQStreamFactory : private Timeoutable {
+//max datagrams pulled off the socket by one recvmmsg() in the batched reader
+#define EQSTREAM_READER_BATCH	64
+//batch size histogram buckets: 1, 2-3, 4-7, ... 32-63, 64
+#define EQSTREAM_READER_BUCKETS	7
+
+struct EQStreamReaderStats {
+	uint64 packets;
+	uint64 bytes;
+	uint64 batches;				//number of reads that returned at least one datagram
+	uint32 packets_per_second;	//from the last completed one second window
+	uint32 batch_sizes[EQSTREAM_READER_BUCKETS];
+};
+
+//queued-to-written latency buckets: <250us, <1ms, <5ms, <10ms, <20ms, 20ms+
+#define EQSTREAM_LATENCY_BUCKETS	6
+
+struct EQStreamWriterStats {
+	uint64 writes;			//stream writes that put new data on the wire
+	uint64 latency_total;	//usec, summed over writes
+	uint32 latency_max;
+	uint32 latency[EQSTREAM_LATENCY_BUCKETS];
+	uint64 scans;			//passes over every stream
+	uint64 datagrams;		//event writer only
+	uint64 send_calls;		//event writer only
+};
+
+class EQStreamFactory : private Timeoutable, private EQStreamWriteNotify {
 	private:
 		int sock;
 		int Port;
 
+		bool BatchedReader;
+		bool EventWriter;
+
 		bool ReaderRunning;
 		Mutex MReaderRunning;
 		bool WriterRunning;
@@ -22,14 +51,40 @@ class EQStreamFactory : private Timeoutable {
 
 		Condition WriterWork;
 
+		//signaled after each inbound packet, set by whoever sleeps waiting for them
+		Condition *InboundWake;
+
+		//streams that queued something since the event writer last looked
+		std::vector<EQStream *> ReadyStreams;
+		Mutex MReadyStreams;
+
+		EQStreamWriterStats WriterStats;
+		Mutex MWriterStats;
+
 		EQStreamType StreamType;
 
 		std::queue<EQStream *> NewStreams;
 		Mutex MNewStreams;
 
-		std::map<std::string,EQStream *> Streams;
+		//keyed by MakeStreamKey(ip, port), both in network order
+		std::unordered_map<uint64,EQStream *> Streams;
 		Mutex MStreams;
 
+		EQStreamReaderStats ReaderStats;
+		uint32 ReaderWindowStart;
+		uint32 ReaderWindowPackets;
+		Mutex MReaderStats;
+
+		static inline uint64 MakeStreamKey(uint32 ip, uint16 port) { return (((uint64)ip) << 16) | port; }
+
+		void RoutePacket(const unsigned char *buffer, int length, const sockaddr_in &from);
+		void RecordReaderBatch(uint32 count, uint32 bytes);
+		void BatchedReaderLoop();
+
+		virtual void StreamReady(EQStream *s);
+		void RecordWriterLatency(uint32 usec);
+		void EventWriterLoop();
+
 		virtual void CheckTimeout();
 
 		Timer *DecayTimer;
@@ -37,7 +92,7 @@ class EQStreamFactory : private Timeoutable {
 		uint32 stream_timeout;
 
 	public:
-		EQStreamFactory(EQStreamType type, uint32 timeout = 135000) : Timeoutable(5000), stream_timeout(timeout) { ReaderRunning=false; WriterRunning=false; StreamType=type; sock=-1; }
+		EQStreamFactory(EQStreamType type, uint32 timeout = 135000);
 		EQStreamFactory(EQStreamType type, int port, uint32 timeout = 135000);
 
 		EQStream *Pop();
@@ -53,6 +108,19 @@ class EQStreamFactory : private Timeoutable {
 		void StopReader() { MReaderRunning.lock(); ReaderRunning=false; MReaderRunning.unlock(); }
 		void StopWriter() { MWriterRunning.lock(); WriterRunning=false; MWriterRunning.unlock(); WriterWork.Signal(); }
 		void SignalWriter() { WriterWork.Signal(); }
+
+		//drain the socket with epoll + recvmmsg instead of select + recvfrom, must be set before Open()
+		void SetBatchedReader(bool batched) { BatchedReader=batched; }
+		bool IsBatchedReader() const { return BatchedReader; }
+		void GetReaderStats(EQStreamReaderStats &stats);
+
+		//write when streams queue data instead of polling every stream each 10ms, must be set before Open()
+		void SetEventWriter(bool event) { EventWriter=event; }
+		bool IsEventWriter() const { return EventWriter; }
+		void GetWriterStats(EQStreamWriterStats &stats);
+
+		//wakes a main loop sleeping on c whenever a packet arrives
+		void SetInboundWake(Condition *c) { InboundWake=c; }
 };
 
 #endif
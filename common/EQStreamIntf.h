@@ -4,6 +4,7 @@
 //this is the only part of an EQStream that is seen by the application.
 
 #include <string>
+#include "types.h"
 #include "clientversions.h"
 
 typedef enum {
@@ -15,6 +16,20 @@ typedef enum {
 } EQStreamState;
 
 class EQApplicationPacket;
+class StructStrategy;
+
+//compression work done for one stream. cpu is in RDTSC_Timer ticks.
+struct EQStreamCompressionStats {
+	uint64 deflate_in;		//bytes offered to the compressor, including ones it stored
+	uint64 deflate_out;
+	uint64 deflate_ticks;
+	uint32 deflated;		//datagrams sent compressed
+	uint32 stored;			//datagrams sent as is, too small or didn't shrink
+	uint64 inflate_in;
+	uint64 inflate_out;
+	uint64 inflate_ticks;
+	uint32 inflated;
+};
 
 class EQStreamInterface {
 public:
@@ -36,6 +51,13 @@ public:
 	virtual const uint32 GetBytesSentPerSecond() const { return 0; }
 	virtual const uint32 GetBytesRecvPerSecond() const { return 0; }
 	virtual const EQClientVersion ClientVersion() const { return EQClientUnknown; }
+	//false if this stream has no compression to report
+	virtual bool GetCompressionStats(EQStreamCompressionStats &out) const { return false; }
+
+	//the strategy packets are translated with, nullptr if they go out as is. see BroadcastEncoder.
+	virtual const StructStrategy *GetStructStrategy() const { return nullptr; }
+	//queue a packet that was already run through GetStructStrategy(), the packet is not taken.
+	virtual void QueueEncodedPacket(const EQApplicationPacket *p, bool ack_req=true) { QueuePacket(p, ack_req); }
 };
 
 #endif /*EQSTREAMINTF_H_*/
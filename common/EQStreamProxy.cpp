@@ -27,6 +27,17 @@ const EQClientVersion EQStreamProxy::ClientVersion() const
 	return m_structs->ClientVersion();
 }
 
+const StructStrategy *EQStreamProxy::GetStructStrategy() const
+{
+	return m_structs;
+}
+
+void EQStreamProxy::QueueEncodedPacket(const EQApplicationPacket *p, bool ack_req) {
+	if(p == nullptr)
+		return;
+	m_stream->QueuePacket(p, ack_req);
+}
+
 void EQStreamProxy::QueuePacket(const EQApplicationPacket *p, bool ack_req) {
 	if(p == nullptr)
 		return;
@@ -83,6 +94,11 @@ const uint32 EQStreamProxy::GetBytesRecvPerSecond() const
 	return(m_stream->GetBytesRecvPerSecond());
 }
 
+bool EQStreamProxy::GetCompressionStats(EQStreamCompressionStats &out) const
+{
+	return(m_stream->GetCompressionStats(out));
+}
+
 void EQStreamProxy::ReleaseFromUse() {
 	m_stream->ReleaseFromUse();
 
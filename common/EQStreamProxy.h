@@ -28,11 +28,14 @@ public:
 	virtual bool CheckState(EQStreamState state);
 	virtual std::string Describe() const;
 	virtual const EQClientVersion ClientVersion() const;
+	virtual const StructStrategy *GetStructStrategy() const;
+	virtual void QueueEncodedPacket(const EQApplicationPacket *p, bool ack_req=true);
 
 	virtual const uint32 GetBytesSent() const;
 	virtual const uint32 GetBytesRecieved() const;
 	virtual const uint32 GetBytesSentPerSecond() const;
 	virtual const uint32 GetBytesRecvPerSecond() const;
+	virtual bool GetCompressionStats(EQStreamCompressionStats &out) const;
 
 protected:
 	EQStream *const					m_stream;	//we own this stream object.
@@ -32,6 +32,7 @@ tremendously.
 
 #include "EmuTCPConnection.h"
 #include "EmuTCPServer.h"
+#include "Condition.h"
 #include "../common/servertalk.h"
 #include "../common/packet_dump.h"
 
@@ -70,6 +71,7 @@ EmuTCPConnection::EmuTCPConnection(uint32 ID, EmuTCPServer* iServer, SOCKET in_s
 	RelayServer = false;
 	RelayCount = 0;
 	RemoteID = 0;
+	InboundWake = nullptr;
 
 }
 
@@ -87,6 +89,7 @@ EmuTCPConnection::EmuTCPConnection(bool iOldFormat, EmuTCPServer* iRelayServer,
 	RelayLink = 0;
 	RelayCount = 0;
 	RemoteID = 0;
+	InboundWake = nullptr;
 	pOldFormat = iOldFormat;
 	TCPMode = iMode;
 	PacketMode = packetModeZone;
@@ -106,6 +109,7 @@ EmuTCPConnection::EmuTCPConnection(uint32 ID, EmuTCPServer* iServer, EmuTCPConne
 	RelayServer = true;
 	RelayCount = 0;
 	RemoteID = iRemoteID;
+	InboundWake = nullptr;
 	pOldFormat = false;
 	ConnectionType = Incomming;
 	TCPMode = modePacket;
@@ -275,6 +279,8 @@ void EmuTCPConnection::OutQueuePush(ServerPacket* pack) {
 	MOutQueueLock.lock();
 	OutQueue.push(pack);
 	MOutQueueLock.unlock();
+	if (InboundWake)
+		InboundWake->Post();
 }
 
 
@@ -26,6 +26,7 @@
 
 struct SPackSendQueue;
 class EmuTCPServer;
+class Condition;
 
 class EmuTCPConnection : public TCPConnection {
 public:
@@ -47,6 +48,8 @@ public:
 	virtual bool	SendPacket(EmuTCPNetPacket_Struct* tnps);
 	ServerPacket*	PopPacket(); // OutQueuePop()
 	void SetPacketMode(ePacketMode mode) { PacketMode = mode; }
+	//posted whenever a packet is queued for PopPacket
+	void SetInboundWake(Condition *c) { InboundWake = c; }
 
 	eTCPMode		GetMode()	const		{ return TCPMode; }
 	ePacketMode		GetPacketMode() const	{ return(PacketMode); }
@@ -95,6 +98,7 @@ protected:
 	//output queue...
 	MyQueue<ServerPacket> OutQueue;
 	Mutex	MOutQueueLock;
+	Condition	*InboundWake;
 };
 
 #endif /*EmuTCPCONNECTION_H_*/
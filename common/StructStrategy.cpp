@@ -54,6 +54,93 @@ void StructStrategy::PassDecoder(EQApplicationPacket *p) {
 
 
 
+//stands in for a client's stream so the output of an encoder can be kept and
+//queued into any number of real streams afterwards.
+class EncodeCaptureStream : public EQStream {
+public:
+	virtual void QueuePacket(const EQApplicationPacket *p, bool ack_req=true) {
+		if(p != nullptr)
+			packets.push_back(p->Copy());
+	}
+	virtual void FastQueuePacket(EQApplicationPacket **p, bool ack_req=true) {
+		if(p == nullptr || *p == nullptr)
+			return;
+		packets.push_back(*p);
+		*p = nullptr;
+	}
+	virtual void Close() { }
+
+	std::vector<EQApplicationPacket *> packets;
+};
+
+BroadcastEncoder::Stats BroadcastEncoder::s_stats = { 0, 0, 0, 0 };
+
+BroadcastEncoder::BroadcastEncoder(const EQApplicationPacket *app, bool ack_req)
+:	m_app(app),
+	m_ack_req(ack_req),
+	m_counted(false)
+{
+}
+
+BroadcastEncoder::~BroadcastEncoder() {
+	std::vector<Encoded>::iterator cur = m_encoded.begin();
+	for(; cur != m_encoded.end(); cur++) {
+		std::vector<EQApplicationPacket *>::iterator pack = cur->packets.begin();
+		for(; pack != cur->packets.end(); pack++)
+			delete *pack;
+	}
+}
+
+void BroadcastEncoder::Queue(EQStreamInterface *dest) {
+	if(m_app == nullptr || dest == nullptr)
+		return;
+
+	if(!m_counted) {
+		s_stats.broadcasts++;
+		m_counted = true;
+	}
+	s_stats.recipients++;
+
+	const StructStrategy *structs = dest->GetStructStrategy();
+	if(structs == nullptr) {
+		//no translation for this stream, nothing to share
+		dest->QueuePacket(m_app, m_ack_req);
+		return;
+	}
+
+	Encoded *enc = nullptr;
+	std::vector<Encoded>::iterator cur = m_encoded.begin();
+	for(; cur != m_encoded.end(); cur++) {
+		if(cur->structs == structs) {
+			enc = &(*cur);
+			break;
+		}
+	}
+
+	if(enc == nullptr) {
+		//created on first use since constructing a stream reads rules
+		static EncodeCaptureStream *capture = nullptr;
+		if(capture == nullptr)
+			capture = new EncodeCaptureStream();
+
+		Encoded fresh;
+		fresh.structs = structs;
+		m_encoded.push_back(fresh);
+		enc = &m_encoded.back();
+
+		EQApplicationPacket *copy = m_app->Copy();
+		structs->Encode(&copy, capture, m_ack_req);
+		enc->packets.swap(capture->packets);
+		s_stats.encodes++;
+	} else {
+		s_stats.encodes_saved++;
+	}
+
+	std::vector<EQApplicationPacket *>::iterator pack = enc->packets.begin();
+	for(; pack != enc->packets.end(); pack++)
+		dest->QueueEncodedPacket(*pack, m_ack_req);
+}
+
 //effectively a singleton, but I decided to do it this way for no apparent reason.
 namespace StructStrategyFactory {
 
@@ -3,10 +3,13 @@
 
 class EQApplicationPacket;
 class EQStream;
+class EQStreamInterface;
+#include "types.h"
 #include "emu_opcodes.h"
 #include "clientversions.h"
 
 #include <string>
+#include <vector>
 
 class StructStrategy {
 public:
@@ -39,6 +42,44 @@ protected:
 	Decoder decoders[_maxEmuOpcode];
 };
 
+//Sends one emu packet to many streams, running each struct strategy's encoder at
+//most once. The first stream of a given client version pays for the translation,
+//every later stream of that version queues the same encoded packets. Meant to live
+//for the length of one broadcast loop, and only used from the thread doing the
+//broadcast (the encoders write into a shared capture stream).
+class BroadcastEncoder {
+public:
+	//does NOT take the packet, it must outlive this object.
+	BroadcastEncoder(const EQApplicationPacket *app, bool ack_req = true);
+	~BroadcastEncoder();
+
+	void Queue(EQStreamInterface *dest);
+
+	const EQApplicationPacket *GetPacket() const { return m_app; }
+	bool GetAckReq() const { return m_ack_req; }
+
+	struct Stats {
+		uint64 broadcasts;
+		uint64 recipients;
+		uint64 encodes;			//encoder runs actually done
+		uint64 encodes_saved;	//recipients that reused an earlier encode
+	};
+	static const Stats &GetStats() { return s_stats; }
+
+protected:
+	struct Encoded {
+		const StructStrategy *structs;
+		std::vector<EQApplicationPacket *> packets;
+	};
+
+	const EQApplicationPacket *const m_app;
+	const bool m_ack_req;
+	std::vector<Encoded> m_encoded;	//at most one per client version
+	bool m_counted;
+
+	static Stats s_stats;
+};
+
 //effectively a singleton, but I decided to do it this way for no apparent reason.
 namespace StructStrategyFactory {
 	void RegisterPatch(EmuOpcode first_opcode, const StructStrategy *structs);
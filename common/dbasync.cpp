@@ -16,6 +16,7 @@
 //#include "../common/MiscFunctions.h"
 #include "StringUtil.h"
 #define ASYNC_LOOP_GRANULARITY 4 //# of ms between checking our work
+#define ASYNC_DELAY_CHECK 100 //# of ms between checks for delayed work when nothing wakes us
 
 bool DBAsyncCB_LoadVariables(DBAsyncWork* iWork) {
 	char errbuf[MYSQL_ERRMSG_SIZE];
@@ -38,52 +39,111 @@ void AsyncLoadVariables(DBAsync *dba, Database *db) {
 
 //we only need to do anything when somebody puts work on the queue
 //so instead of checking all the time, we will wait on a condition
-//which will get signaled when somebody puts something on the queue
+//which will get signaled when somebody puts something on the queue,
+//or when a worker finishes and frees up the key other work was waiting on
 ThreadReturnType DBAsyncLoop(void* tmp) {
-	DBAsync* dba = (DBAsync*) tmp;
+	DBAsync::Worker* worker = (DBAsync::Worker*) tmp;
+	DBAsync* dba = worker->owner;
 
 #ifndef WIN32
-	_log(COMMON__THREADS, "Starting DBAsyncLoop with thread ID %d", pthread_self());
+	_log(COMMON__THREADS, "Starting DBAsyncLoop %u with thread ID %d", worker->index, pthread_self());
 #endif
+	mysql_thread_init();
 
-	dba->MLoopRunning.lock();
+	worker->MLoopRunning.lock();
+	dba->MRunLoop.lock();
+	worker->started = true;
+	dba->MRunLoop.unlock();
 	while (dba->RunLoop()) {
 		//wait before working so we check the loop condition
-		//as soon as were done working
-		dba->CInList.Wait();
-		//we could check dba->RunLoop() again to see if we
-		//got turned off while we were waiting
+		//as soon as were done working. The timeout picks up delayed work.
+		dba->CInList.TimedWait(ASYNC_DELAY_CHECK * 1000);
 		{
 			_CP(DBAsyncLoop_loop);
-			dba->Process();
+			dba->Process(worker);
 		}
-//		Sleep(ASYNC_LOOP_GRANULARITY);
 	}
-	dba->MLoopRunning.unlock();
 
+	mysql_thread_end();
 #ifndef WIN32
-	_log(COMMON__THREADS, "Ending DBAsyncLoop with thread ID %d", pthread_self());
+	_log(COMMON__THREADS, "Ending DBAsyncLoop %u with thread ID %d", worker->index, pthread_self());
 #endif
+	worker->MLoopRunning.unlock();
 
 	THREAD_RETURN(nullptr);
 }
 
-DBAsync::DBAsync(DBcore* iDBC)
+DBAsync::DBAsync(DBcore* iDBC, uint32 iWorkers)
 : Timeoutable(10000)
 {
 	pDBC = iDBC;
 	pRunLoop = true;
 	pNextID = 1;
+	pStats.workers = 0;
+	ResetStats();
+	StartWorkers(iWorkers ? iWorkers : 1);
+}
+
+DBAsync::~DBAsync() {
+	StopThread();
+	for (size_t i = 0; i < Workers.size(); i++) {
+		if (Workers[i]->own_dbc)
+			safe_delete(Workers[i]->dbc);
+		safe_delete(Workers[i]);
+	}
+}
+
+uint32 DBAsync::StartWorkers(uint32 iWorkers) {
+	if (!RunLoop())
+		return GetWorkerCount();
+
+	MCurrentWork.lock();
+	while (Workers.size() < iWorkers) {
+		Worker* worker = new Worker;
+		worker->owner = this;
+		worker->index = Workers.size();
+		worker->CurrentWork = 0;
+		worker->dbc = new DBcore;
+		worker->own_dbc = true;
+		char errbuf[MYSQL_ERRMSG_SIZE];
+		if (!worker->dbc->OpenLike(*pDBC, 0, errbuf)) {
+			_log(COMMON__THREADS, "DBAsync worker %u could not open its own connection (%s), sharing the main one", worker->index, errbuf);
+			safe_delete(worker->dbc);
+			worker->dbc = pDBC;
+			worker->own_dbc = false;
+		}
+		worker->started = false;
+		Workers.push_back(worker);
 #ifdef _WINDOWS
-	_beginthread(DBAsyncLoop, 0, this);
+		_beginthread(DBAsyncLoop, 0, worker);
 #else
-	pthread_t thread;
-	pthread_create(&thread, nullptr, DBAsyncLoop, this);
+		pthread_t thread;
+		pthread_create(&thread, nullptr, DBAsyncLoop, worker);
+		pthread_detach(thread);
 #endif
+		//the worker holds MLoopRunning for as long as its loop runs, and
+		//StopThread waits on that, so don't go on until it has it
+		while (true) {
+			MRunLoop.lock();
+			bool started = worker->started;
+			MRunLoop.unlock();
+			if (started)
+				break;
+			Sleep(1);
+		}
+	}
+	uint32 ret = Workers.size();
+	MCurrentWork.unlock();
+
+	MStats.lock();
+	pStats.workers = ret;
+	MStats.unlock();
+	return ret;
 }
 
-DBAsync::~DBAsync() {
-	StopThread();
+uint32 DBAsync::GetWorkerCount() {
+	LockMutex lock(&MCurrentWork);
+	return Workers.size();
 }
 
 bool DBAsync::StopThread() {
@@ -94,16 +154,21 @@ bool DBAsync::StopThread() {
 	MRunLoop.unlock();
 
 	//signal the condition so we exit the loop if were waiting
-	CInList.Signal();
+	CInList.SignalAll();
 
-	//this effectively waits for the processing thread to finish
-	MLoopRunning.lock();
-	MLoopRunning.unlock();
+	//this effectively waits for the processing threads to finish
+	MCurrentWork.lock();
+	std::vector<Worker*> workers = Workers;
+	MCurrentWork.unlock();
+	for (size_t i = 0; i < workers.size(); i++) {
+		workers[i]->MLoopRunning.lock();
+		workers[i]->MLoopRunning.unlock();
+	}
 
 	return ret;
 }
 
-uint32 DBAsync::AddWork(DBAsyncWork** iWork, uint32 iDelay) {
+uint32 DBAsync::AddWork(DBAsyncWork** iWork, uint32 iDelay, uint32 iKey) {
 	MInList.lock();
 	uint32 ret = GetNextID();
 	if (!(*iWork)->SetWorkID(ret)) {
@@ -112,6 +177,8 @@ uint32 DBAsync::AddWork(DBAsyncWork** iWork, uint32 iDelay) {
 	}
 	InList.Append(*iWork);
 	(*iWork)->SetStatus(Queued);
+	(*iWork)->pKey = iKey;
+	(*iWork)->pQueuedAt = Timer::GetTimeMicroseconds() + uint64(iDelay) * 1000;
 	if (iDelay)
 		(*iWork)->pExecuteAfter = Timer::GetCurrentTime() + iDelay;
 #if DEBUG_MYSQL_QUERIES >= 2
@@ -119,9 +186,14 @@ uint32 DBAsync::AddWork(DBAsyncWork** iWork, uint32 iDelay) {
 	std::cout << "ExecuteAfter = " << (*iWork)->pExecuteAfter << " (" << Timer::GetCurrentTime() << " + " << iDelay << ")" << std::endl;
 #endif
 	*iWork = 0;
+	uint32 depth = InList.Count();
 	MInList.unlock();
 
-	//wake up the processing thread and tell it to get to work.
+	MStats.lock();
+	pStats.depth.Add(depth);
+	MStats.unlock();
+
+	//wake up a processing thread and tell it to get to work.
 	CInList.Signal();
 
 	return ret;
@@ -134,10 +206,13 @@ bool DBAsync::CancelWork(uint32 iWorkID) {
 	std::cout << "DBAsync::CancelWork: " << iWorkID << std::endl;
 #endif
 	MCurrentWork.lock();
-	if (CurrentWork && CurrentWork->GetWorkID() == iWorkID) {
-		CurrentWork->Cancel();
-		MCurrentWork.unlock();
-		return true;
+	for (size_t i = 0; i < Workers.size(); i++) {
+		DBAsyncWork* current = Workers[i]->CurrentWork;
+		if (current && current->GetWorkID() == iWorkID) {
+			current->Cancel();
+			MCurrentWork.unlock();
+			return true;
+		}
 	}
 	MCurrentWork.unlock();
 	MInList.lock();
@@ -156,6 +231,22 @@ bool DBAsync::CancelWork(uint32 iWorkID) {
 	return false;
 }
 
+bool DBAsync::WaitForKey(uint32 iKey, uint32 iTimeoutMS) {
+	uint64 deadline = Timer::GetTimeMicroseconds() + uint64(iTimeoutMS) * 1000;
+	while (true) {
+		MInList.lock();
+		bool busy = (BusyKeys.find(iKey) != BusyKeys.end());
+		MInList.unlock();
+		if (!busy)
+			return true;
+		uint64 now = Timer::GetTimeMicroseconds();
+		if (now >= deadline)
+			return false;
+		// a post from some other key's release just costs one more look
+		CKeyReleased.WaitForPost((unsigned long)(deadline - now));
+	}
+}
+
 bool DBAsync::RunLoop() {
 	bool ret;
 	MRunLoop.lock();
@@ -164,46 +255,58 @@ bool DBAsync::RunLoop() {
 	return ret;
 }
 
-DBAsyncWork* DBAsync::InListPop() {
+// Takes the first work that is due and whose key isn't already executing, and marks its key busy.
+// Work queued earlier with the same key holds up everything behind it once it is due,
+// delayed work that isn't due yet is passed over so it can't hold up a save or a barrier.
+DBAsyncWork* DBAsync::InListPop(bool iWritesOnly) {
 	DBAsyncWork* ret = 0;
+	std::set<uint32> blocked;
 	MInList.lock();
 	LinkedListIterator<DBAsyncWork*> iterator(InList);
 
 	iterator.Reset();
 	while (iterator.MoreElements()) {
-		if (iterator.GetData()->pExecuteAfter <= Timer::GetCurrentTime()) {
-			ret = iterator.GetData();
+		DBAsyncWork* work = iterator.GetData();
+		//reads are left for the workers, so they don't hold up writes here
+		if (iWritesOnly && work->Type() == Read) {
+			iterator.Advance();
+			continue;
+		}
+		bool ready = iWritesOnly || (work->pExecuteAfter <= Timer::GetCurrentTime());
+		if (ready && BusyKeys.find(work->pKey) == BusyKeys.end() && blocked.find(work->pKey) == blocked.end()) {
+			ret = work;
 #if DEBUG_MYSQL_QUERIES >= 2
 			std::cout << "Poping AsyncWork #" << ret->GetWorkID() << std::endl;
 			std::cout << ret->pExecuteAfter << " <= " << Timer::GetCurrentTime() << std::endl;
 #endif
+			BusyKeys.insert(work->pKey);
 			iterator.RemoveCurrent(false);
 			break;
 		}
+		if (ready)
+			blocked.insert(work->pKey);
 		iterator.Advance();
 	}
 	MInList.unlock();
+
+	if (ret) {
+		uint64 now = Timer::GetTimeMicroseconds();
+		MStats.lock();
+		pStats.wait_us.Add(now > ret->pQueuedAt ? now - ret->pQueuedAt : 0);
+		MStats.unlock();
+	}
 	return ret;
 }
 
-DBAsyncWork* DBAsync::InListPopWrite() {
+void DBAsync::ReleaseKey(uint32 iKey) {
 	MInList.lock();
-	LinkedListIterator<DBAsyncWork*> iterator(InList);
-
-	DBAsyncWork* ret = 0;
-	DBAsync::Type tmpType;
-	iterator.Reset();
-	while (iterator.MoreElements()) {
-		tmpType = iterator.GetData()->Type();
-		if (tmpType == Write || tmpType == Both) {
-			ret = iterator.GetData();
-			iterator.RemoveCurrent(false);
-			break;
-		}
-		iterator.Advance();
-	}
+	BusyKeys.erase(iKey);
+	bool more = (InList.Count() != 0);
 	MInList.unlock();
-	return ret;
+	CKeyReleased.Post();
+	//whatever was waiting on this key can go now
+	if (more)
+		CInList.SignalAll();
 }
 
 void DBAsync::AddFQ(DBAsyncFinishedQueue* iDBAFQ) {
@@ -214,19 +317,21 @@ void DBAsync::AddFQ(DBAsyncFinishedQueue* iDBAFQ) {
 	MFQList.unlock();
 }
 
-void DBAsync::Process() {
+void DBAsync::Process(Worker* iWorker) {
 	DBAsyncWork* tmpWork;
-	MCurrentWork.lock();
-	while ((CurrentWork = InListPop())) {
+	while ((tmpWork = InListPop())) {
+		//the work can be gone once it's dispatched, and its key stays busy until then
+		uint32 key = tmpWork->pKey;
+		MCurrentWork.lock();
+		iWorker->CurrentWork = tmpWork;
 		MCurrentWork.unlock();
 		//move from queued to executing
-		Status tmpStatus = CurrentWork->SetStatus(Executing);
+		Status tmpStatus = tmpWork->SetStatus(Executing);
 		if (tmpStatus == Queued) {
 			//execute the work
-			ProcessWork(CurrentWork);
-			tmpWork = CurrentWork;
+			ProcessWork(tmpWork, iWorker->dbc);
 			MCurrentWork.lock();
-			CurrentWork = 0;
+			iWorker->CurrentWork = 0;
 			MCurrentWork.unlock();
 			//move from executing to finished
 			tmpStatus = tmpWork->SetStatus(DBAsync::Finished);
@@ -234,14 +339,14 @@ void DBAsync::Process() {
 				if (tmpStatus != Canceled) {
 					std::cout << "Error: Unexpected DBAsyncWork->Status in DBAsync::Process #1" << std::endl;
 				}
-				MCurrentWork.lock();
 				safe_delete(tmpWork);
+				ReleaseKey(key);
 			}
 			else {
 				//call callbacks or put results on finished queue
 				DispatchWork(tmpWork);
+				ReleaseKey(key);
 				Sleep(25);
-				MCurrentWork.lock();
 			}
 		}
 		else {
@@ -249,10 +354,12 @@ void DBAsync::Process() {
 				std::cout << "Error: Unexpected DBAsyncWork->Status in DBAsync::Process #2" << std::endl;
 			}
 			MCurrentWork.lock();
-			safe_delete(CurrentWork);
+			iWorker->CurrentWork = 0;
+			MCurrentWork.unlock();
+			safe_delete(tmpWork);
+			ReleaseKey(key);
 		}
 	}
-	MCurrentWork.unlock();
 }
 
 void DBAsync::CheckTimeout() {
@@ -272,15 +379,37 @@ void DBAsync::CheckTimeout() {
 	}
 }
 
+// Runs every queued write on the calling thread, using the main connection.
+// Writes whose key is executing on a worker are waited for, so order still holds.
 void DBAsync::CommitWrites() {
 #if DEBUG_MYSQL_QUERIES >= 2
 	std::cout << "DBAsync::CommitWrites() called." << std::endl;
 #endif
 	DBAsyncWork* tmpWork;
-	while ((tmpWork = InListPopWrite())) {
+	while (true) {
+		tmpWork = InListPop(true);
+		if (!tmpWork) {
+			MInList.lock();
+			bool waiting = false;
+			LinkedListIterator<DBAsyncWork*> iterator(InList);
+			iterator.Reset();
+			while (iterator.MoreElements()) {
+				if (iterator.GetData()->Type() != Read) {
+					waiting = true;
+					break;
+				}
+				iterator.Advance();
+			}
+			MInList.unlock();
+			if (!waiting)
+				break;
+			Sleep(1);
+			continue;
+		}
+		uint32 key = tmpWork->pKey;
 		Status tmpStatus = tmpWork->SetStatus(Executing);
 		if (tmpStatus == Queued) {
-			ProcessWork(tmpWork);
+			ProcessWork(tmpWork, pDBC, false);
 			tmpStatus = tmpWork->SetStatus(DBAsync::Finished);
 			if (tmpStatus != Executing) {
 				if (tmpStatus != Canceled) {
@@ -291,28 +420,41 @@ void DBAsync::CommitWrites() {
 			else {
 				DispatchWork(tmpWork);
 			}
+			ReleaseKey(key);
 		}
 		else {
 			if (tmpStatus != Canceled) {
 				std::cout << "Error: Unexpected DBAsyncWork->Status in DBAsync::CommitWrites #2" << std::endl;
 			}
 			safe_delete(tmpWork);
+			ReleaseKey(key);
 		}
 	}
 }
 
-void DBAsync::ProcessWork(DBAsyncWork* iWork, bool iSleep) {
+void DBAsync::ProcessWork(DBAsyncWork* iWork, DBcore* iDBC, bool iSleep) {
 	_CP(DBAsync_ProcessWork);
 	DBAsyncQuery* CurrentQuery;
 #if DEBUG_MYSQL_QUERIES >= 2
 	std::cout << "Processing AsyncWork #" << iWork->GetWorkID() << std::endl;
 #endif
+	uint32 queries = 0;
 	while ((CurrentQuery = iWork->PopQuery())) {
-		CurrentQuery->Process(pDBC);
+		uint64 start = Timer::GetTimeMicroseconds();
+		CurrentQuery->Process(iDBC);
+		uint64 elapsed = Timer::GetTimeMicroseconds() - start;
+		MStats.lock();
+		pStats.query_us.Add(elapsed);
+		MStats.unlock();
+		queries++;
 		iWork->PushAnswer(CurrentQuery);
 		if (iSleep)
 			Sleep(1);
 	}
+	MStats.lock();
+	pStats.works++;
+	pStats.queries += queries;
+	MStats.unlock();
 }
 
 void DBAsync::DispatchWork(DBAsyncWork* iWork) {
@@ -329,10 +471,59 @@ void DBAsync::DispatchWork(DBAsyncWork* iWork) {
 	}
 }
 
+void DBAsync::GetStats(Stats& oStats) {
+	MInList.lock();
+	uint32 queued = InList.Count();
+	MInList.unlock();
+	LockMutex lock(&MStats);
+	oStats = pStats;
+	oStats.queued = queued;
+}
+
+void DBAsync::ResetStats() {
+	LockMutex lock(&MStats);
+	pStats.works = 0;
+	pStats.queries = 0;
+	pStats.depth.Clear();
+	pStats.wait_us.Clear();
+	pStats.query_us.Clear();
+}
+
+void DBAsync::DescribeStats(std::vector<std::string>& oLines) {
+	Stats stats;
+	GetStats(stats);
+	char buf[256];
+	snprintf(buf, sizeof(buf), "DBAsync: %u workers, %u queued, %llu works and %llu queries run",
+		stats.workers, stats.queued, (unsigned long long)stats.works, (unsigned long long)stats.queries);
+	oLines.push_back(buf);
+
+	uint32 own = 0;
+	MCurrentWork.lock();
+	for (size_t i = 0; i < Workers.size(); i++) {
+		if (Workers[i]->own_dbc)
+			own++;
+	}
+	MCurrentWork.unlock();
+	snprintf(buf, sizeof(buf), "  connections: %u of %u workers have their own", own, stats.workers);
+	oLines.push_back(buf);
+
+	char summary[200];
+	stats.depth.Summary(summary, sizeof(summary));
+	snprintf(buf, sizeof(buf), "  queue depth: %s", summary);
+	oLines.push_back(buf);
+	stats.wait_us.Summary(summary, sizeof(summary));
+	snprintf(buf, sizeof(buf), "  wait (us): %s", summary);
+	oLines.push_back(buf);
+	stats.query_us.Summary(summary, sizeof(summary));
+	snprintf(buf, sizeof(buf), "  query (us): %s", summary);
+	oLines.push_back(buf);
+}
+
 
 
 DBAsyncFinishedQueue::DBAsyncFinishedQueue(uint32 iTimeout) {
 	pTimeout = iTimeout;
+	pWake = 0;
 }
 
 DBAsyncFinishedQueue::~DBAsyncFinishedQueue() {
@@ -403,6 +594,8 @@ bool DBAsyncFinishedQueue::Push(DBAsyncWork* iDBAW) {
 	MLock.lock();
 	list.Append(iDBAW);
 	MLock.unlock();
+	if (pWake)
+		pWake->Post();
 	return true;
 }
 
@@ -422,6 +615,8 @@ DBAsyncWork::DBAsyncWork(Database *db, DBAsyncFinishedQueue* iDBAFQ, uint32 iWPT
 	pAnswerCount = 0;
 	pTimeout = iTimeout;
 	pTSFinish = 0;
+	pKey = 0;
+	pQueuedAt = 0;
 }
 
 DBAsyncWork::DBAsyncWork(Database *db, DBWorkCompleteCallBack iCB, uint32 iWPT, DBAsync::Type iType, uint32 iTimeout)
@@ -438,6 +633,8 @@ DBAsyncWork::DBAsyncWork(Database *db, DBWorkCompleteCallBack iCB, uint32 iWPT,
 	pAnswerCount = 0;
 	pTimeout = iTimeout;
 	pTSFinish = 0;
+	pKey = 0;
+	pQueuedAt = 0;
 }
 
 DBAsyncWork::~DBAsyncWork() {
@@ -476,6 +673,16 @@ bool DBAsyncWork::AddQuery(uint32 iQPT, char** iQuery, uint32 iQueryLen, bool iG
 	}
 }
 
+bool DBAsyncWork::AddQuery(uint32 iQPT, char** iQuery, uint32 iQueryLen, DBParams** iParams, bool iGetErrbuf) {
+	DBAsyncQuery* DBAQ = new DBAsyncQuery(iQPT, iQuery, iQueryLen, iParams, iGetErrbuf);
+	if (AddQuery(&DBAQ))
+		return true;
+	else {
+		safe_delete(DBAQ);
+		return false;
+	}
+}
+
 bool DBAsyncWork::SetWorkID(uint32 iWorkID) {
 	bool ret = true;
 	MLock.lock();
@@ -606,11 +813,24 @@ DBAsyncQuery::DBAsyncQuery(uint32 iQPT, const char* iQuery, uint32 iQueryLen, bo
 	Init(iQPT, iGetResultSet, iGetErrbuf);
 }
 
+DBAsyncQuery::DBAsyncQuery(uint32 iQPT, char** iQuery, uint32 iQueryLen, DBParams** iParams, bool iGetErrbuf) {
+	if (iQueryLen == 0xFFFFFFFF)
+		pQueryLen = strlen(*iQuery);
+	else
+		pQueryLen = iQueryLen;
+	pQuery = *iQuery;
+	*iQuery = 0;
+	Init(iQPT, false, iGetErrbuf);
+	pParams = *iParams;
+	*iParams = 0;
+}
+
 void DBAsyncQuery::Init(uint32 iQPT, bool iGetResultSet, bool iGetErrbuf) {
 	pstatus = DBAsync::AddingWork;
 	pQPT = iQPT;
 	pGetResultSet = iGetResultSet;
 	pGetErrbuf = iGetErrbuf;
+	pParams = 0;
 
 	pmysqlsuccess = false;
 	perrbuf = 0;
@@ -623,6 +843,7 @@ void DBAsyncQuery::Init(uint32 iQPT, bool iGetResultSet, bool iGetErrbuf) {
 DBAsyncQuery::~DBAsyncQuery() {
 	safe_delete_array(perrbuf);
 	safe_delete_array(pQuery);
+	safe_delete(pParams);
 	if (presult)
 		mysql_free_result(presult);
 }
@@ -663,7 +884,10 @@ void DBAsyncQuery::Process(DBcore* iDBC) {
 	MYSQL_RES** resultPP = 0;
 	if (pGetResultSet)
 		resultPP = &presult;
-	pmysqlsuccess = iDBC->RunQuery(pQuery, pQueryLen, perrbuf, resultPP, &paffected_rows, &plast_insert_id, &perrnum);
+	if (pParams)
+		pmysqlsuccess = iDBC->RunPreparedQuery(pQuery, pQueryLen, *pParams, perrbuf, &paffected_rows, &perrnum);
+	else
+		pmysqlsuccess = iDBC->RunQuery(pQuery, pQueryLen, perrbuf, resultPP, &paffected_rows, &plast_insert_id, &perrnum);
 	pstatus = DBAsync::Finished;
 }
 
@@ -2,7 +2,13 @@
 #define DBASYNC_H
 #include "../common/dbcore.h"
 #include "../common/timeoutmgr.h"
+#include "../common/histogram.h"
+#include <set>
+#include <vector>
+#include <string>
 
+//how long the zone's main thread waits on a busy key, about one zone frame
+#define DBASYNC_KEY_WAIT_MS 30
 
 class DBAsyncFinishedQueue;
 class DBAsyncWork;
@@ -10,37 +16,73 @@ class DBAsyncQuery;
 class Database;
 
 // Big daddy that owns the threads and does the work
+//
+// Work is run by a pool of worker threads, each on its own connection. Work
+// that shares a key never runs on two workers at once, and work with the
+// same key runs in the order it was added once it is due. Delayed work that
+// isn't due yet doesn't hold up the work behind it, so anything that has to
+// land after it cancels it first, like Client::Save does. A key stays busy
+// until the work's callback has returned. Work added without a key
+// shares key 0, so it still runs one at a time, in order, like it did when
+// there was only one thread.
 class DBAsync : private Timeoutable {
 public:
 	enum Status { AddingWork, Queued, Executing, Finished, Canceled };
 	enum Type { Read, Write, Both };
 
-	DBAsync(DBcore* iDBC);
+	DBAsync(DBcore* iDBC, uint32 iWorkers = 1);
 	~DBAsync();
 	bool	StopThread();
+	// Starts more workers until there are iWorkers, returns how many are running
+	uint32	StartWorkers(uint32 iWorkers);
+	uint32	GetWorkerCount();
 
-	uint32	AddWork(DBAsyncWork** iWork, uint32 iDelay = 0);
+	uint32	AddWork(DBAsyncWork** iWork, uint32 iDelay = 0, uint32 iKey = 0);
 	bool	CancelWork(uint32 iWorkID);
+	// Waits until no work with iKey is executing, false if it timed out.
+	// Only one thread may wait at a time.
+	bool	WaitForKey(uint32 iKey, uint32 iTimeoutMS = DBASYNC_KEY_WAIT_MS);
 	void	CommitWrites();
 
 	void	AddFQ(DBAsyncFinishedQueue* iDBAFQ);
+
+	struct Stats {
+		uint32 workers;
+		uint32 queued;			// work waiting right now
+		uint64 works;			// work run since the last reset
+		uint64 queries;
+		LogHistogram depth;		// queue depth seen by each AddWork
+		LogHistogram wait_us;	// time from due to picked up by a worker
+		LogHistogram query_us;	// time spent in each query
+	};
+	void	GetStats(Stats& oStats);
+	void	ResetStats();
+	// One line per stat, for the GM command and the world console
+	void	DescribeStats(std::vector<std::string>& oLines);
 protected:
-	//things related to the processing thread:
+	//things related to the processing threads:
+	struct Worker {
+		DBAsync*	owner;
+		uint32		index;
+		DBcore*		dbc;
+		bool		own_dbc;		// false if it had to fall back to the shared connection
+		Mutex		MLoopRunning;	// held by the thread while its loop runs
+		bool		started;		// guarded by MRunLoop
+		DBAsyncWork* CurrentWork;	// guarded by MCurrentWork
+	};
 	friend ThreadReturnType DBAsyncLoop(void* tmp);
-	Mutex	MLoopRunning;
 	Condition CInList;
 	bool	RunLoop();
-	void	Process();
+	void	Process(Worker* iWorker);
 
 private:
 	virtual void CheckTimeout();
 
-	void	ProcessWork(DBAsyncWork* iWork, bool iSleep = true);
+	void	ProcessWork(DBAsyncWork* iWork, DBcore* iDBC, bool iSleep = true);
 	void	DispatchWork(DBAsyncWork* iWork);
 	inline	uint32	GetNextID()		{ return pNextID++; }
-	DBAsyncWork*	InListPop();
-	DBAsyncWork*	InListPopWrite();	// Ignores delay
-	void			OutListPush(DBAsyncWork* iDBAW);
+	DBAsyncWork*	InListPop(bool iWritesOnly = false);	// Writes only ignores delay
+	void			ReleaseKey(uint32 iKey);	// after the work's callback has returned
 
 	Mutex	MRunLoop;
 	bool	pRunLoop;
@@ -49,17 +91,21 @@ private:
 	uint32	pNextID;
 	Mutex	MInList;
 	LinkedList<DBAsyncWork*> InList;
+	std::set<uint32> BusyKeys;	// keys with work executing, guarded by MInList
+	Condition CKeyReleased;		// posted by ReleaseKey for WaitForKey
 
 	Mutex	MFQList;
 	LinkedList<DBAsyncFinishedQueue**> FQList;
 
-	// Mutex for outside access to current work & when current work is being changed.
-	// NOT locked when CurrentWork is being accessed by the DBAsync thread.
+	// Mutex for outside access to the workers' current work & when current work is being changed.
+	// NOT locked when CurrentWork is being accessed by its own worker.
 	// Never change pointer from outside DBAsync thread!
 	// Only here for access to thread-safe DBAsyncWork functions.
 	Mutex	MCurrentWork;
-	DBAsyncWork* CurrentWork;
+	std::vector<Worker*> Workers;
 
+	Mutex	MStats;
+	Stats	pStats;
 };
 
 /*
@@ -80,11 +126,14 @@ public:
 	DBAsyncWork*	PopByWPT(uint32 iWPT);
 	DBAsyncWork*	Find(uint32 iWPT);
 	bool			Push(DBAsyncWork* iDBAW);
+	// Posted after each Push, so the thread that pops can sleep until then
+	void			SetWake(Condition* iWake) { pWake = iWake; }
 
 	void			CheckTimeouts();
 private:
 	Mutex MLock;
 	uint32 pTimeout;
+	Condition* pWake;
 	LinkedList<DBAsyncWork*> list;
 };
 
@@ -97,6 +146,8 @@ public:
 
 	bool			AddQuery(DBAsyncQuery** iDBAQ);
 	bool			AddQuery(uint32 iQPT, char** iQuery, uint32 iQueryLen = 0xFFFFFFFF, bool iGetResultSet = true, bool iGetErrbuf = true);
+	// Prepared statement write, takes ownership of iQuery and iParams
+	bool			AddQuery(uint32 iQPT, char** iQuery, uint32 iQueryLen, DBParams** iParams, bool iGetErrbuf = true);
 	uint32			WPT();
 	DBAsync::Type	Type();
 
@@ -119,6 +170,8 @@ protected:
 
 	// not mutex'd cause only to be accessed from dbasync class
 	uint32	pExecuteAfter;
+	uint32	pKey;
+	uint64	pQueuedAt;		// microseconds, when it was added or became due
 private:
 	Mutex	MLock;
 	uint32	pQuestionCount;
@@ -142,6 +195,7 @@ class DBAsyncQuery {
 public:
 	DBAsyncQuery(uint32 iQPT, char** iQuery, uint32 iQueryLen = 0xFFFFFFFF, bool iGetResultSet = true, bool iGetErrbuf = true);
 	DBAsyncQuery(uint32 iQPT, const char* iQuery, uint32 iQueryLen = 0xFFFFFFFF, bool iGetResultSet = true, bool iGetErrbuf = true);
+	DBAsyncQuery(uint32 iQPT, char** iQuery, uint32 iQueryLen, DBParams** iParams, bool iGetErrbuf = true);
 	~DBAsyncQuery();
 
 	bool	GetAnswer(char* errbuf = 0, MYSQL_RES** result = 0, uint32* affected_rows = 0, uint32* last_insert_id = 0, uint32* errnum = 0);
@@ -159,6 +213,7 @@ protected:
 	uint32		pQueryLen;
 	bool		pGetResultSet;
 	bool		pGetErrbuf;
+	DBParams*	pParams;	// run as a prepared statement when set
 
 	bool		pmysqlsuccess;
 	char*		perrbuf;
@@ -11,6 +11,7 @@
 #include "dbcore.h"
 #include <string.h>
 #include "../common/MiscFunctions.h"
+#include "../common/StringUtil.h"
 #include <cstdlib>
 
 #ifdef _WINDOWS
@@ -41,6 +42,7 @@ DBcore::DBcore() {
 }
 
 DBcore::~DBcore() {
+	FreeStatements();
 	mysql_close(&mysql);
 	safe_delete_array(pHost);
 	safe_delete_array(pUser);
@@ -152,6 +154,312 @@ bool DBcore::RunQuery(const char* query, uint32 querylen, char* errbuf, MYSQL_RE
 	return ret;
 }
 
+void DBParams::AddInt(int32 value) {
+	Param p;
+	p.type = MYSQL_TYPE_LONG;
+	p.is_unsigned = false;
+	p.num.i = value;
+	params.push_back(p);
+}
+
+void DBParams::AddUInt(uint32 value) {
+	Param p;
+	p.type = MYSQL_TYPE_LONG;
+	p.is_unsigned = true;
+	p.num.u = value;
+	params.push_back(p);
+}
+
+void DBParams::AddFloat(float value) {
+	Param p;
+	p.type = MYSQL_TYPE_FLOAT;
+	p.is_unsigned = false;
+	p.num.f = value;
+	params.push_back(p);
+}
+
+void DBParams::AddString(const char* value) {
+	Param p;
+	p.type = MYSQL_TYPE_STRING;
+	p.is_unsigned = false;
+	p.num.u = 0;
+	if (value)
+		p.data = value;
+	params.push_back(p);
+}
+
+void DBParams::AddBlob(const void* data, uint32 len) {
+	Param p;
+	p.type = MYSQL_TYPE_BLOB;
+	p.is_unsigned = false;
+	p.num.u = 0;
+	p.data.assign((const char*) data, len);
+	params.push_back(p);
+}
+
+uint32 DBParams::DataSize() const {
+	uint32 ret = 0;
+	for (size_t i = 0; i < params.size(); i++) {
+		if (params[i].type == MYSQL_TYPE_STRING || params[i].type == MYSQL_TYPE_BLOB)
+			ret += params[i].data.size();
+		else
+			ret += sizeof(params[i].num);
+	}
+	return ret;
+}
+
+int64 DBResultSet::GetInt64(uint32 row, uint32 col) const {
+	const Field& f = Get(row, col);
+	if (f.is_null)
+		return 0;
+	if (f.kind == KindInt)
+		return f.num.i;
+	if (f.kind == KindFloat)
+		return (int64) f.num.d;
+	return strtoll(data.c_str() + f.offset, 0, 10);
+}
+
+float DBResultSet::GetFloat(uint32 row, uint32 col) const {
+	const Field& f = Get(row, col);
+	if (f.is_null)
+		return 0.0f;
+	if (f.kind == KindFloat)
+		return (float) f.num.d;
+	if (f.kind == KindInt)
+		return (float) f.num.i;
+	return (float) atof(data.c_str() + f.offset);
+}
+
+const char* DBResultSet::GetString(uint32 row, uint32 col) const {
+	const Field& f = Get(row, col);
+	if (f.is_null || f.kind != KindBytes)
+		return "";
+	return data.c_str() + f.offset;
+}
+
+void DBResultSet::Clear() {
+	fields.clear();
+	data.clear();
+	rows = 0;
+	cols = 0;
+}
+
+bool DBcore::RunPreparedQuery(const char* query, uint32 querylen, const DBParams& params, char* errbuf, uint32* affected_rows, uint32* errnum, bool retry) {
+	return ExecutePrepared(query, querylen, params, 0, affected_rows, errbuf, errnum, retry);
+}
+
+bool DBcore::RunPreparedQuery(const char* query, uint32 querylen, const DBParams& params, DBResultSet& result, char* errbuf, uint32* errnum, bool retry) {
+	return ExecutePrepared(query, querylen, params, &result, 0, errbuf, errnum, retry);
+}
+
+// Every statement stays prepared in pStatements until the connection drops or the
+// cache fills. Delta saves have at most a hundred shapes (one per count of changed
+// ranges in each blob), so they hit the cache like the fixed reads do.
+bool DBcore::ExecutePrepared(const char* query, uint32 querylen, const DBParams& params, DBResultSet* result, uint32* affected_rows, char* errbuf, uint32* errnum, bool retry) {
+	_CP(DBcore_RunQuery);
+	if (errnum)
+		*errnum = 0;
+	if (errbuf)
+		errbuf[0] = 0;
+	if (result)
+		result->Clear();
+	LockMutex lock(&MDatabase);
+	if (pStatus != Connected)
+		Open();
+
+	bool ret = false;
+	uint32 err = 0;
+	char errmsg[MYSQL_ERRMSG_SIZE];
+	errmsg[0] = 0;
+
+	MYSQL_STMT* stmt = 0;
+	std::string key(query, querylen);
+	std::map<std::string, MYSQL_STMT*>::iterator it = pStatements.find(key);
+	if (it != pStatements.end())
+		stmt = it->second;
+	if (!stmt) {
+		stmt = mysql_stmt_init(&mysql);
+		if (!stmt) {
+			err = mysql_errno(&mysql);
+			strn0cpy(errmsg, mysql_error(&mysql), sizeof(errmsg));
+		}
+		else if (mysql_stmt_prepare(stmt, query, querylen) != 0) {
+			err = mysql_stmt_errno(stmt);
+			strn0cpy(errmsg, mysql_stmt_error(stmt), sizeof(errmsg));
+			mysql_stmt_close(stmt);
+			stmt = 0;
+		}
+		else {
+			my_bool update_max = 1;
+			mysql_stmt_attr_set(stmt, STMT_ATTR_UPDATE_MAX_LENGTH, &update_max);
+			if (pStatements.size() >= DBCORE_STATEMENT_CACHE)
+				FreeStatements();
+			pStatements[key] = stmt;
+		}
+	}
+
+	if (stmt) {
+		uint32 count = params.Count();
+		std::vector<MYSQL_BIND> binds(count ? count : 1);
+		std::vector<unsigned long> lengths(count ? count : 1);
+		memset(&binds[0], 0, sizeof(MYSQL_BIND) * binds.size());
+		for (uint32 i = 0; i < count; i++) {
+			const DBParams::Param& p = params.params[i];
+			binds[i].buffer_type = p.type;
+			binds[i].is_unsigned = p.is_unsigned;
+			if (p.type == MYSQL_TYPE_STRING || p.type == MYSQL_TYPE_BLOB) {
+				lengths[i] = p.data.size();
+				binds[i].buffer = (void*) p.data.data();
+				binds[i].buffer_length = lengths[i];
+				binds[i].length = &lengths[i];
+			}
+			else {
+				binds[i].buffer = (void*) &p.num;
+			}
+		}
+
+		if (mysql_stmt_param_count(stmt) == count
+			&& (count == 0 || !mysql_stmt_bind_param(stmt, &binds[0]))
+			&& mysql_stmt_execute(stmt) == 0
+			&& (!result || FetchResult(stmt, *result))) {
+			if (affected_rows)
+				*affected_rows = (uint32) mysql_stmt_affected_rows(stmt);
+			ret = true;
+		}
+		else {
+			err = mysql_stmt_errno(stmt);
+			if (err)
+				strn0cpy(errmsg, mysql_stmt_error(stmt), sizeof(errmsg));
+			else
+				strcpy(errmsg, "Parameter count does not match the query");
+		}
+
+		if (!ret) {
+			// don't keep a statement around that may be the cause
+			pStatements.erase(key);
+			mysql_stmt_close(stmt);
+		}
+	}
+
+	if (!ret) {
+		if (result)
+			result->Clear();
+		if (err == CR_SERVER_LOST || err == CR_SERVER_GONE_ERROR) {
+			pStatus = Error;
+			if (retry) {
+				std::cout << "Database Error: Lost connection, attempting to recover...." << std::endl;
+				ret = ExecutePrepared(query, querylen, params, result, affected_rows, errbuf, errnum, false);
+				if (ret)
+					std::cout << "Reconnection to database successful." << std::endl;
+				return ret;
+			}
+		}
+		if (errnum)
+			*errnum = err;
+		if (errbuf)
+			snprintf(errbuf, MYSQL_ERRMSG_SIZE, "#%i: %s", err, errmsg);
+#ifdef _EQDEBUG
+		std::cout << "DB Prepared Query Error #" << err << ": " << errmsg << std::endl;
+#endif
+	}
+	return ret;
+}
+
+bool DBcore::FetchResult(MYSQL_STMT* stmt, DBResultSet& result) {
+	MYSQL_RES* meta = mysql_stmt_result_metadata(stmt);
+	if (!meta)
+		return true;	// not a SELECT
+
+	bool ret = false;
+	if (mysql_stmt_store_result(stmt) == 0) {
+		uint32 cols = mysql_num_fields(meta);
+		MYSQL_FIELD* fields = mysql_fetch_fields(meta);
+
+		// one scratch buffer per text column, sized by the longest value in the result
+		std::vector<MYSQL_BIND> binds(cols ? cols : 1);
+		std::vector<DBResultSet::Field> row(cols ? cols : 1);
+		std::vector<my_bool> nulls(cols ? cols : 1);
+		std::vector<unsigned long> lengths(cols ? cols : 1);
+		std::vector<std::string> scratch(cols ? cols : 1);
+		memset(&binds[0], 0, sizeof(MYSQL_BIND) * binds.size());
+		for (uint32 c = 0; c < cols; c++) {
+			DBResultSet::Field& f = row[c];
+			memset(&f, 0, sizeof(f));
+			binds[c].is_null = &nulls[c];
+			binds[c].length = &lengths[c];
+			switch (fields[c].type) {
+			case MYSQL_TYPE_TINY:
+			case MYSQL_TYPE_SHORT:
+			case MYSQL_TYPE_INT24:
+			case MYSQL_TYPE_LONG:
+			case MYSQL_TYPE_LONGLONG:
+			case MYSQL_TYPE_YEAR:
+				f.kind = DBResultSet::KindInt;
+				binds[c].buffer_type = MYSQL_TYPE_LONGLONG;
+				binds[c].is_unsigned = (fields[c].flags & UNSIGNED_FLAG) ? 1 : 0;
+				binds[c].buffer = &f.num.i;
+				break;
+			case MYSQL_TYPE_FLOAT:
+			case MYSQL_TYPE_DOUBLE:
+				f.kind = DBResultSet::KindFloat;
+				binds[c].buffer_type = MYSQL_TYPE_DOUBLE;
+				binds[c].buffer = &f.num.d;
+				break;
+			default:
+				f.kind = DBResultSet::KindBytes;
+				scratch[c].resize(fields[c].max_length + 1);
+				binds[c].buffer_type = (fields[c].flags & BINARY_FLAG) ? MYSQL_TYPE_BLOB : MYSQL_TYPE_STRING;
+				binds[c].buffer = &scratch[c][0];
+				binds[c].buffer_length = scratch[c].size();
+				break;
+			}
+		}
+
+		if (cols == 0 || !mysql_stmt_bind_result(stmt, &binds[0])) {
+			result.cols = cols;
+			result.fields.reserve((size_t) mysql_stmt_num_rows(stmt) * cols);
+			int rc;
+			while ((rc = mysql_stmt_fetch(stmt)) == 0 || rc == MYSQL_DATA_TRUNCATED) {
+				for (uint32 c = 0; c < cols; c++) {
+					DBResultSet::Field f = row[c];
+					f.is_null = nulls[c] != 0;
+					if (f.kind == DBResultSet::KindBytes) {
+						f.offset = result.data.size();
+						f.length = f.is_null ? 0 : (uint32) lengths[c];
+						if (f.length > scratch[c].size()) {
+							// longer than max_length said, pull the column on its own
+							std::string big(f.length, '\0');
+							MYSQL_BIND b = binds[c];
+							b.buffer = &big[0];
+							b.buffer_length = big.size();
+							mysql_stmt_fetch_column(stmt, &b, c, 0);
+							result.data.append(big);
+						}
+						else {
+							result.data.append(scratch[c].data(), f.length);
+						}
+						result.data.push_back('\0');
+					}
+					result.fields.push_back(f);
+				}
+				result.rows++;
+			}
+			ret = (rc == MYSQL_NO_DATA);
+		}
+		mysql_stmt_free_result(stmt);
+	}
+	mysql_free_result(meta);
+	return ret;
+}
+
+void DBcore::FreeStatements() {
+	LockMutex lock(&MDatabase);
+	std::map<std::string, MYSQL_STMT*>::iterator it;
+	for (it = pStatements.begin(); it != pStatements.end(); ++it)
+		mysql_stmt_close(it->second);
+	pStatements.clear();
+}
+
 uint32 DBcore::DoEscapeString(char* tobuf, const char* frombuf, uint32 fromlen) {
 //	No good reason to lock the DB, we only need it in the first place to check char encoding.
 //	LockMutex lock(&MDatabase);
@@ -174,6 +482,16 @@ bool DBcore::Open(const char* iHost, const char* iUser, const char* iPassword, c
 	return Open(errnum, errbuf);
 }
 
+bool DBcore::OpenLike(DBcore& other, uint32* errnum, char* errbuf) {
+	LockMutex lock(&other.MDatabase);
+	if (!other.pHost) {
+		if (errbuf)
+			snprintf(errbuf, MYSQL_ERRMSG_SIZE, "No connection settings to copy");
+		return false;
+	}
+	return Open(other.pHost, other.pUser, other.pPassword, other.pDatabase, other.pPort, errnum, errbuf, other.pCompress, other.pSSL);
+}
+
 bool DBcore::Open(uint32* errnum, char* errbuf) {
 	if (errbuf)
 		errbuf[0] = 0;
@@ -181,6 +499,7 @@ bool DBcore::Open(uint32* errnum, char* errbuf) {
 	if (GetStatus() == Connected)
 		return true;
 	if (GetStatus() == Error) {
+		FreeStatements();	// prepared on the old connection
 		mysql_close(&mysql);
 		mysql_init(&mysql);		// Initialize structure again
 	}
@@ -13,6 +13,79 @@
 #include "../common/queue.h"
 #include "../common/timer.h"
 #include "../common/Condition.h"
+#include <string>
+#include <vector>
+#include <map>
+
+// Prepared statements kept open per connection, past this the cache starts over
+#define DBCORE_STATEMENT_CACHE	256
+
+// Parameters for DBcore::RunPreparedQuery, bound in order to the ?s in the query.
+// Values are copied in, so a set can be built on one thread and run on another.
+class DBParams {
+public:
+	void	AddInt(int32 value);
+	void	AddUInt(uint32 value);
+	void	AddFloat(float value);
+	void	AddString(const char* value);
+	void	AddBlob(const void* data, uint32 len);
+
+	uint32	Count() const { return params.size(); }
+	uint32	DataSize() const;	// bytes sent for the parameters
+private:
+	friend class DBcore;
+	struct Param {
+		enum_field_types type;
+		bool is_unsigned;
+		union {
+			int32 i;
+			uint32 u;
+			float f;
+		} num;
+		std::string data;
+	};
+	std::vector<Param> params;
+};
+
+// Rows from a prepared SELECT. Integer and floating point columns come back as
+// binary values and everything else as bytes, so nothing is formatted or parsed
+// on either end. Columns are addressed by position, like a MYSQL_ROW.
+class DBResultSet {
+public:
+	DBResultSet() : rows(0), cols(0) { }
+
+	uint32	RowCount() const { return rows; }
+	uint32	FieldCount() const { return cols; }
+	bool	IsNull(uint32 row, uint32 col) const { return Get(row, col).is_null; }
+	// Text columns (DECIMAL and the like) are converted, NULL reads as 0
+	int32	GetInt(uint32 row, uint32 col) const { return (int32) GetInt64(row, col); }
+	uint32	GetUInt(uint32 row, uint32 col) const { return (uint32) GetInt64(row, col); }
+	int64	GetInt64(uint32 row, uint32 col) const;
+	float	GetFloat(uint32 row, uint32 col) const;
+	// Null terminated bytes of a text or blob column, "" for NULL and numeric columns
+	const char*	GetString(uint32 row, uint32 col) const;
+	uint32	GetLength(uint32 row, uint32 col) const { return Get(row, col).length; }
+	void	Clear();
+private:
+	friend class DBcore;
+	enum Kind { KindInt, KindFloat, KindBytes };
+	struct Field {
+		uint8 kind;
+		bool is_null;
+		uint32 offset;	// into data, for KindBytes
+		uint32 length;
+		union {
+			int64 i;
+			double d;
+		} num;
+	};
+	const Field& Get(uint32 row, uint32 col) const { return fields[row * cols + col]; }
+
+	std::vector<Field> fields;	// row major
+	std::string data;
+	uint32 rows;
+	uint32 cols;
+};
 
 class DBcore {
 public:
@@ -22,14 +95,24 @@ public:
 	~DBcore();
 	eStatus	GetStatus() { return pStatus; }
 	bool	RunQuery(const char* query, uint32 querylen, char* errbuf = 0, MYSQL_RES** result = 0, uint32* affected_rows = 0, uint32* last_insert_id = 0, uint32* errnum = 0, bool retry = true);
+	// Runs query as a prepared statement with params bound as binary, so blobs go over unescaped.
+	// Statements stay prepared on this connection, so the query text should come from a small set.
+	bool	RunPreparedQuery(const char* query, uint32 querylen, const DBParams& params, char* errbuf = 0, uint32* affected_rows = 0, uint32* errnum = 0, bool retry = true);
+	// Runs a SELECT as a prepared statement and fetches its rows in binary
+	bool	RunPreparedQuery(const char* query, uint32 querylen, const DBParams& params, DBResultSet& result, char* errbuf = 0, uint32* errnum = 0, bool retry = true);
 	uint32	DoEscapeString(char* tobuf, const char* frombuf, uint32 fromlen);
 	void	ping();
 	MYSQL*	getMySQL(){ return &mysql; }
+	// Opens a separate connection with the same settings as other
+	bool	OpenLike(DBcore& other, uint32* errnum = 0, char* errbuf = 0);
 
 protected:
 	bool	Open(const char* iHost, const char* iUser, const char* iPassword, const char* iDatabase, uint32 iPort, uint32* errnum = 0, char* errbuf = 0, bool iCompress = false, bool iSSL = false);
 private:
 	bool	Open(uint32* errnum = 0, char* errbuf = 0);
+	bool	ExecutePrepared(const char* query, uint32 querylen, const DBParams& params, DBResultSet* result, uint32* affected_rows, char* errbuf, uint32* errnum, bool retry);
+	bool	FetchResult(MYSQL_STMT* stmt, DBResultSet& result);
+	void	FreeStatements();
 
 	MYSQL	mysql;
 	Mutex	MDatabase;
@@ -43,6 +126,7 @@ private:
 	uint32	pPort;
 	bool	pSSL;
 
+	std::map<std::string, MYSQL_STMT*> pStatements;
 };
 
 
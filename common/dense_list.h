@@ -0,0 +1,144 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemu.org)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#ifndef DENSELIST_H
+#define DENSELIST_H
+
+#include "types.h"
+#include <vector>
+#include <algorithm>
+
+/*
+	Drop-in replacement for LinkedList<TYPE*> that keeps its pointers in one
+	contiguous array, so walking it every tick doesn't chase a node per
+	element. The iterator has the same interface as LinkedListIterator.
+
+	Walks see the same order a LinkedList gives: Insert puts the element
+	first, so the array is kept oldest first and iterators walk it from the
+	back. Anything inserted while a walk is running lands behind the
+	iterator and isn't visited until the next walk, like LinkedList::Insert.
+	There is no Append, nothing on the entity list uses it.
+
+	Removal nulls the entry, so neither the walk doing the removal nor any
+	other one running at the same time (RemoveCurrent deletes the data, and
+	a destructor that walks the list again is common) sees an element move.
+	Nulled entries are skipped, and the array is compacted, in order, once
+	the last iterator goes away.
+*/
+
+template<class TYPE> class DenseListIterator;
+
+template<class TYPE>
+class DenseList
+{
+public:
+	DenseList() : dont_delete(false), iterators(0), holes(0) { }
+	~DenseList()
+	{
+		if(!dont_delete)
+			Clear();
+	}
+
+	void Insert(const TYPE &data) { items.push_back(data); }
+	uint32 Count() const { return(items.size() - holes); }
+
+	//deletes the data, like LinkedList::Clear
+	void Clear()
+	{
+		std::vector<TYPE> old;
+		if(iterators > 0) {
+			old = items;
+			holes = items.size();
+			std::fill(items.begin(), items.end(), TYPE(0));
+		} else {
+			old.swap(items);
+			holes = 0;
+		}
+		//the list already looks empty to anything these destructors call
+		typename std::vector<TYPE>::iterator it;
+		for(it = old.begin(); it != old.end(); ++it) {
+			TYPE d = *it;
+			safe_delete(d);
+		}
+	}
+
+	bool dont_delete;
+
+private:
+	friend class DenseListIterator<TYPE>;
+
+	void Erase(uint32 index, bool DeleteData)
+	{
+		TYPE data = items[index];
+		items[index] = TYPE(0);
+		holes++;
+		//unlinked first, the destructor may walk this list looking for it
+		if(DeleteData)
+			safe_delete(data);
+	}
+
+	void Compact()
+	{
+		items.erase(std::remove(items.begin(), items.end(), TYPE(0)), items.end());
+		holes = 0;
+	}
+
+	std::vector<TYPE> items;
+	uint32 iterators;
+	uint32 holes;
+};
+
+//pos is one past the current element, walking down to the oldest
+template<class TYPE>
+class DenseListIterator
+{
+public:
+	DenseListIterator(DenseList<TYPE> &l) : list(l), pos(0) { list.iterators++; }
+	~DenseListIterator()
+	{
+		if(--list.iterators == 0 && list.holes > 0)
+			list.Compact();
+	}
+
+	void Reset() { pos = list.items.size(); SkipHoles(); }
+	bool MoreElements() const { return(pos > 0); }
+	const TYPE &GetData() const { return(list.items[pos - 1]); }
+	void Advance()
+	{
+		if(pos > 0)
+			pos--;
+		SkipHoles();
+	}
+	//leaves the iterator on the next element, like LinkedListIterator
+	void RemoveCurrent(bool DeleteData = true)
+	{
+		list.Erase(pos - 1, DeleteData);
+		Advance();
+	}
+
+private:
+	void SkipHoles()
+	{
+		while(pos > 0 && list.items[pos - 1] == TYPE(0))
+			pos--;
+	}
+
+	DenseList<TYPE> &list;
+	uint32 pos;
+};
+
+#endif
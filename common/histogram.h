@@ -0,0 +1,111 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include "types.h"
+#include <string.h>
+#include <stdio.h>
+
+#define LOG_HISTOGRAM_BUCKETS 40
+
+/*
+	Histogram with power of two buckets: bucket 0 holds 0, bucket n holds
+	values in [2^(n-1), 2^n). Cheap enough to update on every sample, and
+	plenty of resolution for latencies and queue depths. Not thread safe,
+	the owner locks around it.
+*/
+class LogHistogram
+{
+public:
+	LogHistogram() { Clear(); }
+
+	void Clear()
+	{
+		memset(buckets, 0, sizeof(buckets));
+		count = 0;
+		sum = 0;
+		max = 0;
+	}
+
+	void Add(uint64 value)
+	{
+		uint32 b = 0;
+		uint64 v = value;
+		while(v && b < LOG_HISTOGRAM_BUCKETS - 1) {
+			v >>= 1;
+			b++;
+		}
+		buckets[b]++;
+		count++;
+		sum += value;
+		if(value > max)
+			max = value;
+	}
+
+	void Merge(const LogHistogram &other)
+	{
+		for(uint32 b = 0; b < LOG_HISTOGRAM_BUCKETS; b++)
+			buckets[b] += other.buckets[b];
+		count += other.count;
+		sum += other.sum;
+		if(other.max > max)
+			max = other.max;
+	}
+
+	uint64 Count() const { return(count); }
+	uint64 Max() const { return(max); }
+	uint64 Mean() const { return(count ? sum / count : 0); }
+
+	//upper bound of the bucket the p'th fraction of samples falls in, 0 <= p <= 1
+	uint64 Percentile(float p) const
+	{
+		if(count == 0)
+			return(0);
+		uint64 want = (uint64)(p * count);
+		if(want >= count)
+			want = count - 1;
+		uint64 seen = 0;
+		for(uint32 b = 0; b < LOG_HISTOGRAM_BUCKETS; b++) {
+			seen += buckets[b];
+			if(seen > want) {
+				uint64 upper = b == 0 ? 0 : ((uint64(1) << b) - 1);
+				return(upper < max ? upper : max);
+			}
+		}
+		return(max);
+	}
+
+	//"n=.. mean=.. p50=.. p90=.. p99=.. max=.."
+	void Summary(char *buf, uint32 len) const
+	{
+		snprintf(buf, len, "n=%llu mean=%llu p50=%llu p90=%llu p99=%llu max=%llu",
+			(unsigned long long)count, (unsigned long long)Mean(),
+			(unsigned long long)Percentile(0.5f), (unsigned long long)Percentile(0.9f),
+			(unsigned long long)Percentile(0.99f), (unsigned long long)max);
+	}
+
+private:
+	uint64 buckets[LOG_HISTOGRAM_BUCKETS];
+	uint64 count;
+	uint64 sum;
+	uint64 max;
+};
+
+#endif
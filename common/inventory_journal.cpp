@@ -0,0 +1,193 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#include "debug.h"
+#include "inventory_journal.h"
+#include "timer.h"
+#include <string.h>
+#include <stdio.h>
+
+#ifdef _WINDOWS
+	#include <windows.h>
+	#define snprintf	_snprintf
+#else
+	#include "unix.h"
+#endif
+
+InventoryJournal::InventoryJournal()
+:	pending_entries(0)
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+void InventoryJournal::Replace(uint32 char_id, const std::string &row) {
+	Append(char_id, true, row);
+}
+
+void InventoryJournal::Delete(uint32 char_id, const std::string &cond) {
+	Append(char_id, false, cond);
+}
+
+void InventoryJournal::Append(uint32 char_id, bool replace, const std::string &sql) {
+	Entry e;
+	e.replace = replace;
+	e.sql = sql;
+	LockMutex lock(&MJournal);
+	journals[char_id].pending.push_back(e);
+	pending_entries++;
+	stats.entries++;
+}
+
+void InventoryJournal::Take(uint32 char_id, std::vector<InventoryJournalBatch> &out) {
+	std::vector<Entry> entries;
+	LockMutex lock(&MJournal);
+	JournalMap::iterator it = char_id ? journals.find(char_id) : journals.begin();
+	while (it != journals.end()) {
+		if (!it->second.pending.empty()) {
+			entries.clear();
+			entries.swap(it->second.pending);
+			pending_entries -= entries.size();
+			it->second.in_flight.push_back(InFlight());
+			InFlight &flight = it->second.in_flight.back();
+			flight.entries.swap(entries);
+
+			InventoryJournalBatch batch;
+			batch.char_id = it->first;
+			out.push_back(batch);
+			BuildStatements(it->first, flight.entries, 0, INVENTORY_JOURNAL_BATCH, out.back().statements, &flight.first);
+			stats.statements += out.back().statements.size();
+			stats.batches++;
+		}
+		if (char_id)
+			break;
+		++it;
+	}
+}
+
+void InventoryJournal::BuildStatements(uint32 char_id, const std::vector<Entry> &entries, size_t from, size_t max_rows,
+	std::vector<std::string> &out, std::vector<size_t> *first)
+{
+	size_t start = from;
+	while (start < entries.size()) {
+		bool replace = entries[start].replace;
+		size_t end = start;
+		while (end < entries.size() && entries[end].replace == replace && end - start < max_rows)
+			end++;
+
+		std::string sql;
+		if (replace) {
+			sql = "REPLACE INTO inventory "
+				"(charid,slotid,itemid,charges,instnodrop,custom_data,color,"
+				"augslot1,augslot2,augslot3,augslot4,augslot5) VALUES ";
+		} else {
+			char buf[64];
+			snprintf(buf, sizeof(buf), "DELETE FROM inventory WHERE charid=%u AND (", char_id);
+			sql = buf;
+		}
+		size_t r;
+		for (r = start; r < end; r++) {
+			if (r != start)
+				sql += replace ? "," : " OR ";
+			sql += entries[r].sql;
+		}
+		if (!replace)
+			sql += ")";
+
+		out.push_back(sql);
+		if (first)
+			first->push_back(start);
+		start = end;
+	}
+}
+
+void InventoryJournal::Completed(uint32 char_id, uint32 errors) {
+	LockMutex lock(&MJournal);
+	stats.errors += errors;
+	JournalMap::iterator it = journals.find(char_id);
+	if (it == journals.end())
+		return;
+	if (!it->second.in_flight.empty())
+		it->second.in_flight.pop_front();
+	if (it->second.in_flight.empty() && it->second.pending.empty())
+		journals.erase(it);
+	CCompleted.Post();
+}
+
+void InventoryJournal::Fallback(uint32 char_id, uint32 failed, std::vector<std::string> &out) {
+	LockMutex lock(&MJournal);
+	JournalMap::iterator it = journals.find(char_id);
+	if (it == journals.end() || it->second.in_flight.empty())
+		return;
+	const InFlight &flight = it->second.in_flight.front();
+	if (failed >= flight.first.size())
+		return;
+	// REPLACE and DELETE are idempotent, so rerunning the statements after
+	// the failed one that already went through is harmless and keeps the order
+	BuildStatements(char_id, flight.entries, flight.first[failed], 1, out);
+	stats.fallbacks++;
+}
+
+bool InventoryJournal::Outstanding(uint32 char_id) {
+	LockMutex lock(&MJournal);
+	return(journals.find(char_id) != journals.end());
+}
+
+bool InventoryJournal::HasInFlight(uint32 char_id) {
+	LockMutex lock(&MJournal);
+	JournalMap::iterator it = journals.find(char_id);
+	return(it != journals.end() && !it->second.in_flight.empty());
+}
+
+bool InventoryJournal::Wait(uint32 char_id, uint32 timeout_ms) {
+	return WaitFor(char_id, timeout_ms, true);
+}
+
+bool InventoryJournal::WaitInFlight(uint32 char_id, uint32 timeout_ms) {
+	return WaitFor(char_id, timeout_ms, false);
+}
+
+void InventoryJournal::CountBarrier() {
+	LockMutex lock(&MJournal);
+	stats.barriers++;
+}
+
+bool InventoryJournal::WaitFor(uint32 char_id, uint32 timeout_ms, bool pending_too) {
+	uint64 deadline = Timer::GetTimeMicroseconds() + uint64(timeout_ms) * 1000;
+	while (pending_too ? Outstanding(char_id) : HasInFlight(char_id)) {
+		uint64 now = Timer::GetTimeMicroseconds();
+		if (now >= deadline) {
+			LockMutex lock(&MJournal);
+			stats.barrier_timeouts++;
+			return false;
+		}
+		// posted by every Completed, a post left over from another character
+		// just costs one more look at Outstanding
+		CCompleted.WaitForPost((unsigned long)(deadline - now));
+	}
+	return true;
+}
+
+InventoryJournal::Stats InventoryJournal::GetStats() {
+	LockMutex lock(&MJournal);
+	return stats;
+}
+
+uint32 InventoryJournal::PendingEntries() {
+	LockMutex lock(&MJournal);
+	return pending_entries;
+}
@@ -0,0 +1,130 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef INVENTORY_JOURNAL_H
+#define INVENTORY_JOURNAL_H
+
+#include "types.h"
+#include "Mutex.h"
+#include "Condition.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+
+//most rows put in one REPLACE or conditions in one DELETE
+#define INVENTORY_JOURNAL_BATCH 64
+//how long a barrier waits for the database thread before it says so, about one zone frame
+#define INVENTORY_JOURNAL_BARRIER_MS 30
+//and how long it keeps waiting after that before it gives up on the batches in flight
+#define INVENTORY_JOURNAL_BARRIER_MAX_MS 10000
+
+//the statements one flush produced for one character, in the order they have to run
+struct InventoryJournalBatch {
+	uint32 char_id;
+	std::vector<std::string> statements;
+};
+
+/*
+	Write-behind journal for the inventory table.
+
+	SaveInventory appends rows and deletes here instead of running them, and
+	the zone flushes the journal once per main loop. A flush takes each
+	character's entries as one batch: runs of consecutive REPLACEs become
+	one multi-row REPLACE and runs of consecutive deletes one DELETE, so the
+	statements still apply in the order they were journaled. The zone runs
+	each batch as one DBAsyncWork and DBAsync runs work in the order it was
+	added, so writes for one character never pass each other. If a batched
+	statement fails (one bad row fails the whole REPLACE), the flusher asks
+	for the rest of the batch again one row at a time, see Fallback.
+
+	Anything that needs the database to be current for a character (zoning
+	out, a synchronous write to the same rows) goes through
+	SharedDatabase::InventoryBarrier first: it waits for the batches already
+	on DBAsync and runs the rest of the journal itself.
+*/
+class InventoryJournal
+{
+public:
+	InventoryJournal();
+
+	//row is a parenthesized VALUES tuple in the inventory column order
+	void Replace(uint32 char_id, const std::string &row);
+	//cond is a WHERE condition on slotid, ANDed with the character
+	void Delete(uint32 char_id, const std::string &cond);
+
+	//moves the journaled entries of one character, or of everyone with char_id 0,
+	//into out. Every batch taken has to be handed back to Completed.
+	void Take(uint32 char_id, std::vector<InventoryJournalBatch> &out);
+	void Completed(uint32 char_id, uint32 errors);
+	//one statement per row or delete, for statement failed of the oldest batch
+	//of char_id that hasn't completed and everything after it in that batch.
+	//Run them in order before that batch's Completed.
+	void Fallback(uint32 char_id, uint32 failed, std::vector<std::string> &out);
+
+	//true if char_id has entries that haven't been written yet
+	bool Outstanding(uint32 char_id);
+	//waits until nothing is outstanding for char_id, false if it timed out.
+	//Woken by Completed, so it's meant for the main thread with a short timeout.
+	bool Wait(uint32 char_id, uint32 timeout_ms = INVENTORY_JOURNAL_BARRIER_MS);
+	//the same, but only for batches already taken. Entries still pending don't count.
+	bool WaitInFlight(uint32 char_id, uint32 timeout_ms = INVENTORY_JOURNAL_BARRIER_MS);
+	void CountBarrier();
+
+	struct Stats {
+		uint32 entries;		//rows and deletes journaled
+		uint32 statements;	//statements those were batched into
+		uint32 batches;
+		uint32 errors;		//statements that failed
+		uint32 fallbacks;	//batched statements retried one row at a time
+		uint32 barriers;
+		uint32 barrier_timeouts;	//waits that ran past their timeout
+	};
+	Stats GetStats();
+	uint32 PendingEntries();
+
+private:
+	struct Entry {
+		bool replace;
+		std::string sql;
+	};
+	//a batch taken but not completed, kept for Fallback
+	struct InFlight {
+		std::vector<Entry> entries;
+		std::vector<size_t> first;	//first entry of each statement
+	};
+	struct CharJournal {
+		std::vector<Entry> pending;
+		std::deque<InFlight> in_flight;	//oldest first, batches complete in order
+	};
+	typedef std::map<uint32, CharJournal> JournalMap;
+
+	void Append(uint32 char_id, bool replace, const std::string &sql);
+	bool HasInFlight(uint32 char_id);
+	bool WaitFor(uint32 char_id, uint32 timeout_ms, bool pending_too);
+	static void BuildStatements(uint32 char_id, const std::vector<Entry> &entries, size_t from, size_t max_rows,
+		std::vector<std::string> &out, std::vector<size_t> *first = nullptr);
+
+	Mutex MJournal;
+	Condition CCompleted;
+	JournalMap journals;
+	uint32 pending_entries;
+	Stats stats;
+};
+
+#endif
@@ -0,0 +1,230 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef LOCKFREE_QUEUE_H
+#define LOCKFREE_QUEUE_H
+
+#include "types.h"
+#include <atomic>
+
+#define SPSC_SEGMENT_SIZE 64
+
+/*
+	Unbounded single producer, single consumer FIFO. Items go into fixed
+	size ring segments; when the producer fills one it links a new one
+	instead of failing, so nothing is ever dropped. The consumer hands the
+	segment it finished back as a spare, so a queue that stays under one
+	segment's worth of backlog never allocates.
+
+	Push must only ever be called from one thread at a time, and Pop, Peek
+	and Empty from one (possibly different) thread at a time.
+*/
+template<class T>
+class SPSCQueue
+{
+public:
+	SPSCQueue() : spare(nullptr)
+	{
+		head = tail = new Segment;
+		read = 0;
+	}
+
+	~SPSCQueue()
+	{
+		while(head) {
+			Segment *next = head->next.load(std::memory_order_relaxed);
+			delete head;
+			head = next;
+		}
+		delete spare.load(std::memory_order_relaxed);
+	}
+
+	//producer
+	void Push(const T &value)
+	{
+		uint32 w = tail->written.load(std::memory_order_relaxed);
+		if(w < SPSC_SEGMENT_SIZE) {
+			tail->slots[w] = value;
+			tail->written.store(w + 1, std::memory_order_release);
+			return;
+		}
+
+		Segment *s = spare.exchange(nullptr, std::memory_order_acquire);
+		if(s == nullptr)
+			s = new Segment;
+		else
+			s->Reset();
+		s->slots[0] = value;
+		s->written.store(1, std::memory_order_relaxed);
+		tail->next.store(s, std::memory_order_release);
+		tail = s;
+	}
+
+	//consumer
+	bool Pop(T &out)
+	{
+		if(!Advance())
+			return(false);
+		out = head->slots[read++];
+		return(true);
+	}
+
+	//consumer, looks at the n'th item without removing anything
+	bool Peek(T &out, uint32 n = 0)
+	{
+		Segment *s = head;
+		uint32 r = read;
+		while(true) {
+			if(r == SPSC_SEGMENT_SIZE) {
+				s = s->next.load(std::memory_order_acquire);
+				if(s == nullptr)
+					return(false);
+				r = 0;
+			}
+			uint32 avail = s->written.load(std::memory_order_acquire);
+			if(r + n < avail) {
+				out = s->slots[r + n];
+				return(true);
+			}
+			if(avail < SPSC_SEGMENT_SIZE)
+				return(false);
+			n -= avail - r;
+			r = avail;
+		}
+	}
+
+	//consumer
+	bool Empty() { return(!Advance()); }
+
+private:
+	struct Segment {
+		Segment() { Reset(); }
+		void Reset()
+		{
+			written.store(0, std::memory_order_relaxed);
+			next.store(nullptr, std::memory_order_relaxed);
+		}
+
+		T slots[SPSC_SEGMENT_SIZE];
+		std::atomic<uint32> written;
+		std::atomic<Segment *> next;
+	};
+
+	//moves head on to the next segment once this one is used up, true if an item is ready
+	bool Advance()
+	{
+		if(read == SPSC_SEGMENT_SIZE) {
+			Segment *next = head->next.load(std::memory_order_acquire);
+			if(next == nullptr)
+				return(false);
+			Segment *done = head;
+			head = next;
+			read = 0;
+			delete spare.exchange(done, std::memory_order_release);
+		}
+		return(read < head->written.load(std::memory_order_acquire));
+	}
+
+	//consumer side
+	Segment *head;
+	uint32 read;
+	char pad[64];	//keep the two sides off each other's cache line
+	//producer side
+	Segment *tail;
+	std::atomic<Segment *> spare;
+};
+
+/*
+	Unbounded multiple producer, single consumer FIFO (Vyukov's node
+	queue). Push is one atomic exchange and never waits on another thread.
+	Items from one producer come out in the order it pushed them.
+
+	A producer that is preempted between its exchange and linking its node
+	hides everything pushed after it until it resumes, so Pop can briefly
+	report empty while the queue isn't. Whoever pushes should wake the
+	consumer afterwards, as EQStream does with its write notify.
+
+	Pop, Peek and Empty must only be called from one thread at a time.
+*/
+template<class T>
+class MPSCQueue
+{
+public:
+	MPSCQueue()
+	{
+		Node *stub = new Node;
+		last.store(stub, std::memory_order_relaxed);
+		first = stub;
+	}
+
+	~MPSCQueue()
+	{
+		while(first) {
+			Node *next = first->next.load(std::memory_order_relaxed);
+			delete first;
+			first = next;
+		}
+	}
+
+	//any thread
+	void Push(const T &value)
+	{
+		Node *n = new Node;
+		n->value = value;
+		Node *prev = last.exchange(n, std::memory_order_acq_rel);
+		prev->next.store(n, std::memory_order_release);
+	}
+
+	//consumer
+	bool Pop(T &out)
+	{
+		Node *next = first->next.load(std::memory_order_acquire);
+		if(next == nullptr)
+			return(false);
+		out = next->value;
+		delete first;
+		first = next;	//next becomes the new stub
+		return(true);
+	}
+
+	//consumer
+	bool Peek(T &out)
+	{
+		Node *next = first->next.load(std::memory_order_acquire);
+		if(next == nullptr)
+			return(false);
+		out = next->value;
+		return(true);
+	}
+
+	//consumer
+	bool Empty() { return(first->next.load(std::memory_order_acquire) == nullptr); }
+
+private:
+	struct Node {
+		Node() : next(nullptr) { }
+		std::atomic<Node *> next;
+		T value;
+	};
+
+	Node *first;	//consumer, the stub in front of the oldest item
+	char pad[64];
+	std::atomic<Node *> last;	//producers
+};
+
+#endif
@@ -102,9 +102,10 @@ namespace EQEmu {
 #endif
 	}
 
-	MemoryMappedFile::MemoryMappedFile(std::string filename)
+	MemoryMappedFile::MemoryMappedFile(std::string filename, OpenMode mode)
 		: filename_(filename) {
 		imp_ = new Implementation;
+		bool read_only = (mode == ReadOnly);
 
 		//get existing size
 		FILE *f = fopen(filename.c_str(), "rb");
@@ -112,17 +113,21 @@ namespace EQEmu {
 			EQ_EXCEPT("Shared Memory", "Could not open the file to find the existing file size.");
 		}
 		fseek(f, 0U, SEEK_END);
-		uint32 size = static_cast<uint32>(ftell(f)) - sizeof(shared_memory_struct);
-		size_ = size;
+		long file_size = ftell(f);
 		fclose(f);
+		if(file_size < static_cast<long>(sizeof(shared_memory_struct))) {
+			EQ_EXCEPT("Shared Memory", "The existing file is too small to be a shared memory file.");
+		}
+		uint32 size = static_cast<uint32>(file_size) - sizeof(shared_memory_struct);
+		size_ = size;
 
 #ifdef _WINDOWS
 		DWORD total_size = size + sizeof(shared_memory_struct);
 		HANDLE file = CreateFile(filename.c_str(),
-			GENERIC_READ | GENERIC_WRITE,
-			FILE_SHARE_READ | FILE_SHARE_WRITE,
+			read_only ? GENERIC_READ : (GENERIC_READ | GENERIC_WRITE),
+			FILE_SHARE_READ | FILE_SHARE_WRITE | (read_only ? FILE_SHARE_DELETE : 0),
 			nullptr,
-			OPEN_ALWAYS,
+			read_only ? OPEN_EXISTING : OPEN_ALWAYS,
 			0,
 			nullptr);
 
@@ -130,19 +135,22 @@ namespace EQEmu {
 			EQ_EXCEPT("Shared Memory", "Could not open a file for this shared memory segment.");
 		}
 
+		//read only mappings are private to the file, so they don't get a name others could open writable
 		imp_->mapped_object_ = CreateFileMapping(file,
 			nullptr,
-			PAGE_READWRITE,
+			read_only ? PAGE_READONLY : PAGE_READWRITE,
 			0,
 			total_size,
-			filename.c_str());
+			read_only ? nullptr : filename.c_str());
+		if(read_only)
+			CloseHandle(file);	//the mapping keeps it open
 
 		if(!imp_->mapped_object_) {
 			EQ_EXCEPT("Shared Memory", "Could not create a file mapping for this shared memory file.");
 		}
 
 		memory_ = reinterpret_cast<shared_memory_struct*>(MapViewOfFile(imp_->mapped_object_,
-			FILE_MAP_ALL_ACCESS,
+			read_only ? FILE_MAP_READ : FILE_MAP_ALL_ACCESS,
 			0,
 			0,
 			total_size));
@@ -153,17 +161,21 @@ namespace EQEmu {
 
 #else
 		size_t total_size = size + sizeof(shared_memory_struct);
-		imp_->fd_ = open(filename.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+		if(read_only) {
+			imp_->fd_ = open(filename.c_str(), O_RDONLY);
+		} else {
+			imp_->fd_ = open(filename.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+		}
 		if(imp_->fd_ == -1) {
 			EQ_EXCEPT("Shared Memory", "Could not open a file for this shared memory segment.");
 		}
 
-		if(ftruncate(imp_->fd_, total_size) == -1) {
+		if(!read_only && ftruncate(imp_->fd_, total_size) == -1) {
 			EQ_EXCEPT("Shared Memory", "Could not set file size for this shared memory segment.");
 		}
 
 		memory_ = reinterpret_cast<shared_memory_struct*>(
-			mmap(nullptr, total_size, PROT_READ | PROT_WRITE, MAP_FILE | MAP_SHARED, imp_->fd_, 0));
+			mmap(nullptr, total_size, read_only ? PROT_READ : (PROT_READ | PROT_WRITE), MAP_FILE | MAP_SHARED, imp_->fd_, 0));
 
 		if(memory_ == MAP_FAILED) {
 			EQ_EXCEPT("Shared Memory", "Could not create a file mapping for this shared memory file.");
@@ -173,6 +185,9 @@ namespace EQEmu {
 
 	MemoryMappedFile::~MemoryMappedFile() {
 #ifdef _WINDOWS
+		if(memory_) {
+			UnmapViewOfFile(memory_);
+		}
 		if(imp_->mapped_object_) {
 			CloseHandle(imp_->mapped_object_);
 		}
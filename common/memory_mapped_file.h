@@ -39,6 +39,12 @@ namespace EQEmu {
 			unsigned char data[1];
 		};
 	public:
+		//! How an existing file is opened
+		enum OpenMode {
+			ReadWrite,	//!< Mapped writable and shared, resized to what it already is
+			ReadOnly	//!< Mapped read only, the file is never written or resized
+		};
+
 		//! Constructor
 		/*!
 			Creates a mmf for the given filename and of size.
@@ -51,8 +57,9 @@ namespace EQEmu {
 		/*!
 			Creates a mmf for the given filename and gets the size based on the existing size.
 		\param filename Actual filename of the mmf.
+		\param mode Whether the mapping may be written to.
 		*/
-		MemoryMappedFile(std::string filename);
+		MemoryMappedFile(std::string filename, OpenMode mode = ReadWrite);
 
 		//! Destructor
 		~MemoryMappedFile();
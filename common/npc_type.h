@@ -0,0 +1,119 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef _EQEMU_NPC_TYPE_H
+#define _EQEMU_NPC_TYPE_H
+
+#include "types.h"
+#include "eq_constants.h"
+
+//one row of npc_types. lives in shared memory (see SharedDatabase::LoadNPCTypes),
+//so it has to stay plain data.
+#pragma pack(1)
+
+struct NPCType
+{
+	char	name[64];
+	char	lastname[70];
+
+	int32	cur_hp;
+	int32	max_hp;
+
+	float	size;
+	float	runspeed;
+	uint8	gender;
+	uint16	race;
+	uint8	class_;
+	uint8	bodytype;	// added for targettype support
+	uint8	deity;		//not loaded from DB
+	uint8	level;
+	uint32	npc_id;
+	uint8	texture;
+	uint8	helmtexture;
+	uint32	loottable_id;
+	uint32	npc_spells_id;
+	int32	npc_faction_id;
+	uint32	merchanttype;
+	uint32	alt_currency_type;
+	uint32	adventure_template;
+	uint32	trap_template;
+	uint8	light;		//not loaded from DB
+	uint16	AC;
+	uint32	Mana;	//not loaded from DB
+	uint16	ATK;	//not loaded from DB
+	uint16	STR;
+	uint16	STA;
+	uint16	DEX;
+	uint16	AGI;
+	uint16	INT;
+	uint16	WIS;
+	uint16	CHA;
+	int16	MR;
+	int16	FR;
+	int16	CR;
+	int16	PR;
+	int16	DR;
+	int16	Corrup;
+	uint8	haircolor;
+	uint8	beardcolor;
+	uint8	eyecolor1;			// the eyecolors always seem to be the same, maybe left and right eye?
+	uint8	eyecolor2;
+	uint8	hairstyle;
+	uint8	luclinface;			//
+	uint8	beard;				//
+	uint32	drakkin_heritage;
+	uint32	drakkin_tattoo;
+	uint32	drakkin_details;
+	uint32	armor_tint[MAX_MATERIALS];
+	uint32	min_dmg;
+	uint32	max_dmg;
+	int16	attack_count;
+	char	npc_attacks[30];
+	uint16	d_meele_texture1;
+	uint16	d_meele_texture2;
+	uint8	prim_melee_type;
+	uint8	sec_melee_type;
+	int32	hp_regen;
+	int32	mana_regen;
+	int32	aggroradius; // added for AI improvement - neotokyo
+	uint8	see_invis;			// See Invis flag added
+	bool	see_invis_undead;	// See Invis vs. Undead flag added
+	bool	see_hide;
+	bool	see_improved_hide;
+	bool	qglobal;
+	bool	npc_aggro;
+	uint8	spawn_limit;	//only this many may be in zone at a time (0=no limit)
+	uint8	mount_color;	//only used by horse class
+	float	attack_speed;	//%+- on attack delay of the mob.
+	int		accuracy_rating;	//10 = 1% accuracy
+	bool	findable;		//can be found with find command
+	bool	trackable;
+	float	slow_mitigation;	// Slow mitigation % in decimal form.
+	uint8	maxlevel;
+	uint32	scalerate;
+	bool	private_corpse;
+	bool	unique_spawn_by_name;
+	bool	underwater;
+	uint32	emoteid;
+	float	spellscale;
+	float	healscale;
+};
+
+#pragma pack()
+
+#endif
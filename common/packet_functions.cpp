@@ -94,52 +94,108 @@ void eqemu_free_func(voidpf opaque, voidpf address) {
 #endif
 
 
-int DeflatePacket(const unsigned char* in_data, int in_length, unsigned char* out_data, int max_out_length) {
-#ifdef REUSE_ZLIB
-	static bool inited = false;
-	static z_stream zstream;
-	int zerror;
+static THREAD_LOCAL ZlibThreadContext *zlib_context = nullptr;
 
-	if(in_data == nullptr && out_data == nullptr && in_length == 0 && max_out_length == 0) {
-		//special delete state
-		deflateEnd(&zstream);
-		return(0);
+static void InflateError(z_stream &zstream, int zerror, const uchar* indata, uint32 indatalen) {
+	std::cout << "Error: InflatePacket: inflate() returned " << zerror << " '";
+	if (zstream.msg)
+		std::cout << zstream.msg;
+	std::cout << "'" << std::endl;
+#ifdef EQDEBUG
+	DumpPacket(indata-16, indatalen+16);
+#endif
+}
+
+ZlibThreadContext::ZlibThreadContext() {
+	deflater = nullptr;
+	inflater = nullptr;
+	deflate_level = DEFLATE_DEFAULT_LEVEL;
+	previous = zlib_context;
+	zlib_context = this;
+}
+
+ZlibThreadContext::~ZlibThreadContext() {
+	zlib_context = previous;
+	if(deflater) {
+		deflateEnd(deflater);
+		delete deflater;
 	}
-	if(!inited) {
-		memset(&zstream, 0, sizeof(zstream));
-		zstream.zalloc	= eqemu_alloc_func;
-		zstream.zfree	= eqemu_free_func;
-		zstream.opaque	= Z_NULL;
-		deflateInit(&zstream, Z_FINISH);
+	if(inflater) {
+		inflateEnd(inflater);
+		delete inflater;
 	}
+}
 
-	zstream.next_in		= const_cast<unsigned char *>(in_data);
-	zstream.avail_in	= in_length;
-/*	zstream.zalloc	= Z_NULL;
-	zstream.zfree	= Z_NULL;
-	zstream.opaque	= Z_NULL;
-	deflateInit(&zstream, Z_FINISH);*/
-	zstream.next_out = out_data;
-	zstream.avail_out = max_out_length;
-	zerror = deflate(&zstream, Z_FINISH);
+int ZlibThreadContext::Deflate(const unsigned char* in_data, int in_length, unsigned char* out_data, int max_out_length, int level) {
+	if(deflater == nullptr) {
+		deflater = new z_stream;
+		memset(deflater, 0, sizeof(z_stream));
+		deflater->zalloc	= eqemu_alloc_func;
+		deflater->zfree	= eqemu_free_func;
+		deflater->opaque	= Z_NULL;
+		if(deflateInit(deflater, level) != Z_OK) {
+			delete deflater;
+			deflater = nullptr;
+			return 0;
+		}
+		deflate_level = level;
+	} else if(level != deflate_level) {
+		//the stream was reset after its last packet, so nothing is flushed here
+		deflateParams(deflater, level, Z_DEFAULT_STRATEGY);
+		deflate_level = level;
+	}
 
-	deflateReset(&zstream);
+	deflater->next_in	= const_cast<unsigned char *>(in_data);
+	deflater->avail_in	= in_length;
+	deflater->next_out	= out_data;
+	deflater->avail_out	= max_out_length;
+	int zerror = deflate(deflater, Z_FINISH);
+	int total = deflater->total_out;
+	deflateReset(deflater);
 
 	if (zerror == Z_STREAM_END)
-	{
-//		deflateEnd(&zstream);
-		return zstream.total_out;
-	}
-	else
-	{
-//		zerror = deflateEnd(&zstream);
-		return 0;
+		return total;
+	return 0;
+}
+
+uint32 ZlibThreadContext::Inflate(const uchar* indata, uint32 indatalen, uchar* outdata, uint32 outdatalen, bool iQuiet) {
+	if(inflater == nullptr) {
+		inflater = new z_stream;
+		memset(inflater, 0, sizeof(z_stream));
+		inflater->zalloc	= eqemu_alloc_func;
+		inflater->zfree	= eqemu_free_func;
+		inflater->opaque	= Z_NULL;
+		if(inflateInit2(inflater, 15) != Z_OK) {
+			delete inflater;
+			inflater = nullptr;
+			return 0;
+		}
 	}
-#else
+
+	inflater->next_in	= const_cast<unsigned char *>(indata);
+	inflater->avail_in	= indatalen;
+	inflater->next_out	= outdata;
+	inflater->avail_out	= outdatalen;
+	int zerror = inflate(inflater, Z_FINISH);
+	uint32 total = inflater->total_out;
+
+	if(zerror != Z_STREAM_END && !iQuiet)
+		InflateError(*inflater, zerror, indata, indatalen);
+	inflateReset(inflater);
+
+	if(zerror == Z_STREAM_END)
+		return total;
+	return 0;
+}
+
+int DeflatePacket(const unsigned char* in_data, int in_length, unsigned char* out_data, int max_out_length, int level) {
 	if(in_data == nullptr) {
 		return(0);
 	}
 
+	if(zlib_context)
+		return(zlib_context->Deflate(in_data, in_length, out_data, max_out_length, level));
+
 	z_stream zstream;
 	memset(&zstream, 0, sizeof(zstream));
 	int zerror;
@@ -149,7 +205,7 @@ int DeflatePacket(const unsigned char* in_data, int in_length, unsigned char* ou
 	zstream.zalloc	= eqemu_alloc_func;
 	zstream.zfree	= eqemu_free_func;
 	zstream.opaque	= Z_NULL;
-	deflateInit(&zstream, Z_FINISH);
+	deflateInit(&zstream, level);
 	zstream.next_out = out_data;
 	zstream.avail_out = max_out_length;
 	zerror = deflate(&zstream, Z_FINISH);
@@ -164,69 +220,15 @@ int DeflatePacket(const unsigned char* in_data, int in_length, unsigned char* ou
 		zerror = deflateEnd(&zstream);
 		return 0;
 	}
-#endif
 }
 
 uint32 InflatePacket(const uchar* indata, uint32 indatalen, uchar* outdata, uint32 outdatalen, bool iQuiet) {
-#ifdef REUSE_ZLIB
-	static bool inited = false;
-	static z_stream zstream;
-	int zerror;
-
-	if(indata == nullptr && outdata == nullptr && indatalen == 0 && outdatalen == 0) {
-		//special delete state
-		inflateEnd(&zstream);
-		return(0);
-	}
-	if(!inited) {
-		zstream.zalloc	= eqemu_alloc_func;
-		zstream.zfree	= eqemu_free_func;
-		zstream.opaque	= Z_NULL;
-		inflateInit2(&zstream, 15);
-	}
-
-	zstream.next_in		= const_cast<unsigned char *>(indata);
-	zstream.avail_in	= indatalen;
-	zstream.next_out	= outdata;
-	zstream.avail_out	= outdatalen;
-	zstream.zalloc		= eqemu_alloc_func;
-	zstream.zfree		= eqemu_free_func;
-	zstream.opaque		= Z_NULL;
-
-	i = inflateInit2( &zstream, 15 );
-	if (i != Z_OK) {
-		return 0;
-	}
-
-	zerror = inflate( &zstream, Z_FINISH );
-
-	inflateReset(&zstream);
-
-	if(zerror == Z_STREAM_END) {
-		return zstream.total_out;
-	}
-	else {
-		if (!iQuiet) {
-			std::cout << "Error: InflatePacket: inflate() returned " << zerror << " '";
-			if (zstream.msg)
-				std::cout << zstream.msg;
-			std::cout << "'" << std::endl;
-#ifdef EQDEBUG
-			DumpPacket(indata-16, indatalen+16);
-#endif
-		}
-
-		if (zerror == -4 && zstream.msg == 0)
-		{
-			return 0;
-		}
-
-		return 0;
-	}
-#else
 	if(indata == nullptr)
 		return(0);
 
+	if(zlib_context)
+		return(zlib_context->Inflate(indata, indatalen, outdata, outdatalen, iQuiet));
+
 	z_stream zstream;
 	int zerror = 0;
 	int i;
@@ -251,25 +253,12 @@ uint32 InflatePacket(const uchar* indata, uint32 indatalen, uchar* outdata, uint
 		return zstream.total_out;
 	}
 	else {
-		if (!iQuiet) {
-			std::cout << "Error: InflatePacket: inflate() returned " << zerror << " '";
-			if (zstream.msg)
-				std::cout << zstream.msg;
-			std::cout << "'" << std::endl;
-#ifdef EQDEBUG
-			DumpPacket(indata-16, indatalen+16);
-#endif
-		}
-
-		if (zerror == -4 && zstream.msg == 0)
-		{
-			return 0;
-		}
+		if (!iQuiet)
+			InflateError(zstream, zerror, indata, indatalen);
 
 		zerror = inflateEnd( &zstream );
 		return 0;
 	}
-#endif
 }
 
 uint32 roll(uint32 in, uint8 bits) {
@@ -36,7 +36,36 @@ void EncryptProfilePacket(uchar* pBuffer, uint32 size);
 void EncryptZoneSpawnPacket(EQApplicationPacket* app);
 void EncryptZoneSpawnPacket(uchar* pBuffer, uint32 size);
 
-int DeflatePacket(const unsigned char* in_data, int in_length, unsigned char* out_data, int max_out_length);
+//what deflateInit(&zstream, Z_FINISH) has always given us
+#define DEFLATE_DEFAULT_LEVEL 4
+
+struct z_stream_s;
+
+/*
+	While one of these is alive on a thread, DeflatePacket and InflatePacket
+	on that thread reuse its zlib streams instead of setting up and tearing
+	down a new one (a couple hundred KB of tables) for every packet. Threads
+	that compress a lot, like the EQStreamFactory reader and writer, keep
+	one on their stack for as long as they run; everything else still gets
+	a one shot stream. Must be destroyed on the thread that created it.
+*/
+class ZlibThreadContext
+{
+public:
+	ZlibThreadContext();
+	~ZlibThreadContext();
+
+	int Deflate(const unsigned char* in_data, int in_length, unsigned char* out_data, int max_out_length, int level);
+	uint32 Inflate(const uchar* indata, uint32 indatalen, uchar* outdata, uint32 outdatalen, bool iQuiet);
+
+private:
+	struct z_stream_s *deflater;
+	struct z_stream_s *inflater;
+	int deflate_level;
+	ZlibThreadContext *previous;
+};
+
+int DeflatePacket(const unsigned char* in_data, int in_length, unsigned char* out_data, int max_out_length, int level = DEFLATE_DEFAULT_LEVEL);
 uint32 InflatePacket(const uchar* indata, uint32 indatalen, uchar* outdata, uint32 outdatalen, bool iQuiet = false);
 uint32 GenerateCRC(uint32 b, uint32 bufsize, uchar *buf);
 
@@ -0,0 +1,183 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#include "debug.h"
+#include "packet_pool.h"
+#include "Mutex.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+//in front of every block, keeps what follows 16 byte aligned
+#define PACKET_POOL_HEADER	16
+#define PACKET_POOL_OVERSIZE	0xFF
+
+struct PacketPoolCache {
+	void *blocks[PACKET_POOL_CLASSES][PACKET_POOL_CACHE];
+	uint32 count[PACKET_POOL_CLASSES];
+	PacketPool::Stats stats;
+};
+
+//caches are never freed, a thread that exits strands at most one cache worth of blocks
+static Mutex MPacketPool;
+static std::vector<PacketPoolCache *> pool_caches;
+static std::vector<void *> pool_depot[PACKET_POOL_CLASSES];
+static PacketPool::Stats pool_baseline;
+static time_t pool_reset_time = time(nullptr);
+static THREAD_LOCAL PacketPoolCache *pool_local = nullptr;
+
+static PacketPoolCache *LocalCache() {
+	PacketPoolCache *c = pool_local;
+	if(c == nullptr) {
+		c = new PacketPoolCache;
+		memset(c, 0, sizeof(PacketPoolCache));
+		LockMutex lock(&MPacketPool);
+		pool_caches.push_back(c);
+		pool_local = c;
+	}
+	return(c);
+}
+
+static inline uint32 ClassBytes(uint32 cls) {
+	return(uint32(1) << (cls + PACKET_POOL_MIN_SHIFT));
+}
+
+static inline uint32 ClassFor(uint32 bytes) {
+	uint32 cls = 0;
+	while(cls < PACKET_POOL_CLASSES && ClassBytes(cls) < bytes)
+		cls++;
+	return(cls);
+}
+
+void *PacketPool::Allocate(uint32 bytes) {
+	PacketPoolCache *c = LocalCache();
+	c->stats.allocs++;
+
+	uint32 cls = ClassFor(bytes);
+	if(cls == PACKET_POOL_CLASSES) {
+		c->stats.heap_allocs++;
+		c->stats.oversize++;
+		uint8 *block = (uint8 *)malloc(PACKET_POOL_HEADER + bytes);
+		block[0] = PACKET_POOL_OVERSIZE;
+		return(block + PACKET_POOL_HEADER);
+	}
+
+	if(c->count[cls] == 0) {
+		//refill half a cache from the depot in one lock
+		LockMutex lock(&MPacketPool);
+		std::vector<void *> &depot = pool_depot[cls];
+		while(!depot.empty() && c->count[cls] < PACKET_POOL_CACHE / 2) {
+			c->blocks[cls][c->count[cls]++] = depot.back();
+			depot.pop_back();
+			c->stats.depot_gets++;
+		}
+	}
+
+	if(c->count[cls] > 0)
+		return(c->blocks[cls][--c->count[cls]]);
+
+	c->stats.heap_allocs++;
+	uint8 *block = (uint8 *)malloc(PACKET_POOL_HEADER + ClassBytes(cls));
+	block[0] = cls;
+	return(block + PACKET_POOL_HEADER);
+}
+
+void PacketPool::Free(void *ptr) {
+	if(ptr == nullptr)
+		return;
+	PacketPoolCache *c = LocalCache();
+	c->stats.frees++;
+
+	uint8 *block = (uint8 *)ptr - PACKET_POOL_HEADER;
+	uint32 cls = block[0];
+	if(cls == PACKET_POOL_OVERSIZE) {
+		free(block);
+		return;
+	}
+
+	if(c->count[cls] == PACKET_POOL_CACHE) {
+		//full, pass the older half on to whichever thread is allocating
+		LockMutex lock(&MPacketPool);
+		std::vector<void *> &depot = pool_depot[cls];
+		uint32 r;
+		for(r = 0; r < PACKET_POOL_CACHE / 2; r++) {
+			void *spill = c->blocks[cls][r];
+			if(depot.size() < PACKET_POOL_DEPOT) {
+				depot.push_back(spill);
+				c->stats.depot_puts++;
+			} else {
+				free((uint8 *)spill - PACKET_POOL_HEADER);
+			}
+		}
+		memmove(c->blocks[cls], c->blocks[cls] + PACKET_POOL_CACHE / 2, sizeof(void *) * (PACKET_POOL_CACHE / 2));
+		c->count[cls] = PACKET_POOL_CACHE / 2;
+	}
+	c->blocks[cls][c->count[cls]++] = ptr;
+}
+
+unsigned char *PacketPool::AllocateBuffer(uint32 length, uint32 &capacity) {
+	uint32 bytes = length + PACKET_POOL_HEADROOM;
+	uint32 cls = ClassFor(bytes);
+	if(cls < PACKET_POOL_CLASSES)
+		bytes = ClassBytes(cls);
+	capacity = bytes - PACKET_POOL_HEADROOM;
+	return((unsigned char *)Allocate(bytes) + PACKET_POOL_HEADROOM);
+}
+
+void PacketPool::FreeBuffer(unsigned char *buffer) {
+	if(buffer)
+		Free(buffer - PACKET_POOL_HEADROOM);
+}
+
+static void SumStats(PacketPool::Stats &out) {
+	memset(&out, 0, sizeof(out));
+	std::vector<PacketPoolCache *>::iterator cur;
+	for(cur = pool_caches.begin(); cur != pool_caches.end(); ++cur) {
+		const PacketPool::Stats &s = (*cur)->stats;
+		out.allocs += s.allocs;
+		out.frees += s.frees;
+		out.heap_allocs += s.heap_allocs;
+		out.oversize += s.oversize;
+		out.depot_puts += s.depot_puts;
+		out.depot_gets += s.depot_gets;
+	}
+}
+
+void PacketPool::GetStats(Stats &out) {
+	LockMutex lock(&MPacketPool);
+	SumStats(out);
+	out.allocs -= pool_baseline.allocs;
+	out.frees -= pool_baseline.frees;
+	out.heap_allocs -= pool_baseline.heap_allocs;
+	out.oversize -= pool_baseline.oversize;
+	out.depot_puts -= pool_baseline.depot_puts;
+	out.depot_gets -= pool_baseline.depot_gets;
+}
+
+void PacketPool::ResetStats() {
+	//each thread owns its counters, so a reset just moves the baseline
+	LockMutex lock(&MPacketPool);
+	SumStats(pool_baseline);
+	pool_reset_time = time(nullptr);
+}
+
+uint32 PacketPool::GetStatsAge() {
+	LockMutex lock(&MPacketPool);
+	return(uint32(time(nullptr) - pool_reset_time));
+}
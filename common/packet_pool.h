@@ -0,0 +1,70 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef PACKET_POOL_H
+#define PACKET_POOL_H
+
+#include "types.h"
+
+//size classes are powers of two from 64 bytes up to 64 << (classes - 1)
+#define PACKET_POOL_CLASSES		7
+#define PACKET_POOL_MIN_SHIFT	6
+//blocks a thread keeps for itself per class before handing half to the shared depot
+#define PACKET_POOL_CACHE		64
+//blocks the shared depot keeps per class, anything past this goes back to the heap
+#define PACKET_POOL_DEPOT		4096
+//free bytes in front of every buffer, room for protocol and app opcodes and a combine length
+#define PACKET_POOL_HEADROOM	8
+
+/*
+	Size classed free lists for EQProtocolPacket objects and buffers.
+	Every thread allocates from and frees into its own cache without
+	locking. A packet built on the zone thread and freed on the writer
+	thread lands in the writer's cache, and the shared depot carries the
+	surplus back, so a steady stream settles into no heap traffic at all.
+
+	Anything bigger than the largest class comes straight from the heap
+	and is only counted.
+*/
+class PacketPool
+{
+public:
+	//raw blocks, at least bytes long
+	static void *Allocate(uint32 bytes);
+	static void Free(void *block);
+
+	//a buffer with PACKET_POOL_HEADROOM writable bytes before it.
+	//capacity is set to how much fits from the returned pointer on.
+	static unsigned char *AllocateBuffer(uint32 length, uint32 &capacity);
+	static void FreeBuffer(unsigned char *buffer);
+
+	struct Stats {
+		uint64 allocs;		//blocks handed out
+		uint64 frees;
+		uint64 heap_allocs;	//of allocs, how many needed the heap
+		uint64 oversize;	//of heap_allocs, how many were too big for any class
+		uint64 depot_puts;	//blocks a thread gave up to the depot
+		uint64 depot_gets;	//blocks a thread took back from it
+	};
+	//summed over every thread, since the last reset
+	static void GetStats(Stats &out);
+	static void ResetStats();
+	static uint32 GetStatsAge();	//seconds since the last reset
+};
+
+#endif
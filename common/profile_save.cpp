@@ -0,0 +1,150 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#include "debug.h"
+#include "profile_save.h"
+#include <string.h>
+
+ProfileSaveState::Stats ProfileSaveState::stats = { 0, 0, 0, 0, 0 };
+
+BlobDelta::BlobDelta(uint32 size)
+:	size(size),
+	has_baseline(false),
+	baseline(size),
+	forced((size + BLOB_DELTA_REGION - 1) / BLOB_DELTA_REGION, false)
+{
+}
+
+bool BlobDelta::Collect(const void *data, std::vector<DeltaRun> &runs) {
+	runs.clear();
+	const uint8 *src = (const uint8 *) data;
+
+	if(!has_baseline) {
+		DeltaRun r = { 0, size };
+		runs.push_back(r);
+	} else {
+		uint32 dirty = 0;
+		uint32 region;
+		for(region = 0; region < forced.size(); region++) {
+			uint32 offset = region * BLOB_DELTA_REGION;
+			uint32 len = size - offset < BLOB_DELTA_REGION ? size - offset : BLOB_DELTA_REGION;
+			if(!forced[region] && !RegionChanged(offset, len, src))
+				continue;
+
+			dirty += len;
+			if(!runs.empty() && runs.back().offset + runs.back().length == offset) {
+				runs.back().length += len;
+			} else {
+				DeltaRun r = { offset, len };
+				runs.push_back(r);
+			}
+		}
+
+		if(runs.empty())
+			return(false);
+
+		//past this point splicing costs more than it saves
+		if(runs.size() > BLOB_DELTA_MAX_RUNS || dirty > size / 2) {
+			runs.clear();
+			DeltaRun r = { 0, size };
+			runs.push_back(r);
+		}
+	}
+
+	memcpy(&baseline[0], src, size);
+	std::fill(forced.begin(), forced.end(), false);
+	has_baseline = true;
+	return(true);
+}
+
+void BlobDelta::Ignore(uint32 offset, uint32 length) {
+	if(offset >= size || length == 0)
+		return;
+	DeltaRun r = { offset, length < size - offset ? length : size - offset };
+	ignored.push_back(r);
+}
+
+bool BlobDelta::RegionChanged(uint32 offset, uint32 len, const uint8 *src) const {
+	if(memcmp(&baseline[offset], src + offset, len) == 0)
+		return(false);
+
+	//compare the region again around whatever ignored ranges fall in it
+	uint32 pos = offset;
+	uint32 end = offset + len;
+	while(pos < end) {
+		uint32 next = end;
+		std::vector<DeltaRun>::const_iterator it;
+		for(it = ignored.begin(); it != ignored.end(); ++it) {
+			if(it->offset <= pos && pos < it->offset + it->length) {
+				next = pos;
+				pos = it->offset + it->length;
+				break;
+			}
+			if(it->offset > pos && it->offset < next)
+				next = it->offset;
+		}
+		if(next > pos) {
+			if(memcmp(&baseline[pos], src + pos, next - pos) != 0)
+				return(true);
+			pos = next;
+		}
+	}
+	return(false);
+}
+
+void BlobDelta::MarkDirty(const std::vector<DeltaRun> &runs) {
+	std::vector<DeltaRun>::const_iterator it;
+	for(it = runs.begin(); it != runs.end(); ++it) {
+		if(it->length == 0)
+			continue;
+		uint32 first = it->offset / BLOB_DELTA_REGION;
+		uint32 last = (it->offset + it->length - 1) / BLOB_DELTA_REGION;
+		for(; first <= last && first < forced.size(); first++)
+			forced[first] = true;
+	}
+}
+
+ProfileSaveState::ProfileSaveState(uint32 pp_size, uint32 ext_size)
+:	pp(pp_size),
+	ext(ext_size),
+	zone_id(0),
+	instance_id(0),
+	xtargets(0),
+	force_write(false)
+{
+}
+
+void ProfileSaveState::Requeue() {
+	pp.MarkDirty(pp_runs);
+	ext.MarkDirty(ext_runs);
+	force_write = true;
+	pp_runs.clear();
+	ext_runs.clear();
+}
+
+void ProfileSaveState::Invalidate() {
+	pp.Invalidate();
+	ext.Invalidate();
+	force_write = true;
+	pp_runs.clear();
+	ext_runs.clear();
+}
+
+void ProfileSaveState::ResetStats() {
+	memset(&stats, 0, sizeof(stats));
+}
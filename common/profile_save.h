@@ -0,0 +1,105 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef PROFILE_SAVE_H
+#define PROFILE_SAVE_H
+
+#include "types.h"
+#include <vector>
+
+//granularity of the dirty tracking, in bytes
+#define BLOB_DELTA_REGION	64
+//more runs than this and the whole blob is written instead
+#define BLOB_DELTA_MAX_RUNS	8
+
+struct DeltaRun {
+	uint32 offset;
+	uint32 length;
+};
+
+/*
+	Keeps a copy of what was last written for one fixed size blob and works
+	out which byte ranges changed since then. Without a baseline (first
+	save, or after a failed write) the whole blob is reported dirty.
+*/
+class BlobDelta
+{
+public:
+	BlobDelta(uint32 size);
+
+	//fills runs with the ranges of data that differ from the baseline and
+	//makes data the new baseline. Returns false if nothing changed.
+	bool Collect(const void *data, std::vector<DeltaRun> &runs);
+
+	//forces ranges to be written on the next Collect, for a write that never happened
+	void MarkDirty(const std::vector<DeltaRun> &runs);
+	//the next Collect writes the whole blob
+	void Invalidate() { has_baseline = false; }
+	//bytes that change on every save without mattering on their own (a timestamp).
+	//They don't make their region dirty, but go out with it when something else does.
+	void Ignore(uint32 offset, uint32 length);
+
+	bool IsFull(const std::vector<DeltaRun> &runs) const { return(runs.size() == 1 && runs[0].offset == 0 && runs[0].length == size); }
+	uint32 Size() const { return(size); }
+
+private:
+	bool RegionChanged(uint32 offset, uint32 len, const uint8 *src) const;
+
+	uint32 size;
+	bool has_baseline;
+	std::vector<uint8> baseline;
+	std::vector<bool> forced;	//one per region
+	std::vector<DeltaRun> ignored;
+};
+
+/*
+	Per character save state for the player profile and extended profile.
+	Client::Save asks it what changed and only sends those bytes; the
+	counters are shared by every character in the process.
+*/
+class ProfileSaveState
+{
+public:
+	ProfileSaveState(uint32 pp_size, uint32 ext_size);
+
+	BlobDelta pp;
+	BlobDelta ext;
+	std::vector<DeltaRun> pp_runs;	//what the last built write sends
+	std::vector<DeltaRun> ext_runs;
+	uint32 zone_id;
+	uint32 instance_id;
+	uint8 xtargets;
+	bool force_write;	//write even if no blob changed
+
+	//the last built write was canceled before it ran, put its ranges back
+	void Requeue();
+	//the last write failed, the next one sends everything
+	void Invalidate();
+
+	struct Stats {
+		uint32 writes;			//writes sent to the database
+		uint32 full_writes;		//of those, how many sent a whole blob
+		uint32 skipped;			//saves where nothing had changed
+		uint64 full_bytes;		//blob bytes every save would have sent without deltas
+		uint64 written_bytes;	//blob bytes actually sent
+	};
+	static Stats stats;
+	static void ResetStats();
+};
+
+#endif
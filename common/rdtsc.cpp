@@ -28,8 +28,11 @@
 	#include <sys/time.h>
 #endif
 
-#ifdef i386
+#if defined(i386) || defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
 	#define USE_RDTSC
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#endif
 #endif
 
 bool RDTSC_Timer::_inited = false;
@@ -57,32 +60,32 @@ RDTSC_Timer::RDTSC_Timer(bool start_it) {
 	}
 }
 
+void RDTSC_Timer::calibrate() {
+	if(!_inited)
+		init();
+}
+
 int64 RDTSC_Timer::rdtsc() {
 	int64 res = 0;
 #ifdef USE_RDTSC
-#ifndef WIN64
-#ifdef WIN32
-	//untested!
-	unsigned long highw, loww;
-	__asm {
-		push eax
-		push edx
-		rdtsc
-		mov highw, eax
-		mov loww, edx
-		pop edx
-		pop eax
-	}
-	res = ((int64)highw)<<32 | loww;
+#ifdef _MSC_VER
+	res = __rdtsc();
 #else
-	//gnu version
-	__asm__ __volatile__ ("rdtsc" : "=A" (res));
+	//gnu version, "=A" is only edx:eax on 32 bit
+	uint32 lo, hi;
+	__asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+	res = ((int64)hi) << 32 | lo;
 #endif
 #else
-	//fall back to get time of day
+	//fall back to microseconds
+#ifdef _WINDOWS
+	struct _timeb tb;
+	_ftime(&tb);
+	res = ((int64)tb.time) * 1000000 + tb.millitm * 1000;
+#else
 	timeval t;
 	gettimeofday(&t, nullptr);
-	res = ((int64)t.tv_sec) * 1000 + t.tv_usec;
+	res = ((int64)t.tv_sec) * 1000000 + t.tv_usec;
 #endif
 #endif
 	return(res);
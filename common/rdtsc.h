@@ -48,8 +48,12 @@ public:
 	int64 getTicks() { return(_end - _start); }
 	static int64 ticksPerMS() { return(_ticsperms); }
 
-protected:
+	//raw counter, only differences are meaningful. calibrate() before
+	//using ticksPerMS without having constructed a timer.
 	static int64 rdtsc();
+	static void calibrate();
+
+protected:
 
 	int64 _start;
 	int64 _end;
@@ -96,6 +96,8 @@ RULE_BOOL ( Character, MaintainIntoxicationAcrossZones, true ) // If true, alcoh
 RULE_BOOL ( Character, EnableDiscoveredItems, true ) // If enabled, it enables EVENT_DISCOVER_ITEM and also saves character names and timestamps for the first time an item is discovered.
 RULE_BOOL ( Character, EnableXTargetting, true) // Enable Extended Targetting Window, for users with UF and later clients.
 RULE_BOOL ( Character, KeepLevelOverMax, false) // Don't delevel a character that has somehow gone over the level cap
+RULE_BOOL ( Character, DeltaProfileSaves, true) // Only write the parts of the player profile that changed since the last save, as a prepared statement
+RULE_BOOL ( Character, JournalInventorySaves, false) // Queue inventory writes and let the database thread batch them, instead of one blocking query per slot
 RULE_CATEGORY_END()
 
 RULE_CATEGORY( Mercs )
@@ -119,6 +121,7 @@ RULE_INT ( Guild, PlayerCreationLimit, 1)		// Only allow use of the UF+ window i
 RULE_INT ( Guild, PlayerCreationRequiredStatus, 0)	// Required admin status.
 RULE_INT ( Guild, PlayerCreationRequiredLevel, 0)	// Required Level of the player attempting to create the guild.
 RULE_INT ( Guild, PlayerCreationRequiredTime, 0)	// Required Time Entitled On Account (in Minutes) to create the guild.
+RULE_INT ( Guild, RosterCacheSeconds, 300)	// How long a zone keeps a guild's member list before reading it from the database again, 0 reads it for every send.
 
 RULE_CATEGORY_END()
 
@@ -165,6 +168,7 @@ RULE_INT ( World, PVPSettings, 0) // Sets the PVP settings for the server, 1 = R
 RULE_BOOL (World, IsGMPetitionWindowEnabled, false)
 RULE_INT (World, FVNoDropFlag, 0) // Sets the Firiona Vie settings on the client. If set to 2, the flag will be set for GMs only, allowing trading of no-drop items.
 RULE_BOOL (World, IPLimitDisconnectAll, false)
+RULE_INT ( World, WorldDBAsyncWorkers, 2) // Threads running async queries, each on its own database connection
 RULE_CATEGORY_END()
 
 RULE_CATEGORY( Zone )
@@ -193,6 +197,14 @@ RULE_INT ( Zone, ReservedInstances, 30 ) //Will reserve this many instance ids f
 RULE_INT ( Zone, EbonCrystalItemID, 40902)
 RULE_INT ( Zone, RadiantCrystalItemID, 40903)
 RULE_BOOL ( Zone, LevelBasedEXPMods, false) // Allows you to use the level_exp_mods table in consideration to your players EXP hits
+RULE_BOOL ( Zone, UseTimerWheel, false) // Mob tic, mana, stun, gravity and viral timers and NPC hp update and enrage timers go off from a timer wheel instead of being polled. Applies to mobs spawned after it is set.
+RULE_BOOL ( Zone, AdaptiveMainLoop, true) // Main loop sleeps until its next timer is due or a packet arrives, instead of a fixed 3ms every pass
+RULE_INT ( Zone, IdleLoopSleepMS, 50) // Longest the adaptive main loop sleeps when nothing is due, bounds how late world server messages are seen
+RULE_INT ( Zone, ZoneDBAsyncWorkers, 4) // Threads running async queries, each on its own database connection. Saves for one character still run in order.
+RULE_INT ( Zone, BootDBWorkers, 4) // Threads running the independent database loads of a zone boot, each on its own connection. 0 boots everything on the zone thread one load at a time
+RULE_BOOL ( Zone, EnableProfiler, false) // Start zones with the _ZP() section profiler on, #zprofile and the world console zoneprofile command toggle it at runtime
+RULE_INT ( Zone, ProfileSnapshotSeconds, 60) // While the profiler is on, append its counters to logs/zoneprofile_* this often and start a new interval. 0 disables the file
+RULE_BOOL ( Zone, ProfileSnapshotCSV, false) // Write profiler snapshots as CSV rows instead of one JSON object per line
 RULE_CATEGORY_END()
 
 RULE_CATEGORY( Map )
@@ -210,6 +222,7 @@ RULE_BOOL ( Map, UseClosestZ, false)			// Move mobs to the nearest Z above or be
 							// with azone2.
 							//
 RULE_INT ( Map, FindBestZHeightAdjust, 1)		// Adds this to the current Z before seeking the best Z position
+RULE_BOOL ( Map, UseFileCache, true)		// Load .map, .wtr and .path files from a shared, read only <file>.mmf beside each one, rebuilt when stale
 RULE_CATEGORY_END()
 
 RULE_CATEGORY( Pathing )
@@ -239,6 +252,7 @@ RULE_INT ( Pathing, MinNodesLeftForLOSCheck, 4)	// Only check for LOS when we ar
 RULE_INT ( Pathing, MinNodesTraversedForLOSCheck, 3)	// Only check for LOS after we have traversed this many path nodes.
 RULE_INT ( Pathing, CullNodesFromStart, 1)		// Checks LOS from Start point to second node for this many nodes and removes first node if there is LOS
 RULE_INT ( Pathing, CullNodesFromEnd, 1)		// Checks LOS from End point to second to last node for this many nodes and removes last node if there is LOS
+RULE_INT ( Pathing, RouteCacheSize, 262144)	// Bytes of node to node routes each zone keeps for reuse, 0 disables the cache.
 RULE_REAL ( Pathing, CandidateNodeRangeXY, 400)		// When searching for path start/end nodes, only nodes within this range will be considered.
 RULE_REAL ( Pathing, CandidateNodeRangeZ, 10)		// When searching for path start/end nodes, only nodes within this range will be considered.
 
@@ -506,6 +520,11 @@ RULE_INT ( EQStream, RetransmitTimeoutMax, 5000 ) // maximum retransmit timeout
 RULE_INT ( EQStream, AverageDeltaMax, 2500 ) // maximum average rtt where we will still recalculate transmit rates
 RULE_REAL ( EQStream, RetransmitTimeoutMult, 3.0 ) // multiplier applied to rtt stats to generate a retransmit timeout value
 RULE_BOOL ( EQStream, RetransmitAckedPackets, true ) // should we restransmit packets that were already acked?
+RULE_BOOL ( EQStream, BatchedReader, false ) // drain the UDP socket with epoll + recvmmsg instead of select + recvfrom (linux only, read when the port is opened)
+RULE_BOOL ( EQStream, EventWriter, false ) // write as soon as a stream queues data (sendmmsg where available) instead of polling every 10ms (read when the port is opened)
+RULE_INT ( EQStream, CompressMinSize, 30 ) // datagrams this size or smaller go out uncompressed
+RULE_INT ( EQStream, ZoneCompressLevel, 4 ) // zlib level for zone streams, 1 (fastest) to 9 (smallest), 0 sends everything uncompressed
+RULE_INT ( EQStream, WorldCompressLevel, 4 ) // zlib level for world streams, same range as ZoneCompressLevel
 RULE_CATEGORY_END()
 
 RULE_CATEGORY( QueryServ )
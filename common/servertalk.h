@@ -178,6 +178,7 @@
 #define ServerOP_CZSignalClientByName 0x4007
 #define ServerOP_CZMessagePlayer 0x4008
 #define ServerOP_ReloadWorld 0x4009
+#define ServerOP_ZoneProfile 0x400A
 
 #define ServerOP_QSPlayerLogTrades			0x4010
 #define ServerOP_QSPlayerLogHandins			0x4011
@@ -1229,6 +1230,11 @@ struct ReloadWorld_Struct{
 	uint32 Option;
 };
 
+enum { ZoneProfileOff = 0, ZoneProfileOn, ZoneProfileReset, ZoneProfileSnapshot };
+struct ServerZoneProfile_Struct {
+	uint32 Option;
+};
+
 #pragma pack()
 
 #endif
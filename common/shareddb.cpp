@@ -16,19 +16,23 @@
 #include "ipc_mutex.h"
 #include "eqemu_exception.h"
 #include "loottable.h"
+#include "spawngroup_table.h"
 #include "faction.h"
+#include "profile_save.h"
 #include "features.h"
 
 SharedDatabase::SharedDatabase()
-: Database(), skill_caps_mmf(nullptr), items_mmf(nullptr), items_hash(nullptr), faction_mmf(nullptr), faction_hash(nullptr),
-	loot_table_mmf(nullptr), loot_table_hash(nullptr), loot_drop_mmf(nullptr), loot_drop_hash(nullptr)
+: Database(), inv_journal_enabled(false), skill_caps_mmf(nullptr), items_mmf(nullptr), items_hash(nullptr), faction_mmf(nullptr), faction_hash(nullptr),
+	loot_table_mmf(nullptr), loot_table_hash(nullptr), loot_drop_mmf(nullptr), loot_drop_hash(nullptr), npc_types_mmf(nullptr),
+	npc_types_hash(nullptr), spawn_groups_mmf(nullptr), spawn_groups_hash(nullptr)
 {
 }
 
 SharedDatabase::SharedDatabase(const char* host, const char* user, const char* passwd, const char* database, uint32 port)
-: Database(host, user, passwd, database, port), skill_caps_mmf(nullptr), items_mmf(nullptr), items_hash(nullptr),
+: Database(host, user, passwd, database, port), inv_journal_enabled(false), skill_caps_mmf(nullptr), items_mmf(nullptr), items_hash(nullptr),
 	faction_mmf(nullptr), faction_hash(nullptr), loot_table_mmf(nullptr), loot_table_hash(nullptr), loot_drop_mmf(nullptr),
-	loot_drop_hash(nullptr)
+	loot_drop_hash(nullptr), npc_types_mmf(nullptr), npc_types_hash(nullptr), spawn_groups_mmf(nullptr),
+	spawn_groups_hash(nullptr)
 {
 }
 
@@ -42,6 +46,10 @@ SharedDatabase::~SharedDatabase() {
 	safe_delete(loot_drop_mmf);
 	safe_delete(loot_table_hash);
 	safe_delete(loot_drop_hash);
+	safe_delete(npc_types_mmf);
+	safe_delete(npc_types_hash);
+	safe_delete(spawn_groups_mmf);
+	safe_delete(spawn_groups_hash);
 }
 
 bool SharedDatabase::SetHideMe(uint32 account_id, uint8 hideme)
@@ -147,6 +155,13 @@ int i;
 bool ret=true;
 	char errbuf[MYSQL_ERRMSG_SIZE];
 	char* query = 0;
+	if (JournalingInventory()) {
+		inv_journal.Delete(char_id, "(slotid>=8000 AND slotid<=8999) OR slotid=30 OR (slotid>=331 AND slotid<=340)");
+		for(it=start,i=8000;it!=end;it++,i++)
+			JournalInventory(char_id, *it, (i==8000) ? 30 : i);
+		return true;
+	}
+	InventoryBarrier(char_id);
 	// Delete cursor items
 	if ((ret = RunQuery(query, MakeAnyLenString(&query, "DELETE FROM inventory WHERE charid=%i AND ( (slotid >=8000 and slotid<=8999) or slotid=30 or (slotid>=331 and slotid<=340))", char_id), errbuf))) {
 		for(it=start,i=8000;it!=end;it++,i++) {
@@ -210,6 +225,15 @@ bool SharedDatabase::SaveInventory(uint32 char_id, const ItemInst* inst, int16 s
 	if(slot_id >= 400 && slot_id <= 404)
 		return(true);
 
+	// Shared bank slots are read back by VerifyInventory and shared with the rest of the account, so they stay synchronous
+	if (slot_id < 2500 || slot_id > 2600) {
+		if (JournalingInventory()) {
+			JournalInventory(char_id, inst, slot_id);
+			return true;
+		}
+		InventoryBarrier(char_id);
+	}
+
 	if (inst && inst->IsType(ItemClassCommon)) {
 		for(int i=0;i<5;i++) {
 			ItemInst *auginst=inst->GetItem(i);
@@ -313,6 +337,106 @@ bool SharedDatabase::SaveInventory(uint32 char_id, const ItemInst* inst, int16 s
 	return ret;
 }
 
+bool SharedDatabase::JournalingInventory() {
+	return (inv_journal_enabled && RuleB(Character, JournalInventorySaves));
+}
+
+// Same rows SaveInventory writes for the inventory table, queued on the journal
+void SharedDatabase::JournalInventory(uint32 char_id, const ItemInst* inst, int16 slot_id) {
+	if(slot_id >= 400 && slot_id <= 404)
+		return;
+
+	char buf[256];
+	if (!inst) {
+		snprintf(buf, sizeof(buf), "slotid=%i", slot_id);
+		inv_journal.Delete(char_id, buf);
+		if (Inventory::SupportsContainers(slot_id)) {
+			int16 base_slot_id = Inventory::CalcSlotId(slot_id, 0);
+			snprintf(buf, sizeof(buf), "(slotid>=%i AND slotid<%i)", base_slot_id, (base_slot_id+10));
+			inv_journal.Delete(char_id, buf);
+		}
+		return;
+	}
+
+	uint32 augslot[5] = { 0, 0, 0, 0, 0 };
+	if (inst->IsType(ItemClassCommon)) {
+		for(int i=0;i<5;i++) {
+			ItemInst *auginst=inst->GetItem(i);
+			augslot[i]=(auginst && auginst->GetItem()) ? auginst->GetItem()->ID : 0;
+		}
+	}
+	uint16 charges = 0;
+	if(inst->GetCharges() >= 0)
+		charges = inst->GetCharges();
+	else
+		charges = 0x7FFF;
+
+	std::string row;
+	StringFormat(row, "(%lu,%lu,%lu,%lu,%lu,'%s',%lu,%lu,%lu,%lu,%lu,%lu)",
+		(unsigned long)char_id, (unsigned long)slot_id, (unsigned long)inst->GetItem()->ID, (unsigned long)charges,
+		(unsigned long)(inst->IsInstNoDrop() ? 1:0), inst->GetCustomDataString().c_str(), (unsigned long)inst->GetColor(),
+		(unsigned long)augslot[0],(unsigned long)augslot[1],(unsigned long)augslot[2],(unsigned long)augslot[3],(unsigned long)augslot[4]);
+	inv_journal.Replace(char_id, row);
+
+	if (inst->IsType(ItemClassContainer) && Inventory::SupportsContainers(slot_id)) {
+		for (uint8 idx=0; idx<10; idx++)
+			JournalInventory(char_id, inst->GetItem(idx), Inventory::CalcSlotId(slot_id, idx));
+	}
+}
+
+void SharedDatabase::FlushInventoryJournal(uint32 char_id) {
+	char errbuf[MYSQL_ERRMSG_SIZE];
+	std::vector<InventoryJournalBatch> batches;
+	inv_journal.Take(char_id, batches);
+	for (size_t b = 0; b < batches.size(); b++) {
+		uint32 errors = 0;
+		for (size_t q = 0; q < batches[b].statements.size(); q++) {
+			const std::string& sql = batches[b].statements[q];
+			if (!RunQuery(sql.c_str(), sql.length(), errbuf)) {
+				LogFile->write(EQEMuLog::Error, "Journaled inventory write '%s': %s", sql.c_str(), errbuf);
+				errors += RunInventoryFallback(batches[b].char_id, q);
+				break;
+			}
+		}
+		inv_journal.Completed(batches[b].char_id, errors);
+	}
+}
+
+uint32 SharedDatabase::RunInventoryFallback(uint32 char_id, uint32 failed) {
+	char errbuf[MYSQL_ERRMSG_SIZE];
+	std::vector<std::string> singles;
+	inv_journal.Fallback(char_id, failed, singles);
+	uint32 errors = 0;
+	for (size_t q = 0; q < singles.size(); q++) {
+		if (!RunQuery(singles[q].c_str(), singles[q].length(), errbuf)) {
+			LogFile->write(EQEMuLog::Error, "Journaled inventory write '%s': %s", singles[q].c_str(), errbuf);
+			errors++;
+		}
+	}
+	return errors;
+}
+
+// Zoning, camping and the synchronous writes to the same rows all come through
+// here, and the next reader goes straight to the inventory table, so this can't
+// just give up after a frame. Batches already on DBAsync have to land first (they
+// would pass anything run around them), then the rest of the journal runs here.
+bool SharedDatabase::InventoryBarrier(uint32 char_id) {
+	if (!inv_journal.Outstanding(char_id))
+		return true;
+
+	inv_journal.CountBarrier();
+	if (!inv_journal.WaitInFlight(char_id, INVENTORY_JOURNAL_BARRIER_MS)) {
+		LogFile->write(EQEMuLog::Status, "Journaled inventory writes for character %u still running after %u ms, waiting for them", char_id, INVENTORY_JOURNAL_BARRIER_MS);
+		if (!inv_journal.WaitInFlight(char_id, INVENTORY_JOURNAL_BARRIER_MAX_MS)) {
+			LogFile->write(EQEMuLog::Error, "Journaled inventory writes for character %u did not finish in %u ms, the database may not have this character's inventory yet", char_id, INVENTORY_JOURNAL_BARRIER_MAX_MS);
+			return false;
+		}
+	}
+	// not the virtual one, the zone's would queue them on DBAsync again
+	SharedDatabase::FlushInventoryJournal(char_id);
+	return true;
+}
+
 int32 SharedDatabase::GetSharedPlatinum(uint32 account_id)
 {
 	char errbuf[MYSQL_ERRMSG_SIZE];
@@ -511,27 +635,28 @@ bool SharedDatabase::GetSharedBank(uint32 id, Inventory* inv, bool is_charid) {
 bool SharedDatabase::GetInventory(uint32 char_id, Inventory* inv) {
 	_CP(Database_GetInventory);
 	char errbuf[MYSQL_ERRMSG_SIZE];
-	char* query = 0;
-	MYSQL_RES* result;
-	MYSQL_ROW row;
+	const char* query = "SELECT slotid,itemid,charges,color,augslot1,augslot2,augslot3,augslot4,augslot5,"
+		"instnodrop,custom_data FROM inventory WHERE charid=? ORDER BY slotid";
+	DBParams params;
+	DBResultSet result;
 	bool ret = false;
 
-	// Retrieve character inventory
-	if (RunQuery(query, MakeAnyLenString(&query, "SELECT slotid,itemid,charges,color,augslot1,augslot2,augslot3,augslot4,augslot5,"
-		"instnodrop,custom_data FROM inventory WHERE charid=%i ORDER BY slotid", char_id), errbuf, &result)) {
+	params.AddUInt(char_id);
 
-		while ((row = mysql_fetch_row(result))) {
-			int16 slot_id	= atoi(row[0]);
-			uint32 item_id	= atoi(row[1]);
-			uint16 charges	= atoi(row[2]);
-			uint32 color		= atoul(row[3]);
+	// Retrieve character inventory
+	if (RunPreparedQuery(query, strlen(query), params, result, errbuf)) {
+		for (uint32 row = 0; row < result.RowCount(); row++) {
+			int16 slot_id	= result.GetInt(row, 0);
+			uint32 item_id	= result.GetUInt(row, 1);
+			uint16 charges	= result.GetInt(row, 2);
+			uint32 color		= result.GetUInt(row, 3);
 			uint32 aug[5];
-			aug[0]	= (uint32)atoul(row[4]);
-			aug[1]	= (uint32)atoul(row[5]);
-			aug[2]	= (uint32)atoul(row[6]);
-			aug[3]	= (uint32)atoul(row[7]);
-			aug[4]	= (uint32)atoul(row[8]);
-			bool instnodrop	= (row[9] && (uint16)atoi(row[9])) ? true : false;
+			aug[0]	= result.GetUInt(row, 4);
+			aug[1]	= result.GetUInt(row, 5);
+			aug[2]	= result.GetUInt(row, 6);
+			aug[3]	= result.GetUInt(row, 7);
+			aug[4]	= result.GetUInt(row, 8);
+			bool instnodrop	= result.GetInt(row, 9) ? true : false;
 
 			const Item_Struct* item = GetItem(item_id);
 
@@ -540,8 +665,8 @@ bool SharedDatabase::GetInventory(uint32 char_id, Inventory* inv) {
 
 				ItemInst* inst = CreateBaseItem(item, charges);
 
-				if(row[10]) {
-					std::string data_str(row[10]);
+				if(!result.IsNull(row, 10)) {
+					std::string data_str(result.GetString(row, 10));
 					std::string id;
 					std::string value;
 					bool use_id = true;
@@ -602,7 +727,6 @@ bool SharedDatabase::GetInventory(uint32 char_id, Inventory* inv) {
 					char_id, item_id, slot_id);
 			}
 		}
-		mysql_free_result(result);
 
 		// Retrieve shared inventory
 		ret = GetSharedBank(char_id, inv, true);
@@ -612,7 +736,6 @@ bool SharedDatabase::GetInventory(uint32 char_id, Inventory* inv) {
 		LogFile->write(EQEMuLog::Error, "If you got an error related to the 'instnodrop' field, run the following SQL Queries:\nalter table inventory add instnodrop tinyint(1) unsigned default 0 not null;\n");
 	}
 
-	safe_delete_array(query);
 	return ret;
 }
 
@@ -1299,6 +1422,115 @@ uint32 SharedDatabase::SetPlayerProfile_MQ(char** query, uint32 account_id, uint
 }
 
 
+bool SharedDatabase::SetPlayerProfileDelta(ProfileSaveState& state, uint32 charid, PlayerProfile_Struct* pp, ExtendedProfile_Struct *ext, uint32 current_zone, uint32 current_instance, uint8 MaxXTargets) {
+	_CP(Database_SetPlayerProfile);
+	char errbuf[MYSQL_ERRMSG_SIZE];
+	char* query = 0;
+	DBParams* params = 0;
+	uint32 affected_rows = 0;
+
+	uint32 len = SetPlayerProfileDelta_MQ(&query, &params, state, charid, pp, ext, current_zone, current_instance, MaxXTargets);
+	if (len == 0)
+		return (strlen(pp->name) != 0);	// nothing changed
+
+	bool ret = false;
+	if (RunPreparedQuery(query, len, *params, errbuf, &affected_rows)) {
+		ret = (affected_rows != 0);
+	}
+
+	if (!ret) {
+		LogFile->write(EQEMuLog::Error, "SetPlayerProfileDelta query '%s' %s", query, errbuf);
+		state.Invalidate();
+	}
+
+	safe_delete_array(query);
+	safe_delete(params);
+	return ret;
+}
+
+// Appends the SQL for a blob column. A whole blob is bound as is, otherwise the
+// changed ranges are spliced into the stored value with nested INSERT()s.
+static void AppendBlobDelta(std::string& sql, DBParams& params, const char* column, const void* data, const std::vector<DeltaRun>& runs, uint32 blob_size) {
+	if (runs.empty())
+		return;
+	sql += ", ";
+	sql += column;
+	sql += "=";
+	if (runs.size() == 1 && runs[0].offset == 0 && runs[0].length == blob_size) {
+		sql += "?";
+		params.AddBlob(data, blob_size);
+		return;
+	}
+	size_t r;
+	for (r = 0; r < runs.size(); r++)
+		sql += "INSERT(";
+	sql += column;
+	for (r = 0; r < runs.size(); r++) {
+		sql += ",?,?,?)";
+		params.AddUInt(runs[r].offset + 1);	// INSERT() positions are 1 based
+		params.AddUInt(runs[r].length);
+		params.AddBlob((const uint8*) data + runs[r].offset, runs[r].length);
+	}
+}
+
+// Generate a parameterized update for whatever changed since the last write through state.
+// Returns 0 if there is nothing to write.
+uint32 SharedDatabase::SetPlayerProfileDelta_MQ(char** query, DBParams** params, ProfileSaveState& state, uint32 charid, PlayerProfile_Struct* pp, ExtendedProfile_Struct *ext, uint32 current_zone, uint32 current_instance, uint8 MaxXTargets) {
+	*query = 0;
+	*params = 0;
+	if (!current_zone)
+		current_zone = pp->zone_id;
+
+	if (!current_instance)
+		current_instance = pp->zoneInstance;
+
+	if(strlen(pp->name) == 0) // Sanity check in case pp never loaded
+		return 0;
+
+	ProfileSaveState::stats.full_bytes += sizeof(PlayerProfile_Struct) + sizeof(ExtendedProfile_Struct);
+
+	bool pp_changed = state.pp.Collect(pp, state.pp_runs);
+	bool ext_changed = state.ext.Collect(ext, state.ext_runs);
+	if (!pp_changed && !ext_changed && !state.force_write && state.zone_id == current_zone
+		&& state.instance_id == current_instance && state.xtargets == MaxXTargets) {
+		ProfileSaveState::stats.skipped++;
+		return 0;
+	}
+	state.zone_id = current_zone;
+	state.instance_id = current_instance;
+	state.xtargets = MaxXTargets;
+	state.force_write = false;
+
+	DBParams* p = new DBParams;
+	std::string sql = "UPDATE character_ SET timelaston=unix_timestamp(now()), name=?, zonename=?, zoneid=?, instanceid=?, x=?, y=?, z=?";
+	p->AddString(pp->name);
+	p->AddString(GetZoneName(current_zone));
+	p->AddUInt(current_zone);
+	p->AddUInt(current_instance);
+	p->AddFloat(pp->x);
+	p->AddFloat(pp->y);
+	p->AddFloat(pp->z);
+	AppendBlobDelta(sql, *p, "profile", pp, state.pp_runs, sizeof(PlayerProfile_Struct));
+	AppendBlobDelta(sql, *p, "extprofile", ext, state.ext_runs, sizeof(ExtendedProfile_Struct));
+	sql += ", class=?, level=?, xtargets=? WHERE id=?";
+	p->AddUInt(pp->class_);
+	p->AddUInt(pp->level);
+	p->AddUInt(MaxXTargets);
+	p->AddUInt(charid);
+
+	ProfileSaveState::stats.writes++;
+	size_t r;
+	for (r = 0; r < state.pp_runs.size(); r++)
+		ProfileSaveState::stats.written_bytes += state.pp_runs[r].length;
+	for (r = 0; r < state.ext_runs.size(); r++)
+		ProfileSaveState::stats.written_bytes += state.ext_runs[r].length;
+	if (state.pp.IsFull(state.pp_runs) || state.ext.IsFull(state.ext_runs))
+		ProfileSaveState::stats.full_writes++;
+
+	*query = strn0cpy(new char[sql.length() + 1], sql.c_str(), sql.length() + 1);
+	*params = p;
+	return sql.length();
+}
 
 // Create appropriate ItemInst class
 ItemInst* SharedDatabase::CreateItem(uint32 item_id, int16 charges, uint32 aug1, uint32 aug2, uint32 aug3, uint32 aug4, uint32 aug5)
@@ -1954,6 +2186,456 @@ const LootDrop_Struct* SharedDatabase::GetLootDrop(uint32 lootdrop_id) {
 	return nullptr;
 }
 
+#define NPCTypeBaseQuery \
+	"SELECT npc_types.id, npc_types.name, npc_types.level, npc_types.race, npc_types.class, npc_types.hp," \
+	" npc_types.mana, npc_types.gender, npc_types.texture, npc_types.helmtexture, npc_types.size," \
+	" npc_types.loottable_id, npc_types.merchant_id, npc_types.alt_currency_id, npc_types.adventure_template_id," \
+	" npc_types.trap_template, npc_types.attack_speed, npc_types.STR, npc_types.STA, npc_types.DEX, npc_types.AGI," \
+	" npc_types._INT, npc_types.WIS, npc_types.CHA, npc_types.MR, npc_types.CR, npc_types.DR, npc_types.FR," \
+	" npc_types.PR, npc_types.Corrup, npc_types.mindmg, npc_types.maxdmg, npc_types.attack_count," \
+	" npc_types.npcspecialattks, npc_types.npc_spells_id, npc_types.d_meele_texture1, npc_types.d_meele_texture2," \
+	" npc_types.prim_melee_type, npc_types.sec_melee_type, npc_types.runspeed, npc_types.findable," \
+	" npc_types.trackable, npc_types.hp_regen_rate, npc_types.mana_regen_rate, npc_types.aggroradius," \
+	" npc_types.bodytype, npc_types.npc_faction_id, npc_types.face, npc_types.luclin_hairstyle," \
+	" npc_types.luclin_haircolor, npc_types.luclin_eyecolor, npc_types.luclin_eyecolor2," \
+	" npc_types.luclin_beardcolor, npc_types.luclin_beard, npc_types.drakkin_heritage, npc_types.drakkin_tattoo," \
+	" npc_types.drakkin_details, npc_types.armortint_id, npc_types.armortint_red, npc_types.armortint_green," \
+	" npc_types.armortint_blue, npc_types.see_invis, npc_types.see_invis_undead, npc_types.lastname," \
+	" npc_types.qglobal, npc_types.AC, npc_types.npc_aggro, npc_types.spawn_limit, npc_types.see_hide," \
+	" npc_types.see_improved_hide, npc_types.ATK, npc_types.Accuracy, npc_types.slow_mitigation," \
+	" npc_types.maxlevel, npc_types.scalerate, npc_types.private_corpse, npc_types.unique_spawn_by_name," \
+	" npc_types.underwater, npc_types.emoteid, npc_types.spellscale, npc_types.healscale" \
+	" FROM npc_types"
+
+#define NPCTypeTintQuery \
+	"SELECT id, red1h, grn1h, blu1h, red2c, grn2c, blu2c, red3a, grn3a, blu3a, red4b, grn4b, blu4b," \
+	" red5g, grn5g, blu5g, red6l, grn6l, blu6l, red7f, grn7f, blu7f, red8x, grn8x, blu8x," \
+	" red9x, grn9x, blu9x FROM npc_types_tint"
+
+//fills in everything but the per slot tints, which come from npc_types_tint when
+//the returned armortint_id is set and the row's own tint is black.
+uint32 SharedDatabase::ParseNPCType(MYSQL_ROW row, NPCType &into) {
+	memset(&into, 0, sizeof(into));
+
+	int r = 0;
+	into.npc_id = atoi(row[r++]);
+
+	strn0cpy(into.name, row[r++], 50);
+
+	into.level = atoi(row[r++]);
+	into.race = atoi(row[r++]);
+	into.class_ = atoi(row[r++]);
+	into.max_hp = atoi(row[r++]);
+	into.cur_hp = into.max_hp;
+	into.Mana = atoi(row[r++]);
+	into.gender = atoi(row[r++]);
+	into.texture = atoi(row[r++]);
+	into.helmtexture = atoi(row[r++]);
+	into.size = atof(row[r++]);
+	into.loottable_id = atoi(row[r++]);
+	into.merchanttype = atoi(row[r++]);
+	into.alt_currency_type = atoi(row[r++]);
+	into.adventure_template = atoi(row[r++]);
+	into.trap_template = atoi(row[r++]);
+	into.attack_speed = atof(row[r++]);
+	into.STR = atoi(row[r++]);
+	into.STA = atoi(row[r++]);
+	into.DEX = atoi(row[r++]);
+	into.AGI = atoi(row[r++]);
+	into.INT = atoi(row[r++]);
+	into.WIS = atoi(row[r++]);
+	into.CHA = atoi(row[r++]);
+	into.MR = atoi(row[r++]);
+	into.CR = atoi(row[r++]);
+	into.DR = atoi(row[r++]);
+	into.FR = atoi(row[r++]);
+	into.PR = atoi(row[r++]);
+	into.Corrup = atoi(row[r++]);
+	into.min_dmg = atoi(row[r++]);
+	into.max_dmg = atoi(row[r++]);
+	into.attack_count = atoi(row[r++]);
+	strn0cpy(into.npc_attacks, row[r++], sizeof(into.npc_attacks));
+	into.npc_spells_id = atoi(row[r++]);
+	into.d_meele_texture1 = atoi(row[r++]);
+	into.d_meele_texture2 = atoi(row[r++]);
+	into.prim_melee_type = atoi(row[r++]);
+	into.sec_melee_type = atoi(row[r++]);
+	into.runspeed= atof(row[r++]);
+	into.findable = atoi(row[r++]) == 0? false : true;
+	into.trackable = atoi(row[r++]) == 0? false : true;
+	into.hp_regen = atoi(row[r++]);
+	into.mana_regen = atoi(row[r++]);
+
+	into.aggroradius = (int32)atoi(row[r++]);
+	// set defaultvalue for aggroradius
+	if (into.aggroradius <= 0)
+		into.aggroradius = 70;
+
+	if (row[r] && strlen(row[r]))
+		into.bodytype = (uint8)atoi(row[r]);
+	else
+		into.bodytype = 0;
+	r++;
+
+	into.npc_faction_id = atoi(row[r++]);
+
+	into.luclinface = atoi(row[r++]);
+	into.hairstyle = atoi(row[r++]);
+	into.haircolor = atoi(row[r++]);
+	into.eyecolor1 = atoi(row[r++]);
+	into.eyecolor2 = atoi(row[r++]);
+	into.beardcolor = atoi(row[r++]);
+	into.beard = atoi(row[r++]);
+	into.drakkin_heritage = atoi(row[r++]);
+	into.drakkin_tattoo = atoi(row[r++]);
+	into.drakkin_details = atoi(row[r++]);
+	uint32 armor_tint_id = atoi(row[r++]);
+	into.armor_tint[0] = (atoi(row[r++]) & 0xFF) << 16;
+	into.armor_tint[0] |= (atoi(row[r++]) & 0xFF) << 8;
+	into.armor_tint[0] |= (atoi(row[r++]) & 0xFF);
+	into.armor_tint[0] |= (into.armor_tint[0]) ? (0xFF << 24) : 0;
+	for (int i = 1; i < MAX_MATERIALS; i++)
+		into.armor_tint[i] = into.armor_tint[0];
+	if (into.armor_tint[0] != 0)
+		armor_tint_id = 0;
+
+	into.see_invis = atoi(row[r++]);
+	into.see_invis_undead = atoi(row[r++])==0?false:true;	// Set see_invis_undead flag
+	if (row[r] != nullptr)
+		strn0cpy(into.lastname, row[r], 32);
+	r++;
+
+	into.qglobal = atoi(row[r++])==0?false:true;	// qglobal
+	into.AC = atoi(row[r++]);
+	into.npc_aggro = atoi(row[r++])==0?false:true;
+	into.spawn_limit = atoi(row[r++]);
+	into.see_hide = atoi(row[r++])==0?false:true;
+	into.see_improved_hide = atoi(row[r++])==0?false:true;
+	into.ATK = atoi(row[r++]);
+	into.accuracy_rating = atoi(row[r++]);
+	into.slow_mitigation = atof(row[r++]);
+	into.maxlevel = atoi(row[r++]);
+	into.scalerate = atoi(row[r++]);
+	into.private_corpse = atoi(row[r++]) == 1 ? true : false;
+	into.unique_spawn_by_name = atoi(row[r++]) == 1 ? true : false;
+	into.underwater = atoi(row[r++]) == 1 ? true : false;
+	into.emoteid = atoi(row[r++]);
+	into.spellscale = atoi(row[r++]);
+	into.healscale = atoi(row[r++]);
+
+	return armor_tint_id;
+}
+
+static void ParseNPCTypeTint(MYSQL_ROW row, uint32 *armor_tint) {
+	//row[0] is the id
+	for (int i = 0; i < MAX_MATERIALS; i++) {
+		armor_tint[i] = atoi(row[i * 3 + 1]) << 16;
+		armor_tint[i] |= atoi(row[i * 3 + 2]) << 8;
+		armor_tint[i] |= atoi(row[i * 3 + 3]);
+		armor_tint[i] |= (armor_tint[i]) ? (0xFF << 24) : 0;
+	}
+}
+
+bool SharedDatabase::GetNPCTypeTint(uint32 tint_id, uint32 *armor_tint) {
+	char errbuf[MYSQL_ERRMSG_SIZE];
+	char *query = nullptr;
+	MYSQL_RES *result;
+	MYSQL_ROW row;
+	bool ret = false;
+
+	if (RunQuery(query, MakeAnyLenString(&query, NPCTypeTintQuery " WHERE id=%d", tint_id), errbuf, &result)) {
+		if ((row = mysql_fetch_row(result))) {
+			ParseNPCTypeTint(row, armor_tint);
+			ret = true;
+		}
+		mysql_free_result(result);
+	}
+	safe_delete_array(query);
+	return ret;
+}
+
+bool SharedDatabase::GetNPCTypeFromDB(uint32 id, NPCType &into) {
+	char errbuf[MYSQL_ERRMSG_SIZE];
+	char *query = nullptr;
+	MYSQL_RES *result;
+	MYSQL_ROW row;
+	bool ret = false;
+	uint32 tint_id = 0;
+
+	if (RunQuery(query, MakeAnyLenString(&query, NPCTypeBaseQuery " WHERE id=%d", id), errbuf, &result)) {
+		if ((row = mysql_fetch_row(result))) {
+			tint_id = ParseNPCType(row, into);
+			ret = true;
+		}
+		mysql_free_result(result);
+	} else {
+		LogFile->write(EQEMuLog::Error, "Error loading npc type %u: %s", id, errbuf);
+	}
+	safe_delete_array(query);
+
+	if (ret && tint_id != 0)
+		GetNPCTypeTint(tint_id, into.armor_tint);
+	return ret;
+}
+
+void SharedDatabase::GetNPCTypesInfo(uint32 &npc_type_count, uint32 &max_npc_type) {
+	char errbuf[MYSQL_ERRMSG_SIZE];
+	MYSQL_RES *result;
+	MYSQL_ROW row;
+	npc_type_count = 0;
+	max_npc_type = 0;
+
+	const char *query = "SELECT MAX(id), count(*) FROM npc_types";
+	if(RunQuery(query, static_cast<uint32>(strlen(query)), errbuf, &result)) {
+		if(row = mysql_fetch_row(result)) {
+			if(row[0] && row[1]) {
+				max_npc_type = static_cast<uint32>(atoul(row[0]));
+				npc_type_count = static_cast<uint32>(atoul(row[1]));
+			}
+		}
+		mysql_free_result(result);
+	} else {
+		LogFile->write(EQEMuLog::Error, "Error getting npc type info from database: %s, %s", query, errbuf);
+	}
+}
+
+void SharedDatabase::LoadNPCTypes(void *data, uint32 size, uint32 npc_type_count, uint32 max_npc_type) {
+	EQEmu::FixedMemoryHashSet<NPCType> hash(reinterpret_cast<uint8*>(data), size, npc_type_count, max_npc_type);
+	char errbuf[MYSQL_ERRMSG_SIZE];
+	MYSQL_RES *result;
+	MYSQL_ROW row;
+
+	//one pass over the tints instead of a query per npc that uses one
+	std::map<uint32, std::vector<uint32> > tints;
+	const char *tint_query = NPCTypeTintQuery;
+	if(RunQuery(tint_query, static_cast<uint32>(strlen(tint_query)), errbuf, &result)) {
+		while((row = mysql_fetch_row(result))) {
+			std::vector<uint32> &tint = tints[static_cast<uint32>(atoul(row[0]))];
+			tint.resize(MAX_MATERIALS);
+			ParseNPCTypeTint(row, &tint[0]);
+		}
+		mysql_free_result(result);
+	} else {
+		LogFile->write(EQEMuLog::Error, "Error getting npc type tints from database: %s", errbuf);
+	}
+
+	const char *query = NPCTypeBaseQuery " ORDER BY id";
+	if(RunQuery(query, static_cast<uint32>(strlen(query)), errbuf, &result)) {
+		NPCType npc;
+		while((row = mysql_fetch_row(result))) {
+			uint32 tint_id = ParseNPCType(row, npc);
+			if(tint_id != 0) {
+				std::map<uint32, std::vector<uint32> >::const_iterator tint = tints.find(tint_id);
+				if(tint != tints.end())
+					memcpy(npc.armor_tint, &tint->second[0], sizeof(npc.armor_tint));
+			}
+			hash.insert(npc.npc_id, npc);
+		}
+		mysql_free_result(result);
+	} else {
+		LogFile->write(EQEMuLog::Error, "Error getting npc types from database: %s, %s", query, errbuf);
+	}
+}
+
+bool SharedDatabase::LoadNPCTypes() {
+	if(npc_types_hash) {
+		return true;
+	}
+
+	try {
+		EQEmu::IPCMutex mutex("npc_types");
+		mutex.Lock();
+		npc_types_mmf = new EQEmu::MemoryMappedFile("shared/npc_types");
+
+		uint32 npc_type_count = 0;
+		uint32 max_npc_type = 0;
+		GetNPCTypesInfo(npc_type_count, max_npc_type);
+		if(npc_type_count == 0) {
+			EQ_EXCEPT("SharedDatabase", "Database returned no result");
+		}
+		uint32 size = static_cast<uint32>(EQEmu::FixedMemoryHashSet<NPCType>::estimated_size(
+			npc_type_count, max_npc_type));
+
+		if(npc_types_mmf->Size() != size) {
+			EQ_EXCEPT("SharedDatabase", "Couldn't load npc types because npc_types_mmf->Size() != size");
+		}
+
+		npc_types_hash = new EQEmu::FixedMemoryHashSet<NPCType>(reinterpret_cast<uint8*>(npc_types_mmf->Get()), size);
+		mutex.Unlock();
+	} catch(std::exception& ex) {
+		LogFile->write(EQEMuLog::Error, "Error Loading npc types: %s", ex.what());
+		safe_delete(npc_types_mmf);
+		return false;
+	}
+
+	return true;
+}
+
+//ReloadNPCType can rewrite an entry from another process at any time, so
+//nothing holds pointers into the table: callers keep the copy made here
+bool SharedDatabase::GetSharedNPCType(uint32 id, NPCType &into) {
+	if(!npc_types_hash || !npc_types_hash->exists(id))
+		return false;
+
+	try {
+		EQEmu::IPCMutex mutex("npc_types");
+		mutex.Lock();
+		memcpy(&into, &npc_types_hash->at(id), sizeof(NPCType));
+		mutex.Unlock();
+	} catch(std::exception& ex) {
+		LogFile->write(EQEMuLog::Error, "Error copying npc type %u: %s", id, ex.what());
+		return false;
+	}
+	return true;
+}
+
+//writes over the shared entry, under the lock GetSharedNPCType copies with.
+//Zones only copy an entry when they don't have one cached, so they pick the
+//change up after their next repop, and npcs already spawned keep the old one.
+//Ids that weren't in npc_types when the table was built can't be added.
+bool SharedDatabase::ReloadNPCType(uint32 id) {
+	if(!npc_types_hash || !npc_types_hash->exists(id))
+		return false;
+
+	NPCType npc;
+	if(!GetNPCTypeFromDB(id, npc))
+		return false;
+
+	try {
+		EQEmu::IPCMutex mutex("npc_types");
+		mutex.Lock();
+		npc_types_hash->insert(id, npc);
+		mutex.Unlock();
+	} catch(std::exception& ex) {
+		LogFile->write(EQEMuLog::Error, "Error reloading npc type %u: %s", id, ex.what());
+		return false;
+	}
+	return true;
+}
+
+void SharedDatabase::GetSpawnGroupInfo(uint32 &spawn_group_count, uint32 &max_spawn_group, uint32 &spawn_group_entries) {
+	spawn_group_count = 0;
+	max_spawn_group = 0;
+	spawn_group_entries = 0;
+	const char *query = "SELECT COUNT(*), MAX(id), (SELECT COUNT(*) FROM spawnentry) FROM spawngroup";
+	char errbuf[MYSQL_ERRMSG_SIZE];
+	MYSQL_RES *result;
+	MYSQL_ROW row;
+
+	if(RunQuery(query, strlen(query), errbuf, &result)) {
+		if(row = mysql_fetch_row(result)) {
+			spawn_group_count = static_cast<uint32>(atoul(row[0]));
+			max_spawn_group = row[1] ? static_cast<uint32>(atoul(row[1])) : 0;
+			spawn_group_entries = static_cast<uint32>(atoul(row[2]));
+		}
+		mysql_free_result(result);
+	} else {
+		LogFile->write(EQEMuLog::Error, "Error getting spawn group info from database: %s, %s", query, errbuf);
+	}
+}
+
+//every spawn group in the database, not just one zone's, with its alias table already built
+void SharedDatabase::LoadSpawnGroupTable(void *data, uint32 size) {
+	EQEmu::FixedMemoryVariableHashSet<SpawnGroup_Struct> hash(reinterpret_cast<uint8*>(data), size);
+	const char *query = "SELECT spawngroup.id, spawngroup.name, spawngroup.spawn_limit, spawngroup.dist, "
+		"spawngroup.max_x, spawngroup.min_x, spawngroup.max_y, spawngroup.min_y, spawngroup.delay, "
+		"spawngroup.despawn, spawngroup.despawn_timer, spawnentry.npcID, spawnentry.chance, npc_types.spawn_limit, "
+		"npc_types.id FROM spawngroup LEFT JOIN spawnentry ON spawnentry.spawngroupID = spawngroup.id "
+		"LEFT JOIN npc_types ON npc_types.id = spawnentry.npcID ORDER BY spawngroup.id";
+	char errbuf[MYSQL_ERRMSG_SIZE];
+	MYSQL_RES *result;
+	MYSQL_ROW row;
+
+	uint32 group_size = sizeof(SpawnGroup_Struct) + (sizeof(SpawnGroupEntries_Struct) * MAX_SPAWNGROUP_ENTRIES);
+	std::vector<uint8> spawn_group(group_size);
+	SpawnGroup_Struct *sg = reinterpret_cast<SpawnGroup_Struct*>(&spawn_group[0]);
+	if(RunQuery(query, strlen(query), errbuf, &result)) {
+		uint32 current_id = 0;
+		while(row = mysql_fetch_row(result)) {
+			uint32 id = static_cast<uint32>(atoul(row[0]));
+			if(id != current_id) {
+				if(current_id != 0) {
+					BuildSpawnGroupAlias(sg);
+					hash.insert(current_id, &spawn_group[0], (sizeof(SpawnGroup_Struct) +
+						(sizeof(SpawnGroupEntries_Struct) * sg->NumEntries)));
+				}
+
+				memset(&spawn_group[0], 0, group_size);
+				current_id = id;
+				strn0cpy(sg->name, row[1] ? row[1] : "", sizeof(sg->name));
+				sg->spawn_limit = atoi(row[2]);
+				sg->dist = static_cast<float>(atof(row[3]));
+				sg->max_x = static_cast<float>(atof(row[4]));
+				sg->min_x = static_cast<float>(atof(row[5]));
+				sg->max_y = static_cast<float>(atof(row[6]));
+				sg->min_y = static_cast<float>(atof(row[7]));
+				sg->delay = atoi(row[8]);
+				sg->despawn = atoi(row[9]);
+				sg->despawn_timer = static_cast<uint32>(atoul(row[10]));
+			}
+
+			//no entries, or an entry for an npc that doesn't exist
+			if(!row[11] || !row[14]) {
+				continue;
+			}
+
+			if(sg->NumEntries >= MAX_SPAWNGROUP_ENTRIES) {
+				continue;
+			}
+
+			SpawnGroupEntries_Struct &entry = sg->Entries[sg->NumEntries];
+			entry.npc_type = static_cast<uint32>(atoul(row[11]));
+			entry.chance = atoi(row[12]);
+			entry.npc_spawn_limit = row[13] ? static_cast<uint8>(atoi(row[13])) : 0;
+			++(sg->NumEntries);
+		}
+		if(current_id != 0) {
+			BuildSpawnGroupAlias(sg);
+			hash.insert(current_id, &spawn_group[0], (sizeof(SpawnGroup_Struct) +
+				(sizeof(SpawnGroupEntries_Struct) * sg->NumEntries)));
+		}
+
+		mysql_free_result(result);
+	} else {
+		LogFile->write(EQEMuLog::Error, "Error getting spawn groups from database: %s, %s", query, errbuf);
+	}
+}
+
+bool SharedDatabase::LoadSharedSpawnGroups() {
+	if(spawn_groups_hash)
+		return true;
+
+	try {
+		EQEmu::IPCMutex mutex("spawn_groups");
+		mutex.Lock();
+		spawn_groups_mmf = new EQEmu::MemoryMappedFile("shared/spawn_groups");
+		spawn_groups_hash = new EQEmu::FixedMemoryVariableHashSet<SpawnGroup_Struct>(
+			reinterpret_cast<uint8*>(spawn_groups_mmf->Get()),
+			spawn_groups_mmf->Size());
+		mutex.Unlock();
+	} catch(std::exception &ex) {
+		LogFile->write(EQEMuLog::Error, "Error loading spawn groups: %s", ex.what());
+		safe_delete(spawn_groups_mmf);
+		return false;
+	}
+
+	return true;
+}
+
+const SpawnGroup_Struct* SharedDatabase::GetSharedSpawnGroup(uint32 id) {
+	if(!spawn_groups_hash)
+		return nullptr;
+
+	try {
+		if(spawn_groups_hash->exists(id)) {
+			return &spawn_groups_hash->at(id);
+		}
+	} catch(std::exception &ex) {
+		LogFile->write(EQEMuLog::Error, "Could not get spawn group: %s", ex.what());
+	}
+	return nullptr;
+}
+
 void SharedDatabase::GetPlayerInspectMessage(char* playername, InspectMessage_Struct* message) {
 
 	char errbuf[MYSQL_ERRMSG_SIZE];
@@ -9,6 +9,8 @@
 #include "Item.h"
 #include "fixed_memory_hash_set.h"
 #include "fixed_memory_variable_hash_set.h"
+#include "inventory_journal.h"
+#include "npc_type.h"
 
 #include <list>
 
@@ -18,6 +20,8 @@ struct NPCFactionList;
 struct Faction;
 struct LootTable_Struct;
 struct LootDrop_Struct;
+struct SpawnGroup_Struct;
+class ProfileSaveState;
 namespace EQEmu {
 	class MemoryMappedFile;
 }
@@ -42,6 +46,9 @@ public:
 	bool	GetPlayerProfile(uint32 account_id, char* name, PlayerProfile_Struct* pp, Inventory* inv, ExtendedProfile_Struct *ext, char* current_zone = 0, uint32 *current_instance = 0);
 	bool	SetPlayerProfile(uint32 account_id, uint32 charid, PlayerProfile_Struct* pp, Inventory* inv, ExtendedProfile_Struct *ext, uint32 current_zone, uint32 current_instance, uint8 MaxXTargets);
 	uint32	SetPlayerProfile_MQ(char** query, uint32 account_id, uint32 charid, PlayerProfile_Struct* pp, Inventory* inv, ExtendedProfile_Struct *ext, uint32 current_zone, uint32 current_instance, uint8 MaxXTargets);
+	// Only writes the parts of the profiles that changed since the last save through state
+	bool	SetPlayerProfileDelta(ProfileSaveState& state, uint32 charid, PlayerProfile_Struct* pp, ExtendedProfile_Struct *ext, uint32 current_zone, uint32 current_instance, uint8 MaxXTargets);
+	uint32	SetPlayerProfileDelta_MQ(char** query, DBParams** params, ProfileSaveState& state, uint32 charid, PlayerProfile_Struct* pp, ExtendedProfile_Struct *ext, uint32 current_zone, uint32 current_instance, uint8 MaxXTargets);
 	int32	DeleteStalePlayerCorpses();
 	int32	DeleteStalePlayerBackups();
 	void	GetPlayerInspectMessage(char* playername, InspectMessage_Struct* message);
@@ -64,6 +71,18 @@ public:
 	bool	GetInventory(uint32 account_id, char* name, Inventory* inv);
 	bool	SetStartingItems(PlayerProfile_Struct* pp, Inventory* inv, uint32 si_race, uint32 si_class, uint32 si_deity, uint32 si_current_zone, char* si_name, int admin);
 
+	// Character inventory writes go through a journal that is flushed once per loop instead of running inline
+	void	EnableInventoryJournal() { inv_journal_enabled = true; }
+	InventoryJournal& GetInventoryJournal() { return inv_journal; }
+	bool	JournalingInventory();
+	// Writes journaled entries of one character, or everyone with 0. Runs them inline here, zone queues them on DBAsync.
+	virtual void FlushInventoryJournal(uint32 char_id = 0);
+	// Reruns a failed batch one row at a time from statement failed on, returns how many rows still failed
+	uint32	RunInventoryFallback(uint32 char_id, uint32 failed);
+	// Makes sure every journaled inventory write of char_id reached the database: waits for the
+	// ones on DBAsync and runs the rest inline. False (and logged) only if DBAsync never finished.
+	bool	InventoryBarrier(uint32 char_id);
+
 
 	std::string	GetBook(const char *txtfile);
 
@@ -106,11 +125,30 @@ public:
 	uint16 GetSkillCap(uint8 Class_, SkillType Skill, uint8 Level);
 	uint8 GetTrainLevel(uint8 Class_, SkillType Skill, uint8 Level);
 
+	//npc types
+	void GetNPCTypesInfo(uint32 &npc_type_count, uint32 &max_npc_type);
+	void LoadNPCTypes(void *data, uint32 size, uint32 npc_type_count, uint32 max_npc_type);
+	bool LoadNPCTypes();
+	bool GetSharedNPCType(uint32 id, NPCType &into);	//copies one entry out under the table's lock
+	bool GetNPCTypeFromDB(uint32 id, NPCType &into);
+	bool ReloadNPCType(uint32 id);	//rereads one npc type from the database into the shared table
+
+	//spawn groups
+	void GetSpawnGroupInfo(uint32 &spawn_group_count, uint32 &max_spawn_group, uint32 &spawn_group_entries);
+	void LoadSpawnGroupTable(void *data, uint32 size);
+	bool LoadSharedSpawnGroups();
+	bool HasSharedSpawnGroups() const { return spawn_groups_hash != nullptr; }
+	const SpawnGroup_Struct* GetSharedSpawnGroup(uint32 id);
+
 	int GetMaxSpellID();
 	void LoadSpells(void *data, int max_spells);
 	void LoadDamageShieldTypes(SPDat_Spell_Struct* sp, int32 iMaxSpellID);
 
 protected:
+	void	JournalInventory(uint32 char_id, const ItemInst* inst, int16 slot_id);
+
+	bool inv_journal_enabled;
+	InventoryJournal inv_journal;
 
 	EQEmu::MemoryMappedFile *skill_caps_mmf;
 	EQEmu::MemoryMappedFile *items_mmf;
@@ -121,6 +159,13 @@ protected:
 	EQEmu::FixedMemoryVariableHashSet<LootTable_Struct> *loot_table_hash;
 	EQEmu::MemoryMappedFile *loot_drop_mmf;
 	EQEmu::FixedMemoryVariableHashSet<LootDrop_Struct> *loot_drop_hash;
+	EQEmu::MemoryMappedFile *npc_types_mmf;
+	EQEmu::FixedMemoryHashSet<NPCType> *npc_types_hash;
+	EQEmu::MemoryMappedFile *spawn_groups_mmf;
+	EQEmu::FixedMemoryVariableHashSet<SpawnGroup_Struct> *spawn_groups_hash;
+
+	uint32 ParseNPCType(MYSQL_ROW row, NPCType &into);	//returns the row's armortint_id
+	bool GetNPCTypeTint(uint32 tint_id, uint32 *armor_tint);
 };
 
 #endif /*SHAREDDB_H_*/
@@ -0,0 +1,72 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemu.org)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#include "spawngroup_table.h"
+#include <vector>
+
+void BuildSpawnGroupAlias(SpawnGroup_Struct *group) {
+	uint32 count = group->NumEntries;
+	uint32 total = 0;
+	uint32 r;
+
+	group->limited_entries = 0;
+	for(r = 0; r < count; ++r) {
+		if(group->Entries[r].chance > 0)
+			total += group->Entries[r].chance;
+		if(group->Entries[r].npc_spawn_limit > 0)
+			++(group->limited_entries);
+		group->Entries[r].alias_chance = 0;
+		group->Entries[r].alias = static_cast<uint16>(r);
+	}
+	group->total_chance = total;
+	if(total == 0)
+		return;
+
+	//scaled by count so each slot holds exactly total
+	std::vector<uint64> scaled(count);
+	std::vector<uint32> small, large;
+	for(r = 0; r < count; ++r) {
+		int32 chance = group->Entries[r].chance;
+		scaled[r] = chance > 0 ? static_cast<uint64>(chance) * count : 0;
+		if(scaled[r] < total)
+			small.push_back(r);
+		else
+			large.push_back(r);
+	}
+
+	while(!small.empty() && !large.empty()) {
+		uint32 under = small.back();
+		uint32 over = large.back();
+		small.pop_back();
+
+		group->Entries[under].alias_chance = static_cast<uint32>(scaled[under]);
+		group->Entries[under].alias = static_cast<uint16>(over);
+
+		scaled[over] -= total - scaled[under];
+		if(scaled[over] < total) {
+			large.pop_back();
+			small.push_back(over);
+		}
+	}
+
+	//whatever is left is exactly full
+	for(r = 0; r < large.size(); ++r)
+		group->Entries[large[r]].alias_chance = total;
+	for(r = 0; r < small.size(); ++r)
+		group->Entries[small[r]].alias_chance = total;
+}
@@ -0,0 +1,68 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemu.org)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef _EQEMU_SPAWNGROUP_TABLE_H
+#define _EQEMU_SPAWNGROUP_TABLE_H
+
+#include "types.h"
+
+#define MAX_SPAWNGROUP_ENTRIES 1024
+
+#pragma pack(1)
+struct SpawnGroupEntries_Struct {
+	uint32	npc_type;
+	int32	chance;
+	uint8	npc_spawn_limit;	//from npc_types.spawn_limit
+	//alias table: a roll under alias_chance keeps this slot's entry, anything else takes alias
+	uint32	alias_chance;
+	uint16	alias;
+};
+
+struct SpawnGroup_Struct {
+	char	name[64];
+	int32	spawn_limit;
+	float	dist;
+	float	max_x;
+	float	min_x;
+	float	max_y;
+	float	min_y;
+	int32	delay;
+	int32	despawn;
+	uint32	despawn_timer;
+	uint32	total_chance;		//of the entries with a chance above 0
+	uint16	limited_entries;	//how many have an npc_spawn_limit to check
+	uint32	NumEntries;
+	SpawnGroupEntries_Struct Entries[0];
+};
+#pragma pack()
+
+/*
+	Fills in the alias table (Vose's alias method) over the entries' chances,
+	so a weighted pick is two rolls and a compare no matter how many entries
+	there are. Every slot is worth total_chance, so everything stays in
+	integers and the odds come out exactly the same as walking the list.
+*/
+void BuildSpawnGroupAlias(SpawnGroup_Struct *group);
+
+//slot in [0, NumEntries), roll in [0, total_chance), returns an index into Entries
+inline uint32 PickSpawnGroupEntry(const SpawnGroup_Struct *group, uint32 slot, uint32 roll) {
+	const SpawnGroupEntries_Struct &entry = group->Entries[slot];
+	return(roll < entry.alias_chance ? slot : entry.alias);
+}
+
+#endif
@@ -29,6 +29,7 @@
 
 uint32 current_time = 0;
 uint32 last_time = 0;
+THREAD_LOCAL uint32 check_count = 0;	//every thread checks timers, each keeps its own count
 
 Timer::Timer(uint32 in_timer_time, bool iUseAcurateTiming) {
 	timer_time = in_timer_time;
@@ -75,6 +76,7 @@ int gettimeofday (timeval *tp, ...)
 bool Timer::Check(bool iReset)
 {
 	_CP(Timer_Check);
+	check_count++;
 	if (this==0) {
 		std::cerr << "Null timer during ->Check()!?\n";
 		return true;
@@ -161,6 +163,11 @@ const uint32 Timer::GetCurrentTime()
 	return current_time;
 }
 
+const uint32 Timer::GetCheckCount()
+{
+	return check_count;
+}
+
 //just to keep all time related crap in one place... not really related to timers.
 const uint32 Timer::GetTimeSeconds() {
 	struct timeval read_time;
@@ -169,6 +176,14 @@ const uint32 Timer::GetTimeSeconds() {
 	return(read_time.tv_sec);
 }
 
+//wall clock in microseconds, read directly (not the cached current_time) so it is safe for the network threads
+const uint64 Timer::GetTimeMicroseconds() {
+	struct timeval read_time;
+
+	gettimeofday(&read_time,0);
+	return((uint64)read_time.tv_sec * 1000000 + read_time.tv_usec);
+}
+
 const uint32 Timer::SetCurrentTime()
 {
 	struct timeval read_time;
@@ -51,6 +51,9 @@ public:
 	static const uint32 SetCurrentTime();
 	static const uint32 GetCurrentTime();
 	static const uint32 GetTimeSeconds();
+	static const uint64 GetTimeMicroseconds();
+	//calls to Check() so far on the calling thread, for comparing against timers on a TimerWheel
+	static const uint32 GetCheckCount();
 
 private:
 	uint32	start_time;
@@ -0,0 +1,314 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#include "debug.h"
+#include "timer_wheel.h"
+
+TimerWheelEntry::TimerWheelEntry()
+{
+	prev = next = nullptr;
+	wheel = nullptr;
+	expires = 0;
+	level0 = false;
+}
+
+TimerWheelEntry::~TimerWheelEntry()
+{
+	if(wheel)
+		wheel->Cancel(this);
+}
+
+TimerWheel::TimerWheel(uint32 now)
+{
+	uint32 r, l;
+	for(r = 0; r < TIMER_WHEEL_LEVEL0_SIZE; r++)
+		InitList(&level0[r]);
+	for(l = 0; l < TIMER_WHEEL_LEVELS - 1; l++) {
+		for(r = 0; r < TIMER_WHEEL_LEVEL_SIZE; r++)
+			InitList(&levels[l][r]);
+	}
+	current = now;
+	count = 0;
+	level0_count = 0;
+	ResetStats();
+}
+
+//entries can outlive the wheel in the zone's shutdown order, so just let go of them
+TimerWheel::~TimerWheel()
+{
+	uint32 r, l;
+	for(r = 0; r < TIMER_WHEEL_LEVEL0_SIZE; r++)
+		Release(&level0[r]);
+	for(l = 0; l < TIMER_WHEEL_LEVELS - 1; l++) {
+		for(r = 0; r < TIMER_WHEEL_LEVEL_SIZE; r++)
+			Release(&levels[l][r]);
+	}
+}
+
+void TimerWheel::Release(TimerWheelLink *head)
+{
+	while(head->next != head) {
+		TimerWheelEntry *entry = static_cast<TimerWheelEntry *>(head->next);
+		Unlink(entry);
+		entry->wheel = nullptr;
+	}
+	count = 0;
+	level0_count = 0;
+}
+
+void TimerWheel::Unlink(TimerWheelLink *link)
+{
+	link->prev->next = link->next;
+	link->next->prev = link->prev;
+	link->prev = link->next = nullptr;
+}
+
+void TimerWheel::Append(TimerWheelLink *head, TimerWheelLink *link)
+{
+	link->prev = head->prev;
+	link->next = head;
+	head->prev->next = link;
+	head->prev = link;
+}
+
+void TimerWheel::Take(TimerWheelLink *from, TimerWheelLink *to)
+{
+	if(from->next == from)
+		return;
+	to->next = from->next;
+	to->prev = from->prev;
+	to->next->prev = to;
+	to->prev->next = to;
+	InitList(from);
+}
+
+void TimerWheel::Schedule(TimerWheelEntry *entry, uint32 expires)
+{
+	if(entry->wheel)
+		entry->wheel->Cancel(entry);
+	entry->wheel = this;
+	entry->expires = expires;
+	count++;
+	File(entry, false);
+}
+
+void TimerWheel::Cancel(TimerWheelEntry *entry)
+{
+	if(entry->wheel != this)
+		return;
+	Unlink(entry);
+	entry->wheel = nullptr;
+	count--;
+	if(entry->level0)
+		level0_count--;
+}
+
+//puts an entry in the slot matching how far out it expires. The slot for
+//current has normally gone out already; cascades run just before it does.
+void TimerWheel::File(TimerWheelEntry *entry, bool cascading)
+{
+	int32 delta = int32(entry->expires - current);
+	uint32 when = entry->expires;
+
+	entry->level0 = false;
+	if(delta < 0 || (delta == 0 && !cascading)) {
+		//already due, goes out on the next millisecond
+		Append(&level0[(current + 1) & (TIMER_WHEEL_LEVEL0_SIZE - 1)], entry);
+		entry->level0 = true;
+		level0_count++;
+		return;
+	}
+	if(delta >= TIMER_WHEEL_SPAN) {
+		//parked on the last slot of the top level, re-filed from there
+		delta = TIMER_WHEEL_SPAN - 1;
+		when = current + delta;
+	}
+
+	if(delta < TIMER_WHEEL_LEVEL0_SIZE) {
+		Append(&level0[when & (TIMER_WHEEL_LEVEL0_SIZE - 1)], entry);
+		entry->level0 = true;
+		level0_count++;
+		return;
+	}
+
+	uint32 l;
+	uint32 shift = TIMER_WHEEL_LEVEL0_BITS;
+	for(l = 0; l < TIMER_WHEEL_LEVELS - 1; l++, shift += TIMER_WHEEL_LEVEL_BITS) {
+		if(l == TIMER_WHEEL_LEVELS - 2 || delta < (1 << (shift + TIMER_WHEEL_LEVEL_BITS)))
+			break;
+	}
+	Append(&levels[l][(when >> shift) & (TIMER_WHEEL_LEVEL_SIZE - 1)], entry);
+}
+
+//re-files one slot of a level, everything in it now lands on a lower one
+void TimerWheel::Cascade(uint32 level, uint32 slot)
+{
+	TimerWheelLink moving;
+	InitList(&moving);
+	Take(&levels[level][slot], &moving);
+	while(moving.next != &moving) {
+		TimerWheelEntry *entry = static_cast<TimerWheelEntry *>(moving.next);
+		Unlink(entry);
+		File(entry, true);
+		stats.cascaded++;
+	}
+}
+
+uint32 TimerWheel::Advance(uint32 now)
+{
+	uint32 fired = 0;
+	stats.ticks++;
+
+	if(count == 0) {
+		current = now;
+		stats.fired_per_tick.Add(0);
+		return(0);
+	}
+
+	while(int32(now - current) > 0) {
+		if(level0_count == 0) {
+			//nothing can fire before level 0 wraps and the levels above cascade into it
+			uint32 wrap = current | (TIMER_WHEEL_LEVEL0_SIZE - 1);
+			if(int32(now - wrap) <= 0) {
+				current = now;
+				break;
+			}
+			current = wrap;
+		}
+		current++;
+
+		uint32 slot = current & (TIMER_WHEEL_LEVEL0_SIZE - 1);
+		if(slot == 0) {
+			uint32 l;
+			uint32 shift = TIMER_WHEEL_LEVEL0_BITS;
+			for(l = 0; l < TIMER_WHEEL_LEVELS - 1; l++, shift += TIMER_WHEEL_LEVEL_BITS) {
+				uint32 index = (current >> shift) & (TIMER_WHEEL_LEVEL_SIZE - 1);
+				Cascade(l, index);
+				if(index != 0)
+					break;
+			}
+		}
+
+		//taken off first, a callback may put itself or anything else back on this slot
+		TimerWheelLink due;
+		InitList(&due);
+		Take(&level0[slot], &due);
+		while(due.next != &due) {
+			TimerWheelEntry *entry = static_cast<TimerWheelEntry *>(due.next);
+			Unlink(entry);
+			entry->wheel = nullptr;
+			count--;
+			level0_count--;
+			if(int32(entry->expires - current) > 0) {
+				//parked past the span, not actually due yet
+				Schedule(entry, entry->expires);
+				continue;
+			}
+			fired++;
+			entry->Fire();
+		}
+
+		if(count == 0) {
+			current = now;
+			break;
+		}
+	}
+
+	stats.fired += fired;
+	stats.fired_per_tick.Add(fired);
+	return(fired);
+}
+
+void TimerWheel::ResetStats()
+{
+	stats.ticks = 0;
+	stats.fired = 0;
+	stats.cascaded = 0;
+	stats.fired_per_tick.Clear();
+	stats.polled_per_tick.Clear();
+}
+
+WheelTimer::WheelTimer(uint32 timer_time)
+:	timer(timer_time)
+{
+	attached = nullptr;
+	due = false;
+}
+
+void WheelTimer::SetWheel(TimerWheel *in_wheel)
+{
+	if(Scheduled())
+		attached->Cancel(this);
+	attached = in_wheel;
+	due = false;
+	Reschedule();
+}
+
+void WheelTimer::Start(uint32 set_timer_time, bool ChangeResetTimer)
+{
+	timer.Start(set_timer_time, ChangeResetTimer);
+	Reschedule();
+}
+
+void WheelTimer::SetTimer(uint32 set_timer_time)
+{
+	timer.SetTimer(set_timer_time);
+	Reschedule();
+}
+
+void WheelTimer::Disable()
+{
+	timer.Disable();
+	due = false;
+	if(Scheduled())
+		attached->Cancel(this);
+}
+
+void WheelTimer::Trigger()
+{
+	timer.Trigger();
+	Reschedule();
+}
+
+//what Timer::Check does when it resets
+void WheelTimer::Restart()
+{
+	timer.Start(timer.GetSetAtTrigger(), false);
+	Reschedule();
+}
+
+void WheelTimer::Reschedule()
+{
+	if(attached == nullptr)
+		return;
+	due = false;
+	if(!timer.Enabled()) {
+		if(Scheduled())
+			attached->Cancel(this);
+		return;
+	}
+	//Timer::Check goes off once more than the duration has passed
+	uint32 expires = timer.GetStartTime() + timer.GetTimerTime() + 1;
+	if(int32(expires - Timer::GetCurrentTime()) <= 0) {
+		if(Scheduled())
+			attached->Cancel(this);
+		due = true;
+		return;
+	}
+	attached->Schedule(this, expires);
+}
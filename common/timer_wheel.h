@@ -0,0 +1,168 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include "types.h"
+#include "timer.h"
+#include "histogram.h"
+
+//level 0 has one slot per millisecond, each level above covers a whole turn of the one below
+#define TIMER_WHEEL_LEVEL0_BITS	8
+#define TIMER_WHEEL_LEVEL_BITS	6
+#define TIMER_WHEEL_LEVELS		4
+#define TIMER_WHEEL_LEVEL0_SIZE	(1 << TIMER_WHEEL_LEVEL0_BITS)
+#define TIMER_WHEEL_LEVEL_SIZE	(1 << TIMER_WHEEL_LEVEL_BITS)
+//longest delay the wheel holds directly, anything further out is re-filed when it comes in range
+#define TIMER_WHEEL_SPAN		(1 << (TIMER_WHEEL_LEVEL0_BITS + (TIMER_WHEEL_LEVELS - 1) * TIMER_WHEEL_LEVEL_BITS))
+
+class TimerWheel;
+
+struct TimerWheelLink {
+	TimerWheelLink *prev;
+	TimerWheelLink *next;
+};
+
+//something that can sit on a TimerWheel. Owned by the caller, unlinks itself when destroyed.
+class TimerWheelEntry : protected TimerWheelLink
+{
+public:
+	TimerWheelEntry();
+	virtual ~TimerWheelEntry();
+
+	bool Scheduled() const { return(wheel != nullptr); }
+	uint32 GetExpires() const { return(expires); }
+
+protected:
+	//called from TimerWheel::Advance once current time reaches the expiry, the
+	//entry is already off the wheel and may schedule itself again
+	virtual void Fire() = 0;
+
+private:
+	friend class TimerWheel;
+	TimerWheel *wheel;
+	uint32 expires;
+	bool level0;	//filed on the millisecond level
+};
+
+/*
+	Hierarchical timer wheel with millisecond slots. Scheduling and canceling
+	are constant time, and Advance only touches the slots between the last
+	call and now, so timers that aren't due cost nothing. Entries far in the
+	future sit on a coarser level and drop down a level each time the one
+	below wraps. While the millisecond level is empty Advance skips straight
+	to its next wrap, so catching up after a long gap (a zone sitting
+	unloaded) costs one step per turn of level 0 rather than per millisecond.
+
+	Times are the zone's Timer::GetCurrentTime() milliseconds and may wrap.
+	Not thread safe.
+*/
+class TimerWheel
+{
+public:
+	TimerWheel(uint32 now = 0);
+	~TimerWheel();
+
+	//fires at the first Advance whose now is at or past expires
+	void Schedule(TimerWheelEntry *entry, uint32 expires);
+	void Cancel(TimerWheelEntry *entry);
+
+	//fires everything due up to and including now, returns how many fired
+	uint32 Advance(uint32 now);
+
+	uint32 Count() const { return(count); }
+	uint32 GetCurrent() const { return(current); }
+
+	struct Stats {
+		uint64 ticks;		//calls to Advance
+		uint64 fired;
+		uint64 cascaded;	//entries moved down a level
+		LogHistogram fired_per_tick;
+		LogHistogram polled_per_tick;	//Timer::Check calls made by whatever still polls
+	};
+	const Stats &GetStats() const { return(stats); }
+	void RecordPolled(uint32 polled) { stats.polled_per_tick.Add(polled); }
+	void ResetStats();
+
+private:
+	void File(TimerWheelEntry *entry, bool cascading);
+	void Cascade(uint32 level, uint32 slot);
+	void Release(TimerWheelLink *head);
+
+	static void InitList(TimerWheelLink *head) { head->prev = head->next = head; }
+	static void Unlink(TimerWheelLink *link);
+	static void Append(TimerWheelLink *head, TimerWheelLink *link);
+	//moves every entry of from onto the empty list to
+	static void Take(TimerWheelLink *from, TimerWheelLink *to);
+
+	TimerWheelLink level0[TIMER_WHEEL_LEVEL0_SIZE];
+	TimerWheelLink levels[TIMER_WHEEL_LEVELS - 1][TIMER_WHEEL_LEVEL_SIZE];
+	uint32 current;
+	uint32 count;
+	uint32 level0_count;	//of count, how many are on level0
+	Stats stats;
+};
+
+/*
+	Drop in for a Timer that the owning entity checks from its Process loop.
+	Given a wheel, Check() only reads a flag the wheel sets when the timer
+	runs out instead of doing the time math on every call; the work still
+	happens in Process, in the same order as before. Without a wheel it is a
+	plain Timer, so using one is opt in.
+*/
+class WheelTimer : public TimerWheelEntry
+{
+public:
+	WheelTimer(uint32 timer_time);
+
+	void SetWheel(TimerWheel *in_wheel);
+
+	inline bool Check(bool iReset = true)
+	{
+		if(attached == nullptr)
+			return(timer.Check(iReset));
+		if(!due)
+			return(false);
+		if(iReset)
+			Restart();
+		return(true);
+	}
+	void Start(uint32 set_timer_time = 0, bool ChangeResetTimer = true);
+	void SetTimer(uint32 set_timer_time = 0);
+	void Disable();
+	void Trigger();
+
+	inline bool Enabled() { return(timer.Enabled()); }
+	inline uint32 GetRemainingTime() { return(timer.GetRemainingTime()); }
+	inline const uint32 &GetTimerTime() { return(timer.GetTimerTime()); }
+	inline uint32 GetDuration() { return(timer.GetDuration()); }
+
+protected:
+	virtual void Fire() { due = true; }
+
+private:
+	void Restart();
+	void Reschedule();
+
+	Timer timer;
+	TimerWheel *attached;
+	bool due;
+};
+
+#endif
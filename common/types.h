@@ -72,9 +72,11 @@ typedef const char Const_char;	//for perl XS
 	#define strcasecmp	_stricmp
 	typedef void ThreadReturnType;
 	#define THREAD_RETURN(x) _endthread(); return;
+	#define THREAD_LOCAL __declspec(thread)
 #else
 	typedef void* ThreadReturnType;
 	#define THREAD_RETURN(x) return(x);
+	#define THREAD_LOCAL __thread
 #endif
 
 #define safe_delete(d) if(d) { delete d; d=nullptr; }
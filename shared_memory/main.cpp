@@ -26,8 +26,10 @@
 #include "../common/eqemu_exception.h"
 #include "items.h"
 #include "npc_faction.h"
+#include "npc_types.h"
 #include "loot.h"
 #include "skill_caps.h"
+#include "spawn_groups.h"
 #include "spells.h"
 
 int main(int argc, char **argv) {
@@ -58,15 +60,19 @@ int main(int argc, char **argv) {
 	bool load_items = true;
 	bool load_factions = true;
 	bool load_loot = true;
+	bool load_npc_types = true;
 	bool load_skill_caps = true;
 	bool load_spells = true;
+	bool load_spawn_groups = true;
 	if(argc > 1) {
 		load_all = false;
 		load_items = false;
 		load_factions = false;
 		load_loot = false;
+		load_npc_types = false;
 		load_skill_caps = false;
 		load_spells = false;
+		load_spawn_groups = false;
 
 		for(int i = 1; i < argc; ++i) {
 			switch(argv[i][0]) {
@@ -94,11 +100,19 @@ int main(int argc, char **argv) {
 				}
 				break;
 
+			case 'n':
+				if(strcasecmp("npc_types", argv[i]) == 0) {
+					load_npc_types = true;
+				}
+				break;
+
 			case 's':
 				if(strcasecmp("skill_caps", argv[i]) == 0) {
 					load_skill_caps = true;
 				} else if(strcasecmp("spells", argv[i]) == 0) {
 					load_spells = true;
+				} else if(strcasecmp("spawn_groups", argv[i]) == 0) {
+					load_spawn_groups = true;
 				}
 				break;
 			}
@@ -135,6 +149,16 @@ int main(int argc, char **argv) {
 		}
 	}
 
+	if(load_all || load_npc_types) {
+		LogFile->write(EQEMuLog::Status, "Loading npc types...");
+		try {
+			LoadNPCTypes(&database);
+		} catch(std::exception &ex) {
+			LogFile->write(EQEMuLog::Error, "%s", ex.what());
+			return 0;
+		}
+	}
+
 	if(load_all || load_skill_caps) {
 		LogFile->write(EQEMuLog::Status, "Loading skill caps...");
 		try {
@@ -155,5 +179,15 @@ int main(int argc, char **argv) {
 		}
 	}
 
+	if(load_all || load_spawn_groups) {
+		LogFile->write(EQEMuLog::Status, "Loading spawn groups...");
+		try {
+			LoadSpawnGroups(&database);
+		} catch(std::exception &ex) {
+			LogFile->write(EQEMuLog::Error, "%s", ex.what());
+			return 0;
+		}
+	}
+
 	return 0;
 }
@@ -0,0 +1,50 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#include "spawn_groups.h"
+#include "../common/debug.h"
+#include "../common/shareddb.h"
+#include "../common/ipc_mutex.h"
+#include "../common/memory_mapped_file.h"
+#include "../common/eqemu_exception.h"
+#include "../common/fixed_memory_variable_hash_set.h"
+#include "../common/spawngroup_table.h"
+
+void LoadSpawnGroups(SharedDatabase *database) {
+	EQEmu::IPCMutex mutex("spawn_groups");
+	mutex.Lock();
+
+	uint32 spawn_group_count, spawn_group_max, spawn_group_entries_count;
+	database->GetSpawnGroupInfo(spawn_group_count, spawn_group_max, spawn_group_entries_count);
+	if(spawn_group_count == 0) {
+		EQ_EXCEPT("Shared Memory", "Unable to get any spawn groups from the database.");
+	}
+
+	uint32 size = (3 * sizeof(uint32)) +								//header
+		((spawn_group_max + 1) * sizeof(uint32)) +						//offset list
+		(spawn_group_count * sizeof(SpawnGroup_Struct)) +				//spawn group headers
+		(spawn_group_entries_count * sizeof(SpawnGroupEntries_Struct));	//number of spawn entries
+
+	EQEmu::MemoryMappedFile mmf("shared/spawn_groups", size);
+	mmf.ZeroFile();
+
+	EQEmu::FixedMemoryVariableHashSet<SpawnGroup_Struct> hash(reinterpret_cast<byte*>(mmf.Get()), size, spawn_group_max);
+
+	database->LoadSpawnGroupTable(mmf.Get(), size);
+	mutex.Unlock();
+}
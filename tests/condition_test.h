@@ -0,0 +1,52 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef __EQEMU_TESTS_CONDITION_H
+#define __EQEMU_TESTS_CONDITION_H
+
+#include "cppunit/cpptest.h"
+#include "../common/Condition.h"
+
+class ConditionTest : public Test::Suite {
+	typedef void(ConditionTest::*TestFunction)(void);
+public:
+	ConditionTest() {
+		TEST_ADD(ConditionTest::PostBeforeWaitTest);
+		TEST_ADD(ConditionTest::NoPostTimesOutTest);
+	}
+	~ConditionTest() {
+	}
+
+	private:
+	void PostBeforeWaitTest() {
+		Condition c;
+		//nobody is waiting yet, the post still has to be seen
+		c.Post();
+		TEST_ASSERT(c.WaitForPost(1000));
+		//and only once
+		TEST_ASSERT(!c.WaitForPost(1000));
+	}
+
+	void NoPostTimesOutTest() {
+		Condition c;
+		c.Signal();
+		TEST_ASSERT(!c.WaitForPost(1000));
+	}
+};
+
+#endif
@@ -0,0 +1,194 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef __EQEMU_TESTS_DENSE_LIST_H
+#define __EQEMU_TESTS_DENSE_LIST_H
+
+#include "cppunit/cpptest.h"
+#include "../common/dense_list.h"
+#include "../common/linked_list.h"
+#include <vector>
+
+#define DENSE_LIST_TEST_TICKS 200
+
+//stand-in mob, Process() touches it the way a real tick would
+struct DenseListTestEntity
+{
+	DenseListTestEntity() : x(0), y(0), z(0), heading(0), ticks(0) { }
+	float x, y, z, heading;
+	uint32 ticks;
+	char padding[200];	//keeps the objects about as spread out as real mobs
+	bool Process()
+	{
+		x += 0.5f;
+		y -= 0.25f;
+		heading += 1.0f;
+		return(++ticks % 200 != 0);
+	}
+};
+
+//every entity leaves and is replaced every 200 ticks, returns how many Process calls ran
+template<class LIST, class ITERATOR>
+uint64 DenseListTestRun(LIST &list, uint32 ticks)
+{
+	uint64 visits = 0;
+	for(uint32 t = 0; t < ticks; t++) {
+		uint32 removed = 0;
+		ITERATOR iterator(list);
+		iterator.Reset();
+		while(iterator.MoreElements()) {
+			visits++;
+			if(!iterator.GetData()->Process()) {
+				//churn, a fresh entity takes its place like a respawn would
+				iterator.RemoveCurrent();
+				removed++;
+			}
+			else
+				iterator.Advance();
+		}
+		while(removed-- > 0)
+			list.Insert(new DenseListTestEntity());
+	}
+	return(visits);
+}
+
+class DenseListTest : public Test::Suite {
+	typedef void(DenseListTest::*TestFunction)(void);
+public:
+	DenseListTest() {
+		TEST_ADD(DenseListTest::RemoveTest);
+		TEST_ADD(DenseListTest::NestedRemoveTest);
+		TEST_ADD(DenseListTest::OrderTest);
+		TEST_ADD(DenseListTest::ProcessWalkTest);
+	}
+	~DenseListTest() {
+	}
+
+	private:
+	void RemoveTest() {
+		DenseList<uint32*> list;
+		for(uint32 r = 0; r < 10; r++)
+			list.Insert(new uint32(r));
+
+		//removing every even one still visits all ten once
+		uint32 seen = 0;
+		DenseListIterator<uint32*> iterator(list);
+		iterator.Reset();
+		while(iterator.MoreElements()) {
+			seen |= 1 << *iterator.GetData();
+			if(*iterator.GetData() % 2 == 0)
+				iterator.RemoveCurrent();
+			else
+				iterator.Advance();
+		}
+		TEST_ASSERT(seen == 0x3FF);
+		TEST_ASSERT(list.Count() == 5);
+	}
+
+	void NestedRemoveTest() {
+		DenseList<uint32*> list;
+		for(uint32 r = 0; r < 4; r++)
+			list.Insert(new uint32(r));
+
+		{
+			DenseListIterator<uint32*> outer(list);
+			outer.Reset();
+			DenseListIterator<uint32*> inner(list);
+			inner.Reset();
+			inner.RemoveCurrent();
+			TEST_ASSERT(list.Count() == 3);
+
+			//the outer iterator skips the hole instead of seeing a moved element twice
+			uint32 visits = 0;
+			for(outer.Reset(); outer.MoreElements(); outer.Advance())
+				visits++;
+			TEST_ASSERT(visits == 3);
+		}
+
+		uint32 visits = 0;
+		DenseListIterator<uint32*> iterator(list);
+		for(iterator.Reset(); iterator.MoreElements(); iterator.Advance())
+			visits++;
+		TEST_ASSERT(visits == 3);
+	}
+
+	//walks in the order a LinkedList would, and skips what was inserted during the walk
+	template<class LIST, class ITERATOR>
+	void OrderWalk(LIST &list, std::vector<uint32> &order) {
+		uint32 r;
+		for(r = 0; r < 5; r++)
+			list.Insert(new uint32(r));
+
+		ITERATOR iterator(list);
+		iterator.Reset();
+		while(iterator.MoreElements()) {
+			uint32 v = *iterator.GetData();
+			order.push_back(v);
+			if(v == 3)
+				list.Insert(new uint32(5));
+			if(v == 2)
+				iterator.RemoveCurrent();
+			else
+				iterator.Advance();
+		}
+		for(iterator.Reset(); iterator.MoreElements(); iterator.Advance())
+			order.push_back(*iterator.GetData());
+	}
+
+	void OrderTest() {
+		LinkedList<uint32*> linked;
+		DenseList<uint32*> dense;
+		std::vector<uint32> linked_order, dense_order;
+		OrderWalk<LinkedList<uint32*>, LinkedListIterator<uint32*> >(linked, linked_order);
+		OrderWalk<DenseList<uint32*>, DenseListIterator<uint32*> >(dense, dense_order);
+
+		static const uint32 expected[] = { 4, 3, 2, 1, 0, 5, 4, 3, 1, 0 };
+		TEST_ASSERT(dense_order == std::vector<uint32>(expected, expected + sizeof(expected) / sizeof(expected[0])));
+		TEST_ASSERT(dense_order == linked_order);
+		TEST_ASSERT(dense.Count() == 5);
+	}
+
+	/*
+		A simulated MobProcess walk over LinkedList and DenseList. Both have to
+		call Process the same number of times.
+	*/
+	void ProcessWalkTest() {
+		static const uint32 counts[] = { 500, 2000, 5000 };
+		for(uint32 n = 0; n < sizeof(counts) / sizeof(counts[0]); n++) {
+			uint32 count = counts[n];
+			LinkedList<DenseListTestEntity*> linked;
+			DenseList<DenseListTestEntity*> dense;
+
+			for(uint32 r = 0; r < count; r++) {
+				DenseListTestEntity *a = new DenseListTestEntity();
+				DenseListTestEntity *b = new DenseListTestEntity();
+				a->ticks = b->ticks = r;
+				linked.Insert(a);
+				dense.Insert(b);
+			}
+
+			uint64 linked_visits = DenseListTestRun<LinkedList<DenseListTestEntity*>, LinkedListIterator<DenseListTestEntity*> >(linked, DENSE_LIST_TEST_TICKS);
+			uint64 dense_visits = DenseListTestRun<DenseList<DenseListTestEntity*>, DenseListIterator<DenseListTestEntity*> >(dense, DENSE_LIST_TEST_TICKS);
+
+			TEST_ASSERT(linked_visits == dense_visits);
+			TEST_ASSERT(linked.Count() == count && dense.Count() == count);
+		}
+	}
+};
+
+#endif
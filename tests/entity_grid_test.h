@@ -0,0 +1,125 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef __EQEMU_TESTS_ENTITY_GRID_H
+#define __EQEMU_TESTS_ENTITY_GRID_H
+
+#include "cppunit/cpptest.h"
+#include "../zone/entity_grid.h"
+#include "../common/MiscFunctions.h"
+#include <vector>
+
+//stand-in entity, the grid only needs a position
+struct EntityGridTestEntity
+{
+	float x, y;
+	float GetX() const { return x; }
+	float GetY() const { return y; }
+};
+
+class EntityGridTest : public Test::Suite {
+	typedef void(EntityGridTest::*TestFunction)(void);
+public:
+	EntityGridTest() {
+		TEST_ADD(EntityGridTest::UpdateTest);
+		TEST_ADD(EntityGridTest::AggroTickTest);
+	}
+	~EntityGridTest() {
+	}
+
+	private:
+	void UpdateTest() {
+		EntityGrid<EntityGridTestEntity> grid;
+		EntityGridTestEntity a = { 10.0f, 10.0f };
+		EntityGridTestEntity b = { 1000.0f, 1000.0f };
+		grid.Insert(&a);
+		grid.Insert(&b);
+		TEST_ASSERT(grid.Count() == 2);
+
+		std::vector<EntityGridTestEntity*> out;
+		grid.GetInRange(0.0f, 0.0f, 50.0f, out);
+		TEST_ASSERT(out.size() == 1 && out[0] == &a);
+
+		b.x = 20.0f;
+		b.y = 20.0f;
+		grid.Update(&b);
+		out.clear();
+		grid.GetInRange(0.0f, 0.0f, 50.0f, out);
+		TEST_ASSERT(out.size() == 2);
+
+		grid.Remove(&a);
+		TEST_ASSERT(!grid.Contains(&a));
+		TEST_ASSERT(grid.Count() == 1);
+	}
+
+	/*
+		Every entity looks for others within aggro range, once by scanning all
+		of them like the old list walks did and once through the grid, after
+		each entity moved a little. Both have to find the same pairs.
+	*/
+	void AggroTickTest() {
+		static const uint32 counts[] = { 250, 1000, 2000 };
+		const float extent = 4000.0f;
+		const float range = 70.0f;
+		const float range2 = range * range;
+
+		for(uint32 n = 0; n < sizeof(counts) / sizeof(counts[0]); n++) {
+			uint32 count = counts[n];
+			std::vector<EntityGridTestEntity> ents(count);
+			EntityGrid<EntityGridTestEntity> grid;
+			uint32 i, j;
+
+			for(i = 0; i < count; i++) {
+				ents[i].x = MakeRandomFloat(0, extent);
+				ents[i].y = MakeRandomFloat(0, extent);
+				grid.Insert(&ents[i]);
+			}
+
+			for(i = 0; i < count; i++) {
+				ents[i].x += MakeRandomFloat(-5, 5);
+				ents[i].y += MakeRandomFloat(-5, 5);
+				grid.Update(&ents[i]);
+			}
+			uint32 scan_hits = 0;
+			for(i = 0; i < count; i++) {
+				for(j = 0; j < count; j++) {
+					float dx = ents[j].x - ents[i].x;
+					float dy = ents[j].y - ents[i].y;
+					if(i != j && (dx * dx + dy * dy) <= range2)
+						scan_hits++;
+				}
+			}
+			uint32 grid_hits = 0;
+			std::vector<EntityGridTestEntity*> candidates;
+			std::vector<EntityGridTestEntity*>::iterator iter;
+			for(i = 0; i < count; i++) {
+				candidates.clear();
+				grid.GetInRange(ents[i].x, ents[i].y, range, candidates);
+				for(iter = candidates.begin(); iter != candidates.end(); ++iter) {
+					float dx = (*iter)->x - ents[i].x;
+					float dy = (*iter)->y - ents[i].y;
+					if(*iter != &ents[i] && (dx * dx + dy * dy) <= range2)
+						grid_hits++;
+				}
+			}
+			TEST_ASSERT(grid_hits == scan_hits);
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,123 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef __EQEMU_TESTS_ENTITY_SLOTS_H
+#define __EQEMU_TESTS_ENTITY_SLOTS_H
+
+#include "cppunit/cpptest.h"
+#include "../zone/entity_slots.h"
+#include "../common/linked_list.h"
+#include "../common/MiscFunctions.h"
+#include <vector>
+
+#define ENTITY_SLOTS_TEST_LOOKUPS 20000
+
+//stand-in entity, the table only needs an id
+struct EntitySlotsTestEntity
+{
+	uint16 id;
+	uint16 GetID() const { return id; }
+};
+
+class EntitySlotsTest : public Test::Suite {
+	typedef void(EntitySlotsTest::*TestFunction)(void);
+public:
+	EntitySlotsTest() {
+		TEST_ADD(EntitySlotsTest::HandleTest);
+		TEST_ADD(EntitySlotsTest::LookupTest);
+	}
+	~EntitySlotsTest() {
+	}
+
+	private:
+	void HandleTest() {
+		EntitySlotTable<EntitySlotsTestEntity> *table = new EntitySlotTable<EntitySlotsTestEntity>;
+		EntitySlotsTestEntity a, b;
+		a.id = b.id = 7;
+
+		table->Claim(7, &a, EntitySlotNPC);
+		TEST_ASSERT(table->Get(7, EntitySlotNPC) == &a);
+		TEST_ASSERT(table->Get(7, EntitySlotClient) == nullptr);
+		uint32 handle = table->GetHandle(7);
+		TEST_ASSERT(table->GetByHandle(handle) == &a);
+
+		//someone else's release doesn't clear the slot
+		table->Release(7, &b);
+		TEST_ASSERT(table->Get(7) == &a);
+
+		//the id is reused, the old handle no longer finds anything
+		table->Release(7, &a);
+		table->Claim(7, &b, EntitySlotNPC);
+		TEST_ASSERT(table->GetByHandle(handle) == nullptr);
+		TEST_ASSERT(table->GetByHandle(table->GetHandle(7)) == &b);
+
+		table->Clear();
+		TEST_ASSERT(table->GetHandle(7) == 0);
+		delete table;
+	}
+
+	/*
+		Random id lookups, one in ten a miss, through the table and by walking
+		a LinkedList like the old entity list lookups did. Ids are handed out
+		from 1 to 1500 by GetFreeID, so that's the realistic top end. Both have
+		to find the same entities.
+	*/
+	void LookupTest() {
+		static const uint32 counts[] = { 100, 500, 1500 };
+		std::vector<uint16> ids(ENTITY_SLOTS_TEST_LOOKUPS);
+		EntitySlotTable<EntitySlotsTestEntity> *table = new EntitySlotTable<EntitySlotsTestEntity>;
+
+		for(uint32 n = 0; n < sizeof(counts) / sizeof(counts[0]); n++) {
+			uint32 count = counts[n];
+			LinkedList<EntitySlotsTestEntity*> list;
+			uint32 r;
+
+			table->Clear();
+			for(r = 1; r <= count; r++) {
+				EntitySlotsTestEntity *ent = new EntitySlotsTestEntity;
+				ent->id = r;
+				list.Insert(ent);
+				table->Claim(r, ent, EntitySlotNPC);
+			}
+			for(r = 0; r < ENTITY_SLOTS_TEST_LOOKUPS; r++)
+				ids[r] = MakeRandomInt(1, count + count / 9);
+
+			uint32 list_found = 0;
+			LinkedListIterator<EntitySlotsTestEntity*> iterator(list);
+			for(r = 0; r < ENTITY_SLOTS_TEST_LOOKUPS; r++) {
+				for(iterator.Reset(); iterator.MoreElements(); iterator.Advance()) {
+					if(iterator.GetData()->GetID() == ids[r]) {
+						list_found++;
+						break;
+					}
+				}
+			}
+			uint32 table_found = 0;
+			for(r = 0; r < ENTITY_SLOTS_TEST_LOOKUPS; r++) {
+				if(table->Get(ids[r], EntitySlotNPC) != nullptr)
+					table_found++;
+			}
+			TEST_ASSERT(table_found == list_found);
+		}
+
+		table->Clear();
+		delete table;
+	}
+};
+
+#endif
@@ -0,0 +1,74 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef __EQEMU_TESTS_HISTOGRAM_H
+#define __EQEMU_TESTS_HISTOGRAM_H
+
+#include "cppunit/cpptest.h"
+#include "../common/histogram.h"
+
+class HistogramTest : public Test::Suite {
+	typedef void(HistogramTest::*TestFunction)(void);
+public:
+	HistogramTest() {
+		TEST_ADD(HistogramTest::EmptyTest);
+		TEST_ADD(HistogramTest::PercentileTest);
+		TEST_ADD(HistogramTest::MergeTest);
+	}
+	~HistogramTest() {
+	}
+
+	private:
+	void EmptyTest() {
+		LogHistogram h;
+		TEST_ASSERT(h.Count() == 0);
+		TEST_ASSERT(h.Mean() == 0);
+		TEST_ASSERT(h.Percentile(0.5f) == 0);
+	}
+
+	void PercentileTest() {
+		LogHistogram h;
+		for(uint32 i = 0; i < 90; i++)
+			h.Add(10);
+		for(uint32 i = 0; i < 10; i++)
+			h.Add(1000);
+		TEST_ASSERT(h.Count() == 100);
+		TEST_ASSERT(h.Max() == 1000);
+		TEST_ASSERT(h.Mean() == 109);
+		//10 lands in [8,16), 1000 in [512,1024)
+		TEST_ASSERT(h.Percentile(0.5f) == 15);
+		TEST_ASSERT(h.Percentile(0.95f) == 1000);
+		TEST_ASSERT(h.Percentile(1.0f) == 1000);
+	}
+
+	void MergeTest() {
+		LogHistogram a, b;
+		a.Add(1);
+		b.Add(0);
+		b.Add(4000);
+		a.Merge(b);
+		TEST_ASSERT(a.Count() == 3);
+		TEST_ASSERT(a.Max() == 4000);
+		TEST_ASSERT(a.Percentile(0.0f) == 0);
+		a.Clear();
+		TEST_ASSERT(a.Count() == 0);
+		TEST_ASSERT(a.Max() == 0);
+	}
+};
+
+#endif
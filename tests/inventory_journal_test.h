@@ -0,0 +1,166 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef __EQEMU_TESTS_INVENTORY_JOURNAL_H
+#define __EQEMU_TESTS_INVENTORY_JOURNAL_H
+
+#include "cppunit/cpptest.h"
+#include "../common/inventory_journal.h"
+
+class InventoryJournalTest : public Test::Suite {
+	typedef void(InventoryJournalTest::*TestFunction)(void);
+public:
+	InventoryJournalTest() {
+		TEST_ADD(InventoryJournalTest::BatchTest);
+		TEST_ADD(InventoryJournalTest::OrderTest);
+		TEST_ADD(InventoryJournalTest::PerCharacterTest);
+		TEST_ADD(InventoryJournalTest::CompletedTest);
+		TEST_ADD(InventoryJournalTest::FallbackTest);
+		TEST_ADD(InventoryJournalTest::WaitTimeoutTest);
+	}
+	~InventoryJournalTest() {
+	}
+
+	private:
+	void BatchTest() {
+		InventoryJournal journal;
+		journal.Replace(5, "(5,1)");
+		journal.Replace(5, "(5,2)");
+		journal.Replace(5, "(5,3)");
+
+		std::vector<InventoryJournalBatch> batches;
+		journal.Take(5, batches);
+		TEST_ASSERT(batches.size() == 1);
+		TEST_ASSERT(batches[0].char_id == 5);
+		TEST_ASSERT(batches[0].statements.size() == 1);
+		TEST_ASSERT(batches[0].statements[0].find("REPLACE INTO inventory") == 0);
+		TEST_ASSERT(batches[0].statements[0].find("VALUES (5,1),(5,2),(5,3)") != std::string::npos);
+		TEST_ASSERT(journal.PendingEntries() == 0);
+	}
+
+	void OrderTest() {
+		InventoryJournal journal;
+		journal.Delete(5, "slotid=22");
+		journal.Delete(5, "(slotid>=251 AND slotid<261)");
+		journal.Replace(5, "(5,22)");
+		journal.Delete(5, "slotid=23");
+
+		std::vector<InventoryJournalBatch> batches;
+		journal.Take(0, batches);
+		TEST_ASSERT(batches.size() == 1);
+		TEST_ASSERT(batches[0].statements.size() == 3);
+		TEST_ASSERT(batches[0].statements[0] == "DELETE FROM inventory WHERE charid=5 AND (slotid=22 OR (slotid>=251 AND slotid<261))");
+		TEST_ASSERT(batches[0].statements[1].find("VALUES (5,22)") != std::string::npos);
+		TEST_ASSERT(batches[0].statements[2] == "DELETE FROM inventory WHERE charid=5 AND (slotid=23)");
+	}
+
+	void PerCharacterTest() {
+		InventoryJournal journal;
+		journal.Replace(5, "(5,1)");
+		journal.Replace(6, "(6,1)");
+
+		std::vector<InventoryJournalBatch> batches;
+		journal.Take(6, batches);
+		TEST_ASSERT(batches.size() == 1);
+		TEST_ASSERT(batches[0].char_id == 6);
+		TEST_ASSERT(journal.PendingEntries() == 1);
+
+		batches.clear();
+		journal.Take(0, batches);
+		TEST_ASSERT(batches.size() == 1);
+		TEST_ASSERT(batches[0].char_id == 5);
+	}
+
+	void CompletedTest() {
+		InventoryJournal journal;
+		TEST_ASSERT(!journal.Outstanding(5));
+		journal.Replace(5, "(5,1)");
+		TEST_ASSERT(journal.Outstanding(5));
+
+		std::vector<InventoryJournalBatch> batches;
+		journal.Take(5, batches);
+		TEST_ASSERT(journal.Outstanding(5));
+		journal.Replace(5, "(5,2)");
+		journal.Completed(5, 0);
+		TEST_ASSERT(journal.Outstanding(5));
+
+		batches.clear();
+		journal.Take(5, batches);
+		journal.Completed(5, 1);
+		TEST_ASSERT(!journal.Outstanding(5));
+		TEST_ASSERT(journal.Wait(5, 0));
+		TEST_ASSERT(journal.GetStats().errors == 1);
+		TEST_ASSERT(journal.GetStats().batches == 2);
+	}
+
+	void FallbackTest() {
+		InventoryJournal journal;
+		journal.Replace(5, "(5,1)");
+		journal.Replace(5, "(5,2)");
+		journal.Delete(5, "slotid=3");
+		journal.Replace(5, "(5,4)");
+
+		std::vector<InventoryJournalBatch> batches;
+		journal.Take(5, batches);
+		TEST_ASSERT(batches[0].statements.size() == 3);
+
+		//the first REPLACE failed, everything from it on comes back a row at a time
+		std::vector<std::string> singles;
+		journal.Fallback(5, 0, singles);
+		TEST_ASSERT(singles.size() == 4);
+		TEST_ASSERT(singles[0].find("VALUES (5,1)") != std::string::npos);
+		TEST_ASSERT(singles[1].find("VALUES (5,2)") != std::string::npos);
+		TEST_ASSERT(singles[2] == "DELETE FROM inventory WHERE charid=5 AND (slotid=3)");
+		TEST_ASSERT(singles[3].find("VALUES (5,4)") != std::string::npos);
+
+		singles.clear();
+		journal.Fallback(5, 2, singles);
+		TEST_ASSERT(singles.size() == 1);
+		TEST_ASSERT(singles[0].find("VALUES (5,4)") != std::string::npos);
+
+		journal.Completed(5, 0);
+		singles.clear();
+		journal.Fallback(5, 0, singles);
+		TEST_ASSERT(singles.empty());
+		TEST_ASSERT(journal.GetStats().fallbacks == 2);
+	}
+
+	void WaitTimeoutTest() {
+		InventoryJournal journal;
+		journal.Replace(5, "(5,1)");
+		std::vector<InventoryJournalBatch> batches;
+		journal.Take(5, batches);
+
+		//another character completing wakes the barrier but doesn't satisfy it
+		journal.Replace(6, "(6,1)");
+		journal.Take(6, batches);
+		journal.Completed(6, 0);
+		TEST_ASSERT(!journal.Wait(5, 5));
+		TEST_ASSERT(journal.GetStats().barrier_timeouts == 1);
+
+		journal.Completed(5, 0);
+		TEST_ASSERT(journal.Wait(5, 5));
+
+		//entries nobody has taken yet don't hold up a wait for the batches in flight
+		journal.Replace(5, "(5,2)");
+		TEST_ASSERT(journal.WaitInFlight(5, 0));
+		TEST_ASSERT(!journal.Wait(5, 0));
+	}
+};
+
+#endif
@@ -0,0 +1,182 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef __EQEMU_TESTS_LOCKFREE_QUEUE_H
+#define __EQEMU_TESTS_LOCKFREE_QUEUE_H
+
+#include "cppunit/cpptest.h"
+#include "../common/lockfree_queue.h"
+#ifdef _WINDOWS
+	#include <process.h>
+#else
+	#include <pthread.h>
+#endif
+
+#define LOCKFREE_TEST_ITEMS 200000
+
+struct LockFreeTestProducer {
+	MPSCQueue<uint32> *mpsc;
+	SPSCQueue<uint32> *spsc;
+	uint32 tag;
+	std::atomic<bool> done;
+};
+
+ThreadReturnType LockFreeTestProducerLoop(void *arg) {
+	LockFreeTestProducer *p = (LockFreeTestProducer *)arg;
+	for(uint32 i = 0; i < LOCKFREE_TEST_ITEMS; i++) {
+		if(p->mpsc)
+			p->mpsc->Push(p->tag | i);
+		else
+			p->spsc->Push(i);
+	}
+	p->done = true;
+	THREAD_RETURN(nullptr);
+}
+
+inline void LockFreeTestStart(LockFreeTestProducer *p) {
+#ifdef _WINDOWS
+	_beginthread(LockFreeTestProducerLoop, 0, p);
+#else
+	pthread_t t;
+	pthread_create(&t, nullptr, LockFreeTestProducerLoop, p);
+	pthread_detach(t);
+#endif
+}
+
+class LockFreeQueueTest : public Test::Suite {
+	typedef void(LockFreeQueueTest::*TestFunction)(void);
+public:
+	LockFreeQueueTest() {
+		TEST_ADD(LockFreeQueueTest::SPSCOrderTest);
+		TEST_ADD(LockFreeQueueTest::SPSCPeekTest);
+		TEST_ADD(LockFreeQueueTest::MPSCOrderTest);
+		TEST_ADD(LockFreeQueueTest::SPSCThreadTest);
+		TEST_ADD(LockFreeQueueTest::MPSCThreadTest);
+	}
+	~LockFreeQueueTest() {
+	}
+
+	private:
+	void SPSCOrderTest() {
+		SPSCQueue<uint32> q;
+		uint32 v = 0;
+		TEST_ASSERT(q.Empty());
+		TEST_ASSERT(!q.Pop(v));
+
+		//several segments, drained part way through to exercise the spare
+		uint32 next = 0;
+		for(uint32 i = 0; i < SPSC_SEGMENT_SIZE * 5 + 3; i++) {
+			q.Push(i);
+			if(i % 3 == 0) {
+				TEST_ASSERT(q.Pop(v));
+				TEST_ASSERT(v == next);
+				next++;
+			}
+		}
+		while(q.Pop(v)) {
+			TEST_ASSERT(v == next);
+			next++;
+		}
+		TEST_ASSERT(next == SPSC_SEGMENT_SIZE * 5 + 3);
+		TEST_ASSERT(q.Empty());
+	}
+
+	void SPSCPeekTest() {
+		SPSCQueue<uint32> q;
+		uint32 v = 0;
+		TEST_ASSERT(!q.Peek(v));
+		for(uint32 i = 0; i < SPSC_SEGMENT_SIZE + 2; i++)
+			q.Push(i + 100);
+		TEST_ASSERT(q.Peek(v) && v == 100);
+		TEST_ASSERT(q.Peek(v, 1) && v == 101);
+		TEST_ASSERT(q.Peek(v, SPSC_SEGMENT_SIZE + 1) && v == SPSC_SEGMENT_SIZE + 101);
+		TEST_ASSERT(!q.Peek(v, SPSC_SEGMENT_SIZE + 2));
+		TEST_ASSERT(q.Pop(v) && v == 100);
+		TEST_ASSERT(q.Peek(v, SPSC_SEGMENT_SIZE) && v == SPSC_SEGMENT_SIZE + 101);
+	}
+
+	void MPSCOrderTest() {
+		MPSCQueue<uint32> q;
+		uint32 v = 0;
+		TEST_ASSERT(q.Empty());
+		TEST_ASSERT(!q.Pop(v));
+		q.Push(1);
+		q.Push(2);
+		TEST_ASSERT(q.Peek(v) && v == 1);
+		TEST_ASSERT(q.Pop(v) && v == 1);
+		q.Push(3);
+		TEST_ASSERT(q.Pop(v) && v == 2);
+		TEST_ASSERT(q.Pop(v) && v == 3);
+		TEST_ASSERT(q.Empty());
+	}
+
+	void SPSCThreadTest() {
+		SPSCQueue<uint32> q;
+		LockFreeTestProducer p;
+		p.mpsc = nullptr;
+		p.spsc = &q;
+		p.tag = 0;
+		p.done = false;
+		LockFreeTestStart(&p);
+
+		uint32 next = 0;
+		bool ordered = true;
+		uint32 v;
+		while(next < LOCKFREE_TEST_ITEMS) {
+			if(q.Pop(v)) {
+				if(v != next)
+					ordered = false;
+				next++;
+			}
+		}
+		while(!p.done) { }
+		TEST_ASSERT(ordered);
+		TEST_ASSERT(q.Empty());
+	}
+
+	void MPSCThreadTest() {
+		MPSCQueue<uint32> q;
+		LockFreeTestProducer p[2];
+		for(int r = 0; r < 2; r++) {
+			p[r].mpsc = &q;
+			p[r].spsc = nullptr;
+			p[r].tag = r << 31;
+			p[r].done = false;
+		}
+		LockFreeTestStart(&p[0]);
+		LockFreeTestStart(&p[1]);
+
+		//every item shows up once, each producer's in the order it pushed them
+		uint32 next[2] = { 0, 0 };
+		bool ordered = true;
+		uint32 v;
+		while(next[0] + next[1] < LOCKFREE_TEST_ITEMS * 2) {
+			if(q.Pop(v)) {
+				uint32 r = v >> 31;
+				if((v & 0x7FFFFFFF) != next[r])
+					ordered = false;
+				next[r]++;
+			}
+		}
+		while(!p[0].done || !p[1].done) { }
+		TEST_ASSERT(ordered);
+		TEST_ASSERT(q.Empty());
+	}
+};
+
+#endif
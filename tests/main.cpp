@@ -24,6 +24,20 @@
 #include "ipc_mutex_test.h"
 #include "fixed_memory_test.h"
 #include "fixed_memory_variable_test.h"
+#include "profile_save_test.h"
+#include "inventory_journal_test.h"
+#include "histogram_test.h"
+#include "timer_wheel_test.h"
+#include "lockfree_queue_test.h"
+#include "packet_compression_test.h"
+#include "packet_pool_test.h"
+#include "spawngroup_alias_test.h"
+#include "condition_test.h"
+#include "stream_queue_test.h"
+#include "entity_grid_test.h"
+#include "entity_slots_test.h"
+#include "dense_list_test.h"
+#include "map_test.h"
 
 int main() {
 	try {
@@ -34,6 +48,20 @@ int main() {
 		tests.add(new IPCMutexTest());
 		tests.add(new FixedMemoryHashTest());
 		tests.add(new FixedMemoryVariableHashTest());
+		tests.add(new ProfileSaveTest());
+		tests.add(new InventoryJournalTest());
+		tests.add(new HistogramTest());
+		tests.add(new TimerWheelTest());
+		tests.add(new LockFreeQueueTest());
+		tests.add(new PacketPoolTest());
+		tests.add(new PacketCompressionTest());
+		tests.add(new SpawnGroupAliasTest());
+		tests.add(new ConditionTest());
+		tests.add(new StreamQueueTest());
+		tests.add(new EntityGridTest());
+		tests.add(new EntitySlotsTest());
+		tests.add(new DenseListTest());
+		tests.add(new MapTest());
 		tests.run(*output, true);
 	} catch(...) {
 		return -1;
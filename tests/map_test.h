@@ -0,0 +1,309 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef __EQEMU_TESTS_MAP_H
+#define __EQEMU_TESTS_MAP_H
+
+#include "cppunit/cpptest.h"
+#include "../zone/map.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+/*
+	A 128x128 map split into four leaves, one per quadrant: rolling ground
+	made of 16 unit squares, a wall standing on x = 10 and a platform at
+	z = 30 over part of the x < 0, y >= 0 leaf. Each check runs the quadtree
+	walk and the batched BestZ against the versions they replaced.
+*/
+class MapTest : public Test::Suite {
+	typedef void(MapTest::*TestFunction)(void);
+public:
+	MapTest() {
+		TEST_ADD(MapTest::LoadTest);
+		TEST_ADD(MapTest::LOSKnownLinesTest);
+		TEST_ADD(MapTest::LOSMatchesSteppedTest);
+		TEST_ADD(MapTest::BestZKnownSpotsTest);
+		TEST_ADD(MapTest::BestZMatchesScalarTest);
+	}
+	~MapTest() {
+	}
+
+	private:
+	static float Ground(float x, float y) {
+		return(4.0f * sinf(x * 0.1f) + 3.0f * cosf(y * 0.13f));
+	}
+
+	static void AddFace(std::vector<FACE> &faces, const VERTEX &a, const VERTEX &b, const VERTEX &c) {
+		FACE f;
+		f.a = a;
+		f.b = b;
+		f.c = c;
+		f.nx = f.ny = f.nz = f.nd = 0.0f;
+		faces.push_back(f);
+	}
+
+	static void AddQuad(std::vector<FACE> &faces, const VERTEX &a, const VERTEX &b, const VERTEX &c, const VERTEX &d) {
+		AddFace(faces, a, b, c);
+		AddFace(faces, a, c, d);
+	}
+
+	//writes the map out the way the map builder does and loads it back
+	Map *BuildMap() {
+		std::vector<FACE> faces;
+		float x, y;
+		for(x = -64.0f; x < 64.0f; x += 16.0f) {
+			for(y = -64.0f; y < 64.0f; y += 16.0f) {
+				AddQuad(faces, VERTEX(x, y, Ground(x, y)), VERTEX(x + 16.0f, y, Ground(x + 16.0f, y)),
+					VERTEX(x + 16.0f, y + 16.0f, Ground(x + 16.0f, y + 16.0f)), VERTEX(x, y + 16.0f, Ground(x, y + 16.0f)));
+			}
+		}
+		AddQuad(faces, VERTEX(10.0f, -30.0f, -20.0f), VERTEX(10.0f, 0.0f, -20.0f), VERTEX(10.0f, 0.0f, 40.0f), VERTEX(10.0f, -30.0f, 40.0f));
+		AddQuad(faces, VERTEX(10.0f, 0.0f, -20.0f), VERTEX(10.0f, 30.0f, -20.0f), VERTEX(10.0f, 30.0f, 40.0f), VERTEX(10.0f, 0.0f, 40.0f));
+		AddQuad(faces, VERTEX(-40.0f, 10.0f, 30.0f), VERTEX(-10.0f, 10.0f, 30.0f), VERTEX(-10.0f, 40.0f, 30.0f), VERTEX(-40.0f, 40.0f, 30.0f));
+
+		//root, then the quadrants in the order map.h gives them
+		NODE nodes[5];
+		memset(nodes, 0, sizeof(nodes));
+		nodes[0].minx = -64.0f; nodes[0].maxx = 64.0f;
+		nodes[0].miny = -64.0f; nodes[0].maxy = 64.0f;
+		const float quad[4][4] = {
+			{ 0.0f, 64.0f, 0.0f, 64.0f },
+			{ -64.0f, 0.0f, 0.0f, 64.0f },
+			{ -64.0f, 0.0f, -64.0f, 0.0f },
+			{ 0.0f, 64.0f, -64.0f, 0.0f }
+		};
+		std::vector<uint32> facelists;
+		int q;
+		for(q = 0; q < 4; q++) {
+			NODE &n = nodes[q + 1];
+			nodes[0].nodes[q] = q + 1;
+			n.minx = quad[q][0]; n.maxx = quad[q][1];
+			n.miny = quad[q][2]; n.maxy = quad[q][3];
+			n.flags = nodeFinal;
+			n.faces.offset = facelists.size();
+			for(uint32 i = 0; i < faces.size(); i++) {
+				const FACE &f = faces[i];
+				float minx = std::min(f.a.x, std::min(f.b.x, f.c.x));
+				float maxx = std::max(f.a.x, std::max(f.b.x, f.c.x));
+				float miny = std::min(f.a.y, std::min(f.b.y, f.c.y));
+				float maxy = std::max(f.a.y, std::max(f.b.y, f.c.y));
+				if(minx < n.maxx && maxx > n.minx && miny < n.maxy && maxy > n.miny)
+					facelists.push_back(i);
+			}
+			n.faces.count = facelists.size() - n.faces.offset;
+		}
+
+		mapHeader head;
+		head.version = MAP_VERSION;
+		head.face_count = faces.size();
+		head.node_count = 5;
+		head.facelist_count = facelists.size();
+
+		FILE *fp = tmpfile();
+		if(fp == nullptr)
+			return(nullptr);
+		fwrite(&head, sizeof(head), 1, fp);
+		fwrite(&faces[0], sizeof(FACE), faces.size(), fp);
+		fwrite(nodes, sizeof(NODE), 5, fp);
+		fwrite(&facelists[0], sizeof(uint32), facelists.size(), fp);
+		rewind(fp);
+
+		Map *map = new Map();
+		bool loaded = map->loadMap(fp);
+		fclose(fp);
+		if(!loaded) {
+			delete map;
+			return(nullptr);
+		}
+		return(map);
+	}
+
+	static bool Near(float a, float b) {
+		return(fabs(a - b) < 0.01f);
+	}
+
+	void LoadTest() {
+		Map *map = BuildMap();
+		TEST_ASSERT(map != nullptr);
+		if(map == nullptr)
+			return;
+		TEST_ASSERT(map->GetFacesNumber() == 134);
+		TEST_ASSERT(map->SeekNode(MAP_ROOT_NODE, 20.0f, 20.0f) == 1);
+		TEST_ASSERT(map->SeekNode(MAP_ROOT_NODE, -20.0f, -20.0f) == 3);
+		TEST_ASSERT(map->SeekNode(MAP_ROOT_NODE, 100.0f, 0.0f) == NODE_NONE);
+		delete map;
+	}
+
+	void LOSKnownLinesTest() {
+		Map *map = BuildMap();
+		TEST_ASSERT(map != nullptr);
+		if(map == nullptr)
+			return;
+
+		VERTEX stepped_hit, traced_hit;
+		FACE *stepped_face = nullptr, *traced_face = nullptr;
+
+		//across the wall inside one leaf
+		VERTEX a(2.0f, -20.0f, 10.0f), b(30.0f, -20.0f, 10.0f);
+		TEST_ASSERT(map->LineIntersectsZoneStepped(a, b, 1.0f, &stepped_hit, &stepped_face));
+		TEST_ASSERT(map->LineIntersectsZone(a, b, 1.0f, &traced_hit, &traced_face));
+		TEST_ASSERT(Near(traced_hit.x, 10.0f) && Near(stepped_hit.x, 10.0f));
+		TEST_ASSERT(traced_face == stepped_face);
+
+		//across the wall and from one leaf into the next
+		VERTEX c(2.0f, 5.0f, 5.0f), d(40.0f, -20.0f, 15.0f);
+		TEST_ASSERT(map->LineIntersectsZoneStepped(c, d, 1.0f, &stepped_hit, nullptr));
+		TEST_ASSERT(map->LineIntersectsZone(c, d, 1.0f, &traced_hit, nullptr));
+		TEST_ASSERT(Near(traced_hit.x, 10.0f) && Near(stepped_hit.y, traced_hit.y));
+
+		//into a hillside
+		VERTEX e(-60.0f, -50.0f, 20.0f), f(-20.0f, -50.0f, -20.0f);
+		TEST_ASSERT(map->LineIntersectsZoneStepped(e, f, 1.0f, &stepped_hit, nullptr));
+		TEST_ASSERT(map->LineIntersectsZone(e, f, 1.0f, &traced_hit, nullptr));
+		TEST_ASSERT(Near(traced_hit.z, stepped_hit.z));
+
+		//over everything, through the middle of the map
+		VERTEX g(-50.0f, -50.0f, 60.0f), h(50.0f, 50.0f, 60.0f);
+		TEST_ASSERT(!map->LineIntersectsZoneStepped(g, h, 1.0f, &stepped_hit, nullptr));
+		TEST_ASSERT(!map->LineIntersectsZone(g, h, 1.0f, &traced_hit, nullptr));
+
+		//under the platform, above the ground
+		VERTEX i(-45.0f, 20.0f, 20.0f), j(-5.0f, 30.0f, 20.0f);
+		TEST_ASSERT(!map->LineIntersectsZoneStepped(i, j, 1.0f, &stepped_hit, nullptr));
+		TEST_ASSERT(!map->LineIntersectsZone(i, j, 1.0f, &traced_hit, nullptr));
+
+		//up through the platform
+		VERTEX k(-25.0f, 25.0f, 20.0f), l(-25.0f, 25.0f, 40.0f);
+		TEST_ASSERT(map->LineIntersectsZoneStepped(k, l, 1.0f, &stepped_hit, nullptr));
+		TEST_ASSERT(map->LineIntersectsZone(k, l, 1.0f, &traced_hit, nullptr));
+		TEST_ASSERT(Near(traced_hit.z, 30.0f));
+
+		//a point isn't a line
+		TEST_ASSERT(!map->LineIntersectsZone(a, a, 1.0f, &traced_hit, nullptr));
+		delete map;
+	}
+
+	//the trace visits every leaf the line crosses, stepping can skip a corner,
+	//so whatever stepping hits the trace hits too, and never farther away
+	void LOSMatchesSteppedTest() {
+		Map *map = BuildMap();
+		TEST_ASSERT(map != nullptr);
+		if(map == nullptr)
+			return;
+
+		uint32 lines = 0, blocked = 0, missed = 0, farther = 0;
+		float sx, sy, ex, ey;
+		for(sx = -60.0f; sx <= 60.0f; sx += 24.0f) {
+			for(sy = -60.0f; sy <= 60.0f; sy += 24.0f) {
+				for(ex = -55.0f; ex <= 55.0f; ex += 22.0f) {
+					for(ey = -55.0f; ey <= 55.0f; ey += 22.0f) {
+						VERTEX start(sx, sy, Ground(sx, sy) + 5.0f);
+						VERTEX end(ex, ey, Ground(ex, ey) + 5.0f);
+						VERTEX stepped_hit, traced_hit;
+						bool stepped = map->LineIntersectsZoneStepped(start, end, 1.0f, &stepped_hit, nullptr);
+						bool traced = map->LineIntersectsZone(start, end, 1.0f, &traced_hit, nullptr);
+						lines++;
+						if(traced)
+							blocked++;
+						if(stepped && !traced)
+							missed++;
+						if(stepped && traced) {
+							float ds = (stepped_hit.x - sx) * (stepped_hit.x - sx) + (stepped_hit.y - sy) * (stepped_hit.y - sy);
+							float dt = (traced_hit.x - sx) * (traced_hit.x - sx) + (traced_hit.y - sy) * (traced_hit.y - sy);
+							if(dt > ds + 0.01f)
+								farther++;
+						}
+					}
+				}
+			}
+		}
+		TEST_ASSERT(lines == 1296);
+		//the wall and the hills have to block some of them or this proves nothing
+		TEST_ASSERT(blocked > 0 && blocked < lines);
+		TEST_ASSERT(missed == 0);
+		TEST_ASSERT(farther == 0);
+		delete map;
+	}
+
+	void BestZKnownSpotsTest() {
+		Map *map = BuildMap();
+		TEST_ASSERT(map != nullptr);
+		if(map == nullptr)
+			return;
+
+		VERTEX hit;
+		FACE *on = nullptr;
+
+		//on top of the platform
+		VERTEX above(-25.0f, 25.0f, 50.0f);
+		TEST_ASSERT(Near(map->FindBestZ(MAP_ROOT_NODE, above, &hit, &on), 30.0f));
+		TEST_ASSERT(on != nullptr);
+		TEST_ASSERT(Near(map->FindBestZScalar(MAP_ROOT_NODE, above, nullptr, nullptr), 30.0f));
+
+		//under it, down to the ground. The ground is flat to within a few
+		//units over one square, so it only has to land near Ground()
+		VERTEX under(-25.0f, 25.0f, 20.0f);
+		float z = map->FindBestZ(MAP_ROOT_NODE, under, &hit, nullptr);
+		TEST_ASSERT(z != BEST_Z_INVALID && fabs(z - Ground(-25.0f, 25.0f)) < 4.0f);
+		TEST_ASSERT(z == map->FindBestZScalar(MAP_ROOT_NODE, under, nullptr, nullptr));
+
+		//too far under the world for the second try
+		VERTEX deep(20.0f, 20.0f, -50.0f);
+		TEST_ASSERT(map->FindBestZ(MAP_ROOT_NODE, deep, nullptr, nullptr) == BEST_Z_INVALID);
+		TEST_ASSERT(map->FindBestZScalar(MAP_ROOT_NODE, deep, nullptr, nullptr) == BEST_Z_INVALID);
+
+		//off the map
+		VERTEX off(100.0f, 100.0f, 0.0f);
+		TEST_ASSERT(map->FindBestZ(MAP_ROOT_NODE, off, nullptr, nullptr) == BEST_Z_INVALID);
+		TEST_ASSERT(map->FindBestZScalar(MAP_ROOT_NODE, off, nullptr, nullptr) == BEST_Z_INVALID);
+		delete map;
+	}
+
+	void BestZMatchesScalarTest() {
+		Map *map = BuildMap();
+		TEST_ASSERT(map != nullptr);
+		if(map == nullptr)
+			return;
+
+		uint32 spots = 0, found = 0, mismatched = 0;
+		float x, y, z;
+		for(x = -70.0f; x <= 70.0f; x += 3.7f) {
+			for(y = -70.0f; y <= 70.0f; y += 3.7f) {
+				for(z = -15.0f; z <= 50.0f; z += 7.0f) {
+					VERTEX spot(x, y, z);
+					FACE *scalar_face = nullptr, *batch_face = nullptr;
+					float scalar_z = map->FindBestZScalar(MAP_ROOT_NODE, spot, nullptr, &scalar_face);
+					float batch_z = map->FindBestZ(MAP_ROOT_NODE, spot, nullptr, &batch_face);
+					spots++;
+					if(scalar_z != BEST_Z_INVALID)
+						found++;
+					if(!Near(scalar_z, batch_z) || scalar_face != batch_face)
+						mismatched++;
+				}
+			}
+		}
+		TEST_ASSERT(found > 0 && found < spots);
+		TEST_ASSERT(mismatched == 0);
+		delete map;
+	}
+};
+
+#endif
@@ -28,6 +28,7 @@ public:
 	MemoryMappedFileTest() {
 		TEST_ADD(MemoryMappedFileTest::LoadAndZeroMMF)
 		TEST_ADD(MemoryMappedFileTest::LoadExistingMMF)
+		TEST_ADD(MemoryMappedFileTest::LoadReadOnlyMMF)
 	}
 
 	~MemoryMappedFileTest() {
@@ -55,6 +56,17 @@ public:
 		uint32 val = *reinterpret_cast<uint32*>(data);
 		TEST_ASSERT(val == 562);
 	}
+
+	void LoadReadOnlyMMF() {
+		EQEmu::MemoryMappedFile mmf("testfile.txt", EQEmu::MemoryMappedFile::ReadOnly);
+		TEST_ASSERT(mmf.Size() == 512);
+
+		const unsigned char *data = reinterpret_cast<const unsigned char*>(mmf.Get());
+		TEST_ASSERT(data != nullptr);
+
+		uint32 val = *reinterpret_cast<const uint32*>(data);
+		TEST_ASSERT(val == 562);
+	}
 };
 
 #endif
@@ -0,0 +1,103 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef __EQEMU_TESTS_PACKET_COMPRESSION_H
+#define __EQEMU_TESTS_PACKET_COMPRESSION_H
+
+#include "cppunit/cpptest.h"
+#include "../common/packet_functions.h"
+#include "../common/EQPacket.h"
+
+class PacketCompressionTest : public Test::Suite {
+	typedef void(PacketCompressionTest::*TestFunction)(void);
+public:
+	PacketCompressionTest() {
+		TEST_ADD(PacketCompressionTest::RoundTripTest);
+		TEST_ADD(PacketCompressionTest::StoredTest);
+		TEST_ADD(PacketCompressionTest::ContextTest);
+	}
+	~PacketCompressionTest() {
+	}
+
+	private:
+	//protocol opcode 00 09 followed by something deflate likes
+	uint32 Build(unsigned char *out, uint32 length) {
+		out[0] = 0;
+		out[1] = 0x09;
+		for(uint32 i = 2; i < length; i++)
+			out[i] = (unsigned char)(i % 7);
+		return(length);
+	}
+
+	bool RoundTrips(const unsigned char *in, uint32 length, uint32 min_size, int level, unsigned char flag) {
+		unsigned char packed[1024];
+		unsigned char unpacked[1024];
+		uint32 packed_length = EQProtocolPacket::Compress(in, length, packed, sizeof(packed), min_size, level);
+		if(packed[2] != flag)
+			return(false);
+		//Decompress expects the two crc bytes on the end
+		packed[packed_length++] = 0;
+		packed[packed_length++] = 0;
+		uint32 unpacked_length = EQProtocolPacket::Decompress(packed, packed_length, unpacked, sizeof(unpacked));
+		return(unpacked_length == length + 2 && memcmp(unpacked, in, length) == 0);
+	}
+
+	void RoundTripTest() {
+		unsigned char in[512];
+		uint32 length = Build(in, sizeof(in));
+		TEST_ASSERT(RoundTrips(in, length, 30, DEFLATE_DEFAULT_LEVEL, 0x5a));
+		TEST_ASSERT(RoundTrips(in, length, 30, 1, 0x5a));
+		TEST_ASSERT(RoundTrips(in, length, 30, 9, 0x5a));
+	}
+
+	void StoredTest() {
+		unsigned char in[512];
+		uint32 length = Build(in, 20);
+		//under the threshold
+		TEST_ASSERT(RoundTrips(in, length, 30, DEFLATE_DEFAULT_LEVEL, 0xa5));
+		//level 0
+		length = Build(in, sizeof(in));
+		TEST_ASSERT(RoundTrips(in, length, 30, 0, 0xa5));
+		//noise that deflate can't shrink
+		uint32 seed = 12345;
+		for(uint32 i = 2; i < 64; i++) {
+			seed = seed * 1103515245 + 12345;
+			in[i] = (unsigned char)(seed >> 16);
+		}
+		TEST_ASSERT(RoundTrips(in, 64, 30, 9, 0xa5));
+	}
+
+	void ContextTest() {
+		unsigned char in[512];
+		uint32 length = Build(in, sizeof(in));
+		unsigned char once[1024];
+		uint32 once_length = EQProtocolPacket::Compress(in, length, once, sizeof(once), 30, 6);
+
+		ZlibThreadContext zlib;
+		//reused streams, switching levels in between, give the same bytes as fresh ones
+		for(int r = 0; r < 3; r++) {
+			unsigned char again[1024];
+			TEST_ASSERT(RoundTrips(in, length, 30, 1, 0x5a));
+			uint32 again_length = EQProtocolPacket::Compress(in, length, again, sizeof(again), 30, 6);
+			TEST_ASSERT(again_length == once_length);
+			TEST_ASSERT(memcmp(again, once, once_length) == 0);
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,106 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef __EQEMU_TESTS_PACKET_POOL_H
+#define __EQEMU_TESTS_PACKET_POOL_H
+
+#include "cppunit/cpptest.h"
+#include "../common/packet_pool.h"
+#include "../common/EQPacket.h"
+
+class PacketPoolTest : public Test::Suite {
+	typedef void(PacketPoolTest::*TestFunction)(void);
+public:
+	PacketPoolTest() {
+		TEST_ADD(PacketPoolTest::ReuseTest);
+		TEST_ADD(PacketPoolTest::BufferTest);
+		TEST_ADD(PacketPoolTest::CombineTest);
+		TEST_ADD(PacketPoolTest::SerializeInPlaceTest);
+	}
+	~PacketPoolTest() {
+	}
+
+	private:
+	void ReuseTest() {
+		void *a = PacketPool::Allocate(100);
+		PacketPool::Free(a);
+		PacketPool::ResetStats();
+
+		//same class, straight back out of this thread's cache
+		void *b = PacketPool::Allocate(120);
+		TEST_ASSERT(b == a);
+		void *big = PacketPool::Allocate(1 << 20);
+		PacketPool::Free(big);
+		PacketPool::Free(b);
+
+		PacketPool::Stats stats;
+		PacketPool::GetStats(stats);
+		TEST_ASSERT(stats.allocs == 2);
+		TEST_ASSERT(stats.frees == 2);
+		TEST_ASSERT(stats.heap_allocs == 1);
+		TEST_ASSERT(stats.oversize == 1);
+	}
+
+	void BufferTest() {
+		uint32 capacity = 0;
+		unsigned char *buf = PacketPool::AllocateBuffer(100, capacity);
+		TEST_ASSERT(capacity >= 100);
+		//the headroom and the whole capacity are writable
+		memset(buf - PACKET_POOL_HEADROOM, 0xAB, capacity + PACKET_POOL_HEADROOM);
+		PacketPool::FreeBuffer(buf);
+	}
+
+	void CombineTest() {
+		unsigned char one[] = { 1, 2, 3 };
+		unsigned char two[] = { 4, 5 };
+		EQProtocolPacket *a = new EQProtocolPacket(0x15, one, sizeof(one));
+		EQProtocolPacket *b = new EQProtocolPacket(0x09, two, sizeof(two));
+		EQProtocolPacket *c = new EQProtocolPacket(0x15, two, sizeof(two));
+
+		TEST_ASSERT(a->combine(b));
+		TEST_ASSERT(a->combine(c));
+		//len, 00 15, 1 2 3, len, 00 09, 4 5, len, 00 15, 4 5
+		unsigned char expect[] = { 5, 0, 0x15, 1, 2, 3, 4, 0, 0x09, 4, 5, 4, 0, 0x15, 4, 5 };
+		TEST_ASSERT(a->size == sizeof(expect));
+		TEST_ASSERT(memcmp(a->pBuffer, expect, sizeof(expect)) == 0);
+
+		//runs out of room in its first block and has to move
+		for(int r = 0; r < 20; r++)
+			TEST_ASSERT(a->combine(b));
+		TEST_ASSERT(a->size == sizeof(expect) + 20 * 5);
+		TEST_ASSERT(memcmp(a->pBuffer, expect, sizeof(expect)) == 0);
+
+		delete a;
+		delete b;
+		delete c;
+	}
+
+	void SerializeInPlaceTest() {
+		unsigned char data[] = { 9, 8, 7, 6 };
+		EQProtocolPacket *p = new EQProtocolPacket(0x09, data, sizeof(data));
+		unsigned char copy[16];
+		uint32 length = p->serialize(copy);
+		unsigned char *raw = p->SerializeInPlace();
+		TEST_ASSERT(raw != nullptr);
+		TEST_ASSERT(length == p->size + 2);
+		TEST_ASSERT(memcmp(raw, copy, length) == 0);
+		delete p;
+	}
+};
+
+#endif
@@ -0,0 +1,171 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef __EQEMU_TESTS_PROFILE_SAVE_H
+#define __EQEMU_TESTS_PROFILE_SAVE_H
+
+#include "cppunit/cpptest.h"
+#include "../common/profile_save.h"
+#include <string.h>
+
+class ProfileSaveTest : public Test::Suite {
+	typedef void(ProfileSaveTest::*TestFunction)(void);
+public:
+	ProfileSaveTest() {
+		TEST_ADD(ProfileSaveTest::FirstCollectTest);
+		TEST_ADD(ProfileSaveTest::UnchangedTest);
+		TEST_ADD(ProfileSaveTest::SingleRunTest);
+		TEST_ADD(ProfileSaveTest::MergeRunsTest);
+		TEST_ADD(ProfileSaveTest::TooManyRunsTest);
+		TEST_ADD(ProfileSaveTest::MarkDirtyTest);
+		TEST_ADD(ProfileSaveTest::InvalidateTest);
+		TEST_ADD(ProfileSaveTest::IgnoreTest);
+	}
+	~ProfileSaveTest() {
+	}
+
+	private:
+	void FirstCollectTest() {
+		BlobDelta delta(1000);
+		uint8 data[1000];
+		memset(data, 1, sizeof(data));
+		std::vector<DeltaRun> runs;
+		TEST_ASSERT(delta.Collect(data, runs));
+		TEST_ASSERT(delta.IsFull(runs));
+	}
+
+	void UnchangedTest() {
+		BlobDelta delta(1000);
+		uint8 data[1000];
+		memset(data, 1, sizeof(data));
+		std::vector<DeltaRun> runs;
+		delta.Collect(data, runs);
+		TEST_ASSERT(!delta.Collect(data, runs));
+		TEST_ASSERT(runs.empty());
+	}
+
+	void SingleRunTest() {
+		BlobDelta delta(1000);
+		uint8 data[1000];
+		memset(data, 1, sizeof(data));
+		std::vector<DeltaRun> runs;
+		delta.Collect(data, runs);
+		data[130] = 2;
+		TEST_ASSERT(delta.Collect(data, runs));
+		TEST_ASSERT(runs.size() == 1);
+		TEST_ASSERT(runs[0].offset == 128);
+		TEST_ASSERT(runs[0].length == BLOB_DELTA_REGION);
+
+		//the last region is short
+		data[999] = 2;
+		TEST_ASSERT(delta.Collect(data, runs));
+		TEST_ASSERT(runs.size() == 1);
+		TEST_ASSERT(runs[0].offset == 960);
+		TEST_ASSERT(runs[0].length == 40);
+	}
+
+	void MergeRunsTest() {
+		BlobDelta delta(1000);
+		uint8 data[1000];
+		memset(data, 1, sizeof(data));
+		std::vector<DeltaRun> runs;
+		delta.Collect(data, runs);
+		data[10] = 2;
+		data[70] = 2;
+		data[300] = 2;
+		TEST_ASSERT(delta.Collect(data, runs));
+		TEST_ASSERT(runs.size() == 2);
+		TEST_ASSERT(runs[0].offset == 0);
+		TEST_ASSERT(runs[0].length == 128);
+		TEST_ASSERT(runs[1].offset == 256);
+		TEST_ASSERT(runs[1].length == 64);
+	}
+
+	void TooManyRunsTest() {
+		BlobDelta delta(4096);
+		uint8 data[4096];
+		memset(data, 1, sizeof(data));
+		std::vector<DeltaRun> runs;
+		delta.Collect(data, runs);
+		for(int i = 0; i <= BLOB_DELTA_MAX_RUNS; i++)
+			data[i * 2 * BLOB_DELTA_REGION] = 2;
+		TEST_ASSERT(delta.Collect(data, runs));
+		TEST_ASSERT(delta.IsFull(runs));
+	}
+
+	void MarkDirtyTest() {
+		BlobDelta delta(1000);
+		uint8 data[1000];
+		memset(data, 1, sizeof(data));
+		std::vector<DeltaRun> runs;
+		delta.Collect(data, runs);
+
+		std::vector<DeltaRun> lost;
+		DeltaRun r = { 500, 10 };
+		lost.push_back(r);
+		delta.MarkDirty(lost);
+		TEST_ASSERT(delta.Collect(data, runs));
+		TEST_ASSERT(runs.size() == 1);
+		TEST_ASSERT(runs[0].offset == 448);
+		TEST_ASSERT(runs[0].length == 64);
+		TEST_ASSERT(!delta.Collect(data, runs));
+	}
+
+	void InvalidateTest() {
+		ProfileSaveState state(1000, 500);
+		uint8 pp[1000], ext[500];
+		memset(pp, 1, sizeof(pp));
+		memset(ext, 1, sizeof(ext));
+		state.pp.Collect(pp, state.pp_runs);
+		state.ext.Collect(ext, state.ext_runs);
+		state.Invalidate();
+		TEST_ASSERT(state.force_write);
+		TEST_ASSERT(state.pp.Collect(pp, state.pp_runs));
+		TEST_ASSERT(state.pp.IsFull(state.pp_runs));
+		TEST_ASSERT(state.ext.Collect(ext, state.ext_runs));
+		TEST_ASSERT(state.ext.IsFull(state.ext_runs));
+	}
+
+	void IgnoreTest() {
+		BlobDelta delta(1000);
+		delta.Ignore(132, 4);
+		uint8 data[1000];
+		memset(data, 1, sizeof(data));
+		std::vector<DeltaRun> runs;
+		delta.Collect(data, runs);
+
+		//only the ignored bytes changed
+		data[132] = 2;
+		data[135] = 2;
+		TEST_ASSERT(!delta.Collect(data, runs));
+
+		//something else in the same region did, the region goes out with both
+		data[133] = 3;
+		data[136] = 2;
+		TEST_ASSERT(delta.Collect(data, runs));
+		TEST_ASSERT(runs.size() == 1);
+		TEST_ASSERT(runs[0].offset == 128);
+
+		data[132] = 4;
+		data[131] = 2;
+		TEST_ASSERT(delta.Collect(data, runs));
+		TEST_ASSERT(runs.size() == 1);
+	}
+};
+
+#endif
@@ -0,0 +1,83 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef __EQEMU_TESTS_SPAWNGROUP_ALIAS_H
+#define __EQEMU_TESTS_SPAWNGROUP_ALIAS_H
+
+#include "cppunit/cpptest.h"
+#include "../common/spawngroup_table.h"
+#include <string.h>
+#include <vector>
+
+class SpawnGroupAliasTest : public Test::Suite {
+	typedef void(SpawnGroupAliasTest::*TestFunction)(void);
+public:
+	SpawnGroupAliasTest() {
+		TEST_ADD(SpawnGroupAliasTest::ExactOddsTest);
+		TEST_ADD(SpawnGroupAliasTest::NoChanceTest);
+	}
+	~SpawnGroupAliasTest() {
+	}
+
+	private:
+	SpawnGroup_Struct *MakeGroup(std::vector<uint8> &buffer, const int32 *chances, uint32 count) {
+		buffer.assign(sizeof(SpawnGroup_Struct) + sizeof(SpawnGroupEntries_Struct) * count, 0);
+		SpawnGroup_Struct *sg = reinterpret_cast<SpawnGroup_Struct*>(&buffer[0]);
+		sg->NumEntries = count;
+		for(uint32 r = 0; r < count; ++r) {
+			sg->Entries[r].npc_type = 1000 + r;
+			sg->Entries[r].chance = chances[r];
+		}
+		sg->Entries[1].npc_spawn_limit = 2;
+		BuildSpawnGroupAlias(sg);
+		return sg;
+	}
+
+	void ExactOddsTest() {
+		int32 chances[] = { 5, 0, 30, 10, 55, -3 };
+		uint32 count = sizeof(chances) / sizeof(chances[0]);
+		std::vector<uint8> buffer;
+		SpawnGroup_Struct *sg = MakeGroup(buffer, chances, count);
+		TEST_ASSERT(sg->total_chance == 100);
+		TEST_ASSERT(sg->limited_entries == 1);
+
+		//every slot and roll once, each entry has to come up chance * count times
+		std::vector<uint32> picks(count, 0);
+		for(uint32 slot = 0; slot < count; ++slot) {
+			for(uint32 roll = 0; roll < sg->total_chance; ++roll) {
+				uint32 pick = PickSpawnGroupEntry(sg, slot, roll);
+				TEST_ASSERT(pick < count);
+				++picks[pick];
+			}
+		}
+
+		for(uint32 r = 0; r < count; ++r) {
+			uint32 expect = chances[r] > 0 ? chances[r] * count : 0;
+			TEST_ASSERT(picks[r] == expect);
+		}
+	}
+
+	void NoChanceTest() {
+		int32 chances[] = { 0, 0, 0 };
+		std::vector<uint8> buffer;
+		SpawnGroup_Struct *sg = MakeGroup(buffer, chances, 3);
+		TEST_ASSERT(sg->total_chance == 0);
+	}
+};
+
+#endif
@@ -0,0 +1,213 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef __EQEMU_TESTS_STREAM_QUEUE_H
+#define __EQEMU_TESTS_STREAM_QUEUE_H
+
+#include "cppunit/cpptest.h"
+#include "../common/lockfree_queue.h"
+#include "../common/Mutex.h"
+#include <vector>
+#include <queue>
+#ifdef _WINDOWS
+	#include <process.h>
+#else
+	#include <pthread.h>
+	#include <sched.h>
+#endif
+
+#define STREAM_QUEUE_TEST_STREAMS 100
+#define STREAM_QUEUE_TEST_PACKETS 200
+
+//one simulated stream the way EQStream used to queue: a mutex per queue
+struct StreamQueueLocked
+{
+	Mutex MIn, MOut;
+	std::vector<uint32> in;
+	std::queue<uint32> out;
+
+	void PushIn(uint32 v) { MIn.lock(); in.push_back(v); MIn.unlock(); }
+	bool PopIn(uint32 &v)
+	{
+		bool got = false;
+		MIn.lock();
+		if(!in.empty()) {
+			v = in.front();
+			in.erase(in.begin());
+			got = true;
+		}
+		MIn.unlock();
+		return(got);
+	}
+	void PushOut(uint32 v) { MOut.lock(); out.push(v); MOut.unlock(); }
+	bool PopOut(uint32 &v)
+	{
+		bool got = false;
+		MOut.lock();
+		if(!out.empty()) {
+			v = out.front();
+			out.pop();
+			got = true;
+		}
+		MOut.unlock();
+		return(got);
+	}
+};
+
+//and the way it queues now: pushes take no lock, pops still serialize against each other
+struct StreamQueueLockFree
+{
+	Mutex MIn, MOut;
+	SPSCQueue<uint32> in;
+	MPSCQueue<uint32> out;
+
+	void PushIn(uint32 v) { in.Push(v); }
+	bool PopIn(uint32 &v) { MIn.lock(); bool got = in.Pop(v); MIn.unlock(); return(got); }
+	void PushOut(uint32 v) { out.Push(v); }
+	bool PopOut(uint32 &v) { MOut.lock(); bool got = out.Pop(v); MOut.unlock(); return(got); }
+};
+
+template<class STREAM>
+struct StreamQueueRun
+{
+	STREAM streams[STREAM_QUEUE_TEST_STREAMS];
+	std::atomic<uint32> finished;
+	std::atomic<uint64> written;
+};
+
+inline void StreamQueueYield()
+{
+#ifdef _WINDOWS
+	Sleep(0);
+#else
+	sched_yield();
+#endif
+}
+
+//the factory reader: every packet in also queues an ack out
+template<class STREAM>
+ThreadReturnType StreamQueueReader(void *arg)
+{
+	StreamQueueRun<STREAM> *run = (StreamQueueRun<STREAM> *)arg;
+	for(uint32 p = 0; p < STREAM_QUEUE_TEST_PACKETS; p++) {
+		for(uint32 s = 0; s < STREAM_QUEUE_TEST_STREAMS; s++) {
+			run->streams[s].PushIn(p);
+			run->streams[s].PushOut(p);
+		}
+	}
+	run->finished++;
+	THREAD_RETURN(nullptr);
+}
+
+//the factory writer: drains every stream until it has seen all the acks and replies
+template<class STREAM>
+ThreadReturnType StreamQueueWriter(void *arg)
+{
+	StreamQueueRun<STREAM> *run = (StreamQueueRun<STREAM> *)arg;
+	uint64 want = uint64(STREAM_QUEUE_TEST_STREAMS) * STREAM_QUEUE_TEST_PACKETS * 2;
+	uint64 seen = 0;
+	uint32 v;
+	while(seen < want) {
+		uint64 before = seen;
+		for(uint32 s = 0; s < STREAM_QUEUE_TEST_STREAMS; s++) {
+			while(run->streams[s].PopOut(v))
+				seen++;
+		}
+		if(seen == before)
+			StreamQueueYield();
+	}
+	run->written = seen;
+	run->finished++;
+	THREAD_RETURN(nullptr);
+}
+
+template<class STREAM>
+inline void StreamQueueStart(ThreadReturnType (*loop)(void *), StreamQueueRun<STREAM> *run)
+{
+#ifdef _WINDOWS
+	_beginthread(loop, 0, run);
+#else
+	pthread_t thread;
+	pthread_create(&thread, nullptr, loop, run);
+	pthread_detach(thread);
+#endif
+}
+
+/*
+	Reader, zone and writer threads over a set of streams, the contention
+	EQStreamFactory and the zone put on EQStream's queues. Checks every
+	packet gets through in order with the mutex guarded queues and the
+	lock-free ones.
+*/
+class StreamQueueTest : public Test::Suite {
+	typedef void(StreamQueueTest::*TestFunction)(void);
+public:
+	StreamQueueTest() {
+		TEST_ADD(StreamQueueTest::LockedTest);
+		TEST_ADD(StreamQueueTest::LockFreeTest);
+	}
+	~StreamQueueTest() {
+	}
+
+	private:
+	//this thread plays the zone: handle each packet and queue a reply
+	template<class STREAM>
+	bool Run() {
+		StreamQueueRun<STREAM> *run = new StreamQueueRun<STREAM>;
+		run->finished = 0;
+		run->written = 0;
+		std::vector<uint32> next(STREAM_QUEUE_TEST_STREAMS, 0);
+		bool in_order = true;
+
+		StreamQueueStart<STREAM>(StreamQueueReader<STREAM>, run);
+		StreamQueueStart<STREAM>(StreamQueueWriter<STREAM>, run);
+
+		uint64 want = uint64(STREAM_QUEUE_TEST_STREAMS) * STREAM_QUEUE_TEST_PACKETS;
+		uint64 seen = 0;
+		uint32 v;
+		while(seen < want) {
+			uint64 before = seen;
+			for(uint32 s = 0; s < STREAM_QUEUE_TEST_STREAMS; s++) {
+				while(run->streams[s].PopIn(v)) {
+					if(v != next[s]++)
+						in_order = false;
+					run->streams[s].PushOut(v);
+					seen++;
+				}
+			}
+			if(seen == before)
+				StreamQueueYield();
+		}
+		while(run->finished < 2)
+			StreamQueueYield();
+
+		bool ok = in_order && run->written == want * 2;
+		delete run;
+		return ok;
+	}
+
+	void LockedTest() {
+		TEST_ASSERT(Run<StreamQueueLocked>());
+	}
+
+	void LockFreeTest() {
+		TEST_ASSERT(Run<StreamQueueLockFree>());
+	}
+};
+
+#endif
@@ -0,0 +1,151 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef __EQEMU_TESTS_TIMER_WHEEL_H
+#define __EQEMU_TESTS_TIMER_WHEEL_H
+
+#include "cppunit/cpptest.h"
+#include "../common/timer_wheel.h"
+
+class TestWheelEntry : public TimerWheelEntry {
+public:
+	TestWheelEntry(TimerWheel &w) : wheel(w), fired_at(0), fired(0), repeat(0) { }
+
+	TimerWheel &wheel;
+	uint32 fired_at;
+	uint32 fired;
+	uint32 repeat;
+
+protected:
+	virtual void Fire() {
+		fired_at = wheel.GetCurrent();
+		fired++;
+		if(repeat)
+			wheel.Schedule(this, fired_at + repeat);
+	}
+};
+
+class TimerWheelTest : public Test::Suite {
+	typedef void(TimerWheelTest::*TestFunction)(void);
+public:
+	TimerWheelTest() {
+		TEST_ADD(TimerWheelTest::ExactTimeTest);
+		TEST_ADD(TimerWheelTest::CancelTest);
+		TEST_ADD(TimerWheelTest::RepeatTest);
+		TEST_ADD(TimerWheelTest::LongDelayTest);
+		TEST_ADD(TimerWheelTest::WrapTest);
+		TEST_ADD(TimerWheelTest::SkipTest);
+	}
+	~TimerWheelTest() {
+	}
+
+	private:
+	//steps one millisecond at a time so a late or early fire shows up
+	void Run(TimerWheel &wheel, uint32 until) {
+		while(int32(until - wheel.GetCurrent()) > 0)
+			wheel.Advance(wheel.GetCurrent() + 1);
+	}
+
+	void ExactTimeTest() {
+		TimerWheel wheel(1000);
+		TestWheelEntry a(wheel), b(wheel), c(wheel), d(wheel);
+		wheel.Schedule(&a, 1005);
+		wheel.Schedule(&b, 1256);
+		wheel.Schedule(&c, 1000 + 20000);
+		wheel.Schedule(&d, 1000 + 2000000);
+		TEST_ASSERT(wheel.Count() == 4);
+
+		Run(wheel, 1000 + 2000001);
+		TEST_ASSERT(a.fired == 1 && a.fired_at == 1005);
+		TEST_ASSERT(b.fired == 1 && b.fired_at == 1256);
+		TEST_ASSERT(c.fired == 1 && c.fired_at == 21000);
+		TEST_ASSERT(d.fired == 1 && d.fired_at == 2001000);
+		TEST_ASSERT(wheel.Count() == 0);
+	}
+
+	void CancelTest() {
+		TimerWheel wheel;
+		TestWheelEntry a(wheel);
+		wheel.Schedule(&a, 50);
+		{
+			TestWheelEntry b(wheel);
+			wheel.Schedule(&b, 60);
+			TEST_ASSERT(wheel.Count() == 2);
+		}
+		TEST_ASSERT(wheel.Count() == 1);
+		wheel.Cancel(&a);
+		TEST_ASSERT(!a.Scheduled());
+		TEST_ASSERT(wheel.Advance(100) == 0);
+		TEST_ASSERT(a.fired == 0);
+	}
+
+	void RepeatTest() {
+		TimerWheel wheel;
+		TestWheelEntry a(wheel);
+		a.repeat = 100;
+		wheel.Schedule(&a, 100);
+		//a big jump fires each period once, at its own time
+		wheel.Advance(1000);
+		TEST_ASSERT(a.fired == 10);
+		TEST_ASSERT(a.fired_at == 1000);
+		TEST_ASSERT(a.GetExpires() == 1100);
+	}
+
+	void LongDelayTest() {
+		TimerWheel wheel;
+		TestWheelEntry a(wheel);
+		uint32 when = TIMER_WHEEL_SPAN + 12345;
+		wheel.Schedule(&a, when);
+		wheel.Advance(when - 1);
+		TEST_ASSERT(a.fired == 0);
+		wheel.Advance(when);
+		TEST_ASSERT(a.fired == 1 && a.fired_at == when);
+	}
+
+	void WrapTest() {
+		TimerWheel wheel(0xFFFFFF00);
+		TestWheelEntry a(wheel), b(wheel);
+		wheel.Schedule(&a, 0xFFFFFFF0);
+		wheel.Schedule(&b, 0x00000400);
+		Run(wheel, 0x00000500);
+		TEST_ASSERT(a.fired == 1 && a.fired_at == 0xFFFFFFF0);
+		TEST_ASSERT(b.fired == 1 && b.fired_at == 0x00000400);
+	}
+
+	void SkipTest() {
+		//one long jump across empty level 0 turns still fires on the exact millisecond
+		TimerWheel wheel(100);
+		TestWheelEntry a(wheel), b(wheel);
+		wheel.Schedule(&a, 100 + 3 * TIMER_WHEEL_LEVEL0_SIZE + 7);
+		wheel.Schedule(&b, 100 + 40000);
+		wheel.Advance(100 + 39999);
+		TEST_ASSERT(a.fired == 1 && a.fired_at == 100 + 3 * TIMER_WHEEL_LEVEL0_SIZE + 7);
+		TEST_ASSERT(b.fired == 0);
+		TEST_ASSERT(wheel.GetCurrent() == 100 + 39999);
+		wheel.Advance(100 + 40000);
+		TEST_ASSERT(b.fired == 1 && b.fired_at == 100 + 40000);
+
+		//a repeating entry refiled from its own Fire is picked up mid jump
+		a.repeat = 1000;
+		wheel.Schedule(&a, 50000);
+		wheel.Advance(53500);
+		TEST_ASSERT(a.fired == 5 && a.fired_at == 53000);
+	}
+};
+
+#endif
@@ -46,6 +46,7 @@
 #include "LauncherList.h"
 #include "ucs.h"
 #include "queryserv.h"
+#include "../common/dbasync.h"
 
 #ifdef _WINDOWS
 	#define snprintf	_snprintf
@@ -61,6 +62,7 @@ extern LauncherList launcher_list;
 extern UCSConnection UCSLink;
 extern QueryServConnection QSLink;
 extern volatile bool	RunLoops;
+extern DBAsync *dbasync;
 
 ConsoleList console_list;
 void CatchSignal(int sig_num);
@@ -459,6 +461,8 @@ void Console::ProcessCommand(const char* command) {
 				if (admin >= consoleWorldStatus) {
 					SendMessage(1, "  version");
 					SendMessage(1, "  worldshutdown");
+					SendMessage(1, "  dbstats [reset]");
+					SendMessage(1, "  zoneprofile [on|off|reset|snapshot] [zoneserverid]");
 				}
 				if (admin >= 201) {
 					SendMessage(1, "  IPLookup [name]");
@@ -765,6 +769,53 @@ void Console::ProcessCommand(const char* command) {
 				SendMessage(1, "  Compiled on: %s at %s", COMPILE_DATE, COMPILE_TIME);
 				SendMessage(1, "  Last modified on: %s", LAST_MODIFIED);
 			}
+			else if (strcasecmp(sep.arg[0], "dbstats") == 0 && admin >= consoleWorldStatus) {
+				if (strcasecmp(sep.arg[1], "reset") == 0) {
+					dbasync->ResetStats();
+					SendMessage(1, "DBAsync stats reset.");
+				}
+				else {
+					std::vector<std::string> lines;
+					dbasync->DescribeStats(lines);
+					for (size_t i = 0; i < lines.size(); i++)
+						SendMessage(1, "%s", lines[i].c_str());
+				}
+			}
+			else if (strcasecmp(sep.arg[0], "zoneprofile") == 0 && admin >= consoleWorldStatus) {
+				int option = -1;
+				if (strcasecmp(sep.arg[1], "on") == 0)
+					option = ZoneProfileOn;
+				else if (strcasecmp(sep.arg[1], "off") == 0)
+					option = ZoneProfileOff;
+				else if (strcasecmp(sep.arg[1], "reset") == 0)
+					option = ZoneProfileReset;
+				else if (strcasecmp(sep.arg[1], "snapshot") == 0)
+					option = ZoneProfileSnapshot;
+
+				if (option < 0) {
+					SendMessage(1, "Usage: zoneprofile [on|off|reset|snapshot] [zoneserverid]");
+					SendMessage(1, "  Without an id every zone is told. Snapshots go to each zone's logs/zoneprofile_* file.");
+				}
+				else {
+					ServerPacket* pack = new ServerPacket(ServerOP_ZoneProfile, sizeof(ServerZoneProfile_Struct));
+					ServerZoneProfile_Struct* zp = (ServerZoneProfile_Struct*) pack->pBuffer;
+					zp->Option = option;
+					if (sep.IsNumber(2)) {
+						ZoneServer* zs = zoneserver_list.FindByID(atoi(sep.arg[2]));
+						if (zs) {
+							zs->SendPacket(pack);
+							SendMessage(1, "Sent to zoneserver %s.", sep.arg[2]);
+						}
+						else
+							SendMessage(1, "Zoneserver %s not found.", sep.arg[2]);
+					}
+					else {
+						zoneserver_list.SendPacket(pack);
+						SendMessage(1, "Sent to all zones.");
+					}
+					safe_delete(pack);
+				}
+			}
 			else if (strcasecmp(sep.arg[0], "serverinfo") == 0 && admin >= 200) {
 				if (strcasecmp(sep.arg[1], "os") == 0)	{
 				#ifdef _WINDOWS
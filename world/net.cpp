@@ -305,6 +305,7 @@ int main(int argc, char** argv) {
 			}
 		}
 	}
+	_log(WORLD__INIT, "Running %u async database workers", dbasync->StartWorkers(RuleI(World, WorldDBAsyncWorkers)));
 	if(RuleB(World, ClearTempMerchantlist)){
 		_log(WORLD__INIT, "Clearing temporary merchant lists..");
 		database.ClearMerchantTemp();
@@ -359,6 +360,8 @@ int main(int argc, char** argv) {
 		_log(WORLD__INIT_ERR,"        %s",errbuf);
 		return 1;
 	}
+	eqsf.SetBatchedReader(RuleB(EQStream, BatchedReader));
+	eqsf.SetEventWriter(RuleB(EQStream, EventWriter));
 	if (eqsf.Open()) {
 		_log(WORLD__INIT,"Client (UDP) listener started.");
 	} else {
@@ -17,10 +17,12 @@
 */
 #include "../common/debug.h"
 #include "../common/MiscFunctions.h"
+#include "../common/StringUtil.h"
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
 #include <float.h>
+#include <list>
 
 #ifndef WIN32
 //comment this out if your worried about zone boot times and your not using valgrind
@@ -29,13 +31,13 @@
 
 #include "zone_profile.h"
 #include "map.h"
-#include "zone.h"
+#include "map_cache.h"
+#include "../common/rulesys.h"
+#include "../common/memory_mapped_file.h"
 #ifdef _WINDOWS
 #define snprintf	_snprintf
 #endif
 
-extern Zone* zone;
-
 //Do we believe the normals from the map file?
 //you want this enabled if it dosent break things.
 //#define TRUST_MAPFILE_NORMALS
@@ -43,6 +45,15 @@ extern Zone* zone;
 //#define OPTIMIZE_QT_LOOKUPS
 #define EPS 0.002f	//acceptable error
 
+//test leaf faces four at a time with SSE when the compiler has it
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define MAP_USE_SSE
+#include <xmmintrin.h>
+#if MAP_LEAF_BLOCK != 4
+#error The SSE leaf kernel tests blocks of 4 faces
+#endif
+#endif
+
 //#define DEBUG_SEEK 1
 //#define DEBUG_BEST_Z 1
 
@@ -73,11 +84,31 @@ Map* Map::LoadMapfile(const char* in_zonename, const char *directory) {
 		directory = MAP_DIR;
 	snprintf(cWork, 250, "%s/%s.map", directory, strlwr(zBuf));
 
+	bool use_cache = RuleB(Map, UseFileCache);
+	if(use_cache) {
+		ret = new Map();
+		if(ret->loadMapCache(cWork)) {
+			printf("Map %s loaded from its cache.\n", cWork);
+			return ret;
+		}
+		safe_delete(ret);
+	}
+
 	if ((fp = fopen( cWork, "rb" ))) {
 		ret = new Map();
 		if(ret != nullptr) {
-			ret->loadMap(fp);
+			bool loaded = ret->loadMap(fp);
 			printf("Map %s loaded.\n", cWork);
+			//switch over to the cache straight away so this process shares it too
+			if(loaded && use_cache && ret->saveMapCache(cWork)) {
+				Map *cached = new Map();
+				if(cached->loadMapCache(cWork)) {
+					safe_delete(ret);
+					ret = cached;
+				} else {
+					safe_delete(cached);
+				}
+			}
 		} else {
 			printf("Map %s loading failed.\n", cWork);
 		}
@@ -103,6 +134,15 @@ Map::Map() {
 	mFinalFaces = nullptr;
 	mNodes = nullptr;
 	mFaceLists = nullptr;
+	mFacePlanes = nullptr;
+	mFaceStamps = nullptr;
+	mFaceStamp = 0;
+	mLeafData = nullptr;
+	mLeafFace = nullptr;
+	mLeafStart = nullptr;
+	mLeafSlots = nullptr;
+	mLeafSlotCount = 0;
+	mCache = nullptr;
 }
 
 bool Map::loadMap(FILE *fp) {
@@ -212,14 +252,144 @@ bool Map::loadMap(FILE *fp) {
 	}
 	printf("Loaded map: %lu vertices, %lu faces\n", (unsigned long)m_Faces*3, (unsigned long)m_Faces);
 	printf("Map BB: (%.2f -> %.2f, %.2f -> %.2f, %.2f -> %.2f)\n", _minx, _maxx, _miny, _maxy, _minz, _maxz);
+
+	BuildFacePlanes();
+	BuildLeafFaces();
 	return(true);
 }
 
+//counts and bounds stored in the cache header's extra bytes
+struct MapCacheExtra {
+	uint32 faces;
+	uint32 nodes;
+	uint32 facelists;
+	uint32 leaf_slots;
+	float minx, maxx, miny, maxy, minz, maxz;
+};
+
+enum {
+	MapSectionFaces,
+	MapSectionNodes,
+	MapSectionFaceLists,
+	MapSectionPlanes,
+	MapSectionLeafData,
+	MapSectionLeafFace,
+	MapSectionLeafStart,
+	MapSectionLeafSlots,
+	MapSectionCount
+};
+
+//anything that changes what the sections hold has to change this
+static uint32 MapCacheSignature(uint32 plane_size, uint32 fields) {
+	uint32 sig = sizeof(FACE) | (sizeof(NODE) << 8) | (plane_size << 16) | (fields << 24);
+#ifdef TRUST_MAPFILE_NORMALS
+	sig ^= 0x80000000;	//the planes come out different
+#endif
+	return(sig ^ MAP_LEAF_BLOCK);
+}
+
+bool Map::loadMapCache(const char *map_file) {
+	EQEmu::MemoryMappedFile *mmf = MapCache::Open(map_file, MapCacheMap, MapCacheSignature(sizeof(FacePlane), LeafFieldCount));
+	if(mmf == nullptr)
+		return(false);
+
+	MapCacheExtra extra;
+	memcpy(&extra, MapCache::GetHeader(mmf)->extra, sizeof(extra));
+
+	const void *faces = MapCache::GetSection(mmf, MapSectionFaces, extra.faces * sizeof(FACE));
+	const void *nodes = MapCache::GetSection(mmf, MapSectionNodes, extra.nodes * sizeof(NODE));
+	const void *facelists = MapCache::GetSection(mmf, MapSectionFaceLists, extra.facelists * sizeof(uint32));
+	const void *planes = MapCache::GetSection(mmf, MapSectionPlanes, extra.faces * sizeof(FacePlane));
+	const void *leaf_data = MapCache::GetSection(mmf, MapSectionLeafData, extra.leaf_slots * LeafFieldCount * sizeof(float));
+	const void *leaf_face = MapCache::GetSection(mmf, MapSectionLeafFace, extra.leaf_slots * sizeof(uint32));
+	const void *leaf_start = MapCache::GetSection(mmf, MapSectionLeafStart, extra.nodes * sizeof(uint32));
+	const void *leaf_slots = MapCache::GetSection(mmf, MapSectionLeafSlots, extra.nodes * sizeof(uint32));
+	if(!faces || !nodes || !facelists || !planes || !leaf_data || !leaf_face || !leaf_start || !leaf_slots) {
+		safe_delete(mmf);
+		return(false);
+	}
+
+	//nothing writes through these, the const goes away only to fit the members
+	mCache = mmf;
+	m_Faces = extra.faces;
+	m_Nodes = extra.nodes;
+	m_FaceLists = extra.facelists;
+	mFinalFaces = (PFACE) faces;
+	mNodes = (PNODE) nodes;
+	mFaceLists = (uint32 *) facelists;
+	mFacePlanes = (FacePlane *) planes;
+	mLeafSlotCount = extra.leaf_slots;
+	uint32 k;
+	for(k = 0; k < LeafFieldCount; k++)
+		mLeafField[k] = (float *) leaf_data + k * mLeafSlotCount;
+	mLeafFace = (uint32 *) leaf_face;
+	mLeafStart = (uint32 *) leaf_start;
+	mLeafSlots = (uint32 *) leaf_slots;
+	_minx = extra.minx;
+	_maxx = extra.maxx;
+	_miny = extra.miny;
+	_maxy = extra.maxy;
+	_minz = extra.minz;
+	_maxz = extra.maxz;
+
+	mFaceStamps = new uint32[m_Faces];
+	memset(mFaceStamps, 0, sizeof(uint32) * m_Faces);
+	mFaceStamp = 0;
+	return(true);
+}
+
+bool Map::saveMapCache(const char *map_file) const {
+	if(mCache != nullptr || mLeafStart == nullptr)
+		return(false);
+
+	MapCacheExtra extra;
+	extra.faces = m_Faces;
+	extra.nodes = m_Nodes;
+	extra.facelists = m_FaceLists;
+	extra.leaf_slots = mLeafSlotCount;
+	extra.minx = _minx;
+	extra.maxx = _maxx;
+	extra.miny = _miny;
+	extra.maxy = _maxy;
+	extra.minz = _minz;
+	extra.maxz = _maxz;
+
+	MapCache cache(MapCacheMap, MapCacheSignature(sizeof(FacePlane), LeafFieldCount));
+	cache.SetExtra(&extra, sizeof(extra));
+	cache.AddSection(mFinalFaces, m_Faces * sizeof(FACE));
+	cache.AddSection(mNodes, m_Nodes * sizeof(NODE));
+	cache.AddSection(mFaceLists, m_FaceLists * sizeof(uint32));
+	cache.AddSection(mFacePlanes, m_Faces * sizeof(FacePlane));
+	//the fields sit back to back from the aligned base, not from mLeafData
+	cache.AddSection(mLeafField[0], mLeafSlotCount * LeafFieldCount * sizeof(float));
+	cache.AddSection(mLeafFace, mLeafSlotCount * sizeof(uint32));
+	cache.AddSection(mLeafStart, m_Nodes * sizeof(uint32));
+	cache.AddSection(mLeafSlots, m_Nodes * sizeof(uint32));
+	return(cache.Write(map_file));
+}
+
 Map::~Map() {
+	if(mCache) {
+		//everything but the stamps lives in the mapping
+		mFinalFaces = nullptr;
+		mNodes = nullptr;
+		mFaceLists = nullptr;
+		mFacePlanes = nullptr;
+		mLeafFace = nullptr;
+		mLeafStart = nullptr;
+		mLeafSlots = nullptr;
+		safe_delete(mCache);
+	}
 //	safe_delete_array(mFinalVertex);
 	safe_delete_array(mFinalFaces);
 	safe_delete_array(mNodes);
 	safe_delete_array(mFaceLists);
+	safe_delete_array(mFacePlanes);
+	safe_delete_array(mFaceStamps);
+	safe_delete_array(mLeafData);
+	safe_delete_array(mLeafFace);
+	safe_delete_array(mLeafStart);
+	safe_delete_array(mLeafSlots);
 //	RecFreeNode( mRoot );
 }
 
@@ -376,9 +546,8 @@ float Map::GetFaceHeight( int _idx, float x, float y ) const {
 //p1=start of segment
 //p2=end of segment
 
-bool Map::LineIntersectsZone(VERTEX start, VERTEX end, float step_mag, VERTEX *result, FACE **on) const
+bool Map::LineIntersectsZoneStepped(VERTEX start, VERTEX end, float step_mag, VERTEX *result, FACE **on) const
 {
-	_ZP(Map_LineIntersectsZone);
 	// Cast a ray from start to end, checking for collisions in each node between the two points.
 	//
 	float stepx, stepy, stepz, curx, cury, curz;
@@ -453,6 +622,251 @@ bool Map::LineIntersectsZone(VERTEX start, VERTEX end, float step_mag, VERTEX *r
 	return false;
 }
 
+//Walks the quadtree along the line instead of stepping, so every leaf the
+//line passes over is visited once, in order from start to end, and each
+//face is tested once no matter how many leaves it sits in. The closest hit
+//is returned.
+bool Map::LineIntersectsZone(VERTEX start, VERTEX end, float step_mag, VERTEX *result, FACE **on) const
+{
+	_ZP(Map_LineIntersectsZone);
+
+	if(start.x == end.x && start.y == end.y && start.z == end.z)
+		return(false);
+	if(m_Nodes == 0 || mLeafStart == nullptr)
+		return(false);
+
+	if(++mFaceStamp == 0) {
+		memset(mFaceStamps, 0, sizeof(uint32) * m_Faces);
+		mFaceStamp = 1;
+	}
+
+	LOSTrace trace;
+	trace.start = start;
+	trace.end = end;
+	trace.dx = end.x - start.x;
+	trace.dy = end.y - start.y;
+	trace.best_mu = 2.0f;
+	trace.best_face = -1;
+
+	TraceNode(MAP_ROOT_NODE, trace, 0);
+
+	if(trace.best_face < 0)
+		return(false);
+
+	if(result != nullptr)
+		*result = trace.hit;
+	if(on != nullptr)
+		*on = &mFinalFaces[trace.best_face];
+	return(true);
+}
+
+//clips the line to the node's box, enter is the fraction along the line where it gets in
+bool Map::SegmentEntersNode(NodeRef node_r, const LOSTrace &trace, float &enter) const {
+	const PNODE _node = &mNodes[node_r];
+	float tmin = 0.0f;
+	float tmax = 1.0f;
+
+	if(trace.dx == 0.0f) {
+		if(trace.start.x < _node->minx || trace.start.x > _node->maxx)
+			return(false);
+	} else {
+		float inv = 1.0f / trace.dx;
+		float t1 = (_node->minx - trace.start.x) * inv;
+		float t2 = (_node->maxx - trace.start.x) * inv;
+		if(t1 > t2) { float t = t1; t1 = t2; t2 = t; }
+		if(t1 > tmin) tmin = t1;
+		if(t2 < tmax) tmax = t2;
+		if(tmin > tmax)
+			return(false);
+	}
+
+	if(trace.dy == 0.0f) {
+		if(trace.start.y < _node->miny || trace.start.y > _node->maxy)
+			return(false);
+	} else {
+		float inv = 1.0f / trace.dy;
+		float t1 = (_node->miny - trace.start.y) * inv;
+		float t2 = (_node->maxy - trace.start.y) * inv;
+		if(t1 > t2) { float t = t1; t1 = t2; t2 = t; }
+		if(t1 > tmin) tmin = t1;
+		if(t2 < tmax) tmax = t2;
+		if(tmin > tmax)
+			return(false);
+	}
+
+	enter = tmin;
+	return(true);
+}
+
+void Map::TraceNode(NodeRef node_r, LOSTrace &trace, int depth) const {
+	if(depth > 64)
+		return;	//only a broken map could be this deep, don't loop forever on it
+
+	const PNODE _node = &mNodes[node_r];
+
+	if(_node->flags & nodeFinal) {
+		uint32 slot = mLeafStart[node_r];
+		uint32 last = slot + mLeafSlots[node_r];
+		for(; slot < last; slot += MAP_LEAF_BLOCK) {
+			float mu[MAP_LEAF_BLOCK];
+			VERTEX hit[MAP_LEAF_BLOCK];
+			uint32 mask = IntersectLeafBlock(slot, trace.start, trace.end, mu, hit);
+			int lane;
+			for(lane = 0; lane < MAP_LEAF_BLOCK; lane++) {
+				uint32 face = mLeafFace[slot + lane];
+				if(face == MAP_NO_FACE || mFaceStamps[face] == mFaceStamp)
+					continue;
+				mFaceStamps[face] = mFaceStamp;
+
+				if((mask & (1 << lane)) && mu[lane] < trace.best_mu) {
+					trace.best_mu = mu[lane];
+					trace.best_face = face;
+					trace.hit = hit[lane];
+				}
+			}
+		}
+		return;
+	}
+
+	//visit the children the line crosses, nearest first
+	NodeRef kids[4];
+	float enters[4];
+	int count = 0;
+	int r;
+	for(r = 0; r < 4; r++) {
+		NodeRef kid = _node->nodes[r];
+		if(kid == 0 || kid == node_r || kid >= m_Nodes)
+			continue;
+		float enter;
+		if(!SegmentEntersNode(kid, trace, enter))
+			continue;
+		int pos = count++;
+		while(pos > 0 && enters[pos - 1] > enter) {
+			kids[pos] = kids[pos - 1];
+			enters[pos] = enters[pos - 1];
+			pos--;
+		}
+		kids[pos] = kid;
+		enters[pos] = enter;
+	}
+
+	for(r = 0; r < count; r++) {
+		//anything this child holds is further along than the hit we have
+		if(enters[r] > trace.best_mu)
+			break;
+		TraceNode(kids[r], trace, depth + 1);
+	}
+}
+
+//same test as LineIntersectsFace, on the precomputed plane
+bool Map::LineIntersectsFacePlane(uint32 face, const VERTEX &p1, const VERTEX &p2, float &mu, VERTEX &hit) const {
+	const FacePlane &fp = mFacePlanes[face];
+
+	if(p1.x < fp.minx && p2.x < fp.minx)
+		return(false);
+	if(p1.y < fp.miny && p2.y < fp.miny)
+		return(false);
+	if(p1.z < fp.minz && p2.z < fp.minz)
+		return(false);
+	if(p1.x > fp.maxx && p2.x > fp.maxx)
+		return(false);
+	if(p1.y > fp.maxy && p2.y > fp.maxy)
+		return(false);
+	if(p1.z > fp.maxz && p2.z > fp.maxz)
+		return(false);
+
+	float denom = fp.nx * (p2.x - p1.x) + fp.ny * (p2.y - p1.y) + fp.nz * (p2.z - p1.z);
+	if (ABS(denom) < EPS) // Line and plane don't intersect
+		return(false);
+	mu = - (fp.d + fp.nx * p1.x + fp.ny * p1.y + fp.nz * p1.z) / denom;
+	if (mu < 0 || mu > 1) // Intersection not along line segment
+		return(false);
+	hit.x = p1.x + mu * (p2.x - p1.x);
+	hit.y = p1.y + mu * (p2.y - p1.y);
+	hit.z = p1.z + mu * (p2.z - p1.z);
+
+	//the plane normal is inverted, so inside means every t <= 0
+	const FACE &cf = mFinalFaces[face];
+	VERTEX pa1, pa2, pa3, tmp;
+	float t;
+
+	pa1.x = cf.a.x - hit.x;
+	pa1.y = cf.a.y - hit.y;
+	pa1.z = cf.a.z - hit.z;
+
+	pa2.x = cf.b.x - hit.x;
+	pa2.y = cf.b.y - hit.y;
+	pa2.z = cf.b.z - hit.z;
+
+	tmp.x = pa1.y * pa2.z - pa1.z * pa2.y;
+	tmp.y = pa1.z * pa2.x - pa1.x * pa2.z;
+	tmp.z = pa1.x * pa2.y - pa1.y * pa2.x;
+	t = tmp.x * fp.nx + tmp.y * fp.ny + tmp.z * fp.nz;
+	if(t > 0)
+		return(false);
+
+	pa3.x = cf.c.x - hit.x;
+	pa3.y = cf.c.y - hit.y;
+	pa3.z = cf.c.z - hit.z;
+
+	tmp.x = pa2.y * pa3.z - pa2.z * pa3.y;
+	tmp.y = pa2.z * pa3.x - pa2.x * pa3.z;
+	tmp.z = pa2.x * pa3.y - pa2.y * pa3.x;
+	t = tmp.x * fp.nx + tmp.y * fp.ny + tmp.z * fp.nz;
+	if(t > 0)
+		return(false);
+
+	tmp.x = pa3.y * pa1.z - pa3.z * pa1.y;
+	tmp.y = pa3.z * pa1.x - pa3.x * pa1.z;
+	tmp.z = pa3.x * pa1.y - pa3.y * pa1.x;
+	t = tmp.x * fp.nx + tmp.y * fp.ny + tmp.z * fp.nz;
+	if(t > 0)
+		return(false);
+
+	return(true);
+}
+
+void Map::BuildFacePlanes() {
+	safe_delete_array(mFacePlanes);
+	safe_delete_array(mFaceStamps);
+
+	mFacePlanes = new FacePlane[m_Faces];
+	mFaceStamps = new uint32[m_Faces];
+	memset(mFaceStamps, 0, sizeof(uint32) * m_Faces);
+	mFaceStamp = 0;
+
+	uint32 i;
+	for(i = 0; i < m_Faces; i++) {
+		const VERTEX &pa = mFinalFaces[i].a;
+		const VERTEX &pb = mFinalFaces[i].b;
+		const VERTEX &pc = mFinalFaces[i].c;
+		FacePlane &fp = mFacePlanes[i];
+		VERTEX n;
+
+		fp.minx = Vmin3(x, pa, pb, pc);
+		fp.miny = Vmin3(y, pa, pb, pc);
+		fp.minz = Vmin3(z, pa, pb, pc);
+		fp.maxx = Vmax3(x, pa, pb, pc);
+		fp.maxy = Vmax3(y, pa, pb, pc);
+		fp.maxz = Vmax3(z, pa, pb, pc);
+
+#ifndef TRUST_MAPFILE_NORMALS
+		n.x = (pb.y - pa.y)*(pc.z - pa.z) - (pb.z - pa.z)*(pc.y - pa.y);
+		n.y = (pb.z - pa.z)*(pc.x - pa.x) - (pb.x - pa.x)*(pc.z - pa.z);
+		n.z = (pb.x - pa.x)*(pc.y - pa.y) - (pb.y - pa.y)*(pc.x - pa.x);
+		Normalize(&n);
+#else
+		n.x = mFinalFaces[i].nx;
+		n.y = mFinalFaces[i].ny;
+		n.z = mFinalFaces[i].nz;
+#endif
+		fp.nx = -n.x;
+		fp.ny = -n.y;
+		fp.nz = -n.z;
+		fp.d = - fp.nx * pa.x - fp.ny * pa.y - fp.nz * pa.z;
+	}
+}
+
 bool Map::LocWithinNode( NodeRef node_r, float x, float y ) const {
 	if( node_r == NODE_NONE || node_r >= m_Nodes) {
 		return(false);
@@ -465,7 +879,7 @@ bool Map::LocWithinNode( NodeRef node_r, float x, float y ) const {
 
 bool Map::LineIntersectsNode( NodeRef node_r, VERTEX p1, VERTEX p2, VERTEX *result, FACE **on) const {
 	_ZP(Map_LineIntersectsNode);
-	if( node_r == NODE_NONE || node_r >= m_Nodes) {
+	if( node_r == NODE_NONE || node_r >= m_Nodes || mLeafStart == nullptr) {
 		return(true); //can see through empty nodes, just allow LOS on error...
 	}
 	const PNODE _node = &mNodes[node_r];
@@ -473,21 +887,23 @@ bool Map::LineIntersectsNode( NodeRef node_r, VERTEX p1, VERTEX p2, VERTEX *resu
 		return(true); //not a final node... not sure best action
 	}
 
-	unsigned long i;
-
-	PFACE cur;
-	const uint32 *cfl = mFaceLists + _node->faces.offset;
-
-	for(i = 0; i < _node->faces.count; i++) {
-		if(*cfl > m_Faces)
-			continue;	//watch for invalid lists, they seem to happen
-		cur = &mFinalFaces[ *cfl ];
-		if(LineIntersectsFace(cur,p1, p2, result)) {
-			if(on != nullptr)
-				*on = cur;
-			return(true);
-		}
-		cfl++;
+	//first face in the list that is hit, like testing them one by one
+	uint32 slot = mLeafStart[node_r];
+	uint32 last = slot + mLeafSlots[node_r];
+	for(; slot < last; slot += MAP_LEAF_BLOCK) {
+		float mu[MAP_LEAF_BLOCK];
+		VERTEX hit[MAP_LEAF_BLOCK];
+		uint32 mask = IntersectLeafBlock(slot, p1, p2, mu, hit);
+		if(mask == 0)
+			continue;
+		int lane = 0;
+		while(!(mask & (1 << lane)))
+			lane++;
+		if(result != nullptr)
+			*result = hit[lane];
+		if(on != nullptr)
+			*on = &mFinalFaces[mLeafFace[slot + lane]];
+		return(true);
 	}
 
 //printf("Checked %ld faces and found none in the way.\n", i);
@@ -501,6 +917,61 @@ float Map::FindBestZ( NodeRef node_r, VERTEX p1, VERTEX *result, FACE **on) cons
 
 	p1.z += RuleI(Map, FindBestZHeightAdjust);
 
+	if(RuleB(Map, UseClosestZ))
+		return FindClosestZ(p1);
+
+	if(node_r == GetRoot()) {
+		node_r = SeekNode(node_r, p1.x, p1.y);
+	}
+	if( node_r == NODE_NONE || node_r >= m_Nodes || mLeafStart == nullptr) {
+		return(BEST_Z_INVALID);
+	}
+	const PNODE _node = &mNodes[node_r];
+	if(!(_node->flags & nodeFinal)) {
+		return(BEST_Z_INVALID); //not a final node... could find the proper node...
+	}
+
+	VERTEX p2(p1);
+	p2.z = BEST_Z_INVALID;
+
+	float best_z = BEST_Z_INVALID;
+	int zAttempt;
+
+	// If we don't find a bestZ on the first attempt, we try again from a position CurrentZ + 10 higher
+	// This is in case the pathing between waypoints temporarily sends the NPC below ground level.
+	//
+	for(zAttempt=1; zAttempt<=2; zAttempt++) {
+		uint32 slot = mLeafStart[node_r];
+		uint32 last = slot + mLeafSlots[node_r];
+
+		for(; slot < last; slot += MAP_LEAF_BLOCK) {
+			float mu[MAP_LEAF_BLOCK];
+			VERTEX hit[MAP_LEAF_BLOCK];
+			uint32 mask = IntersectLeafBlock(slot, p1, p2, mu, hit);
+			int lane;
+			for(lane = 0; mask != 0; lane++, mask >>= 1) {
+				if((mask & 1) && hit[lane].z > best_z) {
+					if(on != nullptr)
+						*on = &mFinalFaces[mLeafFace[slot + lane]];
+					if(result != nullptr)
+						*result = hit[lane];
+					best_z = hit[lane].z;
+				}
+			}
+		}
+
+		if(best_z != BEST_Z_INVALID) return best_z;
+
+		p1.z = p1.z + 10 ; // If we can't find a best Z, the NPC is probably just under the world. Try again from 10 units higher up.
+	}
+
+	return best_z;
+}
+
+float Map::FindBestZScalar( NodeRef node_r, VERTEX p1, VERTEX *result, FACE **on) const {
+
+	p1.z += RuleI(Map, FindBestZHeightAdjust);
+
 	if(RuleB(Map, UseClosestZ))
 		return FindClosestZ(p1);
 
@@ -575,6 +1046,186 @@ printf("Best Z found: %.2f\n", best_z);
 }
 
 
+void Map::BuildLeafFaces() {
+	safe_delete_array(mLeafData);
+	safe_delete_array(mLeafFace);
+	safe_delete_array(mLeafStart);
+	safe_delete_array(mLeafSlots);
+
+	mLeafStart = new uint32[m_Nodes];
+	mLeafSlots = new uint32[m_Nodes];
+	mLeafSlotCount = 0;
+
+	//faces actually used per leaf, the fill below has to stop at the same place
+	std::vector<uint32> counts(m_Nodes, 0);
+	uint32 r, k;
+	for(r = 0; r < m_Nodes; r++) {
+		mLeafStart[r] = mLeafSlotCount;
+		mLeafSlots[r] = 0;
+		if(!(mNodes[r].flags & nodeFinal))
+			continue;
+
+		//a bad index ends the list, like it always has in the face loops
+		uint32 count = 0;
+		while(count < mNodes[r].faces.count && mNodes[r].faces.offset + count < m_FaceLists
+			&& mFaceLists[mNodes[r].faces.offset + count] < m_Faces)
+			count++;
+
+		counts[r] = count;
+		mLeafSlots[r] = (count + MAP_LEAF_BLOCK - 1) / MAP_LEAF_BLOCK * MAP_LEAF_BLOCK;
+		mLeafSlotCount += mLeafSlots[r];
+	}
+
+	//each field is a multiple of 4 floats long, so aligning the base aligns them all
+	mLeafData = new float[mLeafSlotCount * LeafFieldCount + 4];
+	float *base = (float *) (((size_t) mLeafData + 15) & ~((size_t) 15));
+	for(k = 0; k < LeafFieldCount; k++)
+		mLeafField[k] = base + k * mLeafSlotCount;
+	mLeafFace = new uint32[mLeafSlotCount];
+
+	for(r = 0; r < m_Nodes; r++) {
+		uint32 slot = mLeafStart[r];
+		for(k = 0; k < mLeafSlots[r]; k++, slot++) {
+			uint32 face = MAP_NO_FACE;
+			if(k < counts[r])
+				face = mFaceLists[mNodes[r].faces.offset + k];
+
+			if(face >= m_Faces) {
+				//padding, the bounds reject it before anything else is looked at
+				uint32 f;
+				for(f = 0; f < LeafFieldCount; f++)
+					mLeafField[f][slot] = 0.0f;
+				mLeafField[LeafMinX][slot] = mLeafField[LeafMinY][slot] = mLeafField[LeafMinZ][slot] = FLT_MAX;
+				mLeafField[LeafMaxX][slot] = mLeafField[LeafMaxY][slot] = mLeafField[LeafMaxZ][slot] = -FLT_MAX;
+				mLeafFace[slot] = MAP_NO_FACE;
+				continue;
+			}
+
+			const FACE &cf = mFinalFaces[face];
+			const FacePlane &fp = mFacePlanes[face];
+			mLeafFace[slot] = face;
+			mLeafField[LeafAX][slot] = cf.a.x;
+			mLeafField[LeafAY][slot] = cf.a.y;
+			mLeafField[LeafAZ][slot] = cf.a.z;
+			mLeafField[LeafBX][slot] = cf.b.x;
+			mLeafField[LeafBY][slot] = cf.b.y;
+			mLeafField[LeafBZ][slot] = cf.b.z;
+			mLeafField[LeafCX][slot] = cf.c.x;
+			mLeafField[LeafCY][slot] = cf.c.y;
+			mLeafField[LeafCZ][slot] = cf.c.z;
+			mLeafField[LeafNX][slot] = fp.nx;
+			mLeafField[LeafNY][slot] = fp.ny;
+			mLeafField[LeafNZ][slot] = fp.nz;
+			mLeafField[LeafD][slot] = fp.d;
+			mLeafField[LeafMinX][slot] = fp.minx;
+			mLeafField[LeafMinY][slot] = fp.miny;
+			mLeafField[LeafMinZ][slot] = fp.minz;
+			mLeafField[LeafMaxX][slot] = fp.maxx;
+			mLeafField[LeafMaxY][slot] = fp.maxy;
+			mLeafField[LeafMaxZ][slot] = fp.maxz;
+		}
+	}
+}
+
+//Tests the MAP_LEAF_BLOCK faces starting at slot against the line, with
+//the same operations in the same order as LineIntersectsFacePlane, so the
+//results match it exactly. Returns a bit per face that was hit, and fills
+//in mu and hit for those.
+uint32 Map::IntersectLeafBlock(uint32 slot, const VERTEX &p1, const VERTEX &p2, float *mu, VERTEX *hit) const {
+#ifdef MAP_USE_SSE
+#define LEAF_FIELD(f) _mm_load_ps(mLeafField[f] + slot)
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	__m128 p1x = _mm_set1_ps(p1.x), p1y = _mm_set1_ps(p1.y), p1z = _mm_set1_ps(p1.z);
+	__m128 p2x = _mm_set1_ps(p2.x), p2y = _mm_set1_ps(p2.y), p2z = _mm_set1_ps(p2.z);
+	__m128 v, reject;
+
+	//quick bounding box checks
+	v = LEAF_FIELD(LeafMinX);
+	reject = _mm_and_ps(_mm_cmplt_ps(p1x, v), _mm_cmplt_ps(p2x, v));
+	v = LEAF_FIELD(LeafMinY);
+	reject = _mm_or_ps(reject, _mm_and_ps(_mm_cmplt_ps(p1y, v), _mm_cmplt_ps(p2y, v)));
+	v = LEAF_FIELD(LeafMinZ);
+	reject = _mm_or_ps(reject, _mm_and_ps(_mm_cmplt_ps(p1z, v), _mm_cmplt_ps(p2z, v)));
+	v = LEAF_FIELD(LeafMaxX);
+	reject = _mm_or_ps(reject, _mm_and_ps(_mm_cmpgt_ps(p1x, v), _mm_cmpgt_ps(p2x, v)));
+	v = LEAF_FIELD(LeafMaxY);
+	reject = _mm_or_ps(reject, _mm_and_ps(_mm_cmpgt_ps(p1y, v), _mm_cmpgt_ps(p2y, v)));
+	v = LEAF_FIELD(LeafMaxZ);
+	reject = _mm_or_ps(reject, _mm_and_ps(_mm_cmpgt_ps(p1z, v), _mm_cmpgt_ps(p2z, v)));
+	if(_mm_movemask_ps(reject) == 0xF)
+		return(0);
+
+	__m128 nx = LEAF_FIELD(LeafNX), ny = LEAF_FIELD(LeafNY), nz = LEAF_FIELD(LeafNZ);
+	__m128 dx = _mm_set1_ps(p2.x - p1.x), dy = _mm_set1_ps(p2.y - p1.y), dz = _mm_set1_ps(p2.z - p1.z);
+
+	__m128 denom = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, dx), _mm_mul_ps(ny, dy)), _mm_mul_ps(nz, dz));
+	reject = _mm_or_ps(reject, _mm_cmplt_ps(_mm_andnot_ps(sign, denom), _mm_set1_ps(EPS)));
+
+	__m128 m = _mm_add_ps(_mm_add_ps(_mm_add_ps(LEAF_FIELD(LeafD), _mm_mul_ps(nx, p1x)), _mm_mul_ps(ny, p1y)), _mm_mul_ps(nz, p1z));
+	m = _mm_div_ps(_mm_xor_ps(m, sign), denom);
+	reject = _mm_or_ps(reject, _mm_or_ps(_mm_cmplt_ps(m, zero), _mm_cmpgt_ps(m, _mm_set1_ps(1.0f))));
+	if(_mm_movemask_ps(reject) == 0xF)
+		return(0);
+
+	__m128 hx = _mm_add_ps(p1x, _mm_mul_ps(m, dx));
+	__m128 hy = _mm_add_ps(p1y, _mm_mul_ps(m, dy));
+	__m128 hz = _mm_add_ps(p1z, _mm_mul_ps(m, dz));
+
+	__m128 pa1x = _mm_sub_ps(LEAF_FIELD(LeafAX), hx), pa1y = _mm_sub_ps(LEAF_FIELD(LeafAY), hy), pa1z = _mm_sub_ps(LEAF_FIELD(LeafAZ), hz);
+	__m128 pa2x = _mm_sub_ps(LEAF_FIELD(LeafBX), hx), pa2y = _mm_sub_ps(LEAF_FIELD(LeafBY), hy), pa2z = _mm_sub_ps(LEAF_FIELD(LeafBZ), hz);
+	__m128 pa3x = _mm_sub_ps(LEAF_FIELD(LeafCX), hx), pa3y = _mm_sub_ps(LEAF_FIELD(LeafCY), hy), pa3z = _mm_sub_ps(LEAF_FIELD(LeafCZ), hz);
+	__m128 tx, ty, tz, t;
+
+	//the plane normal is inverted, so inside means every t <= 0
+	tx = _mm_sub_ps(_mm_mul_ps(pa1y, pa2z), _mm_mul_ps(pa1z, pa2y));
+	ty = _mm_sub_ps(_mm_mul_ps(pa1z, pa2x), _mm_mul_ps(pa1x, pa2z));
+	tz = _mm_sub_ps(_mm_mul_ps(pa1x, pa2y), _mm_mul_ps(pa1y, pa2x));
+	t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, nx), _mm_mul_ps(ty, ny)), _mm_mul_ps(tz, nz));
+	reject = _mm_or_ps(reject, _mm_cmpgt_ps(t, zero));
+
+	tx = _mm_sub_ps(_mm_mul_ps(pa2y, pa3z), _mm_mul_ps(pa2z, pa3y));
+	ty = _mm_sub_ps(_mm_mul_ps(pa2z, pa3x), _mm_mul_ps(pa2x, pa3z));
+	tz = _mm_sub_ps(_mm_mul_ps(pa2x, pa3y), _mm_mul_ps(pa2y, pa3x));
+	t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, nx), _mm_mul_ps(ty, ny)), _mm_mul_ps(tz, nz));
+	reject = _mm_or_ps(reject, _mm_cmpgt_ps(t, zero));
+
+	tx = _mm_sub_ps(_mm_mul_ps(pa3y, pa1z), _mm_mul_ps(pa3z, pa1y));
+	ty = _mm_sub_ps(_mm_mul_ps(pa3z, pa1x), _mm_mul_ps(pa3x, pa1z));
+	tz = _mm_sub_ps(_mm_mul_ps(pa3x, pa1y), _mm_mul_ps(pa3y, pa1x));
+	t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, nx), _mm_mul_ps(ty, ny)), _mm_mul_ps(tz, nz));
+	reject = _mm_or_ps(reject, _mm_cmpgt_ps(t, zero));
+#undef LEAF_FIELD
+
+	uint32 mask = ~_mm_movemask_ps(reject) & 0xF;
+	if(mask == 0)
+		return(0);
+
+	float out[4][4];
+	_mm_storeu_ps(out[0], m);
+	_mm_storeu_ps(out[1], hx);
+	_mm_storeu_ps(out[2], hy);
+	_mm_storeu_ps(out[3], hz);
+	int lane;
+	for(lane = 0; lane < 4; lane++) {
+		mu[lane] = out[0][lane];
+		hit[lane].x = out[1][lane];
+		hit[lane].y = out[2][lane];
+		hit[lane].z = out[3][lane];
+	}
+	return(mask);
+#else
+	uint32 mask = 0;
+	int lane;
+	for(lane = 0; lane < MAP_LEAF_BLOCK; lane++) {
+		uint32 face = mLeafFace[slot + lane];
+		if(face != MAP_NO_FACE && LineIntersectsFacePlane(face, p1, p2, mu[lane], hit[lane]))
+			mask |= 1 << lane;
+	}
+	return(mask);
+#endif
+}
+
 bool Map::LineIntersectsFace( PFACE cface, VERTEX p1, VERTEX p2, VERTEX *result) const {
 	if( cface == nullptr ) {
 		return(false); //cant intersect a face we dont have... i guess
@@ -933,7 +1584,7 @@ bool Map::LineIntersectsZoneNoZLeaps(VERTEX start, VERTEX end, float step_mag, V
 		me.z = cur.z;
 		VERTEX hit;
 		FACE *onhit;
-		float best_z = zone->zonemap->FindBestZ(cnode, me, &hit, &onhit);
+		float best_z = FindBestZ(cnode, me, &hit, &onhit);
 		float diff = ABS(best_z-z);
 //		diff *= sign(diff);
 		if (z == -999999 || best_z == -999999 || diff < 12.0)
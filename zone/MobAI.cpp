@@ -376,7 +376,7 @@ bool EntityList::AICheckCloseBeneficialSpells(NPC* caster, uint8 iChance, float
 
 
 	//Only iterate through NPCs
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 	for(iterator.Reset(); iterator.MoreElements(); iterator.Advance()) {
 		NPC* mob = iterator.GetData();
 
@@ -402,8 +402,6 @@ Corpse::Corpse(Client* client, int32 in_rezexp)
 
 		if(removed_list.size() != 0) {
 			std::stringstream ss("");
-			ss << "DELETE FROM inventory WHERE charid=" << client->CharacterID();
-			ss << " AND (";
 			std::list<uint32>::const_iterator iter = removed_list.begin();
 			bool first = true;
 			while(iter != removed_list.end()) {
@@ -415,8 +413,12 @@ Corpse::Corpse(Client* client, int32 in_rezexp)
 				ss << "slotid=" << (*iter);
 				iter++;
 			}
-			ss << ")";
-			database.RunQuery(ss.str().c_str(), ss.str().length());
+			// stays synchronous even when journaling, the corpse's items are written
+			// and looted straight from the database with no ordering against the journal
+			std::stringstream del("");
+			del << "DELETE FROM inventory WHERE charid=" << client->CharacterID() << " AND (" << ss.str() << ")";
+			database.InventoryBarrier(client->CharacterID());
+			database.RunQuery(del.str().c_str(), del.str().length());
 		}
 
 		if(cursor) { // all cursor items should be on corpse (client < SoF or RespawnFromHover = false)
@@ -35,7 +35,7 @@ extern Zone* zone;
 void EntityList::CheckClientAggro(Client *around) {
 	_ZP(EntityList_CheckClientAggro);
 
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	for(iterator.Reset(); iterator.MoreElements(); iterator.Advance()) {
 		_ZP(EntityList_CheckClientAggro_Loop);
 		Mob* mob = iterator.GetData();
@@ -86,7 +86,7 @@ void EntityList::DescribeAggro(Client *towho, NPC *from_who, float d, bool verbo
 		towho->Message(0, ".. I am on faction %s (%d)\n", namebuf, my_primary);
 	}
 
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	for(iterator.Reset(); iterator.MoreElements(); iterator.Advance()) {
 		Mob* mob = iterator.GetData();
 		if(mob->IsClient())	//also ensures that mob != around
@@ -371,22 +371,22 @@ Mob* EntityList::AICheckCloseAggro(Mob* sender, float iAggroRange, float iAssist
 		return(nullptr);
 	_ZP(EntityList_AICheckCloseAggro);
 
+	//CheckWillAggro rejects anything outside the sender's aggro range box
+	std::vector<Mob*> candidates;
 #ifdef REVERSE_AGGRO
 	//with reverse aggro, npc->client is checked elsewhere, no need to check again
-	LinkedListIterator<NPC*> iterator(npc_list);
+	npc_grid.GetInRange(sender->GetX(), sender->GetY(), sender->GetAggroRange(), candidates);
 #else
-	LinkedListIterator<Mob*> iterator(mob_list);
+	mob_grid.GetInRange(sender->GetX(), sender->GetY(), sender->GetAggroRange(), candidates);
 #endif
-	iterator.Reset();
+	std::vector<Mob*>::iterator iterator;
 	//float distZ;
-	while(iterator.MoreElements()) {
-		Mob* mob = iterator.GetData();
+	for(iterator = candidates.begin(); iterator != candidates.end(); ++iterator) {
+		Mob* mob = *iterator;
 
 		if(sender->CheckWillAggro(mob)) {
 			return(mob);
 		}
-
-		iterator.Advance();
 	}
 	//LogFile->write(EQEMuLog::Debug, "Check aggro for %s no target.", sender->GetName());
 	return(nullptr);
@@ -400,11 +400,14 @@ int EntityList::GetHatedCount(Mob *attacker, Mob *exclude) {
 
 	int Count = 0;
 
-	LinkedListIterator<NPC*> iterator(npc_list);
+	//each npc uses its own aggro range, so look as far as the widest one
+	std::vector<Mob*> candidates;
+	npc_grid.GetInRange(attacker->GetX(), attacker->GetY(), GetNPCReach(), candidates);
 
-	for(iterator.Reset(); iterator.MoreElements(); iterator.Advance()) {
+	std::vector<Mob*>::iterator iterator;
+	for(iterator = candidates.begin(); iterator != candidates.end(); ++iterator) {
 
-		NPC* mob = iterator.GetData();
+		NPC* mob = (*iterator)->CastToNPC();
 
 		if(!mob || (mob == exclude)) continue;
 
@@ -439,13 +442,12 @@ void EntityList::AIYellForHelp(Mob* sender, Mob* attacker) {
 	if (sender->GetPrimaryFaction() == 0 )
 		return; // well, if we dont have a faction set, we're gonna be indiff to everybody
 
-	LinkedListIterator<NPC*> iterator(npc_list);
+	std::vector<Mob*> candidates;
+	npc_grid.GetInRange(sender->GetX(), sender->GetY(), GetNPCReach(), candidates);
 
-	for(iterator.Reset(); iterator.MoreElements(); iterator.Advance()) {
-		NPC* mob = iterator.GetData();
-		if(!mob){
-			continue;
-		}
+	std::vector<Mob*>::iterator iterator;
+	for(iterator = candidates.begin(); iterator != candidates.end(); ++iterator) {
+		NPC* mob = (*iterator)->CastToNPC();
 		float r = mob->GetAssistRange();
 		r = r * r;
 
@@ -16527,7 +16527,7 @@ Mob* EntityList::GetMobByBotID(uint32 botID) {
 	Mob* Result = 0;
 
 	if(botID > 0) {
-		LinkedListIterator<Mob*> iterator(mob_list);
+		DenseListIterator<Mob*> iterator(mob_list);
 
 		iterator.Reset();
 
@@ -16606,6 +16606,7 @@ void EntityList::AddBot(Bot *newBot, bool SendSpawnPacket, bool dontqueue) {
 		bot_list.push_back(newBot);
 
 		mob_list.Insert(newBot);
+		mob_grid.Insert(newBot);
 	}
 }
 
@@ -16626,7 +16627,7 @@ std::list<Bot*> EntityList::GetBotsByBotOwnerCharacterID(uint32 botOwnerCharacte
 
 void EntityList::BotPickLock(Bot* rogue)
 {
-	LinkedListIterator<Doors*> iterator(door_list);
+	DenseListIterator<Doors*> iterator(door_list);
 	iterator.Reset();
 	while(iterator.MoreElements()) {
 		Doors *cdoor = iterator.GetData();
@@ -16701,7 +16702,7 @@ void EntityList::ShowSpawnWindow(Client* client, int Distance, bool NamedOnly) {
 
 	uint32 array_counter = 0;
 
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	iterator.Reset();
 
 	while(iterator.MoreElements())
@@ -43,6 +43,7 @@ extern volatile bool RunLoops;
 #include "../common/misc.h"
 #include "zonedb.h"
 #include "../common/spdat.h"
+#include "../common/StructStrategy.h"
 #include "net.h"
 #include "../common/packet_dump.h"
 #include "../common/packet_functions.h"
@@ -128,6 +129,7 @@ Client::Client(EQStreamInterface* ieqs)
 
 	),
 	//these must be listed in the order they appear in client.h
+	m_profile_save(sizeof(PlayerProfile_Struct), sizeof(ExtendedProfile_Struct)),
 	position_timer(250),
 	hpupdate_timer(1800),
 	camp_timer(29000),
@@ -161,6 +163,9 @@ Client::Client(EQStreamInterface* ieqs)
 	merc_timer(RuleI(Mercs, UpkeepIntervalMS)),
 	ItemTickTimer(10000)
 {
+	// Save stamps lastlogin every time, that alone isn't worth a write
+	m_profile_save.pp.Ignore(offsetof(PlayerProfile_Struct, lastlogin), sizeof(m_pp.lastlogin));
+
 	for(int cf=0; cf < _FilterCount; cf++)
 		ClientFilters[cf] = FilterShow;
 	character_id = 0;
@@ -569,7 +574,13 @@ bool Client::Save(uint8 iCommitNow) {
 
 	m_pp.lastlogin = time(nullptr);
 	if (pQueuedSaveWorkID) {
-		dbasync->CancelWork(pQueuedSaveWorkID);
+		// the queued write is replaced by this one, so whatever it carried has to go out again
+		if (dbasync->CancelWork(pQueuedSaveWorkID)) {
+			m_profile_save.Requeue();
+			// it may already be running on another connection, don't let it land after this save
+			if (iCommitNow > 1 && !dbasync->WaitForKey(character_id))
+				LogFile->write(EQEMuLog::Error, "Client::Save: the queued save for %s is still running after %u ms, it may land after this one", GetName(), DBASYNC_KEY_WAIT_MS);
+		}
 		pQueuedSaveWorkID = 0;
 	}
 
@@ -598,25 +609,52 @@ bool Client::Save(uint8 iCommitNow) {
 //	m_inv.dumpEntireInventory();
 
 	SaveTaskState();
+	// the next zone or world loads the inventory straight from the database
+	bool inventory_written = true;
+	if (iCommitNow > 1)
+		inventory_written = database.InventoryBarrier(character_id);
+
+	bool delta_saves = RuleB(Character, DeltaProfileSaves);
+	if (!delta_saves)
+		m_profile_save.Invalidate();
+
 	if (iCommitNow <= 1) {
 		char* query = 0;
+		DBParams* params = 0;
+		uint32 querylen;
+		if (delta_saves) {
+			querylen = database.SetPlayerProfileDelta_MQ(&query, &params, m_profile_save, character_id, &m_pp, &m_epp, 0, 0, MaxXTargets);
+			if (querylen == 0) {
+				// nothing changed since the last write
+				if (iCommitNow == 1)
+					SaveBackup();
+				return true;
+			}
+		}
+		else
+			querylen = database.SetPlayerProfile_MQ(&query, account_id, character_id, &m_pp, &m_inv, &m_epp, 0, 0, MaxXTargets);
+
 		uint32_breakdown workpt;
 		workpt.b4() = DBA_b4_Entity;
 		workpt.w2_3() = GetID();
 		workpt.b1() = DBA_b1_Entity_Client_Save;
 		DBAsyncWork* dbaw = new DBAsyncWork(&database, &MTdbafq, workpt, DBAsync::Write, 0xFFFFFFFF);
-		dbaw->AddQuery(iCommitNow == 0 ? true : false, &query, database.SetPlayerProfile_MQ(&query, account_id, character_id, &m_pp, &m_inv, &m_epp, 0, 0, MaxXTargets), false);
+		if (params)
+			dbaw->AddQuery(iCommitNow == 0 ? true : false, &query, querylen, &params, false);
+		else
+			dbaw->AddQuery(iCommitNow == 0 ? true : false, &query, querylen, false);
 		if (iCommitNow == 0){
-			pQueuedSaveWorkID = dbasync->AddWork(&dbaw, 2500);
+			pQueuedSaveWorkID = dbasync->AddWork(&dbaw, 2500, character_id);
 		}
 		else {
-			dbasync->AddWork(&dbaw, 0);
+			dbasync->AddWork(&dbaw, 0, character_id);
 			SaveBackup();
 		}
 		safe_delete_array(query);
 		return true;
 	}
-	else if (database.SetPlayerProfile(account_id, character_id, &m_pp, &m_inv, &m_epp, 0, 0, MaxXTargets)) {
+	else if (delta_saves ? database.SetPlayerProfileDelta(m_profile_save, character_id, &m_pp, &m_epp, 0, 0, MaxXTargets)
+		: database.SetPlayerProfile(account_id, character_id, &m_pp, &m_inv, &m_epp, 0, 0, MaxXTargets)) {
 		SaveBackup();
 	}
 	else {
@@ -624,7 +662,7 @@ bool Client::Save(uint8 iCommitNow) {
 		return false;
 	}
 
-	return true;
+	return inventory_written;
 }
 
 void Client::SaveBackup() {
@@ -633,7 +671,8 @@ void Client::SaveBackup() {
 	char* query = 0;
 	DBAsyncWork* dbaw = new DBAsyncWork(&database, &DBAsyncCB_CharacterBackup, this->CharacterID(), DBAsync::Read);
 	dbaw->AddQuery(0, &query, MakeAnyLenString(&query, "Select id, UNIX_TIMESTAMP()-UNIX_TIMESTAMP(ts) as age from character_backup where charid=%u and backupreason=0 order by ts asc", this->CharacterID()), true);
-	dbasync->AddWork(&dbaw, 0);
+	// keyed like the save so it copies the profile that save wrote
+	dbasync->AddWork(&dbaw, 0, this->CharacterID());
 }
 
 CLIENTPACKET::CLIENTPACKET()
@@ -732,6 +771,18 @@ void Client::QueuePacket(const EQApplicationPacket* app, bool ack_req, CLIENT_CO
 			eqs->QueuePacket(app, ack_req);
 }
 
+//for broadcasts, the packet is translated once per client version by the encoder
+void Client::QueuePacket(BroadcastEncoder &packet, CLIENT_CONN_STATUS required_state) {
+	_ZP(Client_QueuePacket);
+	if (required_state != CLIENT_CONNECTINGALL && client_state != required_state) {
+		AddPacket(packet.GetPacket(), packet.GetAckReq());
+		return;
+	}
+
+	if(eqs)
+		packet.Queue(eqs);
+}
+
 void Client::FastQueuePacket(EQApplicationPacket** app, bool ack_req, CLIENT_CONN_STATUS required_state) {
 
 	//cout << "Sending: 0x" << hex << setw(4) << setfill('0') << (*app)->GetOpcode() << dec << ", size=" << (*app)->size << endl;
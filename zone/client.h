@@ -28,6 +28,7 @@ class Client;
 #include "../common/EQPacket.h"
 #include "../common/linked_list.h"
 #include "../common/extprofile.h"
+#include "../common/profile_save.h"
 #include "../common/classes.h"
 #include "../common/races.h"
 #include "../common/deity.h"
@@ -69,6 +70,8 @@ class Client;
 extern Zone* zone;
 extern TaskManager *taskmanager;
 
+class BroadcastEncoder;
+
 class CLIENTPACKET
 {
 public:
@@ -267,6 +270,7 @@ public:
 	void	SendPacketQueue(bool Block = true);
 	void	QueuePacket(const EQApplicationPacket* app, bool ack_req = true, CLIENT_CONN_STATUS = CLIENT_CONNECTINGALL, eqFilterType filter=FilterNone);
 	void	FastQueuePacket(EQApplicationPacket** app, bool ack_req = true, CLIENT_CONN_STATUS = CLIENT_CONNECTINGALL);
+	void	QueuePacket(BroadcastEncoder &packet, CLIENT_CONN_STATUS = CLIENT_CONNECTINGALL);
 	void	ChannelMessageReceived(uint8 chan_num, uint8 language, uint8 lang_skill, const char* orig_message, const char* targetname=nullptr);
 	void	ChannelMessageSend(const char* from, const char* to, uint8 chan_num, uint8 language, const char* message, ...);
 	void	ChannelMessageSend(const char* from, const char* to, uint8 chan_num, uint8 language, uint8 lang_skill, const char* message, ...);
@@ -1292,6 +1296,7 @@ private:
 
 	PlayerProfile_Struct		m_pp;
 	ExtendedProfile_Struct		m_epp;
+	ProfileSaveState			m_profile_save;	// what the last save wrote, so the next only sends changes
 	Inventory					m_inv;
 	Object*						m_tradeskill_object;
 	PetInfo						m_petinfo; // current pet data, used while loading from and saving to DB
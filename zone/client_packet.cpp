@@ -554,7 +554,7 @@ void Client::Handle_Connect_OP_ZoneEntry(const EQApplicationPacket *app)
 	dbaw->AddQuery(3, &query, MakeAnyLenString(&query,
 		"SELECT faction_id,current_value FROM faction_values WHERE temp = 0 AND char_id = %i",
 		character_id));
-	if (!(pDBAsyncWorkID = dbasync->AddWork(&dbaw))) {
+	if (!(pDBAsyncWorkID = dbasync->AddWork(&dbaw, 0, character_id))) {
 		safe_delete(dbaw);
 		LogFile->write(EQEMuLog::Error,"dbasync->AddWork() returned false, client crash");
 		client_state = CLIENT_KICKED;
@@ -8708,6 +8708,7 @@ void Client::DBAWComplete(uint8 workpt_b1, DBAsyncWork* dbaw) {
 			}
 			else {
 				std::cout << "Async client save failed. '" << errbuf << "'" << std::endl;
+				m_profile_save.Invalidate();
 				Message(13, "Error: Asyncronous save of your character failed.");
 				if (Admin() >= 200)
 					Message(13, "errbuf: %s", errbuf);
@@ -8815,6 +8816,8 @@ bool Client::FinishConnState2(DBAsyncWork* dbaw) {
 	x_pos		= m_pp.x;
 	y_pos		= m_pp.y;
 	z_pos		= m_pp.z;
+	//AddClient put us in the grids before the profile said where we are
+	entity_list.UpdateGrids(this);
 	heading		= m_pp.heading;
 	race		= m_pp.race;
 	base_race	= m_pp.race;
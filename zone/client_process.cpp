@@ -2056,6 +2056,7 @@ void Client::HandleRespawnFromHover(uint32 Option)
 			x_pos = corpse->GetX();
 			y_pos = corpse->GetY();
 			z_pos = corpse->GetZ();
+			entity_list.UpdateGrids(this);
 		}
 
 		EQApplicationPacket* outapp = new EQApplicationPacket(OP_ZonePlayerToBind, sizeof(ZonePlayerToBind_Struct) + 10);
@@ -2113,6 +2114,7 @@ void Client::HandleRespawnFromHover(uint32 Option)
 		x_pos = m_pp.binds[0].x;
 		y_pos = m_pp.binds[0].y;
 		z_pos = m_pp.binds[0].z;
+		entity_list.UpdateGrids(this);
 
 		ClearHover();
 		entity_list.RefreshClientXTargets(this);
@@ -61,11 +61,22 @@
 #include "client_logs.h"
 #include "guild_mgr.h"
 #include "titles.h"
+#include "loop_scheduler.h"
 #include "../common/patches/patches.h"
+#include "../common/EQStreamFactory.h"
+#include "../common/StructStrategy.h"
+#include "../common/timer.h"
+#include "../common/MiscFunctions.h"
+#include "../common/packet_pool.h"
+#include "../common/rdtsc.h"
 
 // these should be in the headers...
 extern WorldServer worldserver;
 extern TaskManager *taskmanager;
+extern EQStreamFactory eqsf;
+extern DBAsync *dbasync;
+extern TimerWheel timer_wheel;
+extern ZoneLoopScheduler loop_scheduler;
 void CatchSignal(int sig_num);
 
 #include "QuestParserCollection.h"
@@ -264,6 +275,7 @@ int command_init(void) {
 		command_add("fz",nullptr,100,command_findzone) ||
 		command_add("viewnpctype","[npctype id] - Show info about an npctype",100,command_viewnpctype) ||
 		command_add("reloadstatic","- Reload Static Zone Data",150,command_reloadstatic) ||
+		command_add("reloadnpctype","[npctype_id] - Reread an npc type (your target's if no id) into the shared npc type table",150,command_reloadnpctype) ||
 		command_add("reloadquest"," - Clear quest cache (any argument causes it to also stop all timers)",150,command_reloadqst) ||
 		command_add("reloadqst",nullptr,0,command_reloadqst) ||
 		command_add("reloadpl",nullptr,0,command_reloadqst) ||
@@ -431,7 +443,7 @@ int command_init(void) {
 		command_add("undyeme","- Remove dye from all of your armor slots",0,command_undyeme) ||
 		command_add("instance","- Modify Instances",200,command_instance) ||
 		command_add("setstartzone","[zoneid] - Set target's starting zone. Set to zero to allow the player to use /setstartcity",80,command_setstartzone) ||
-		command_add("netstats","- Gets the network stats for a stream.",200,command_netstats) ||
+		command_add("netstats","[reader|writer|broadcast|compress] - Gets the network or compression stats for a stream, or the zone's UDP reader/writer/broadcast encode stats.",200,command_netstats) ||
 		command_add("object","List|Add|Edit|Move|Rotate|Copy|Save|Undo|Delete - Manipulate static and tradeskill objects within the zone",100,command_object) ||
 		command_add("raidloot","LEADER|GROUPLEADER|SELECTED|ALL - Sets your raid loot settings if you have permission to do so.",0,command_raidloot) ||
 		command_add("globalview","Lists all qglobals in cache if you were to do a quest with this target.",80,command_globalview) ||
@@ -453,7 +465,15 @@ int command_init(void) {
 		command_add("printquestitems","Returns available quest items for multiquesting currently on the target npc.",200,command_printquestitems) ||
 		command_add("clearquestitems","Clears quest items for multiquesting currently on the target npc.",200,command_clearquestitems) ||
 		command_add("zopp", "Troubleshooting command - Sends a fake item packet to you. No server reference is created.", 250, command_zopp) ||
-		command_add("augmentitem", "Force augments an item. Must have the augment item window open.", 250, command_augmentitem)
+		command_add("augmentitem", "Force augments an item. Must have the augment item window open.", 250, command_augmentitem) ||
+		command_add("gridstats", "- Shows how many mobs this zone's entity grid holds, in how many cells, and the widest npc aggro/assist range.", 250, command_gridstats) ||
+		command_add("dbstats", "[reset] - Shows this zone's async database workers, queue depth, wait and query time histograms.", 200, command_dbstats) ||
+		command_add("timerstats", "[reset] - Shows timers fired by the timer wheel against Timer checks still polled, per zone tick.", 200, command_timerstats) ||
+		command_add("loopstats", "[reset] - Shows how long this zone's main loop spends in each subsystem and sleeping between passes.", 200, command_loopstats) ||
+		command_add("savestats", "[reset] - Shows how many player profile bytes this zone has written against what whole profile saves would have written, and inventory journal counters.", 200, command_savestats) ||
+		command_add("zprofile", "[on|off|reset|snapshot|dump] - Turns this zone's section profiler on or off, or shows the sections it spent the most time in.", 200, command_zprofile) ||
+		command_add("packetpool", "[reset] - Shows how many protocol packets and buffers this zone allocated and how many of those still went to the heap.", 200, command_packetpool) ||
+		command_add("boottiming", "- Shows how long each stage of this zone's boot took and which thread ran it.", 200, command_boottiming)
 		)
 	{
 		command_deinit();
@@ -3495,7 +3515,7 @@ void command_reloadlevelmods(Client *c, const Seperator *sep)
 	if (sep->arg[1][0] == 0)
 	{
 		if(RuleB(Zone, LevelBasedEXPMods)){
-			zone->LoadLevelEXPMods();
+			zone->LoadLevelEXPMods(database);
 			c->Message(15, "Level based EXP Mods have been reloaded zonewide");
 		}else{
 			c->Message(15, "Level based EXP Mods are disabled in rules!");
@@ -7640,6 +7660,7 @@ void command_path(Client *c, const Seperator *sep)
 		c->Message(0, "#path move: Moves your targeted node to your current position");
 		c->Message(0, "#path process file_name: processes the map file and tries to automatically generate a rudimentary path setup and then dumps the current zone->pathing to a file of your naming.");
 		c->Message(0, "#path resort [nodes]: resorts the connections/nodes after you've manually altered them so they'll work.");
+		c->Message(0, "#path cache [clear]: shows the route cache size and hit rate, or empties it.");
 		return;
 	}
 	if(!strcasecmp(sep->arg[1], "shownodes"))
@@ -7796,6 +7817,23 @@ void command_path(Client *c, const Seperator *sep)
 	}
 
 
+	if(!strcasecmp(sep->arg[1], "cache"))
+	{
+		if(zone->pathing)
+		{
+			if(!strcasecmp(sep->arg[2], "clear"))
+			{
+				zone->pathing->ClearRouteCache();
+				c->Message(0, "Route cache cleared.");
+			}
+			else
+			{
+				zone->pathing->ShowRouteCache(c);
+			}
+		}
+		return;
+	}
+
 	if(!strcasecmp(sep->arg[1], "move"))
 	{
 		if(zone->pathing)
@@ -9545,7 +9583,59 @@ void command_netstats(Client *c, const Seperator *sep)
 {
 	if(c)
 	{
-		if(c->GetTarget() && c->GetTarget()->IsClient())
+		if(strcasecmp(sep->arg[1], "reader") == 0)
+		{
+			EQStreamReaderStats stats;
+			eqsf.GetReaderStats(stats);
+			c->Message(0, "Reader (%s):", eqsf.IsBatchedReader() ? "batched" : "select");
+			c->Message(0, "Packets: %llu, bytes: %llu, reads: %llu, per second: %u", (unsigned long long)stats.packets,
+				(unsigned long long)stats.bytes, (unsigned long long)stats.batches, stats.packets_per_second);
+			c->Message(0, "Batch sizes: 1: %u, 2-3: %u, 4-7: %u, 8-15: %u, 16-31: %u, 32-63: %u, 64: %u",
+				stats.batch_sizes[0], stats.batch_sizes[1], stats.batch_sizes[2], stats.batch_sizes[3],
+				stats.batch_sizes[4], stats.batch_sizes[5], stats.batch_sizes[6]);
+		}
+		else if(strcasecmp(sep->arg[1], "broadcast") == 0)
+		{
+			const BroadcastEncoder::Stats &stats = BroadcastEncoder::GetStats();
+			c->Message(0, "Broadcasts: %llu, recipients: %llu", (unsigned long long)stats.broadcasts, (unsigned long long)stats.recipients);
+			c->Message(0, "Encodes done: %llu, encodes saved: %llu", (unsigned long long)stats.encodes, (unsigned long long)stats.encodes_saved);
+		}
+		else if(strcasecmp(sep->arg[1], "writer") == 0)
+		{
+			EQStreamWriterStats stats;
+			eqsf.GetWriterStats(stats);
+			c->Message(0, "Writer (%s):", eqsf.IsEventWriter() ? "event" : "polling");
+			c->Message(0, "Writes: %llu, full scans: %llu, datagrams: %llu, send calls: %llu", (unsigned long long)stats.writes,
+				(unsigned long long)stats.scans, (unsigned long long)stats.datagrams, (unsigned long long)stats.send_calls);
+			c->Message(0, "Queue latency avg: %uus, max: %uus", stats.writes ? (uint32)(stats.latency_total / stats.writes) : 0, stats.latency_max);
+			c->Message(0, "Latency: <250us: %u, <1ms: %u, <5ms: %u, <10ms: %u, <20ms: %u, 20ms+: %u",
+				stats.latency[0], stats.latency[1], stats.latency[2], stats.latency[3], stats.latency[4], stats.latency[5]);
+		}
+		else if(strcasecmp(sep->arg[1], "compress") == 0)
+		{
+			Client *t = c;
+			if(c->GetTarget() && c->GetTarget()->IsClient())
+				t = c->GetTarget()->CastToClient();
+
+			EQStreamCompressionStats stats;
+			if(!t->Connection()->GetCompressionStats(stats)) {
+				c->Message(0, "%s's stream is not compressed.", t->GetName());
+				return;
+			}
+			RDTSC_Timer::calibrate();
+			int64 per_us = RDTSC_Timer::ticksPerMS() / 1000;
+			if(per_us < 1)
+				per_us = 1;
+			c->Message(0, "Compression for %s:", t->GetName());
+			c->Message(0, "Deflate: %u compressed, %u stored, %llu bytes in, %llu out (%u%%), %lluus cpu",
+				stats.deflated, stats.stored, (unsigned long long)stats.deflate_in, (unsigned long long)stats.deflate_out,
+				stats.deflate_in ? (uint32)(stats.deflate_out * 100 / stats.deflate_in) : 0,
+				(unsigned long long)(stats.deflate_ticks / per_us));
+			c->Message(0, "Inflate: %u packets, %llu bytes in, %llu out, %lluus cpu",
+				stats.inflated, (unsigned long long)stats.inflate_in, (unsigned long long)stats.inflate_out,
+				(unsigned long long)(stats.inflate_ticks / per_us));
+		}
+		else if(c->GetTarget() && c->GetTarget()->IsClient())
 		{
 			c->Message(0, "Sent:");
 			c->Message(0, "Total: %u, per second: %u", c->GetTarget()->CastToClient()->Connection()->GetBytesSent(),
@@ -11125,7 +11215,7 @@ void command_emotesearch(Client *c, const Seperator *sep)
 void command_reloademote(Client *c, const Seperator *sep)
 {
 	zone->NPCEmoteList.Clear();
-	zone->LoadNPCEmotes(&zone->NPCEmoteList);
+	zone->LoadNPCEmotes(&zone->NPCEmoteList, database);
 	c->Message(0, "NPC emotes reloaded.");
 }
 
@@ -11639,3 +11729,209 @@ void command_augmentitem(Client *c, const Seperator *sep)
 		safe_delete_array(in_augment);
 }
 
+
+void command_gridstats(Client *c, const Seperator *sep)
+{
+	uint32 mobs, cells;
+	entity_list.GetGridStats(mobs, cells);
+	c->Message(0, "This zone: %u mobs in %u cells, widest npc aggro/assist range %.0f", mobs, cells, entity_list.GetNPCReach());
+}
+
+void command_savestats(Client *c, const Seperator *sep)
+{
+	if(strcasecmp(sep->arg[1], "reset") == 0) {
+		ProfileSaveState::ResetStats();
+		c->Message(0, "Profile save counters reset.");
+		return;
+	}
+
+	const ProfileSaveState::Stats &stats = ProfileSaveState::stats;
+	c->Message(0, "Profile saves: %u written (%u with a whole blob), %u skipped with nothing changed", stats.writes, stats.full_writes, stats.skipped);
+	c->Message(0, "Blob bytes: %llu written, %llu without deltas, %llu saved (%.1f%%)",
+		(unsigned long long)stats.written_bytes, (unsigned long long)stats.full_bytes,
+		(unsigned long long)(stats.full_bytes - stats.written_bytes),
+		stats.full_bytes ? 100.0f * (stats.full_bytes - stats.written_bytes) / stats.full_bytes : 0.0f);
+	c->Message(0, "Delta saves are %s.", RuleB(Character, DeltaProfileSaves) ? "on" : "off");
+
+	InventoryJournal::Stats inv = database.GetInventoryJournal().GetStats();
+	c->Message(0, "Inventory journal: %u entries in %u statements (%u batches), %u pending, %u failed, %u retried by row",
+		inv.entries, inv.statements, inv.batches, database.GetInventoryJournal().PendingEntries(), inv.errors, inv.fallbacks);
+	c->Message(0, "Inventory barriers: %u, waits past their timeout: %u. Journaling is %s.", inv.barriers, inv.barrier_timeouts,
+		database.JournalingInventory() ? "on" : "off");
+}
+
+void command_dbstats(Client *c, const Seperator *sep)
+{
+	if(strcasecmp(sep->arg[1], "reset") == 0) {
+		dbasync->ResetStats();
+		c->Message(0, "DBAsync stats reset.");
+		return;
+	}
+
+	std::vector<std::string> lines;
+	dbasync->DescribeStats(lines);
+	for(size_t i = 0; i < lines.size(); i++)
+		c->Message(0, "%s", lines[i].c_str());
+}
+
+void command_timerstats(Client *c, const Seperator *sep)
+{
+	if(strcasecmp(sep->arg[1], "reset") == 0) {
+		timer_wheel.ResetStats();
+		c->Message(0, "Timer wheel stats reset.");
+		return;
+	}
+
+	const TimerWheel::Stats &stats = timer_wheel.GetStats();
+	char buf[128];
+	c->Message(0, "Timer wheel is %s, %u timers scheduled", RuleB(Zone, UseTimerWheel) ? "on" : "off", timer_wheel.Count());
+	c->Message(0, "%llu ticks, %llu fired, %llu moved down a level",
+		(unsigned long long)stats.ticks, (unsigned long long)stats.fired, (unsigned long long)stats.cascaded);
+	stats.fired_per_tick.Summary(buf, sizeof(buf));
+	c->Message(0, "Fired per tick: %s", buf);
+	stats.polled_per_tick.Summary(buf, sizeof(buf));
+	c->Message(0, "Polled per tick: %s", buf);
+}
+
+void command_loopstats(Client *c, const Seperator *sep)
+{
+	if(strcasecmp(sep->arg[1], "reset") == 0) {
+		loop_scheduler.ResetStats();
+		c->Message(0, "Main loop stats reset.");
+		return;
+	}
+
+	const ZoneLoopScheduler::Stats &stats = loop_scheduler.GetStats();
+	char buf[128];
+	c->Message(0, "Main loop is %s: %llu passes, %llu cut short by packets, %llu past their deadline",
+		RuleB(Zone, AdaptiveMainLoop) ? "adaptive" : "fixed", (unsigned long long)stats.loops,
+		(unsigned long long)stats.woken, (unsigned long long)stats.overran);
+	stats.busy_us.Summary(buf, sizeof(buf));
+	c->Message(0, "Busy us: %s", buf);
+	stats.sleep_us.Summary(buf, sizeof(buf));
+	c->Message(0, "Sleep us: %s", buf);
+
+	uint32 r;
+	for(r = 0; r < LoopSectionCount; r++) {
+		if(stats.sections[r].Count() == 0)
+			continue;
+		stats.sections[r].Summary(buf, sizeof(buf));
+		c->Message(0, "%s us: %s", ZoneLoopScheduler::SectionName((ZoneLoopSection)r), buf);
+	}
+}
+
+static bool zprofile_by_total(const std::pair<uint32, uint64> &l, const std::pair<uint32, uint64> &r)
+{
+	return(l.second > r.second);
+}
+
+void command_zprofile(Client *c, const Seperator *sep)
+{
+	if(strcasecmp(sep->arg[1], "on") == 0) {
+		ZoneProfiler::Enable(true);
+		c->Message(0, "Zone profiler on.");
+		return;
+	}
+	if(strcasecmp(sep->arg[1], "off") == 0) {
+		ZoneProfiler::Enable(false);
+		c->Message(0, "Zone profiler off.");
+		return;
+	}
+	if(strcasecmp(sep->arg[1], "reset") == 0) {
+		ZoneProfiler::Reset();
+		c->Message(0, "Zone profiler reset.");
+		return;
+	}
+	if(strcasecmp(sep->arg[1], "snapshot") == 0) {
+		if(WriteZoneProfileSnapshot())
+			c->Message(0, "Zone profile snapshot written.");
+		else
+			c->Message(13, "Unable to write the zone profile snapshot, see the error log.");
+		return;
+	}
+	if(strcasecmp(sep->arg[1], "dump") == 0) {
+		DumpZoneProfile();
+		c->Message(0, "Zone profile written to the debug log.");
+		return;
+	}
+
+	std::vector<ZoneProfileCounter> counters;
+	ZoneProfiler::Snapshot(counters);
+	double tpus = ZoneProfiler::TicksPerUS();
+	if(tpus <= 0)
+		tpus = 1;
+	c->Message(0, "Zone profiler is %s, %.1f seconds of data", ZoneProfiler::IsEnabled() ? "on" : "off", ZoneProfiler::GetElapsed());
+
+	std::vector<std::pair<uint32, uint64> > order;
+	uint32 r;
+	for(r = 0; r < ZoneProfiler::MaxZoneProfilerId; r++) {
+		if(counters[r].calls > 0)
+			order.push_back(std::make_pair(r, counters[r].ticks));
+	}
+	std::sort(order.begin(), order.end(), zprofile_by_total);
+
+	for(r = 0; r < order.size() && r < 15; r++) {
+		const ZoneProfileCounter &cur = counters[order[r].first];
+		c->Message(0, "%s: %llu calls, %.2fms, p50 %.1fus p99 %.1fus max %.1fus", ZoneProfiler::GetName(order[r].first),
+			(unsigned long long)cur.calls, double(cur.ticks) / tpus / 1000.0, double(cur.hist.Percentile(0.5f)) / tpus,
+			double(cur.hist.Percentile(0.99f)) / tpus, double(cur.hist.Max()) / tpus);
+	}
+}
+
+void command_packetpool(Client *c, const Seperator *sep)
+{
+	if(strcasecmp(sep->arg[1], "reset") == 0) {
+		PacketPool::ResetStats();
+		c->Message(0, "Packet pool stats reset.");
+		return;
+	}
+
+	PacketPool::Stats stats;
+	PacketPool::GetStats(stats);
+	uint32 age = PacketPool::GetStatsAge();
+	if(age == 0)
+		age = 1;
+	c->Message(0, "Over %u seconds: %llu allocations (%llu/s), %llu frees", age,
+		(unsigned long long)stats.allocs, (unsigned long long)(stats.allocs / age), (unsigned long long)stats.frees);
+	c->Message(0, "Heap allocations: %llu (%llu/s, %.1f%%), %llu of them too big to pool",
+		(unsigned long long)stats.heap_allocs, (unsigned long long)(stats.heap_allocs / age),
+		stats.allocs ? 100.0 * stats.heap_allocs / stats.allocs : 0.0, (unsigned long long)stats.oversize);
+	c->Message(0, "Blocks passed between threads: %llu given up, %llu taken back",
+		(unsigned long long)stats.depot_puts, (unsigned long long)stats.depot_gets);
+}
+
+void command_reloadnpctype(Client *c, const Seperator *sep)
+{
+	uint32 npctype_id = 0;
+	if(sep->IsNumber(1))
+		npctype_id = atoi(sep->arg[1]);
+	else if(c->GetTarget() && c->GetTarget()->IsNPC())
+		npctype_id = c->GetTarget()->CastToNPC()->GetNPCTypeID();
+
+	if(npctype_id == 0) {
+		c->Message(0, "Usage: #reloadnpctype [npctype_id] - or target an NPC");
+		return;
+	}
+
+	if(database.ReloadNPCType(npctype_id))
+		c->Message(0, "Reloaded npc type %u in the shared table. Zones on this host use it after their next repop, npcs already up keep the old one.", npctype_id);
+	else
+		c->Message(0, "Npc type %u is not in the shared npc type table, it will be read from the database on its next spawn.", npctype_id);
+}
+
+void command_boottiming(Client *c, const Seperator *sep)
+{
+	float serial_ms = 0.0f;
+	std::vector<ZoneBootTiming>::const_iterator cur;
+	for(cur = zone->boot_timings.begin(); cur != zone->boot_timings.end(); ++cur)
+		serial_ms += cur->elapsed_ms;
+	c->Message(0, "Zone boot took %.1f ms, its stages add up to %.1f ms", zone->boot_ms, serial_ms);
+
+	for(cur = zone->boot_timings.begin(); cur != zone->boot_timings.end(); ++cur) {
+		const char *where = "zone";
+		if(cur->thread != 0)
+			where = ZoneBoot::GetStageRunsOn(cur->stage) == BootOnFile ? "file" : "db";
+		c->Message(0, "  %s: %.1f ms, from %.1f ms on %s%s", ZoneBoot::GetStageName(cur->stage),
+			cur->elapsed_ms, cur->start_ms, where, cur->ok ? "" : " (failed)");
+	}
+}
@@ -273,6 +273,7 @@ void command_aggro(Client *c, const Seperator *sep);
 void command_hatelist(Client *c, const Seperator *sep);
 void command_aggrozone(Client *c, const Seperator *sep);
 void command_reloadstatic(Client *c, const Seperator *sep);
+void command_reloadnpctype(Client *c, const Seperator *sep);
 void command_flags(Client *c, const Seperator *sep);
 void command_flagedit(Client *c, const Seperator *sep);
 void command_mlog(Client *c, const Seperator *sep);
@@ -323,6 +324,14 @@ void command_printquestitems(Client *c, const Seperator *sep);
 void command_clearquestitems(Client *c, const Seperator *sep);
 void command_zopp(Client *c, const Seperator *sep);
 void command_augmentitem(Client *c, const Seperator *sep);
+void command_gridstats(Client *c, const Seperator *sep);
+void command_savestats(Client *c, const Seperator *sep);
+void command_dbstats(Client *c, const Seperator *sep);
+void command_timerstats(Client *c, const Seperator *sep);
+void command_loopstats(Client *c, const Seperator *sep);
+void command_zprofile(Client *c, const Seperator *sep);
+void command_packetpool(Client *c, const Seperator *sep);
+void command_boottiming(Client *c, const Seperator *sep);
 
 #ifdef EMBPERL
 void command_embperl_plugin(Client *c, const Seperator *sep);
@@ -730,17 +730,20 @@ void Doors::SetLocation(float x, float y, float z)
 	pos_x = x;
 	pos_y = y;
 	pos_z = z;
+	entity_list.DoorMoved(this);
 	entity_list.RespawnAllDoors();
 }
 
 void Doors::SetX(float in) {
 	entity_list.DespawnAllDoors();
 	pos_x = in;
+	entity_list.DoorMoved(this);
 	entity_list.RespawnAllDoors();
 }
 void Doors::SetY(float in) {
 	entity_list.DespawnAllDoors();
 	pos_y = in;
+	entity_list.DoorMoved(this);
 	entity_list.RespawnAllDoors();
 }
 void Doors::SetZ(float in) {
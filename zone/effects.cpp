@@ -634,7 +634,7 @@ bool Client::UseDiscipline(uint32 spell_id, uint32 target) {
 }
 
 void EntityList::AETaunt(Client* taunter, float range) {
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 
 	if(range == 0) {
 		range = 100;		//arbitrary default...
@@ -666,7 +666,7 @@ void EntityList::AETaunt(Client* taunter, float range) {
 // NPC spells will only affect other NPCs with compatible faction
 void EntityList::AESpell(Mob *caster, Mob *center, uint16 spell_id, bool affect_caster, int16 resist_adjust)
 {
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	Mob *curmob;
 
 	float dist = caster->GetAOERange(spell_id);
@@ -736,7 +736,7 @@ void EntityList::AESpell(Mob *caster, Mob *center, uint16 spell_id, bool affect_
 
 void EntityList::MassGroupBuff(Mob *caster, Mob *center, uint16 spell_id, bool affect_caster)
 {
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	Mob *curmob;
 
 	float dist = caster->GetAOERange(spell_id);
@@ -785,7 +785,7 @@ void EntityList::MassGroupBuff(Mob *caster, Mob *center, uint16 spell_id, bool a
 // NPC spells will only affect other NPCs with compatible faction
 void EntityList::AEBardPulse(Mob *caster, Mob *center, uint16 spell_id, bool affect_caster)
 {
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	Mob *curmob;
 
 	float dist = caster->GetAOERange(spell_id);
@@ -840,7 +840,7 @@ void EntityList::AEBardPulse(Mob *caster, Mob *center, uint16 spell_id, bool aff
 //NPCs handle it differently in Mob::Rampage
 void EntityList::AEAttack(Mob *attacker, float dist, int Hand, int count, bool IsFromSpell) {
 //Dook- Will need tweaking, currently no pets or players or horses
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	Mob *curmob;
 
 	float dist2 = dist * dist;
@@ -43,6 +43,7 @@
 #include "StringIDs.h"
 #include "parser.h"
 #include "../common/dbasync.h"
+#include "../common/StructStrategy.h"
 #include "guild_mgr.h"
 #include "raids.h"
 #include "QuestParserCollection.h"
@@ -71,10 +72,16 @@ Entity::Entity() {
 
 Entity::~Entity() {
 	dbasync->CancelWork(pDBAsyncWorkID);
+	if(id != 0)
+		entity_list.ReleaseEntityID(this);
 }
 
 void Entity::SetID(uint16 set_id) {
+	if(id != 0)
+		entity_list.ReleaseEntityID(this);
 	id = set_id;
+	if(id != 0)
+		entity_list.ClaimEntityID(this);
 }
 
 Client* Entity::CastToClient() {
@@ -284,6 +291,8 @@ Bot* Entity::CastToBot() {
 
 EntityList::EntityList() {
 	last_insert_id = 0;
+	npc_reach = 0;
+	npc_reach_pass = 0;
 }
 
 EntityList::~EntityList() {
@@ -293,7 +302,7 @@ EntityList::~EntityList() {
 }
 
 bool EntityList::CanAddHateForMob(Mob *p) {
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 	int count = 0;
 
 	iterator.Reset();
@@ -317,6 +326,8 @@ void EntityList::AddClient(Client* client) {
 	client->SetID(GetFreeID());
 	client_list.Insert(client);
 	mob_list.Insert(client);
+	client_grid.Insert(client);
+	mob_grid.Insert(client);
 	if(!client_list.dont_delete)
 		client_list.dont_delete=true;
 }
@@ -326,7 +337,7 @@ void EntityList::TrapProcess() {
 	if(numclients < 1)
 		return;
 	_ZP(EntityList_TrapProcess);
-	LinkedListIterator<Trap*> iterator(trap_list);
+	DenseListIterator<Trap*> iterator(trap_list);
 	iterator.Reset();
 	uint32 count=0;
 	while(iterator.MoreElements())
@@ -428,13 +439,14 @@ void EntityList::DoorProcess() {
 		return;
 #endif
 	_ZP(EntityList_DoorProcess);
-	LinkedListIterator<Doors*> iterator(door_list);
+	DenseListIterator<Doors*> iterator(door_list);
 	iterator.Reset();
 	uint32 count=0;
 	while(iterator.MoreElements())
 	{
 		count++;
 		if(!iterator.GetData()->Process()){
+			door_grid.Remove(iterator.GetData());
 			iterator.RemoveCurrent();
 		}
 		else
@@ -446,7 +458,7 @@ void EntityList::DoorProcess() {
 
 void EntityList::ObjectProcess() {
 	_ZP(EntityList_ObjectProcess);
-	LinkedListIterator<Object*> iterator(object_list);
+	DenseListIterator<Object*> iterator(object_list);
 	iterator.Reset();
 	uint32 count=0;
 	while(iterator.MoreElements())
@@ -464,7 +476,7 @@ void EntityList::ObjectProcess() {
 
 void EntityList::CorpseProcess() {
 	_ZP(EntityList_CorpseProcess);
-	LinkedListIterator<Corpse*> iterator(corpse_list);
+	DenseListIterator<Corpse*> iterator(corpse_list);
 	iterator.Reset();
 	uint32 count=0;
 	while(iterator.MoreElements())
@@ -486,7 +498,7 @@ void EntityList::MobProcess() {
 		return;
 #endif
 	_ZP(EntityList_MobProcess);
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -497,6 +509,7 @@ void EntityList::MobProcess() {
 		}
 		if(!iterator.GetData()->Process()){
 			Mob* mob=iterator.GetData();
+			RemoveFromGrids(mob);
 			if(mob->IsNPC())
 				entity_list.RemoveNPC(mob->CastToNPC()->GetID());
 			else if(mob->IsMerc()) {
@@ -528,14 +541,40 @@ void EntityList::MobProcess() {
 			}
 			iterator.RemoveCurrent();
 		}
-		else
+		else {
+			//a nested removal during Process() leaves a hole here
+			if(iterator.GetData())
+				UpdateGrids(iterator.GetData());
 			iterator.Advance();
+		}
 	}
+	npc_reach = npc_reach_pass;
+	npc_reach_pass = 0;
+}
+
+void EntityList::UpdateGrids(Mob *mob) {
+	mob_grid.Update(mob);
+	if(mob->IsClient()) {
+		client_grid.Update(mob);
+	}
+	else if(mob->IsNPC()) {
+		npc_grid.Update(mob);
+		float reach = mob->GetAggroRange() > mob->GetAssistRange() ? mob->GetAggroRange() : mob->GetAssistRange();
+		if(reach > npc_reach_pass)
+			npc_reach_pass = reach;
+	}
+}
+
+//no type checks here, this gets called from ~Mob after the derived parts are gone
+void EntityList::RemoveFromGrids(Mob *mob) {
+	mob_grid.Remove(mob);
+	npc_grid.Remove(mob);
+	client_grid.Remove(mob);
 }
 
 void EntityList::BeaconProcess() {
 	_ZP(EntityList_BeaconProcess);
-	LinkedListIterator<Beacon *> iterator(beacon_list);
+	DenseListIterator<Beacon *> iterator(beacon_list);
 	int count;
 
 	for(iterator.Reset(), count = 0; iterator.MoreElements(); count++)
@@ -640,6 +679,11 @@ void EntityList::AddNPC(NPC* npc, bool SendSpawnPacket, bool dontqueue) {
 	if(!npc_list.dont_delete)
 		npc_list.dont_delete=true;
 	mob_list.Insert(npc);
+	npc_grid.Insert(npc);
+	mob_grid.Insert(npc);
+	float reach = npc->GetAggroRange() > npc->GetAssistRange() ? npc->GetAggroRange() : npc->GetAssistRange();
+	if(reach > npc_reach)
+		npc_reach = reach;
 }
 
 void EntityList::AddMerc(Merc* merc, bool SendSpawnPacket, bool dontqueue) {
@@ -669,6 +713,7 @@ void EntityList::AddMerc(Merc* merc, bool SendSpawnPacket, bool dontqueue) {
 
 		merc_list.Insert(merc);
 		mob_list.Insert(merc);
+		mob_grid.Insert(merc);
 		if(!merc_list.dont_delete)
 			merc_list.dont_delete=true;
 	}
@@ -692,6 +737,7 @@ void EntityList::AddObject(Object* obj, bool SendSpawnPacket) {
 void EntityList::AddDoor(Doors* door) {
 	door->SetEntityID(GetFreeID());
 	door_list.Insert(door);
+	door_grid.Insert(door);
 	if(!net.door_timer.Enabled())
 		net.door_timer.Start();
 }
@@ -764,7 +810,7 @@ Doors* EntityList::FindDoor(uint8 door_id)
 	if (door_id == 0)
 		return 0;
 
-	LinkedListIterator<Doors*> iterator(door_list);
+	DenseListIterator<Doors*> iterator(door_list);
 	iterator.Reset();
 
 	while(iterator.MoreElements())
@@ -781,7 +827,7 @@ Doors* EntityList::FindDoor(uint8 door_id)
 
 Object* EntityList::FindObject(uint32 object_id)
 {
-	LinkedListIterator<Object*> iterator(object_list);
+	DenseListIterator<Object*> iterator(object_list);
 	iterator.Reset();
 
 	while(iterator.MoreElements())
@@ -798,7 +844,7 @@ Object* EntityList::FindObject(uint32 object_id)
 
 Object* EntityList::FindNearbyObject(float x, float y, float z, float radius)
 {
-	LinkedListIterator<Object*> iterator(object_list);
+	DenseListIterator<Object*> iterator(object_list);
 	iterator.Reset();
 
 	float ox;
@@ -831,7 +877,7 @@ bool EntityList::MakeDoorSpawnPacket(EQApplicationPacket* app, Client *client)
 {
 	uint32 mask_test = client->GetClientVersionBit();
 	int count = 0;
-	LinkedListIterator<Doors*> iterator(door_list);
+	DenseListIterator<Doors*> iterator(door_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -885,38 +931,55 @@ bool EntityList::MakeDoorSpawnPacket(EQApplicationPacket* app, Client *client)
 	app->pBuffer = packet_buffer;
 	return true;
 }
+void EntityList::ClaimEntityID(Entity *ent) {
+	uint8 type = EntitySlotOther;
+	if(ent->IsClient())
+		type = EntitySlotClient;
+	else if(ent->IsMerc())
+		type = EntitySlotMerc;
+	else if(ent->IsNPC())
+		type = EntitySlotNPC;
+#ifdef BOTS
+	else if(ent->IsBot())
+		type = EntitySlotBot;
+#endif
+	else if(ent->IsCorpse())
+		type = EntitySlotCorpse;
+	else if(ent->IsObject())
+		type = EntitySlotObject;
+	else if(ent->IsTrap())
+		type = EntitySlotTrap;
+	else if(ent->IsBeacon())
+		type = EntitySlotBeacon;
+
+	//a corpse takes over its mob's id before the mob drops it, so the newest claim wins
+	id_slots.Claim(ent->GetID(), ent, type);
+}
+
+void EntityList::ReleaseEntityID(Entity *ent) {
+	//no virtual calls here, this runs from ~Entity
+	id_slots.Release(ent->GetID(), ent);
+}
+
 Entity* EntityList::GetEntityMob(uint16 id){
-	LinkedListIterator<Mob*> iterator(mob_list);
-	iterator.Reset();
-	while(iterator.MoreElements())
-	{
-		if (iterator.GetData()->GetID() == id)
-		{
-			return iterator.GetData();
-		}
-		iterator.Advance();
+	switch(id_slots.GetType(id)) {
+	case EntitySlotClient:
+	case EntitySlotNPC:
+	case EntitySlotMerc:
+	case EntitySlotBot:
+		return id_slots.Get(id);
 	}
 	return 0;
 }
 Entity* EntityList::GetEntityMerc(uint16 id){
-	LinkedListIterator<Merc*> iterator(merc_list);
-	iterator.Reset();
-	while(iterator.MoreElements())
-	{
-		if (iterator.GetData()->GetID() == id)
-		{
-			return iterator.GetData();
-		}
-		iterator.Advance();
-	}
-	return 0;
+	return id_slots.Get(id, EntitySlotMerc);
 }
 Entity* EntityList::GetEntityMob(const char *name)
 {
 	if (name == 0)
 		return 0;
 
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 
 	for(iterator.Reset(); iterator.MoreElements(); iterator.Advance())
 	{
@@ -928,7 +991,7 @@ Entity* EntityList::GetEntityMob(const char *name)
 	return 0;
 }
 Entity* EntityList::GetEntityDoor(uint16 id){
-	LinkedListIterator<Doors*> iterator(door_list);
+	DenseListIterator<Doors*> iterator(door_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -941,24 +1004,14 @@ Entity* EntityList::GetEntityDoor(uint16 id){
 	return 0;
 }
 Entity* EntityList::GetEntityCorpse(uint16 id){
-	LinkedListIterator<Corpse*> iterator(corpse_list);
-	iterator.Reset();
-	while(iterator.MoreElements())
-	{
-		if (iterator.GetData()->GetID() == id)
-		{
-			return iterator.GetData();
-		}
-		iterator.Advance();
-	}
-	return 0;
+	return id_slots.Get(id, EntitySlotCorpse);
 }
 Entity* EntityList::GetEntityCorpse(const char *name)
 {
 	if (name == 0)
 		return 0;
 
-	LinkedListIterator<Corpse*> iterator(corpse_list);
+	DenseListIterator<Corpse*> iterator(corpse_list);
 
 	for(iterator.Reset(); iterator.MoreElements(); iterator.Advance())
 	{
@@ -971,31 +1024,11 @@ Entity* EntityList::GetEntityCorpse(const char *name)
 }
 
 Entity* EntityList::GetEntityTrap(uint16 id){
-	LinkedListIterator<Trap*> iterator(trap_list);
-	iterator.Reset();
-	while(iterator.MoreElements())
-	{
-		if (iterator.GetData()->GetID() == id)
-		{
-			return iterator.GetData();
-		}
-		iterator.Advance();
-	}
-	return 0;
+	return id_slots.Get(id, EntitySlotTrap);
 }
 
 Entity* EntityList::GetEntityObject(uint16 id){
-	LinkedListIterator<Object*> iterator(object_list);
-	iterator.Reset();
-	while(iterator.MoreElements())
-	{
-		if (iterator.GetData()->GetID() == id)
-		{
-			return iterator.GetData();
-		}
-		iterator.Advance();
-	}
-	return 0;
+	return id_slots.Get(id, EntitySlotObject);
 }
 /*
 Entity* EntityList::GetEntityGroup(uint16 id){
@@ -1013,53 +1046,18 @@ Entity* EntityList::GetEntityGroup(uint16 id){
 }
 */
 Entity* EntityList::GetEntityBeacon(uint16 id) {
-	LinkedListIterator<Beacon*> iterator(beacon_list);
-	iterator.Reset();
-	while(iterator.MoreElements())
-	{
-		if (iterator.GetData()->GetID() == id)
-		{
-			return iterator.GetData();
-		}
-		iterator.Advance();
-	}
-	return 0;
+	return id_slots.Get(id, EntitySlotBeacon);
 }
 Entity* EntityList::GetID(uint16 get_id)
 {
-	Entity* ent=0;
-	if((ent=entity_list.GetEntityMob(get_id))!=0)
-		return ent;
-	else if((ent=entity_list.GetEntityDoor(get_id))!=0)
-		return ent;
-	else if((ent=entity_list.GetEntityCorpse(get_id))!=0)
-		return ent;
-//	else if((ent=entity_list.GetEntityGroup(get_id))!=0)
-//		return ent;
-	else if((ent=entity_list.GetEntityObject(get_id))!=0)
-		return ent;
-	else if((ent=entity_list.GetEntityTrap(get_id))!=0)
-		return ent;
-	else if((ent=entity_list.GetEntityBeacon(get_id))!=0)
-		return ent;
-	else
-		return 0;
+	//doors keep their id in entity_id rather than Entity::id, so they never show up here
+	return id_slots.Get(get_id);
 }
 
 NPC* EntityList::GetNPCByID(uint16 id) {
-	LinkedListIterator<NPC*> iterator(npc_list);
-
-	iterator.Reset();
-	while(iterator.MoreElements())
-	{
-		if (iterator.GetData())
-		{
-			if (iterator.GetData()->GetID() == id) {
-				return iterator.GetData();
-			}
-		}
-		iterator.Advance();
-	}
+	Entity *ent = id_slots.Get(id, EntitySlotNPC);
+	if(ent)
+		return ent->CastToNPC();
 	return 0;
 }
 
@@ -1067,7 +1065,7 @@ NPC* EntityList::GetNPCByNPCTypeID(uint32 npc_id)
 {
 	if (npc_id == 0)
 		return 0;
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -1082,33 +1080,25 @@ NPC* EntityList::GetNPCByNPCTypeID(uint32 npc_id)
 }
 
 Merc* EntityList::GetMercByID(uint16 id) {
-	LinkedListIterator<Merc*> iterator(merc_list);
-
-	iterator.Reset();
-	while(iterator.MoreElements())
-	{
-		if (iterator.GetData())
-		{
-			if (iterator.GetData()->GetID() == id) {
-				return iterator.GetData();
-			}
-		}
-		iterator.Advance();
-	}
+	Entity *ent = id_slots.Get(id, EntitySlotMerc);
+	if(ent)
+		return ent->CastToMerc();
 	return 0;
 }
 
 Mob* EntityList::GetMob(uint16 get_id)
 {
-	Entity* ent=0;
-
 	if (get_id == 0)
 		return 0;
 
-	if((ent=entity_list.GetEntityMob(get_id))!=0)
-		return ent->CastToMob();
-	else if((ent=entity_list.GetEntityCorpse(get_id))!=0)
-		return ent->CastToMob();
+	switch(id_slots.GetType(get_id)) {
+	case EntitySlotClient:
+	case EntitySlotNPC:
+	case EntitySlotMerc:
+	case EntitySlotBot:
+	case EntitySlotCorpse:
+		return id_slots.Get(get_id)->CastToMob();
+	}
 
 	return 0;
 }
@@ -1132,7 +1122,7 @@ Mob* EntityList::GetMobByNpcTypeID(uint32 get_id)
 {
 	if (get_id == 0)
 		return 0;
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -1151,7 +1141,7 @@ Object* EntityList::GetObjectByDBID(uint32 id)
 	if (id == 0)
 		return 0;
 
-	LinkedListIterator<Object*> iterator(object_list);
+	DenseListIterator<Object*> iterator(object_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -1173,20 +1163,9 @@ Object* EntityList::GetObjectByID(uint16 id)
 	if (id == 0)
 		return 0;
 
-	LinkedListIterator<Object*> iterator(object_list);
-
-	iterator.Reset();
-	while(iterator.MoreElements())
-	{
-		if (iterator.GetData())
-		{
-			if (iterator.GetData()->CastToObject()->GetID() == id)
-			{
-				return iterator.GetData();
-			}
-		}
-		iterator.Advance();
-	}
+	Entity *ent = id_slots.Get(id, EntitySlotObject);
+	if(ent)
+		return ent->CastToObject();
 	return 0;
 }
 
@@ -1195,7 +1174,7 @@ Doors* EntityList::GetDoorsByID(uint16 id)
 	if (id == 0)
 		return 0;
 
-	LinkedListIterator<Doors*> iterator(door_list);
+	DenseListIterator<Doors*> iterator(door_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -1217,7 +1196,7 @@ Doors* EntityList::GetDoorsByDBID(uint32 id)
 	if (id == 0)
 		return 0;
 
-	LinkedListIterator<Doors*> iterator(door_list);
+	DenseListIterator<Doors*> iterator(door_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -1239,7 +1218,7 @@ Doors* EntityList::GetDoorsByDoorID(uint32 id)
 	if (id == 0)
 		return 0;
 
-	LinkedListIterator<Doors*> iterator(door_list);
+	DenseListIterator<Doors*> iterator(door_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -1278,7 +1257,7 @@ void EntityList::ChannelMessage(Mob* from, uint8 chan_num, uint8 language, const
 }
 
 void EntityList::ChannelMessage(Mob* from, uint8 chan_num, uint8 language, uint8 lang_skill, const char* message, ...) {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	va_list argptr;
 	char buffer[4096];
 
@@ -1306,7 +1285,7 @@ void EntityList::ChannelMessage(Mob* from, uint8 chan_num, uint8 language, uint8
 }
 
 void EntityList::ChannelMessageSend(Mob* to, uint8 chan_num, uint8 language, const char* message, ...) {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	va_list argptr;
 	char buffer[4096];
 	va_start(argptr, message);
@@ -1326,7 +1305,7 @@ void EntityList::ChannelMessageSend(Mob* to, uint8 chan_num, uint8 language, con
 
 void EntityList::SendZoneSpawns(Client* client)
 {
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 
 	EQApplicationPacket* app;
 	iterator.Reset();
@@ -1351,7 +1330,7 @@ void EntityList::SendZoneSpawns(Client* client)
 void EntityList::SendZoneSpawnsBulk(Client* client)
 {
 	//float rate = client->Connection()->GetDataRate();
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	NewSpawn_Struct ns;
 	Mob *spawn;
 	uint32 maxspawns=100;
@@ -1378,7 +1357,7 @@ void EntityList::SendZoneSpawnsBulk(Client* client)
 
 //this is a hack to handle a broken spawn struct
 void EntityList::SendZonePVPUpdates(Client *to) {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements()) {
@@ -1392,7 +1371,7 @@ void EntityList::SendZonePVPUpdates(Client *to) {
 void EntityList::SendZoneCorpses(Client* client)
 {
 	EQApplicationPacket* app;
-	LinkedListIterator<Corpse*> iterator(corpse_list);
+	DenseListIterator<Corpse*> iterator(corpse_list);
 
 	for(iterator.Reset(); iterator.MoreElements(); iterator.Advance())
 	{
@@ -1406,7 +1385,7 @@ void EntityList::SendZoneCorpses(Client* client)
 
 void EntityList::SendZoneCorpsesBulk(Client* client) {
 	//float rate = client->Connection()->GetDataRate();
-	LinkedListIterator<Corpse*> iterator(corpse_list);
+	DenseListIterator<Corpse*> iterator(corpse_list);
 	NewSpawn_Struct ns;
 	Corpse *spawn;
 	uint32 maxspawns=100;
@@ -1430,7 +1409,7 @@ void EntityList::SendZoneCorpsesBulk(Client* client) {
 
 void EntityList::SendZoneObjects(Client* client)
 {
-	LinkedListIterator<Object*> iterator(object_list);
+	DenseListIterator<Object*> iterator(object_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -1443,7 +1422,7 @@ void EntityList::SendZoneObjects(Client* client)
 
 void EntityList::Save()
 {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -1457,7 +1436,7 @@ void EntityList::ReplaceWithTarget(Mob* pOldMob, Mob*pNewTarget)
 {
 	if(!pNewTarget)
 		return;
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements()) {
@@ -1472,7 +1451,7 @@ void EntityList::ReplaceWithTarget(Mob* pOldMob, Mob*pNewTarget)
 
 void EntityList::RemoveFromTargets(Mob* mob, bool RemoveFromXTargets)
 {
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -1499,7 +1478,7 @@ void EntityList::RemoveFromTargets(Mob* mob, bool RemoveFromXTargets)
 
 void EntityList::RemoveFromXTargets(Mob* mob)
 {
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -1518,7 +1497,7 @@ void EntityList::RemoveFromXTargets(Mob* mob)
 
 void EntityList::RemoveFromAutoXTargets(Mob* mob)
 {
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -1540,7 +1519,7 @@ void EntityList::RefreshAutoXTargets(Client *c)
 	if(!c)
 		return;
 
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -1565,7 +1544,7 @@ void EntityList::RefreshClientXTargets(Client *c)
 	if(!c)
 		return;
 
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -1584,7 +1563,7 @@ void EntityList::RefreshClientXTargets(Client *c)
 void EntityList::QueueClientsByTarget(Mob* sender, const EQApplicationPacket* app, bool iSendToSender, Mob* SkipThisMob, bool ackreq, bool HoTT,
 						uint32 ClientVersionBits)
 {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 
@@ -1633,7 +1612,7 @@ void EntityList::QueueClientsByTarget(Mob* sender, const EQApplicationPacket* ap
 
 void EntityList::QueueClientsByXTarget(Mob* sender, const EQApplicationPacket* app, bool iSendToSender)
 {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 
@@ -1663,12 +1642,14 @@ void EntityList::QueueCloseClients(Mob* sender, const EQApplicationPacket* app,
 	}
 	float dist2 = dist * dist; //pow(dist, 2);
 
-	LinkedListIterator<Client*> iterator(client_list);
+	BroadcastEncoder packet(app, ackreq);
+	std::vector<Mob*> candidates;
+	client_grid.GetInRange(sender->GetX(), sender->GetY(), dist, candidates);
 
-	iterator.Reset();
-	while(iterator.MoreElements()) {
+	std::vector<Mob*>::iterator iterator;
+	for(iterator = candidates.begin(); iterator != candidates.end(); ++iterator) {
 
-		Client* ent = iterator.GetData();
+		Client* ent = (*iterator)->CastToClient();
 
 		if ((!ignore_sender || ent != sender) && (ent != SkipThisMob)) {
 			eqFilterMode filter2 = ent->GetFilter(filter);
@@ -1679,16 +1660,16 @@ void EntityList::QueueCloseClients(Mob* sender, const EQApplicationPacket* app,
 					(ent->GetGroup() && ent->GetGroup()->IsGroupMember(sender))))
 				|| (filter2 == FilterShowSelfOnly && ent==sender))
 			&& (ent->DistNoRoot(*sender) <= dist2)) {
-				ent->QueuePacket(app, ackreq, Client::CLIENT_CONNECTED);
+				ent->QueuePacket(packet, Client::CLIENT_CONNECTED);
 			}
 		}
-		iterator.Advance();
 	}
 }
 
 //sender can be null
 void EntityList::QueueClients(Mob* sender, const EQApplicationPacket* app, bool ignore_sender, bool ackreq) {
-	LinkedListIterator<Client*> iterator(client_list);
+	BroadcastEncoder packet(app, ackreq);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -1697,7 +1678,7 @@ void EntityList::QueueClients(Mob* sender, const EQApplicationPacket* app, bool
 
 		if ((!ignore_sender || ent != sender))
 		{
-			ent->QueuePacket(app, ackreq, Client::CLIENT_CONNECTED);
+			ent->QueuePacket(packet, Client::CLIENT_CONNECTED);
 		}
 		iterator.Advance();
 	}
@@ -1716,7 +1697,7 @@ void EntityList::FilterQueueCloseClients(uint8 filter, uint8 required, Mob* send
 	float dist2 = dist * dist; //pow(dist, 2);
 #endif
 
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements()) {
@@ -1761,7 +1742,7 @@ void EntityList::QueueCloseClients(Mob* sender, const EQApplicationPacket* app,
 #endif
 
 
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements()) {
@@ -1793,7 +1774,7 @@ void EntityList::QueueCloseClients(Mob* sender, const EQApplicationPacket* app,
 }
 
 void EntityList::QueueClients(Mob* sender, const EQApplicationPacket* app, bool ignore_sender, bool ackreq) {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 #ifdef PACKET_UPDATE_MANAGER
 	EQApplicationPacket* tmp_app = app->Copy();
@@ -1822,7 +1803,7 @@ void EntityList::QueueClients(Mob* sender, const EQApplicationPacket* app, bool
 
 /*
 void EntityList::QueueManaged(Mob* sender, const EQApplicationPacket* app, bool ignore_sender, bool ackreq) {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -1838,7 +1819,7 @@ void EntityList::QueueManaged(Mob* sender, const EQApplicationPacket* app, bool
 }*/
 
 void EntityList::QueueManaged(Mob* sender, const EQApplicationPacket* app, bool ignore_sender, bool ackreq) {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 #ifdef PACKET_UPDATE_MANAGER
 	EQApplicationPacket* tmp_app = app->Copy();
@@ -1867,7 +1848,7 @@ void EntityList::QueueManaged(Mob* sender, const EQApplicationPacket* app, bool
 
 void EntityList::QueueClientsStatus(Mob* sender, const EQApplicationPacket* app, bool ignore_sender, uint8 minstatus, uint8 maxstatus)
 {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -1881,7 +1862,7 @@ void EntityList::QueueClientsStatus(Mob* sender, const EQApplicationPacket* app,
 }
 
 void EntityList::DuelMessage(Mob* winner, Mob* loser, bool flee) {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	if(winner->GetLevelCon(winner->GetLevel(), loser->GetLevel()) > 2)
 	{
@@ -1905,7 +1886,7 @@ void EntityList::DuelMessage(Mob* winner, Mob* loser, bool flee) {
 }
 
 Client* EntityList::GetClientByName(const char *checkname) {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -1919,7 +1900,7 @@ Client* EntityList::GetClientByName(const char *checkname) {
 }
 
 Client* EntityList::GetClientByCharID(uint32 iCharID) {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements()) {
@@ -1933,7 +1914,7 @@ Client* EntityList::GetClientByCharID(uint32 iCharID) {
 }
 
 Client* EntityList::GetClientByWID(uint32 iWID) {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements()) {
@@ -1949,7 +1930,7 @@ Client* EntityList::GetRandomClient(float x, float y, float z, float Distance, C
 {
 	std::vector<Client*> ClientsInRange;
 
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -1969,7 +1950,7 @@ Client* EntityList::GetRandomClient(float x, float y, float z, float Distance, C
 }
 
 Corpse*	EntityList::GetCorpseByOwner(Client* client){
-	LinkedListIterator<Corpse*> iterator(corpse_list);
+	DenseListIterator<Corpse*> iterator(corpse_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -1986,7 +1967,7 @@ Corpse*	EntityList::GetCorpseByOwner(Client* client){
 }
 
 Corpse*	EntityList::GetCorpseByOwnerWithinRange(Client* client, Mob* center, int range){
-	LinkedListIterator<Corpse*> iterator(corpse_list);
+	DenseListIterator<Corpse*> iterator(corpse_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -2003,20 +1984,14 @@ Corpse*	EntityList::GetCorpseByOwnerWithinRange(Client* client, Mob* center, int
 }
 
 Corpse* EntityList::GetCorpseByID(uint16 id){
-	LinkedListIterator<Corpse*> iterator(corpse_list);
-	iterator.Reset();
-	while(iterator.MoreElements())
-	{
-		if (iterator.GetData()->id == id) {
-			return iterator.GetData();
-		}
-		iterator.Advance();
-	}
+	Entity *ent = id_slots.Get(id, EntitySlotCorpse);
+	if(ent)
+		return ent->CastToCorpse();
 	return 0;
 }
 
 Corpse* EntityList::GetCorpseByDBID(uint32 dbid){
-	LinkedListIterator<Corpse*> iterator(corpse_list);
+	DenseListIterator<Corpse*> iterator(corpse_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -2029,7 +2004,7 @@ Corpse* EntityList::GetCorpseByDBID(uint32 dbid){
 }
 
 Corpse* EntityList::GetCorpseByName(const char* name){
-	LinkedListIterator<Corpse*> iterator(corpse_list);
+	DenseListIterator<Corpse*> iterator(corpse_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -2043,7 +2018,7 @@ Corpse* EntityList::GetCorpseByName(const char* name){
 
 void EntityList::RemoveAllCorpsesByCharID(uint32 charid)
 {
-	LinkedListIterator<Corpse*> iterator(corpse_list);
+	DenseListIterator<Corpse*> iterator(corpse_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -2056,7 +2031,7 @@ void EntityList::RemoveAllCorpsesByCharID(uint32 charid)
 
 void EntityList::RemoveCorpseByDBID(uint32 dbid)
 {
-	LinkedListIterator<Corpse*> iterator(corpse_list);
+	DenseListIterator<Corpse*> iterator(corpse_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -2071,7 +2046,7 @@ int EntityList::RezzAllCorpsesByCharID(uint32 charid)
 {
 	int RezzExp = 0;
 
-	LinkedListIterator<Corpse*> iterator(corpse_list);
+	DenseListIterator<Corpse*> iterator(corpse_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -2231,7 +2206,7 @@ Raid* EntityList::GetRaidByMob(Mob* mob) {
 
 Client* EntityList::GetClientByAccID(uint32 accid)
 {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -2244,25 +2219,15 @@ Client* EntityList::GetClientByAccID(uint32 accid)
 	return 0;
 }
 Client* EntityList::GetClientByID(uint16 id) {
-	LinkedListIterator<Client*> iterator(client_list);
-
-	iterator.Reset();
-	while(iterator.MoreElements())
-	{
-		if (iterator.GetData())
-		{
-			if (iterator.GetData()->GetID() == id) {
-				return iterator.GetData();
-			}
-		}
-		iterator.Advance();
-	}
+	Entity *ent = id_slots.Get(id, EntitySlotClient);
+	if(ent)
+		return ent->CastToClient();
 	return 0;
 }
 
 void EntityList::ChannelMessageFromWorld(const char* from, const char* to, uint8 chan_num, uint32 guild_id, uint8 language, const char* message) {
 
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 	for(; iterator.MoreElements(); iterator.Advance())
@@ -2291,7 +2256,7 @@ void EntityList::Message(uint32 to_guilddbid, uint32 type, const char* message,
 	vsnprintf(buffer, 4096, message, argptr);
 	va_end(argptr);
 
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -2304,7 +2269,7 @@ void EntityList::Message(uint32 to_guilddbid, uint32 type, const char* message,
 }
 
 void EntityList::QueueClientsGuild(Mob* sender, const EQApplicationPacket* app, bool ignore_sender, uint32 guild_id){
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -2325,7 +2290,7 @@ void EntityList::QueueClientsGuildBankItemUpdate(const GuildBankItemUpdate_Struc
 
 	const Item_Struct *Item = database.GetItem(gbius->ItemID);
 
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 
@@ -2354,7 +2319,7 @@ void EntityList::MessageStatus(uint32 to_guild_id, int to_minstatus, uint32 type
 	vsnprintf(buffer, 4096, message, argptr);
 	va_end(argptr);
 
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements()) {
@@ -2369,7 +2334,7 @@ void EntityList::MessageStatus(uint32 to_guild_id, int to_minstatus, uint32 type
 void EntityList::MessageClose_StringID(Mob *sender, bool skipsender, float dist, uint32 type, uint32 string_id, const char* message1,const char* message2,const char* message3,const char* message4,const char* message5,const char* message6,const char* message7,const char* message8,const char* message9)
 {
 	Client *c;
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	float dist2 = dist * dist;
 
 
@@ -2384,7 +2349,7 @@ void EntityList::MessageClose_StringID(Mob *sender, bool skipsender, float dist,
 void EntityList::Message_StringID(Mob *sender, bool skipsender, uint32 type, uint32 string_id, const char* message1,const char* message2,const char* message3,const char* message4,const char* message5,const char* message6,const char* message7,const char* message8,const char* message9)
 {
 	Client *c;
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 
 	for(iterator.Reset(); iterator.MoreElements(); iterator.Advance())
@@ -2405,7 +2370,7 @@ void EntityList::MessageClose(Mob* sender, bool skipsender, float dist, uint32 t
 
 	float dist2 = dist * dist;
 
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -2418,19 +2383,22 @@ void EntityList::MessageClose(Mob* sender, bool skipsender, float dist, uint32 t
 }
 
 void EntityList::RemoveAllMobs(){
-	LinkedListIterator<Mob*> iterator(mob_list);
+	mob_grid.Clear();
+	DenseListIterator<Mob*> iterator(mob_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 		iterator.RemoveCurrent();
 }
 void EntityList::RemoveAllClients(){
-	LinkedListIterator<Client*> iterator(client_list);
+	client_grid.Clear();
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 		iterator.RemoveCurrent(false);
 }
 void EntityList::RemoveAllNPCs(){
-	LinkedListIterator<NPC*> iterator(npc_list);
+	npc_grid.Clear();
+	DenseListIterator<NPC*> iterator(npc_list);
 	iterator.Reset();
 	while(iterator.MoreElements()) {
 		iterator.RemoveCurrent(false);
@@ -2438,7 +2406,7 @@ void EntityList::RemoveAllNPCs(){
 	npc_limit_list.clear();
 }
 void EntityList::RemoveAllMercs(){
-	LinkedListIterator<Merc*> iterator(merc_list);
+	DenseListIterator<Merc*> iterator(merc_list);
 	iterator.Reset();
 	while(iterator.MoreElements()) {
 		iterator.RemoveCurrent(false);
@@ -2458,7 +2426,8 @@ void EntityList::RemoveAllRaids(){
 }
 
 void EntityList::RemoveAllDoors(){
-	LinkedListIterator<Doors*> iterator(door_list);
+	door_grid.Clear();
+	DenseListIterator<Doors*> iterator(door_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 		iterator.RemoveCurrent();
@@ -2472,7 +2441,7 @@ void EntityList::DespawnAllDoors(){
 }
 
 void EntityList::RespawnAllDoors(){
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -2487,19 +2456,19 @@ void EntityList::RespawnAllDoors(){
 }
 
 void EntityList::RemoveAllCorpses(){
-	LinkedListIterator<Corpse*> iterator(corpse_list);
+	DenseListIterator<Corpse*> iterator(corpse_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 		iterator.RemoveCurrent();
 }
 void EntityList::RemoveAllObjects(){
-	LinkedListIterator<Object*> iterator(object_list);
+	DenseListIterator<Object*> iterator(object_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 		iterator.RemoveCurrent();
 }
 void EntityList::RemoveAllTraps(){
-	LinkedListIterator<Trap*> iterator(trap_list);
+	DenseListIterator<Trap*> iterator(trap_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 		iterator.RemoveCurrent();
@@ -2507,7 +2476,7 @@ void EntityList::RemoveAllTraps(){
 bool EntityList::RemoveMob(uint16 delete_id){
 	if(delete_id==0)
 		return true;
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -2516,6 +2485,7 @@ bool EntityList::RemoveMob(uint16 delete_id){
 				entity_list.RemoveNPC(delete_id);
 			else if(iterator.GetData()->IsClient())
 				entity_list.RemoveClient(delete_id);
+			RemoveFromGrids(iterator.GetData());
 			iterator.RemoveCurrent();
 			return true;
 		}
@@ -2527,11 +2497,12 @@ bool EntityList::RemoveMob(uint16 delete_id){
 bool EntityList::RemoveMob(Mob *delete_mob) {
 	if(delete_mob==0)
 		return true;
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
 		if(iterator.GetData()==delete_mob){
+			RemoveFromGrids(delete_mob);
 			iterator.RemoveCurrent();
 			return true;
 		}
@@ -2541,13 +2512,14 @@ bool EntityList::RemoveMob(Mob *delete_mob) {
 }
 
 bool EntityList::RemoveNPC(uint16 delete_id){
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
 		if(iterator.GetData()->GetID()==delete_id){
 			//make sure its proximity is removed
 			RemoveProximity(iterator.GetData()->GetID());
+			npc_grid.Remove(iterator.GetData());
 			//take it out of the list
 			iterator.RemoveCurrent(false);//Already Deleted
 			//take it out of our limit list
@@ -2560,7 +2532,7 @@ bool EntityList::RemoveNPC(uint16 delete_id){
 	return false;
 }
 bool EntityList::RemoveMerc(uint16 delete_id){
-	LinkedListIterator<Merc*> iterator(merc_list);
+	DenseListIterator<Merc*> iterator(merc_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -2573,11 +2545,12 @@ bool EntityList::RemoveMerc(uint16 delete_id){
 	return false;
 }
 bool EntityList::RemoveClient(uint16 delete_id){
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
 		if(iterator.GetData()->GetID()==delete_id){
+			client_grid.Remove(iterator.GetData());
 			iterator.RemoveCurrent(false);//Already Deleted
 			return true;
 		}
@@ -2587,11 +2560,12 @@ bool EntityList::RemoveClient(uint16 delete_id){
 }
 
 bool EntityList::RemoveClient(Client *delete_client){
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
 		if(iterator.GetData()==delete_client){
+			client_grid.Remove(delete_client);
 			iterator.RemoveCurrent(false);//Already Deleted
 			return true;
 		}
@@ -2601,7 +2575,7 @@ bool EntityList::RemoveClient(Client *delete_client){
 }
 
 bool EntityList::RemoveObject(uint16 delete_id){
-	LinkedListIterator<Object*> iterator(object_list);
+	DenseListIterator<Object*> iterator(object_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -2614,7 +2588,7 @@ bool EntityList::RemoveObject(uint16 delete_id){
 	return false;
 }
 bool EntityList::RemoveTrap(uint16 delete_id){
-	LinkedListIterator<Trap*> iterator(trap_list);
+	DenseListIterator<Trap*> iterator(trap_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -2627,11 +2601,12 @@ bool EntityList::RemoveTrap(uint16 delete_id){
 	return false;
 }
 bool EntityList::RemoveDoor(uint16 delete_id){
-	LinkedListIterator<Doors*> iterator(door_list);
+	DenseListIterator<Doors*> iterator(door_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
 		if(iterator.GetData()->GetID()==delete_id){
+			door_grid.Remove(iterator.GetData());
 			iterator.RemoveCurrent();
 			return true;
 		}
@@ -2640,7 +2615,7 @@ bool EntityList::RemoveDoor(uint16 delete_id){
 	return false;
 }
 bool EntityList::RemoveCorpse(uint16 delete_id){
-	LinkedListIterator<Corpse*> iterator(corpse_list);
+	DenseListIterator<Corpse*> iterator(corpse_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -2702,13 +2677,14 @@ void EntityList::Clear()
 	entity_list.RemoveAllObjects();
 	entity_list.RemoveAllRaids();
 	entity_list.RemoveAllLocalities();
+	id_slots.Clear();
 	last_insert_id = 0;
 }
 
 void EntityList::UpdateWho(bool iSendFullUpdate) {
 	if ((!worldserver.Connected()) || !ZoneLoaded)
 		return;
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	uint32 tmpNumUpdates = numclients + 5;
 	ServerPacket* pack = 0;
 	ServerClientListKeepAlive_Struct* sclka = 0;
@@ -2781,7 +2757,7 @@ void EntityList::Process()
 }
 
 void EntityList::CountNPC(uint32* NPCCount, uint32* NPCLootCount, uint32* gmspawntype_count) {
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 	*NPCCount = 0;
 	*NPCLootCount = 0;
 
@@ -2803,7 +2779,7 @@ void EntityList::DoZoneDump(ZSDump_Spawn2* spawn2_dump, ZSDump_NPC* npc_dump, ZS
 	uint32 gmspawntype_index = 0;
 
 	if (npc_dump != 0) {
-		LinkedListIterator<NPC*> iterator(npc_list);
+		DenseListIterator<NPC*> iterator(npc_list);
 		NPC* npc = 0;
 		iterator.Reset();
 		while(iterator.MoreElements())
@@ -2848,7 +2824,7 @@ void EntityList::DoZoneDump(ZSDump_Spawn2* spawn2_dump, ZSDump_NPC* npc_dump, ZS
 }
 
 void EntityList::Depop(bool StartSpawnTimer) {
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 
 	iterator.Reset();
 	for(; iterator.MoreElements(); iterator.Advance())
@@ -2869,7 +2845,7 @@ void EntityList::Depop(bool StartSpawnTimer) {
 }
 
 void EntityList::DepopAll(int NPCTypeID, bool StartSpawnTimer) {
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 
 	iterator.Reset();
 	for(; iterator.MoreElements(); iterator.Advance())
@@ -2881,7 +2857,7 @@ void EntityList::DepopAll(int NPCTypeID, bool StartSpawnTimer) {
 }
 
 void EntityList::SendTraders(Client* client){
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	Client* trader;
 	while(iterator.MoreElements()) {
@@ -2897,7 +2873,7 @@ void EntityList::SendTraders(Client* client){
 }
 
 void EntityList::RemoveFromHateLists(Mob* mob, bool settoone) {
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements()) {
@@ -2917,7 +2893,7 @@ void EntityList::RemoveFromHateLists(Mob* mob, bool settoone) {
 
 void EntityList::RemoveDebuffs(Mob* caster)
 {
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -2933,7 +2909,7 @@ void EntityList::RemoveDebuffs(Mob* caster)
 // all updates into one packet.
 void EntityList::SendPositionUpdates(Client* client, uint32 cLastUpdate, float range, Entity* alwayssend, bool iSendEvenIfNotChanged) {
 	range = range * range;
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 
 	EQApplicationPacket* outapp = 0;
 	PlayerPositionUpdateServer_Struct* ppu = 0;
@@ -2973,7 +2949,7 @@ char* EntityList::MakeNameUnique(char* name) {
 	memset(used, 0, sizeof(used));
 	name[61] = 0; name[62] = 0; name[63] = 0;
 
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 
 	iterator.Reset();
 	int len = strlen(name);
@@ -3024,7 +3000,7 @@ void EntityList::ListNPCs(Client* client, const char* arg1, const char* arg2, ui
 		searchtype = 0;
 	else if (arg2 == 0 && searchtype >= 2)
 		searchtype = 0;
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 	uint32 x = 0;
 	uint32 z = 0;
 	char sName[36];
@@ -3075,7 +3051,7 @@ void EntityList::ListNPCs(Client* client, const char* arg1, const char* arg2, ui
 }
 
 void EntityList::ListNPCCorpses(Client* client) {
-	LinkedListIterator<Corpse*> iterator(corpse_list);
+	DenseListIterator<Corpse*> iterator(corpse_list);
 	uint32 x = 0;
 
 	iterator.Reset();
@@ -3091,7 +3067,7 @@ void EntityList::ListNPCCorpses(Client* client) {
 }
 
 void EntityList::ListPlayerCorpses(Client* client) {
-	LinkedListIterator<Corpse*> iterator(corpse_list);
+	DenseListIterator<Corpse*> iterator(corpse_list);
 	uint32 x = 0;
 
 	iterator.Reset();
@@ -3111,7 +3087,7 @@ void EntityList::FindPathsToAllNPCs()
 	if(!zone->pathing)
 		return;
 
-	LinkedListIterator<NPC*> Iterator(npc_list);
+	DenseListIterator<NPC*> Iterator(npc_list);
 
 	Iterator.Reset();
 
@@ -3134,7 +3110,7 @@ void EntityList::FindPathsToAllNPCs()
 
 // returns the number of corpses deleted. A negative number indicates an error code.
 int32 EntityList::DeleteNPCCorpses() {
-	LinkedListIterator<Corpse*> iterator(corpse_list);
+	DenseListIterator<Corpse*> iterator(corpse_list);
 	int32 x = 0;
 
 	iterator.Reset();
@@ -3150,7 +3126,7 @@ int32 EntityList::DeleteNPCCorpses() {
 
 // returns the number of corpses deleted. A negative number indicates an error code.
 int32 EntityList::DeletePlayerCorpses() {
-	LinkedListIterator<Corpse*> iterator(corpse_list);
+	DenseListIterator<Corpse*> iterator(corpse_list);
 	int32 x = 0;
 
 	iterator.Reset();
@@ -3164,7 +3140,7 @@ int32 EntityList::DeletePlayerCorpses() {
 	return x;
 }
 void EntityList::SendPetitionToAdmins(){
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	EQApplicationPacket* outapp = new EQApplicationPacket(OP_PetitionUpdate,sizeof(PetitionUpdate_Struct));
 	PetitionUpdate_Struct* pcus = (PetitionUpdate_Struct*) outapp->pBuffer;
 	pcus->petnumber = 0;		// Petition Number
@@ -3183,7 +3159,7 @@ void EntityList::SendPetitionToAdmins(){
 	safe_delete(outapp);
 }
 void EntityList::SendPetitionToAdmins(Petition* pet) {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	EQApplicationPacket* outapp = new EQApplicationPacket(OP_PetitionUpdate,sizeof(PetitionUpdate_Struct));
 	PetitionUpdate_Struct* pcus = (PetitionUpdate_Struct*) outapp->pBuffer;
@@ -3227,7 +3203,7 @@ void EntityList::ClearClientPetitionQueue() {
 	strcpy(pet->gmsenttoo, "");
 	strcpy(pet->charname, "");
 	pet->quetotal = petition_list.GetTotalPetitions();
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -3245,7 +3221,7 @@ void EntityList::ClearClientPetitionQueue() {
 }
 
 void EntityList::WriteEntityIDs() {
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -3299,7 +3275,7 @@ void BulkZoneSpawnPacket::SendBuffer() {
 
 void EntityList::DoubleAggro(Mob* who)
 {
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -3311,7 +3287,7 @@ void EntityList::DoubleAggro(Mob* who)
 
 void EntityList::HalveAggro(Mob* who)
 {
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -3326,7 +3302,7 @@ void EntityList::Evade(Mob *who)
 {
 	uint32 flatval = who->GetLevel() * 13;
 	int amt = 0;
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -3344,7 +3320,7 @@ void EntityList::Evade(Mob *who)
 
 //removes "targ" from all hate lists, including feigned, in the zone
 void EntityList::ClearAggro(Mob* targ) {
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 	iterator.Reset();
 	while(iterator.MoreElements()) {
 		if (iterator.GetData()->CheckAggro(targ))
@@ -3356,7 +3332,7 @@ void EntityList::ClearAggro(Mob* targ) {
 
 void EntityList::ClearFeignAggro(Mob* targ)
 {
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -3387,7 +3363,7 @@ void EntityList::ClearFeignAggro(Mob* targ)
 // EverHood 6/17/06
 void EntityList::ClearZoneFeignAggro(Client* targ)
 {
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -3398,7 +3374,7 @@ void EntityList::ClearZoneFeignAggro(Client* targ)
 }
 
 void EntityList::AggroZone(Mob* who, int hate) {
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -3410,7 +3386,7 @@ void EntityList::AggroZone(Mob* who, int hate) {
 // Signal Quest command function
 void EntityList::SignalMobsByNPCID(uint32 snpc, int signal_id)
 {
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -3455,7 +3431,7 @@ bool EntityList::MakeTrackPacket(Client* client)
 
 	uint32 array_counter = 0;
 
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	iterator.Reset();
 
 	Group *g = client->GetGroup();
@@ -3515,7 +3491,7 @@ void EntityList::MessageGroup(Mob* sender, bool skipclose, uint32 type, const ch
 	if (skipclose)
 		dist2 = 0;
 
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -3529,7 +3505,7 @@ void EntityList::MessageGroup(Mob* sender, bool skipclose, uint32 type, const ch
 
 
 bool EntityList::Fighting(Mob* targ) {
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -3544,7 +3520,7 @@ bool EntityList::Fighting(Mob* targ) {
 
 void EntityList::AddHealAggro(Mob* target, Mob* caster, uint16 thedam)
 {
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 
 	iterator.Reset();
 	NPC *cur = nullptr;
@@ -3613,10 +3589,12 @@ void EntityList::AddHealAggro(Mob* target, Mob* caster, uint16 thedam)
 
 void EntityList::OpenDoorsNear(NPC* who)
 {
-	LinkedListIterator<Doors*> iterator(door_list);
-	iterator.Reset();
-	while(iterator.MoreElements()) {
-		Doors *cdoor = iterator.GetData();
+	std::vector<Doors*> candidates;
+	door_grid.GetInRange(who->GetX(), who->GetY(), 10, candidates);
+
+	std::vector<Doors*>::iterator iterator;
+	for(iterator = candidates.begin(); iterator != candidates.end(); ++iterator) {
+		Doors *cdoor = *iterator;
 		if(cdoor && !cdoor->IsDoorOpen()) {
 			float zdiff = who->GetZ() - cdoor->GetZ();
 			if(zdiff < 0)
@@ -3630,13 +3608,17 @@ void EntityList::OpenDoorsNear(NPC* who)
 				cdoor->NPCOpen(who);
 			}
 		}
-		iterator.Advance();
 	}
 }
 
+void EntityList::DoorMoved(Doors* door)
+{
+	door_grid.Update(door);
+}
+
 void EntityList::SendAlarm(Trap* trap, Mob* currenttarget, uint8 kos)
 {
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 	iterator.Reset();
 
 	float val2 = trap->effectvalue * trap->effectvalue;
@@ -3682,7 +3664,7 @@ void EntityList::AddProximity(NPC *proximity_for) {
 }
 
 bool EntityList::RemoveProximity(uint16 delete_npc_id) {
-	LinkedListIterator<NPC*> iterator(proximity_list);
+	DenseListIterator<NPC*> iterator(proximity_list);
 	iterator.Reset();
 	while(iterator.MoreElements()) {
 		NPC *d = iterator.GetData();
@@ -3697,7 +3679,7 @@ bool EntityList::RemoveProximity(uint16 delete_npc_id) {
 }
 
 void EntityList::RemoveAllLocalities() {
-	LinkedListIterator<NPC*> iterator(proximity_list);
+	DenseListIterator<NPC*> iterator(proximity_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 		iterator.RemoveCurrent(false);
@@ -3708,7 +3690,7 @@ void EntityList::ProcessMove(Client *c, float x, float y, float z) {
 		We look through each proximity, looking to see if last_* was in(out)
 		the proximity, and the new supplied coords are out(in)...
 	*/
-	LinkedListIterator<NPC*> iterator(proximity_list);
+	DenseListIterator<NPC*> iterator(proximity_list);
 	std::list<int> skip_ids;
 
 	float last_x = c->ProximityX();
@@ -3782,7 +3764,7 @@ void EntityList::ProcessProximitySay(const char *Message, Client *c, uint8 langu
 	if(!Message || !c)
 		return;
 
-	LinkedListIterator<NPC*> iterator(proximity_list);
+	DenseListIterator<NPC*> iterator(proximity_list);
 
 	for(iterator.Reset(); iterator.MoreElements(); iterator.Advance()) {
 		NPC *d = iterator.GetData();
@@ -3803,7 +3785,7 @@ void EntityList::SaveAllClientsTaskState() {
 
 	if(!taskmanager) return;
 
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -3820,7 +3802,7 @@ void EntityList::ReloadAllClientsTaskState(int TaskID) {
 
 	if(!taskmanager) return;
 
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -3840,7 +3822,7 @@ void EntityList::ReloadAllClientsTaskState(int TaskID) {
 }
 
 bool EntityList::IsMobInZone(Mob *who) {
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -3953,7 +3935,7 @@ bool EntityList::LimitCheckBoth(uint32 npc_type, uint32 spawngroup_id, int group
 
 bool EntityList::LimitCheckName(const char *npc_name)
 {
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -3973,7 +3955,7 @@ bool EntityList::LimitCheckName(const char *npc_name)
 void EntityList::RadialSetLogging(Mob *around, bool enabled, bool clients, bool non_clients, float range) {
 	float range2 = range * range;
 
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	iterator.Reset();
 	while(iterator.MoreElements()) {
 		Mob* mob = iterator.GetData();
@@ -3999,7 +3981,7 @@ void EntityList::RadialSetLogging(Mob *around, bool enabled, bool clients, bool
 }
 
 void EntityList::UpdateHoTT(Mob* target) {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -4016,7 +3998,7 @@ void EntityList::UpdateHoTT(Mob* target) {
 
 void EntityList::DestroyTempPets(Mob *owner)
 {
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -4062,7 +4044,7 @@ bool Entity::CheckCoordLosNoZLeaps(float cur_x, float cur_y, float cur_z, float
 void EntityList::QuestJournalledSayClose(Mob *sender, Client *QuestInitiator, float dist, const char* mobname, const char* message)
 {
 	Client *c;
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	float dist2 = dist * dist;
 
 	// Send the message to the quest initiator such that the client will enter it into the NPC Quest Journal
@@ -4090,7 +4072,7 @@ Corpse* EntityList::GetClosestCorpse(Mob* sender, const char* Name)
 
 	Corpse *CurrentCorpse, *ClosestCorpse = nullptr;
 
-	LinkedListIterator<Corpse*> iterator(corpse_list);
+	DenseListIterator<Corpse*> iterator(corpse_list);
 
 	iterator.Reset();
 
@@ -4118,7 +4100,7 @@ Corpse* EntityList::GetClosestCorpse(Mob* sender, const char* Name)
 }
 
 void EntityList::ForceGroupUpdate(uint32 gid) {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements()) {
@@ -4137,7 +4119,7 @@ void EntityList::ForceGroupUpdate(uint32 gid) {
 }
 
 void EntityList::SendGroupLeave(uint32 gid, const char *name) {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	while(iterator.MoreElements()) {
 		Client *c = iterator.GetData();
@@ -4168,7 +4150,7 @@ void EntityList::SendGroupLeave(uint32 gid, const char *name) {
 }
 
 void EntityList::SendGroupJoin(uint32 gid, const char *name) {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	while(iterator.MoreElements()) {
 		if(iterator.GetData()){
@@ -4197,7 +4179,7 @@ void EntityList::SendGroupJoin(uint32 gid, const char *name) {
 
 void EntityList::GroupMessage(uint32 gid, const char *from, const char *message)
 {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	while(iterator.MoreElements()) {
 		if(iterator.GetData()){
@@ -4269,7 +4251,7 @@ Mob* EntityList::GetTargetForMez(Mob* caster)
 	if(!caster)
 		return nullptr;
 
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	iterator.Reset();
 	//TODO: make this smarter and not mez targets being damaged by dots
 	while(iterator.MoreElements()) {
@@ -4311,7 +4293,7 @@ void EntityList::SendZoneAppearance(Client *c)
 	if(!c)
 		return;
 
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	iterator.Reset();
 	while(iterator.MoreElements()) {
 		Mob *cur = iterator.GetData();
@@ -4341,7 +4323,7 @@ void EntityList::SendNimbusEffects(Client *c)
 	if(!c)
 		return;
 
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	iterator.Reset();
 	while(iterator.MoreElements()) {
 		Mob *cur = iterator.GetData();
@@ -4375,7 +4357,7 @@ void EntityList::SendUntargetable(Client *c)
 	if(!c)
 		return;
 
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	iterator.Reset();
 	while(iterator.MoreElements()) {
 		Mob *cur = iterator.GetData();
@@ -4405,7 +4387,7 @@ void EntityList::ZoneWho(Client *c, Who_All_Struct* Who) {
 
 	uint8 WhomLength = strlen(Who->whom);
 
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 
@@ -4641,7 +4623,7 @@ void EntityList::UnMarkNPC(uint16 ID)
 	// each group to remove the dead mobs entity ID from the groups list of NPCs marked via the
 	// Group Leadership AA Mark NPC ability.
 	//
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 
@@ -4662,61 +4644,47 @@ void EntityList::UnMarkNPC(uint16 ID)
 
 uint32 EntityList::CheckNPCsClose(Mob *center)
 {
-	LinkedListIterator<NPC*> iterator(npc_list);
+	//the rule is compared against the squared distance
+	float range2 = RuleR(Adventure, DistanceForRescueAccept);
 	uint32 count = 0;
 
-	iterator.Reset();
-	while(iterator.MoreElements())
+	std::vector<Mob*> candidates;
+	npc_grid.GetInRange(center->GetX(), center->GetY(), sqrtf(range2), candidates);
+
+	std::vector<Mob*>::iterator iterator;
+	for(iterator = candidates.begin(); iterator != candidates.end(); ++iterator)
 	{
-		NPC *current = iterator.GetData();
-		if(!current)
-		{
-			iterator.Advance();
-			continue;
-		}
+		NPC *current = (*iterator)->CastToNPC();
 
 		if(current == center)
-		{
-			iterator.Advance();
 			continue;
-		}
 
 		if(current->IsPet())
-		{
-			iterator.Advance();
 			continue;
-		}
 
 		if(current->GetClass() == LDON_TREASURE)
-		{
-			iterator.Advance();
 			continue;
-		}
 
 		if(current->GetBodyType() == BT_NoTarget ||
 			current->GetBodyType() == BT_Special)
-		{
-			iterator.Advance();
 			continue;
-		}
 
 		float xDiff = current->GetX() - center->GetX();
 		float yDiff = current->GetY() - center->GetY();
 		float zDiff = current->GetZ() - center->GetZ();
 		float dist = ((xDiff * xDiff) + (yDiff * yDiff) + (zDiff * zDiff));
 
-		if(dist <= RuleR(Adventure, DistanceForRescueAccept))
+		if(dist <= range2)
 		{
 			count++;
 		}
-		iterator.Advance();
 	}
 	return count;
 }
 
 void EntityList::GateAllClients()
 {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -4731,7 +4699,7 @@ void EntityList::GateAllClients()
 
 void EntityList::SignalAllClients(uint32 data)
 {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -4747,7 +4715,7 @@ void EntityList::SignalAllClients(uint32 data)
 void EntityList::GetMobList(std::list<Mob*> &m_list)
 {
 	m_list.clear();
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -4760,7 +4728,7 @@ void EntityList::GetMobList(std::list<Mob*> &m_list)
 void EntityList::GetNPCList(std::list<NPC*> &n_list)
 {
 	n_list.clear();
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -4773,7 +4741,7 @@ void EntityList::GetNPCList(std::list<NPC*> &n_list)
 void EntityList::GetClientList(std::list<Client*> &c_list)
 {
 	c_list.clear();
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -4786,7 +4754,7 @@ void EntityList::GetClientList(std::list<Client*> &c_list)
 void EntityList::GetCorpseList(std::list<Corpse*> &c_list)
 {
 	c_list.clear();
-	LinkedListIterator<Corpse*> iterator(corpse_list);
+	DenseListIterator<Corpse*> iterator(corpse_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -4799,7 +4767,7 @@ void EntityList::GetCorpseList(std::list<Corpse*> &c_list)
 void EntityList::GetObjectList(std::list<Object*> &o_list)
 {
 	o_list.clear();
-	LinkedListIterator<Object*> iterator(object_list);
+	DenseListIterator<Object*> iterator(object_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -4812,7 +4780,7 @@ void EntityList::GetObjectList(std::list<Object*> &o_list)
 void EntityList::GetDoorsList(std::list<Doors*> &o_list)
 {
 	o_list.clear();
-	LinkedListIterator<Doors*> iterator(door_list);
+	DenseListIterator<Doors*> iterator(door_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -4824,7 +4792,7 @@ void EntityList::GetDoorsList(std::list<Doors*> &o_list)
 
 void EntityList::UpdateQGlobal(uint32 qid, QGlobal newGlobal)
 {
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -4861,7 +4829,7 @@ void EntityList::UpdateQGlobal(uint32 qid, QGlobal newGlobal)
 
 void EntityList::DeleteQGlobal(std::string name, uint32 npcID, uint32 charID, uint32 zoneID)
 {
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -4904,7 +4872,7 @@ void EntityList::SendFindableNPCList(Client *c)
 	fnpcs->Action = 0;
 
 
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -4955,7 +4923,7 @@ void EntityList::UpdateFindableNPCState(NPC *n, bool Remove)
 
 	fnpcs->Class = n->GetClass();
 
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 
@@ -4992,7 +4960,7 @@ void EntityList::HideCorpses(Client *c, uint8 CurrentMode, uint8 NewMode)
 			NewMode = HideCorpseAll;
 	}
 
-	LinkedListIterator<Corpse*> iterator(corpse_list);
+	DenseListIterator<Corpse*> iterator(corpse_list);
 
 	iterator.Reset();
 
@@ -5035,7 +5003,7 @@ void EntityList::AddLootToNPCS(uint32 item_id, uint32 count)
 		return;
 
 	int npc_count = 0;
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -5129,7 +5097,7 @@ NPC* EntityList::GetClosestBanker(Mob* sender, uint32 &distance)
 	distance = 4294967295u;
 	NPC* nc = nullptr;
 
-	LinkedListIterator<NPC*> iterator(npc_list);
+	DenseListIterator<NPC*> iterator(npc_list);
 	iterator.Reset();
 
 	while(iterator.MoreElements())
@@ -5154,7 +5122,7 @@ void EntityList::ExpeditionWarning(uint32 minutes_left)
 	ExpeditionExpireWarning *ew = (ExpeditionExpireWarning*)outapp->pBuffer;
 	ew->minutes_remaining = minutes_left;
 
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	while(iterator.MoreElements())
 	{
@@ -5174,7 +5142,7 @@ Mob* EntityList::GetClosestMobByBodyType(Mob* sender, bodyType BodyType)
 
 	Mob *CurrentMob, *ClosestMob = nullptr;
 
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 
 	iterator.Reset();
 
@@ -5203,16 +5171,16 @@ Mob* EntityList::GetClosestMobByBodyType(Mob* sender, bodyType BodyType)
 
 void EntityList::GetTargetsForConeArea(Mob *start, uint32 radius, uint32 height, std::list<Mob*> &m_list)
 {
-	LinkedListIterator<Mob*> iterator(mob_list);
-	iterator.Reset();
-	while(iterator.MoreElements())
+	std::vector<Mob*> candidates;
+	//+1 covers the int32 truncation of the diffs below
+	mob_grid.GetInRange(start->GetX(), start->GetY(), radius + 1, candidates);
+
+	std::vector<Mob*>::iterator iterator;
+	for(iterator = candidates.begin(); iterator != candidates.end(); ++iterator)
 	{
-		Mob *ptr = iterator.GetData();
+		Mob *ptr = *iterator;
 		if(ptr == start)
-		{
-			iterator.Advance();
 			continue;
-		}
 		int32 x_diff = ptr->GetX() - start->GetX();
 		int32 y_diff = ptr->GetY() - start->GetY();
 		int32 z_diff = ptr->GetZ() - start->GetZ();
@@ -5228,14 +5196,12 @@ void EntityList::GetTargetsForConeArea(Mob *start, uint32 radius, uint32 height,
 				m_list.push_back(ptr);
 			}
 		}
-
-		iterator.Advance();
 	}
 }
 
 Client* EntityList::FindCorpseDragger(const char *CorpseName)
 {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 
@@ -5255,7 +5221,7 @@ Mob* EntityList::GetTargetForVirus(Mob* spreader)
 	int max_spread_range = RuleI(Spells, VirusSpreadDistance);
 
 	std::vector<Mob*> TargetsInRange;
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -20,6 +20,7 @@
 
 #include "../common/types.h"
 #include "../common/linked_list.h"
+#include "../common/dense_list.h"
 #include "../common/servertalk.h"
 #include "../common/bodytypes.h"
 #include "../common/eq_constants.h"
@@ -28,6 +29,8 @@
 #include "zonedump.h"
 #include "zonedbasync.h"
 #include "QGlobals.h"
+#include "entity_grid.h"
+#include "entity_slots.h"
 
 // max number of newspawns to send per bulk packet
 #define SPAWNS_PER_POINT_DATARATE 10
@@ -132,6 +135,11 @@ public:
 	~EntityList();
 
 	Entity* GetID(uint16 id);
+	uint32	GetEntityHandle(uint16 id) const { return(id_slots.GetHandle(id)); }
+	Entity*	GetEntityByHandle(uint32 handle) const { return(id_slots.GetByHandle(handle)); }
+	//called from Entity::SetID and ~Entity to keep the id table current
+	void	ClaimEntityID(Entity *ent);
+	void	ReleaseEntityID(Entity *ent);
 	Mob*	GetMob(uint16 id);
 	inline Mob*	GetMobID(uint16 id) { return(GetMob(id)); }	//for perl
 	Mob*	GetMob(const char* name);
@@ -177,7 +185,7 @@ public:
 	bool CanAddHateForMob(Mob *p);
 	void	SendGuildMOTD(uint32 guild_id);
 	void	SendGuildSpawnAppearance(uint32 guild_id);
-	void	SendGuildMembers(uint32 guild_id);
+	void	SendGuildMembers(uint32 guild_id, const EQApplicationPacket *delta = nullptr);	//delta goes instead of the whole list to clients that apply it
 	void	RefreshAllGuildInfo(uint32 guild_id);
 	void	SendGuildList();
 //	void	SendGuildJoin(GuildJoin_Struct* gj);
@@ -310,6 +318,7 @@ public:
 	void	AddHealAggro(Mob* target, Mob* caster, uint16 thedam);
 	Mob*	FindDefenseNPC(uint32 npcid);
 	void	OpenDoorsNear(NPC* opener);
+	void	DoorMoved(Doors* door);
 	void	UpdateWho(bool iSendFullUpdate = false);
 	void	SendPositionUpdates(Client* client, uint32 cLastUpdate = 0, float range = 0, Entity* alwayssend = 0, bool iSendEvenIfNotChanged = false);
 	char*	MakeNameUnique(char* name);
@@ -397,6 +406,15 @@ public:
 	void GetDoorsList(std::list<Doors*> &d_list);
 	void GetTargetsForConeArea(Mob *start, uint32 radius, uint32 height, std::list<Mob*> &m_list);
 
+	//proximity index, see entity_grid.h
+	void	GetMobsInRange(float x, float y, float range, std::vector<Mob*> &out) const { mob_grid.GetInRange(x, y, range, out); }
+	void	GetClientsInRange(float x, float y, float range, std::vector<Mob*> &out) const { client_grid.GetInRange(x, y, range, out); }
+	void	GetNPCsInRange(float x, float y, float range, std::vector<Mob*> &out) const { npc_grid.GetInRange(x, y, range, out); }
+	float	GetNPCReach() const { return(npc_reach > npc_reach_pass ? npc_reach : npc_reach_pass); }
+	void	GetGridStats(uint32 &mobs, uint32 &cells) const { mobs = mob_grid.Count(); cells = mob_grid.CellCount(); }
+	//moves mob to its current cell, MobProcess does it every tick, anything that jumps a mob does it at once
+	void	UpdateGrids(Mob *mob);
+
 	void	DepopAll(int NPCTypeID, bool StartSpawnTimer = true);
 
 	uint16 GetFreeID();
@@ -410,6 +428,7 @@ protected:
 private:
 	void	AddToSpawnQueue(uint16 entityid, NewSpawn_Struct** app);
 	void	CheckSpawnQueue();
+	void	RemoveFromGrids(Mob *mob);
 
 	//used for limiting spawns
 	class SpawnLimitRecord { public: uint32 spawngroup_id; uint32 npc_type; };
@@ -419,20 +438,31 @@ private:
 	uint32	NumSpawnsOnQueue;
 	LinkedList<NewSpawn_Struct*> SpawnQueue;
 
-	LinkedList<Client*> client_list;
-	LinkedList<Mob*> mob_list;
-	LinkedList<NPC*> npc_list;
-	LinkedList<Merc *> merc_list;
+	DenseList<Client*> client_list;
+	DenseList<Mob*> mob_list;
+	DenseList<NPC*> npc_list;
+	DenseList<Merc *> merc_list;
 	std::list<Group*> group_list;
-	LinkedList<Corpse*> corpse_list;
-	LinkedList<Object*> object_list;
-	LinkedList<Doors*> door_list;
-	LinkedList<Trap*> trap_list;
-	LinkedList<Beacon*> beacon_list;
-	LinkedList<NPC *> proximity_list;
+	DenseList<Corpse*> corpse_list;
+	DenseList<Object*> object_list;
+	DenseList<Doors*> door_list;
+	DenseList<Trap*> trap_list;
+	DenseList<Beacon*> beacon_list;
+	DenseList<NPC *> proximity_list;
 	std::list<Raid *> raid_list;
 	uint16 last_insert_id;
 
+	//spatial indexes over the lists above, kept in step by Add*/Remove* and MobProcess
+	EntityGrid<Mob> mob_grid;
+	EntityGrid<Mob> npc_grid;
+	EntityGrid<Mob> client_grid;
+	EntityGrid<Doors> door_grid;
+	float npc_reach;		//largest npc aggro/assist range seen on the last MobProcess pass
+	float npc_reach_pass;	//running max for the pass in progress
+
+	//id -> entity, see entity_slots.h
+	EntitySlotTable<Entity> id_slots;
+
 	// Please Do Not Declare Any EntityList Class Members After This Comment
 #ifdef BOTS
 	public:
@@ -0,0 +1,168 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemu.org)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef ENTITY_GRID_H
+#define ENTITY_GRID_H
+
+#include "../common/types.h"
+#include <math.h>
+#include <vector>
+#include <unordered_map>
+
+//width of one grid cell in world units. Aggro and assist ranges are
+//usually well under this, so most queries only touch 4 cells.
+#define ENTITY_GRID_CELL_SIZE 200.0f
+
+/*
+	Uniform 2D spatial hash over anything with GetX()/GetY().
+
+	Only occupied cells are stored, so the size of a zone doesn't matter.
+	Entities are re-bucketed by Update() whenever they cross a cell
+	boundary; the entity list does that once per mob per tick, right after
+	Process() moves it, and anything that jumps a mob somewhere else
+	(GMMove, Warp, Teleport, zone-in) does it straight away.
+
+	Queries are coarse: they return every entity in the cells touched by
+	the square around the point, and the caller applies its own exact
+	distance test. Z is not indexed.
+*/
+template<class T>
+class EntityGrid
+{
+public:
+	EntityGrid(float cell_size = ENTITY_GRID_CELL_SIZE) : cell_size(cell_size), inv_cell_size(1.0f / cell_size) { }
+
+	void Insert(T *ent)
+	{
+		if(ent == nullptr || slots.count(ent))
+			return;
+		uint64 key = CellKey(ent->GetX(), ent->GetY());
+		Bucket &bucket = cells[key];
+		Slot s;
+		s.cell = key;
+		s.index = bucket.size();
+		bucket.push_back(ent);
+		slots[ent] = s;
+	}
+
+	void Remove(T *ent)
+	{
+		typename SlotMap::iterator it = slots.find(ent);
+		if(it == slots.end())
+			return;
+		Unlink(it->second);
+		slots.erase(it);
+	}
+
+	//moves ent to the cell matching its current position, if it changed
+	void Update(T *ent)
+	{
+		typename SlotMap::iterator it = slots.find(ent);
+		if(it == slots.end())
+			return;
+		uint64 key = CellKey(ent->GetX(), ent->GetY());
+		if(key == it->second.cell)
+			return;
+		Unlink(it->second);
+		Bucket &bucket = cells[key];
+		it->second.cell = key;
+		it->second.index = bucket.size();
+		bucket.push_back(ent);
+	}
+
+	void Clear()
+	{
+		cells.clear();
+		slots.clear();
+	}
+
+	bool Contains(T *ent) const { return(slots.count(ent) != 0); }
+	uint32 Count() const { return(slots.size()); }
+	uint32 CellCount() const { return(cells.size()); }
+
+	//appends every entity whose cell overlaps the square of half width
+	//range centered on x,y. The result is a superset of the entities in range.
+	void GetInRange(float x, float y, float range, std::vector<T*> &out) const
+	{
+		if(range < 0)
+			range = 0;
+		int32 minx = CellCoord(x - range);
+		int32 maxx = CellCoord(x + range);
+		int32 miny = CellCoord(y - range);
+		int32 maxy = CellCoord(y + range);
+
+		uint64 span = uint64(maxx - minx + 1) * uint64(maxy - miny + 1);
+		if(span >= cells.size()) {
+			//cheaper to walk the occupied cells than to probe the empty ones
+			typename CellMap::const_iterator it;
+			for(it = cells.begin(); it != cells.end(); ++it) {
+				int32 cx = int32(uint32(it->first >> 32));
+				int32 cy = int32(uint32(it->first));
+				if(cx < minx || cx > maxx || cy < miny || cy > maxy)
+					continue;
+				out.insert(out.end(), it->second.begin(), it->second.end());
+			}
+			return;
+		}
+
+		int32 cx, cy;
+		for(cx = minx; cx <= maxx; cx++) {
+			for(cy = miny; cy <= maxy; cy++) {
+				typename CellMap::const_iterator it = cells.find(MakeKey(cx, cy));
+				if(it != cells.end())
+					out.insert(out.end(), it->second.begin(), it->second.end());
+			}
+		}
+	}
+
+private:
+	typedef std::vector<T*> Bucket;
+	struct Slot {
+		uint64 cell;
+		uint32 index;
+	};
+	typedef std::unordered_map<uint64, Bucket> CellMap;
+	typedef std::unordered_map<T*, Slot> SlotMap;
+
+	int32 CellCoord(float v) const { return(int32(floorf(v * inv_cell_size))); }
+	static uint64 MakeKey(int32 cx, int32 cy) { return((uint64(uint32(cx)) << 32) | uint64(uint32(cy))); }
+	uint64 CellKey(float x, float y) const { return(MakeKey(CellCoord(x), CellCoord(y))); }
+
+	//swap-removes the entry at s from its bucket, fixing up the moved entity's slot
+	void Unlink(const Slot &s)
+	{
+		typename CellMap::iterator cit = cells.find(s.cell);
+		if(cit == cells.end())
+			return;
+		Bucket &bucket = cit->second;
+		T *last = bucket.back();
+		bucket[s.index] = last;
+		bucket.pop_back();
+		if(s.index < bucket.size())
+			slots[last].index = s.index;
+		if(bucket.empty())
+			cells.erase(cit);
+	}
+
+	float cell_size;
+	float inv_cell_size;
+	CellMap cells;
+	SlotMap slots;
+};
+
+#endif
@@ -0,0 +1,116 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemu.org)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef ENTITY_SLOTS_H
+#define ENTITY_SLOTS_H
+
+#include "../common/types.h"
+#include <string.h>
+
+#define ENTITY_SLOT_COUNT 0x10000
+
+//what kind of entity holds a slot, so typed lookups don't need a virtual call
+enum EntitySlotType {
+	EntitySlotNone = 0,
+	EntitySlotClient,
+	EntitySlotNPC,
+	EntitySlotMerc,
+	EntitySlotBot,
+	EntitySlotCorpse,
+	EntitySlotObject,
+	EntitySlotTrap,
+	EntitySlotBeacon,
+	EntitySlotOther
+};
+
+/*
+	Flat table indexed by entity id. Ids are 16 bit, so every lookup is a
+	single indexed read instead of a list walk.
+
+	Each slot has a generation that is bumped whenever the slot is claimed
+	or released. A handle packs the generation with the id, so code that
+	holds on to an entity for a while can tell whether the id has since been
+	reused by something else.
+*/
+template<class T>
+class EntitySlotTable
+{
+public:
+	EntitySlotTable() { memset(slots, 0, sizeof(slots)); }
+
+	void Claim(uint16 id, T *ent, uint8 type)
+	{
+		Slot &s = slots[id];
+		s.ent = ent;
+		s.type = type;
+		s.generation++;
+	}
+
+	//only clears the slot if ent still owns it
+	void Release(uint16 id, T *ent)
+	{
+		Slot &s = slots[id];
+		if(s.ent != ent)
+			return;
+		s.ent = nullptr;
+		s.type = EntitySlotNone;
+		s.generation++;
+	}
+
+	void Clear()
+	{
+		uint32 r;
+		for(r = 0; r < ENTITY_SLOT_COUNT; r++) {
+			if(slots[r].ent != nullptr) {
+				slots[r].ent = nullptr;
+				slots[r].type = EntitySlotNone;
+				slots[r].generation++;
+			}
+		}
+	}
+
+	inline T *Get(uint16 id) const { return(slots[id].ent); }
+	inline uint8 GetType(uint16 id) const { return(slots[id].type); }
+	inline T *Get(uint16 id, uint8 type) const { return(slots[id].type == type ? slots[id].ent : nullptr); }
+
+	//0 when the slot is empty, otherwise generation << 16 | id
+	inline uint32 GetHandle(uint16 id) const
+	{
+		if(slots[id].ent == nullptr)
+			return(0);
+		return((uint32(slots[id].generation) << 16) | id);
+	}
+
+	inline T *GetByHandle(uint32 handle) const
+	{
+		const Slot &s = slots[handle & 0xFFFF];
+		if(s.generation != (handle >> 16))
+			return(nullptr);
+		return(s.ent);
+	}
+
+private:
+	struct Slot {
+		T *ent;
+		uint16 generation;
+		uint8 type;
+	};
+	Slot slots[ENTITY_SLOT_COUNT];
+};
+
+#endif
@@ -230,7 +230,7 @@ void Client::RefreshGuildInfo()
 void EntityList::SendGuildMOTD(uint32 guild_id) {
 	if(guild_id == GUILD_NONE)
 		return;
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	while(iterator.MoreElements()) {
 		Client* client = iterator.GetData();
@@ -246,7 +246,7 @@ void EntityList::SendGuildMOTD(uint32 guild_id) {
 void EntityList::SendGuildSpawnAppearance(uint32 guild_id) {
 	if(guild_id == GUILD_NONE)
 		return;
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	while(iterator.MoreElements()) {
 		Client* client = iterator.GetData();
@@ -260,7 +260,7 @@ void EntityList::SendGuildSpawnAppearance(uint32 guild_id) {
 void EntityList::RefreshAllGuildInfo(uint32 guild_id) {
 	if(guild_id == GUILD_NONE)
 		return;
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	while(iterator.MoreElements()) {
 		Client* client = iterator.GetData();
@@ -271,26 +271,29 @@ void EntityList::RefreshAllGuildInfo(uint32 guild_id) {
 	}
 }
 
-void EntityList::SendGuildMembers(uint32 guild_id) {
+void EntityList::SendGuildMembers(uint32 guild_id, const EQApplicationPacket *delta) {
 	if(guild_id == GUILD_NONE)
 		return;
 
-	//this could be optimized a bit to only build the member's packet once
-	//and then keep swapping out the name in the packet on each send.
+	//the list itself comes out of guild_mgr's roster cache, so this is one build
+	//(and at most one query) for the whole guild rather than one per member.
 
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	while(iterator.MoreElements()) {
 		Client* client = iterator.GetData();
 		if (client->GuildID() == guild_id) {
-			client->SendGuildMembers();
+			if(delta != nullptr && client->GetClientVersion() >= EQClientSoF)
+				client->QueuePacket(delta);
+			else
+				client->SendGuildMembers();
 		}
 		iterator.Advance();
 	}
 }
 
 void EntityList::SendGuildList() {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 	iterator.Reset();
 	while(iterator.MoreElements()) {
 		Client* client = iterator.GetData();
@@ -319,7 +322,7 @@ void Client::SendGuildJoin(GuildJoin_Struct* gj){
 
 /*
 void EntityList::SendGuildJoin(GuildJoin_Struct* gj){
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	iterator.Reset();
 	while(iterator.MoreElements())
@@ -165,34 +165,91 @@ uint8 *ZoneGuildManager::MakeGuildMembers(uint32 guild_id, const char *prefix_na
 		return(retbuffer);
 	}
 
+	GuildRoster *roster = GetRoster(guild_id);
+	if(roster == nullptr)
+		return(nullptr);
+	if(roster->packet == nullptr)
+		BuildRosterPacket(roster);
+
+	//everyone gets the same list, only the name up front is theirs
+	length = roster->length;
+	retbuffer = new uint8[length];
+	memcpy(retbuffer, roster->packet, length);
+	Internal_GuildMembers_Struct *gms = (Internal_GuildMembers_Struct *) retbuffer;
+	strn0cpy(gms->player_name, prefix_name, sizeof(gms->player_name));
+
+	return(retbuffer);
+}
+
+ZoneGuildManager::GuildRoster *ZoneGuildManager::FindRoster(uint32 guild_id) {
+	std::map<uint32, GuildRoster *>::iterator res = m_rosters.find(guild_id);
+	if(res == m_rosters.end())
+		return(nullptr);
+	return(res->second);
+}
+
+//the cached roster for a guild, (re)loaded from the database when missing or older than Guild:RosterCacheSeconds.
+ZoneGuildManager::GuildRoster *ZoneGuildManager::GetRoster(uint32 guild_id) {
+	uint32 now = Timer::GetTimeSeconds();
+	GuildRoster *roster = FindRoster(guild_id);
+	if(roster != nullptr && now - roster->loaded < (uint32) RuleI(Guild, RosterCacheSeconds))
+		return(roster);
+
 	std::vector<CharGuildInfo *> members;
 	if(!GetEntireGuild(guild_id, members))
 		return(nullptr);
 
+	if(roster == nullptr) {
+		roster = new GuildRoster;
+		roster->packet = nullptr;
+		m_rosters[guild_id] = roster;
+	}
+	safe_delete_array(roster->packet);
+	roster->length = 0;
+	roster->loaded = now;
+	roster->members.clear();
+	roster->members.reserve(members.size());
+
+	std::vector<CharGuildInfo *>::iterator cur, end;
+	cur = members.begin();
+	end = members.end();
+	for(; cur != end; cur++) {
+		roster->members.push_back(**cur);
+		delete *cur;
+	}
+
+	_log(GUILDS__DB, "Cached %d members of guild %d", roster->members.size(), guild_id);
+	return(roster);
+}
+
+void ZoneGuildManager::BuildRosterPacket(GuildRoster *roster) {
+	std::vector<CharGuildInfo> &members = roster->members;
+
 	//figure out the actual packet length.
 	uint32 fixed_length = sizeof(Internal_GuildMembers_Struct) + members.size()*sizeof(Internal_GuildMemberEntry_Struct);
-	std::vector<CharGuildInfo *>::iterator cur, end;
+	std::vector<CharGuildInfo>::iterator cur, end;
 	CharGuildInfo *ci;
 	cur = members.begin();
 	end = members.end();
 	uint32 name_len = 0;
 	uint32 note_len = 0;
 	for(; cur != end; cur++) {
-		ci = *cur;
+		ci = &*cur;
 		name_len += ci->char_name.length();
 		note_len += ci->public_note.length();
 	}
 
 	//calc total length.
-	length = fixed_length + name_len + note_len + members.size()*2;	//string data + null terminators
+	roster->length = fixed_length + name_len + note_len + members.size()*2;	//string data + null terminators
 
 	//make our nice buffer
-	retbuffer = new uint8[length];
+	uint8 *retbuffer = new uint8[roster->length];
+	roster->packet = retbuffer;
 
 	Internal_GuildMembers_Struct *gms = (Internal_GuildMembers_Struct *) retbuffer;
 
-	//fill in the global header
-	strcpy(gms->player_name, prefix_name);
+	//fill in the global header, the name is filled in per recipient
+	memset(gms->player_name, 0, sizeof(gms->player_name));
 	gms->count = members.size();
 	gms->name_length = name_len;
 	gms->note_length = note_len;
@@ -206,7 +263,7 @@ uint8 *ZoneGuildManager::MakeGuildMembers(uint32 guild_id, const char *prefix_na
 	cur = members.begin();
 	end = members.end();
 	for(; cur != end; cur++) {
-		ci = *cur;
+		ci = &*cur;
 
 		//the order we set things here must match the struct
 
@@ -232,12 +289,97 @@ uint8 *ZoneGuildManager::MakeGuildMembers(uint32 guild_id, const char *prefix_na
 #undef SlideStructString
 #undef PutFieldN
 
-		delete *cur;
-
 		e++;
 	}
+}
 
-	return(retbuffer);
+CharGuildInfo *ZoneGuildManager::FindRosterMember(GuildRoster *roster, const char *name) {
+	std::vector<CharGuildInfo>::iterator cur, end;
+	cur = roster->members.begin();
+	end = roster->members.end();
+	for(; cur != end; cur++) {
+		if(strcasecmp(cur->char_name.c_str(), name) == 0)
+			return(&*cur);
+	}
+	return(nullptr);
+}
+
+//applies a ServerOP_GuildCharRefresh to the cached rosters. info is filled in with the
+//char's current guild info when it had to be looked up (anything but RosterMembership).
+ZoneGuildManager::RosterChange ZoneGuildManager::UpdateRosterMember(uint32 char_id, uint32 old_guild_id, uint32 guild_id, CharGuildInfo &info) {
+	RosterChange change = RosterMembership;
+
+	if(old_guild_id != 0 && old_guild_id != GUILD_NONE && old_guild_id != guild_id) {
+		GuildRoster *old_roster = FindRoster(old_guild_id);
+		if(old_roster != nullptr) {
+			std::vector<CharGuildInfo>::iterator cur;
+			for(cur = old_roster->members.begin(); cur != old_roster->members.end(); cur++) {
+				if(cur->char_id == char_id) {
+					old_roster->members.erase(cur);
+					safe_delete_array(old_roster->packet);
+					break;
+				}
+			}
+		}
+	}
+
+	if(guild_id == 0 || guild_id == GUILD_NONE)
+		return(RosterMembership);
+	GuildRoster *roster = FindRoster(guild_id);
+	if(roster == nullptr)
+		return(RosterMembership);	//loaded fresh on the next send
+
+	if(!GetCharInfo(char_id, info) || info.guild_id != guild_id) {
+		//world is ahead of or behind the database, start over
+		ForgetRoster(guild_id);
+		return(RosterMembership);
+	}
+
+	CharGuildInfo *member = nullptr;
+	std::vector<CharGuildInfo>::iterator cur;
+	for(cur = roster->members.begin(); cur != roster->members.end(); cur++) {
+		if(cur->char_id == char_id) {
+			member = &*cur;
+			break;
+		}
+	}
+
+	if(member == nullptr) {
+		roster->members.push_back(info);
+	} else {
+		if(member->rank != info.rank || member->banker != info.banker || member->alt != info.alt)
+			change = RosterRank;
+		else
+			change = RosterUnchanged;
+		if(member->public_note != info.public_note || member->tribute_enable != info.tribute_enable
+			|| member->total_tribute != info.total_tribute || member->last_tribute != info.last_tribute
+			|| member->level != info.level || member->class_ != info.class_ || member->time_last_on != info.time_last_on
+			|| member->char_name != info.char_name)
+			change = RosterDetails;
+		*member = info;
+	}
+	if(change != RosterUnchanged)
+		safe_delete_array(roster->packet);
+
+	return(change);
+}
+
+void ZoneGuildManager::ForgetRoster(uint32 guild_id) {
+	std::map<uint32, GuildRoster *>::iterator res = m_rosters.find(guild_id);
+	if(res == m_rosters.end())
+		return;
+	safe_delete_array(res->second->packet);
+	delete res->second;
+	m_rosters.erase(res);
+}
+
+void ZoneGuildManager::ClearRosters() {
+	std::map<uint32, GuildRoster *>::iterator cur;
+	for(cur = m_rosters.begin(); cur != m_rosters.end(); cur++) {
+		safe_delete_array(cur->second->packet);
+		delete cur->second;
+	}
+	m_rosters.clear();
 }
 
 void ZoneGuildManager::ListGuilds(Client *c) const {
@@ -361,11 +503,22 @@ void ZoneGuildManager::ProcessWorldPacket(ServerPacket *pack) {
 			c->RefreshGuildInfo();
 		}
 
-		//it would be nice if we had the packet to send just a one-person update
+		CharGuildInfo info;
+		RosterChange change = UpdateRosterMember(s->char_id, s->old_guild_id, s->guild_id, info);
+
 		if(s->guild_id == GUILD_NONE) {
 			if(c != nullptr)
 				c->SendGuildMembers();	//only need to update this player's list (trying to clear it)
-		} else {
+		} else if(change == RosterRank) {
+			//a promotion or demotion, clients that take OP_SetGuildRank don't need the whole list again
+			EQApplicationPacket *outapp = new EQApplicationPacket(OP_SetGuildRank, sizeof(GuildSetRank_Struct));
+			GuildSetRank_Struct *gsrs = (GuildSetRank_Struct*)outapp->pBuffer;
+			gsrs->Rank = info.rank;
+			strn0cpy(gsrs->MemberName, info.char_name.c_str(), sizeof(gsrs->MemberName));
+			gsrs->Banker = info.banker + (info.alt * 2);
+			entity_list.SendGuildMembers(s->guild_id, outapp);
+			safe_delete(outapp);
+		} else if(change != RosterUnchanged) {
 			entity_list.SendGuildMembers(s->guild_id);		//even send GUILD_NONE (empty)
 		}
 
@@ -394,6 +547,16 @@ void ZoneGuildManager::ProcessWorldPacket(ServerPacket *pack) {
 
 			ServerGuildRankUpdate_Struct *sgrus = (ServerGuildRankUpdate_Struct*)pack->pBuffer;
 
+			//banker and alt changes only come this way, keep the cached list in step
+			GuildRoster *roster = FindRoster(sgrus->GuildID);
+			CharGuildInfo *member = roster ? FindRosterMember(roster, sgrus->MemberName) : nullptr;
+			if(member != nullptr) {
+				member->rank = sgrus->Rank;
+				member->banker = (sgrus->Banker & 1) != 0;
+				member->alt = (sgrus->Banker & 2) != 0;
+				safe_delete_array(roster->packet);
+			}
+
 			EQApplicationPacket *outapp = new EQApplicationPacket(OP_SetGuildRank, sizeof(GuildSetRank_Struct));
 
 			GuildSetRank_Struct *gsrs = (GuildSetRank_Struct*)outapp->pBuffer;
@@ -419,6 +582,8 @@ void ZoneGuildManager::ProcessWorldPacket(ServerPacket *pack) {
 
 		_log(GUILDS__REFRESH, "Received guild delete from world for guild %d", s->guild_id);
 
+		ForgetRoster(s->guild_id);
+
 		//clear all the guild tags.
 		entity_list.RefreshAllGuildInfo(s->guild_id);
 
@@ -436,6 +601,13 @@ void ZoneGuildManager::ProcessWorldPacket(ServerPacket *pack) {
 	{
 		ServerGuildMemberUpdate_Struct *sgmus = (ServerGuildMemberUpdate_Struct*)pack->pBuffer;
 
+		GuildRoster *roster = FindRoster(sgmus->GuildID);
+		CharGuildInfo *member = roster ? FindRosterMember(roster, sgmus->MemberName) : nullptr;
+		if(member != nullptr && member->time_last_on != sgmus->LastSeen) {
+			member->time_last_on = sgmus->LastSeen;
+			safe_delete_array(roster->packet);
+		}
+
 		if(ZoneLoaded)
 		{
 			EQApplicationPacket *outapp = new EQApplicationPacket(OP_GuildMemberUpdate, sizeof(GuildMemberUpdate_Struct));
@@ -597,6 +769,7 @@ void ZoneGuildManager::AddMemberApproval(uint32 refid,Client* name)
 ZoneGuildManager::~ZoneGuildManager()
 {
 	ClearGuilds();
+	ClearRosters();
 }
 
 void ZoneGuildManager::ClearGuildsApproval()
@@ -5,6 +5,7 @@
 #include "../common/guild_base.h"
 #include <map>
 #include <list>
+#include <vector>
 #include "../zone/petitions.h"
 
 extern PetitionList petition_list;
@@ -89,6 +90,17 @@ public:
 
 	uint8 *MakeGuildMembers(uint32 guild_id, const char *prefix_name, uint32 &length);	//make a guild member list packet, returns ownership of the buffer.
 
+	//what a char refresh did to the cached roster, so the caller knows how much to resend
+	typedef enum {
+		RosterMembership,	//someone joined or left, or nothing was cached: everyone needs the whole list
+		RosterRank,			//only rank/banker/alt changed, which OP_SetGuildRank can carry
+		RosterDetails,		//anything else, the whole list but no one came or went
+		RosterUnchanged
+	} RosterChange;
+	RosterChange UpdateRosterMember(uint32 char_id, uint32 old_guild_id, uint32 guild_id, CharGuildInfo &info);
+	void ForgetRoster(uint32 guild_id);
+	void ClearRosters();
+
 	void RecordInvite(uint32 char_id, uint32 guild_id, uint8 rank);
 	bool VerifyAndClearInvite(uint32 char_id, uint32 guild_id, uint8 rank);
 	void SendGuildMemberUpdateToWorld(const char *MemberName, uint32 GuildID, uint16 ZoneID, uint32 LastSeen);
@@ -102,6 +114,21 @@ protected:
 
 	std::map<uint32, std::pair<uint32, uint8> > m_inviteQueue;	//map from char ID to guild,rank
 
+	//every member of a guild someone in this zone has asked for, so the member list
+	//packet is built from memory instead of GetEntireGuild on every send.
+	struct GuildRoster {
+		std::vector<CharGuildInfo> members;
+		uint8 *packet;		//member list with an empty player_name, nullptr until rebuilt
+		uint32 length;
+		uint32 loaded;		//Timer::GetTimeSeconds() of the GetEntireGuild it came from
+	};
+	std::map<uint32, GuildRoster *> m_rosters;
+
+	GuildRoster *GetRoster(uint32 guild_id);
+	GuildRoster *FindRoster(uint32 guild_id);
+	void BuildRosterPacket(GuildRoster *roster);
+	CharGuildInfo *FindRosterMember(GuildRoster *roster, const char *name);
+
 private:
 	LinkedList<GuildApproval*> list;
 	uint32 id;
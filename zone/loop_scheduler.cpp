@@ -0,0 +1,88 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemu.org)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#include "../common/debug.h"
+#include "../common/features.h"
+#include "../common/rulesys.h"
+#include "loop_scheduler.h"
+
+#ifndef WIN32
+#include "../common/unix.h"
+#endif
+
+ZoneLoopScheduler::ZoneLoopScheduler()
+{
+	deadline = 0xFFFFFFFF;
+	pass_start = Timer::GetTimeMicroseconds();
+	ResetStats();
+}
+
+void ZoneLoopScheduler::Sleep(uint32 idle_ms)
+{
+	uint64 now = Timer::GetTimeMicroseconds();
+	stats.loops++;
+	stats.busy_us.Add(now - pass_start);
+
+	if(!RuleB(Zone, AdaptiveMainLoop)) {
+		::Sleep(ZoneTimerResolution);
+	} else {
+		uint32 ms = deadline < idle_ms ? deadline : idle_ms;
+		if(ms == 0) {
+			stats.overran++;
+		} else if(wake.WaitForPost(ms * 1000)) {
+			stats.woken++;
+		}
+	}
+
+	deadline = 0xFFFFFFFF;
+	pass_start = Timer::GetTimeMicroseconds();
+	stats.sleep_us.Add(pass_start - now);
+}
+
+void ZoneLoopScheduler::ResetStats()
+{
+	uint32 r;
+	stats.loops = 0;
+	stats.woken = 0;
+	stats.overran = 0;
+	stats.busy_us.Clear();
+	stats.sleep_us.Clear();
+	for(r = 0; r < LoopSectionCount; r++)
+		stats.sections[r].Clear();
+}
+
+const char *ZoneLoopScheduler::SectionName(ZoneLoopSection section)
+{
+	switch(section) {
+	case LoopWorld: return("world");
+	case LoopNetwork: return("network");
+	case LoopGroups: return("groups");
+	case LoopDoors: return("doors");
+	case LoopObjects: return("objects");
+	case LoopCorpses: return("corpses");
+	case LoopTraps: return("traps");
+	case LoopRaids: return("raids");
+	case LoopEntities: return("entities");
+	case LoopMobs: return("mobs");
+	case LoopBeacons: return("beacons");
+	case LoopZone: return("zone");
+	case LoopQuests: return("quests");
+	case LoopDatabase: return("database");
+	default: return("unknown");
+	}
+}
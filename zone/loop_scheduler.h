@@ -0,0 +1,108 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemu.org)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+
+#ifndef LOOP_SCHEDULER_H
+#define LOOP_SCHEDULER_H
+
+#include "../common/types.h"
+#include "../common/timer.h"
+#include "../common/Condition.h"
+#include "../common/histogram.h"
+
+//the parts of the zone main loop that get their own time histogram
+enum ZoneLoopSection {
+	LoopWorld = 0,
+	LoopNetwork,
+	LoopGroups,
+	LoopDoors,
+	LoopObjects,
+	LoopCorpses,
+	LoopTraps,
+	LoopRaids,
+	LoopEntities,
+	LoopMobs,
+	LoopBeacons,
+	LoopZone,
+	LoopQuests,
+	LoopDatabase,
+	LoopSectionCount
+};
+
+/*
+	Decides how long the zone main loop sleeps. Each pass the loop reports
+	the timers it is waiting on with Deadline(), and Sleep() waits until the
+	nearest one. Anything the loop has to pick up from another thread posts
+	the wake condition: client packets (EQStreamFactory), packets from world
+	and finished DBAsync work. A post cuts the sleep short, and one that
+	lands while the pass is still running makes the next Sleep return at
+	once, so it isn't lost. A pass that overran its deadline doesn't sleep.
+
+	With Zone:AdaptiveMainLoop off it sleeps ZoneTimerResolution like before.
+	Main thread only, apart from Wake().
+*/
+class ZoneLoopScheduler
+{
+public:
+	ZoneLoopScheduler();
+
+	Condition *GetWakeCondition() { return(&wake); }
+	void Wake() { wake.Post(); }
+
+	//the loop wants to run again within ms
+	void Deadline(uint32 ms) { if(ms < deadline) deadline = ms; }
+	void Deadline(Timer &t) { if(t.Enabled()) Deadline(t.GetRemainingTime()); }
+
+	//call once all deadlines are in, does the sleep and starts the next pass
+	void Sleep(uint32 idle_ms);
+
+	void Record(ZoneLoopSection section, uint64 usec) { stats.sections[section].Add(usec); }
+
+	struct Stats {
+		uint64 loops;
+		uint64 woken;		//sleeps cut short by a wake
+		uint64 overran;		//passes that were already past their deadline
+		LogHistogram busy_us;	//time spent in a pass
+		LogHistogram sleep_us;	//time spent sleeping between passes
+		LogHistogram sections[LoopSectionCount];
+	};
+	const Stats &GetStats() const { return(stats); }
+	void ResetStats();
+
+	static const char *SectionName(ZoneLoopSection section);
+
+private:
+	Condition wake;
+	uint32 deadline;
+	uint64 pass_start;
+	Stats stats;
+};
+
+//times one section of the loop into the scheduler's histograms
+class ZoneLoopSectionTimer
+{
+public:
+	ZoneLoopSectionTimer(ZoneLoopScheduler &s, ZoneLoopSection sec) : scheduler(s), section(sec), start(Timer::GetTimeMicroseconds()) { }
+	~ZoneLoopSectionTimer() { scheduler.Record(section, Timer::GetTimeMicroseconds() - start); }
+
+private:
+	ZoneLoopScheduler &scheduler;
+	ZoneLoopSection section;
+	uint64 start;
+};
+
+#endif
@@ -112,10 +112,17 @@ typedef struct _nodeHeader {
 
 //special value returned as 'not found'
 #define NODE_NONE 65534
+#define MAP_NO_FACE 0xFFFFFFFF
+//faces tested together by Map's leaf kernel
+#define MAP_LEAF_BLOCK 4
 #define MAP_ROOT_NODE 0
 
 typedef uint16 NodeRef;
 
+namespace EQEmu {
+	class MemoryMappedFile;
+}
+
 /*typedef struct _node {
 	nodeHeader head;
 	unsigned int *	pfaces;
@@ -131,6 +138,9 @@ public:
 	~Map();
 
 	bool loadMap(FILE *fp);
+	//zero parse load from the .mmf beside the map file, see MapCache
+	bool loadMapCache(const char *map_file);
+	bool saveMapCache(const char *map_file) const;
 
 	//the result is always final, except special NODE_NONE
 	NodeRef SeekNode( NodeRef _node, float x, float y ) const;
@@ -145,7 +155,12 @@ public:
 	bool LineIntersectsNode( NodeRef _node, VERTEX start, VERTEX end, VERTEX *result, FACE **on = nullptr) const;
 	bool LineIntersectsFace( PFACE cface, VERTEX start, VERTEX end, VERTEX *result) const;
 	float FindBestZ( NodeRef _node, VERTEX start, VERTEX *result, FACE **on = nullptr) const;
+	//the original face by face version, kept as a reference for FindBestZ
+	float FindBestZScalar( NodeRef _node, VERTEX start, VERTEX *result, FACE **on = nullptr) const;
+	//step is only used by LineIntersectsZoneStepped, the quadtree walk doesn't need one
 	bool LineIntersectsZone(VERTEX start, VERTEX end, float step, VERTEX *result, FACE **on = nullptr) const;
+	//the original version that marches along the line, kept as a reference for LineIntersectsZone
+	bool LineIntersectsZoneStepped(VERTEX start, VERTEX end, float step, VERTEX *result, FACE **on = nullptr) const;
 
 //	inline unsigned int		GetVertexNumber( ) {return m_Vertex; }
 	inline uint32		GetFacesNumber( ) const { return m_Faces; }
@@ -182,6 +197,55 @@ private:
 
 	static void Normalize(VERTEX *p);
 
+	//plane and bounds of a face, worked out once at load instead of per test
+	struct FacePlane {
+		float nx, ny, nz, d;	//inverted normal, like LineIntersectsFace uses
+		float minx, miny, minz;
+		float maxx, maxy, maxz;
+	};
+
+	struct LOSTrace {
+		VERTEX start;
+		VERTEX end;
+		float dx, dy;
+		float best_mu;		//fraction along the line of the closest hit so far
+		int32 best_face;
+		VERTEX hit;
+	};
+
+	void BuildFacePlanes();
+	void BuildLeafFaces();
+	uint32 IntersectLeafBlock(uint32 slot, const VERTEX &p1, const VERTEX &p2, float *mu, VERTEX *hit) const;
+	bool SegmentEntersNode(NodeRef node_r, const LOSTrace &trace, float &enter) const;
+	void TraceNode(NodeRef node_r, LOSTrace &trace, int depth) const;
+	bool LineIntersectsFacePlane(uint32 face, const VERTEX &p1, const VERTEX &p2, float &mu, VERTEX &hit) const;
+
+	FacePlane *mFacePlanes;
+	//Every leaf's faces copied out structure of arrays, padded to blocks of
+	//MAP_LEAF_BLOCK, so a block of faces can be tested at once.
+	enum {
+		LeafAX, LeafAY, LeafAZ,
+		LeafBX, LeafBY, LeafBZ,
+		LeafCX, LeafCY, LeafCZ,
+		LeafNX, LeafNY, LeafNZ, LeafD,
+		LeafMinX, LeafMinY, LeafMinZ,
+		LeafMaxX, LeafMaxY, LeafMaxZ,
+		LeafFieldCount
+	};
+	float *mLeafData;		//backs mLeafField
+	float *mLeafField[LeafFieldCount];
+	uint32 *mLeafFace;		//face in each slot, MAP_NO_FACE for padding
+	uint32 *mLeafStart;		//first slot of each final node
+	uint32 *mLeafSlots;		//slots in each final node
+	uint32 mLeafSlotCount;
+
+	//faces can sit in more than one leaf, these stop a trace testing one twice
+	mutable uint32 *mFaceStamps;
+	mutable uint32 mFaceStamp;
+
+	//set when the arrays above point into a mapped cache instead of the heap
+	EQEmu::MemoryMappedFile *mCache;
+
 //	void	RecLoadNode( PNODE	_node, FILE *l_f );
 //	void	RecFreeNode( PNODE	_node );
 };
@@ -0,0 +1,171 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#include "../common/debug.h"
+#include "../common/memory_mapped_file.h"
+#include "map_cache.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WINDOWS
+	#include <process.h>
+	#define getpid _getpid
+#else
+	#include <unistd.h>
+#endif
+
+static const char map_cache_magic[8] = "EQEMUMC";
+
+//the mapped data starts just past MemoryMappedFile's size field, and the
+//mapping itself starts on a page, so offsets are aligned as addresses
+static uint32 MapCacheAlign(uint32 offset) {
+	uint32 lead = sizeof(uint32);
+	return(((offset + lead + MAP_CACHE_ALIGN - 1) & ~(MAP_CACHE_ALIGN - 1)) - lead);
+}
+
+std::string MapCache::GetCachePath(const char *source) {
+	return(std::string(source) + MAP_CACHE_SUFFIX);
+}
+
+bool MapCache::GetSourceStamp(const char *source, uint64 &size, uint64 &mtime) {
+	struct stat st;
+	if(stat(source, &st) != 0)
+		return(false);
+	size = st.st_size;
+	mtime = st.st_mtime;
+	return(true);
+}
+
+EQEmu::MemoryMappedFile *MapCache::Open(const char *source, uint32 kind, uint32 signature) {
+	uint64 size, mtime;
+	if(!GetSourceStamp(source, size, mtime))
+		return(nullptr);
+
+	std::string path = GetCachePath(source);
+	struct stat st;
+	if(stat(path.c_str(), &st) != 0)
+		return(nullptr);	//never built, not worth an exception
+
+	EQEmu::MemoryMappedFile *mmf = nullptr;
+	try {
+		mmf = new EQEmu::MemoryMappedFile(path, EQEmu::MemoryMappedFile::ReadOnly);
+	} catch(std::exception &ex) {
+		LogFile->write(EQEMuLog::Error, "Unable to map %s: %s", path.c_str(), ex.what());
+		return(nullptr);
+	}
+
+	const MapCacheHeader *head = GetHeader(mmf);
+	bool current = head != nullptr
+		&& memcmp(head->magic, map_cache_magic, sizeof(head->magic)) == 0
+		&& head->layout == MAP_CACHE_LAYOUT
+		&& head->kind == kind
+		&& head->signature == signature
+		&& head->section_count <= MAP_CACHE_SECTIONS
+		&& head->source_size == size
+		&& head->source_mtime == mtime;
+
+	uint32 r;
+	for(r = 0; current && r < head->section_count; r++) {
+		if(head->offset[r] != MapCacheAlign(head->offset[r])
+			|| uint64(head->offset[r]) + head->length[r] > mmf->Size())
+			current = false;
+	}
+
+	if(!current) {
+		safe_delete(mmf);
+		return(nullptr);
+	}
+	return(mmf);
+}
+
+const MapCacheHeader *MapCache::GetHeader(const EQEmu::MemoryMappedFile *mmf) {
+	uint32 offset = MapCacheAlign(0);
+	if(mmf->Size() < offset + sizeof(MapCacheHeader))
+		return(nullptr);
+	return((const MapCacheHeader *) ((const uint8 *) mmf->Get() + offset));
+}
+
+const void *MapCache::GetSection(const EQEmu::MemoryMappedFile *mmf, uint32 index, uint32 length) {
+	const MapCacheHeader *head = GetHeader(mmf);
+	if(head == nullptr || index >= head->section_count || head->length[index] != length)
+		return(nullptr);
+	return((const uint8 *) mmf->Get() + head->offset[index]);
+}
+
+MapCache::MapCache(uint32 kind, uint32 signature) {
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, map_cache_magic, sizeof(header.magic));
+	header.layout = MAP_CACHE_LAYOUT;
+	header.kind = kind;
+	header.signature = signature;
+}
+
+void MapCache::AddSection(const void *data, uint32 length) {
+	if(header.section_count >= MAP_CACHE_SECTIONS)
+		return;
+	header.length[header.section_count++] = length;
+	sections.push_back(data);
+}
+
+void MapCache::SetExtra(const void *data, uint32 length) {
+	if(length > MAP_CACHE_EXTRA)
+		length = MAP_CACHE_EXTRA;
+	memcpy(header.extra, data, length);
+}
+
+bool MapCache::Write(const char *source) {
+	if(!GetSourceStamp(source, header.source_size, header.source_mtime))
+		return(false);
+
+	uint32 size = MapCacheAlign(0) + sizeof(MapCacheHeader);
+	uint32 r;
+	for(r = 0; r < header.section_count; r++) {
+		header.offset[r] = MapCacheAlign(size);
+		size = header.offset[r] + header.length[r];
+	}
+
+	std::string path = GetCachePath(source);
+	char temp[512];
+	snprintf(temp, sizeof(temp), "%s.%d", path.c_str(), (int) getpid());
+
+	try {
+		EQEmu::MemoryMappedFile mmf(temp, size);
+		mmf.ZeroFile();
+		uint8 *data = (uint8 *) mmf.Get();
+		memcpy(data + MapCacheAlign(0), &header, sizeof(header));
+		for(r = 0; r < header.section_count; r++) {
+			if(header.length[r] > 0)
+				memcpy(data + header.offset[r], sections[r], header.length[r]);
+		}
+	} catch(std::exception &ex) {
+		LogFile->write(EQEMuLog::Error, "Unable to write %s: %s", temp, ex.what());
+		remove(temp);
+		return(false);
+	}
+
+#ifdef _WINDOWS
+	//rename won't replace a file here, and can't while anyone has it mapped
+	remove(path.c_str());
+#endif
+	if(rename(temp, path.c_str()) != 0) {
+		LogFile->write(EQEMuLog::Error, "Unable to replace %s with a new cache", path.c_str());
+		remove(temp);
+		return(false);
+	}
+	return(true);
+}
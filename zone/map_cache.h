@@ -0,0 +1,94 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#ifndef MAP_CACHE_H
+#define MAP_CACHE_H
+
+#include "../common/types.h"
+#include <string>
+#include <vector>
+
+namespace EQEmu {
+	class MemoryMappedFile;
+}
+
+//bump whenever MapCacheHeader or the sections any kind writes change shape or content
+#define MAP_CACHE_LAYOUT		2
+#define MAP_CACHE_SECTIONS		8
+#define MAP_CACHE_EXTRA			64
+//every section and the header start on this boundary in memory
+#define MAP_CACHE_ALIGN			16
+#define MAP_CACHE_SUFFIX		".mmf"
+
+enum MapCacheKind {
+	MapCacheMap = 1,
+	MapCacheWater = 2,
+	MapCachePath = 3
+};
+
+struct MapCacheHeader {
+	char	magic[8];		//"EQEMUMC"
+	uint32	layout;			//MAP_CACHE_LAYOUT
+	uint32	kind;
+	uint32	signature;		//sizes of the structs the kind stores, from its loader
+	uint32	section_count;
+	uint64	source_size;	//of the file this was built from
+	uint64	source_mtime;
+	uint32	offset[MAP_CACHE_SECTIONS];	//from the start of the mapped data
+	uint32	length[MAP_CACHE_SECTIONS];	//in bytes
+	uint8	extra[MAP_CACHE_EXTRA];		//counts and bounds, laid out by the kind
+};
+
+/*
+	Ready to use copies of the .map, .wtr and .path files, kept beside
+	each one as <file>.mmf and mapped read only. The arrays a loader used
+	to fread and then build on (faces, nodes, face planes, leaf blocks,
+	path nodes) are stored exactly as they sit in memory, so loading is
+	pointing at them, and every zone process on the host shares the same
+	pages.
+
+	A cache is used only when its layout, kind and struct signature match
+	this build and its recorded size and modification time match the
+	source file, anything else is rebuilt from the source. A rebuild
+	writes a temporary file and renames it over the old cache, so
+	processes that still have the old one mapped keep their copy.
+*/
+class MapCache {
+public:
+	//the current cache for source, or nullptr if there isn't one
+	static EQEmu::MemoryMappedFile *Open(const char *source, uint32 kind, uint32 signature);
+	static const MapCacheHeader *GetHeader(const EQEmu::MemoryMappedFile *mmf);
+	//nullptr unless the section is exactly length bytes long
+	static const void *GetSection(const EQEmu::MemoryMappedFile *mmf, uint32 index, uint32 length);
+
+	MapCache(uint32 kind, uint32 signature);
+
+	//the data is copied when Write is called, not before
+	void	AddSection(const void *data, uint32 length);
+	void	SetExtra(const void *data, uint32 length);
+	bool	Write(const char *source);
+
+	static std::string GetCachePath(const char *source);
+
+protected:
+	static bool GetSourceStamp(const char *source, uint64 &size, uint64 &mtime);
+
+	MapCacheHeader header;
+	std::vector<const void *> sections;
+};
+
+#endif
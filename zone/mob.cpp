@@ -31,6 +31,7 @@ extern EntityList entity_list;
 
 extern Zone* zone;
 extern WorldServer worldserver;
+extern TimerWheel timer_wheel;
 
 Mob::Mob(const char* in_name,
 		const char* in_lastname,
@@ -115,6 +116,15 @@ Mob::Mob(const char* in_name,
 	fear_walkto_z = -999999;
 	curfp = false;
 
+	if(RuleB(Zone, UseTimerWheel)) {
+		tic_timer.SetWheel(&timer_wheel);
+		mana_timer.SetWheel(&timer_wheel);
+		stunned_timer.SetWheel(&timer_wheel);
+		spun_timer.SetWheel(&timer_wheel);
+		gravity_timer.SetWheel(&timer_wheel);
+		viral_timer.SetWheel(&timer_wheel);
+	}
+
 	AI_Init();
 	SetMoving(false);
 	moved=false;
@@ -1271,6 +1281,14 @@ void Mob::ShowBuffList(Client* client) {
 	}
 }
 
+//pathing jumps a mob along with this, so it can land in another grid cell
+void Mob::Teleport(VERTEX NewPosition) {
+	x_pos = NewPosition.x;
+	y_pos = NewPosition.y;
+	z_pos = NewPosition.z;
+	entity_list.UpdateGrids(this);
+}
+
 void Mob::GMMove(float x, float y, float z, float heading, bool SendUpdate) {
 
 	Route.clear();
@@ -1278,6 +1296,7 @@ void Mob::GMMove(float x, float y, float z, float heading, bool SendUpdate) {
 	x_pos = x;
 	y_pos = y;
 	z_pos = z;
+	entity_list.UpdateGrids(this);
 	if (heading != 0.01)
 		this->heading = heading;
 	if(IsNPC())
@@ -2621,6 +2640,7 @@ void Mob::Warp( float x, float y, float z )
 	x_pos = x;
 	y_pos = y;
 	z_pos = z;
+	entity_list.UpdateGrids(this);
 
 	Mob* target = GetTarget();
 	if (target) {
@@ -19,6 +19,7 @@
 #define MOB_H
 
 #include "../common/features.h"
+#include "../common/timer_wheel.h"
 #include "common.h"
 #include "entity.h"
 #include "hate_list.h"
@@ -382,8 +383,7 @@ public:
 	void MakeSpawnUpdate(PlayerPositionUpdateServer_Struct* spu);
 	void SendPosition();
 	void SetFlyMode(uint8 flymode);
-	inline void Teleport(VERTEX NewPosition) { x_pos = NewPosition.x; y_pos = NewPosition.y;
-		z_pos = NewPosition.z; };
+	void Teleport(VERTEX NewPosition);
 
 	//AI
 	static uint32 GetLevelCon(uint8 mylevel, uint8 iOtherLevel);
@@ -967,8 +967,8 @@ protected:
 	Timer ranged_timer;
 	float attack_speed; //% increase/decrease in attack speed (not haste)
 	float slow_mitigation; // Allows for a slow mitigation based on a % in decimal form. IE, 1 = 100% mitigation, .5 is 50%
-	Timer tic_timer;
-	Timer mana_timer;
+	WheelTimer tic_timer;
+	WheelTimer mana_timer;
 
 	//spell casting vars
 	Timer spellend_timer;
@@ -1031,11 +1031,11 @@ protected:
 	Timer bindwound_timer;
 	Mob* bindwound_target;
 
-	Timer stunned_timer;
-	Timer spun_timer;
+	WheelTimer stunned_timer;
+	WheelTimer spun_timer;
 	Timer bardsong_timer;
-	Timer gravity_timer;
-	Timer viral_timer;
+	WheelTimer gravity_timer;
+	WheelTimer viral_timer;
 	uint8 viral_timer_counter;
 	uint16 adverrorinfo;
 
@@ -58,6 +58,7 @@
 #include "guild_mgr.h"
 #include "tasks.h"
 #include "QuestParserCollection.h"
+#include "loop_scheduler.h"
 
 #include <iostream>
 #include <string>
@@ -98,6 +99,8 @@ EQStreamFactory eqsf(ZoneStream);
 npcDecayTimes_Struct npcCorpseDecayTimes[100];
 TitleManager title_manager;
 DBAsyncFinishedQueue MTdbafq;
+TimerWheel timer_wheel;
+ZoneLoopScheduler loop_scheduler;
 DBAsync *dbasync = nullptr;
 TaskManager *taskmanager = 0;
 QuestParserCollection *parse = 0;
@@ -167,6 +170,10 @@ int main(int argc, char** argv) {
 	}
 	dbasync = new DBAsync(&database);
 	dbasync->AddFQ(&MTdbafq);
+	//finished queries and packets from world cut the main loop's sleep short
+	MTdbafq.SetWake(loop_scheduler.GetWakeCondition());
+	worldserver.SetInboundWake(loop_scheduler.GetWakeCondition());
+	database.EnableInventoryJournal();
 	guild_mgr.SetDatabase(&database);
 
 	GuildBanks = nullptr;
@@ -219,6 +226,16 @@ int main(int argc, char** argv) {
 		CheckEQEMuErrorAndPause();
 		return 0;
 	}
+	_log(ZONE__INIT, "Loading npc types");
+	if (!database.LoadNPCTypes()) {
+		_log(ZONE__INIT_ERR, "Loading npc types FAILED!");
+		_log(ZONE__INIT, "Failed. But ignoring error and going on, npc types will be read from the database as needed...");
+	}
+	_log(ZONE__INIT, "Loading spawn groups");
+	if (!database.LoadSharedSpawnGroups()) {
+		_log(ZONE__INIT_ERR, "Loading spawn groups FAILED!");
+		_log(ZONE__INIT, "Failed. But ignoring error and going on, spawn groups will be read from the database at zone boot...");
+	}
 	_log(ZONE__INIT, "Loading loot tables");
 	if (!database.LoadLoot()) {
 		_log(ZONE__INIT_ERR, "Loading loot FAILED!");
@@ -271,6 +288,7 @@ int main(int argc, char** argv) {
 			}
 		}
 	}
+	_log(ZONE__INIT, "Running %u async database workers", dbasync->StartWorkers(RuleI(Zone, ZoneDBAsyncWorkers)));
 
 	if(RuleB(TaskSystem, EnableTaskSystem)) {
 		_log(ZONE__INIT, "Loading Tasks");
@@ -315,6 +333,10 @@ int main(int argc, char** argv) {
 		zone = 0;
 	}
 
+	if (RuleB(Zone, EnableProfiler))
+		ZoneProfiler::Enable(true);
+	Timer profile_snapshot_timer(RuleI(Zone, ProfileSnapshotSeconds) * 1000);
+
 	//register all the patches we have avaliable with the stream identifier.
 	EQStreamIdentifier stream_identifier;
 	RegisterAllPatches(stream_identifier);
@@ -338,10 +360,16 @@ int main(int argc, char** argv) {
 		Timer::SetCurrentTime();
 
 		//process stuff from world
-		worldserver.Process();
+		{
+			ZoneLoopSectionTimer section(loop_scheduler, LoopWorld);
+			worldserver.Process();
+		}
 
 		if (!eqsf.IsOpen() && Config->ZonePort!=0) {
 			_log(ZONE__INIT, "Starting EQ Network server on port %d",Config->ZonePort);
+			eqsf.SetBatchedReader(RuleB(EQStream, BatchedReader));
+			eqsf.SetEventWriter(RuleB(EQStream, EventWriter));
+			eqsf.SetInboundWake(loop_scheduler.GetWakeCondition());
 			if (!eqsf.Open(Config->ZonePort)) {
 				_log(ZONE__INIT_ERR, "Failed to open port %d",Config->ZonePort);
 				ZoneConfig::SetZonePort(0);
@@ -350,31 +378,34 @@ int main(int argc, char** argv) {
 			}
 		}
 
-		//check the factory for any new incoming streams.
-		while ((eqss = eqsf.Pop())) {
-			//pull the stream out of the factory and give it to the stream identifier
-			//which will figure out what patch they are running, and set up the dynamic
-			//structures and opcodes for that patch.
-			struct in_addr	in;
-			in.s_addr = eqss->GetRemoteIP();
-			_log(WORLD__CLIENT, "New connection from %s:%d", inet_ntoa(in),ntohs(eqss->GetRemotePort()));
-			stream_identifier.AddStream(eqss);	//takes the stream
-		}
+		{
+			ZoneLoopSectionTimer section(loop_scheduler, LoopNetwork);
+
+			//check the factory for any new incoming streams.
+			while ((eqss = eqsf.Pop())) {
+				//pull the stream out of the factory and give it to the stream identifier
+				//which will figure out what patch they are running, and set up the dynamic
+				//structures and opcodes for that patch.
+				struct in_addr	in;
+				in.s_addr = eqss->GetRemoteIP();
+				_log(WORLD__CLIENT, "New connection from %s:%d", inet_ntoa(in),ntohs(eqss->GetRemotePort()));
+				stream_identifier.AddStream(eqss);	//takes the stream
+			}
 
-		//give the stream identifier a chance to do its work....
-		stream_identifier.Process();
-
-		//check the stream identifier for any now-identified streams
-		while((eqsi = stream_identifier.PopIdentified())) {
-			//now that we know what patch they are running, start up their client object
-			struct in_addr	in;
-			in.s_addr = eqsi->GetRemoteIP();
-			_log(WORLD__CLIENT, "New client from %s:%d", inet_ntoa(in), ntohs(eqsi->GetRemotePort()));
-			Client* client = new Client(eqsi);
-			entity_list.AddClient(client);
+			//give the stream identifier a chance to do its work....
+			stream_identifier.Process();
+
+			//check the stream identifier for any now-identified streams
+			while((eqsi = stream_identifier.PopIdentified())) {
+				//now that we know what patch they are running, start up their client object
+				struct in_addr	in;
+				in.s_addr = eqsi->GetRemoteIP();
+				_log(WORLD__CLIENT, "New client from %s:%d", inet_ntoa(in), ntohs(eqsi->GetRemotePort()));
+				Client* client = new Client(eqsi);
+				entity_list.AddClient(client);
+			}
 		}
 
-
 		//check for timeouts in other threads
 		timeout_manager.CheckTimeouts();
 
@@ -389,44 +420,76 @@ int main(int argc, char** argv) {
 
 		if (ZoneLoaded && temp_timer.Check()) {
 			{
-				if(net.group_timer.Enabled() && net.group_timer.Check())
+				uint32 checks = Timer::GetCheckCount();
+				timer_wheel.Advance(Timer::GetCurrentTime());
+
+				if(net.group_timer.Enabled() && net.group_timer.Check()) {
+					ZoneLoopSectionTimer section(loop_scheduler, LoopGroups);
 					entity_list.GroupProcess();
+				}
 
-				if(net.door_timer.Enabled() && net.door_timer.Check())
+				if(net.door_timer.Enabled() && net.door_timer.Check()) {
+					ZoneLoopSectionTimer section(loop_scheduler, LoopDoors);
 					entity_list.DoorProcess();
+				}
 
-				if(net.object_timer.Enabled() && net.object_timer.Check())
+				if(net.object_timer.Enabled() && net.object_timer.Check()) {
+					ZoneLoopSectionTimer section(loop_scheduler, LoopObjects);
 					entity_list.ObjectProcess();
+				}
 
-				if(net.corpse_timer.Enabled() && net.corpse_timer.Check())
+				if(net.corpse_timer.Enabled() && net.corpse_timer.Check()) {
+					ZoneLoopSectionTimer section(loop_scheduler, LoopCorpses);
 					entity_list.CorpseProcess();
+				}
 
-				if(net.trap_timer.Enabled() && net.trap_timer.Check())
+				if(net.trap_timer.Enabled() && net.trap_timer.Check()) {
+					ZoneLoopSectionTimer section(loop_scheduler, LoopTraps);
 					entity_list.TrapProcess();
+				}
 
-				if(net.raid_timer.Enabled() && net.raid_timer.Check())
+				if(net.raid_timer.Enabled() && net.raid_timer.Check()) {
+					ZoneLoopSectionTimer section(loop_scheduler, LoopRaids);
 					entity_list.RaidProcess();
+				}
 
-				entity_list.Process();
+				{
+					ZoneLoopSectionTimer section(loop_scheduler, LoopEntities);
+					entity_list.Process();
+				}
 
-				entity_list.MobProcess();
+				{
+					ZoneLoopSectionTimer section(loop_scheduler, LoopMobs);
+					entity_list.MobProcess();
+				}
 
-				entity_list.BeaconProcess();
+				{
+					ZoneLoopSectionTimer section(loop_scheduler, LoopBeacons);
+					entity_list.BeaconProcess();
+				}
 
 				if (zone) {
+					ZoneLoopSectionTimer section(loop_scheduler, LoopZone);
 					if(!zone->Process()) {
 						Zone::Shutdown();
 					}
 				}
 
-				if(quest_timers.Check())
+				if(quest_timers.Check()) {
+					ZoneLoopSectionTimer section(loop_scheduler, LoopQuests);
 					quest_manager.Process();
+				}
 
+				timer_wheel.RecordPolled(Timer::GetCheckCount() - checks);
 			}
 		}
-		DBAsyncWork* dbaw = 0;
-		while ((dbaw = MTdbafq.Pop())) {
-			DispatchFinishedDBAsync(dbaw);
+		{
+			ZoneLoopSectionTimer section(loop_scheduler, LoopDatabase);
+			DBAsyncWork* dbaw = 0;
+			while ((dbaw = MTdbafq.Pop())) {
+				DispatchFinishedDBAsync(dbaw);
+			}
+			database.FlushInventoryJournal();
 		}
 		if (InterserverTimer.Check()) {
 			InterserverTimer.Start();
@@ -463,8 +526,23 @@ int main(int argc, char** argv) {
 		}
 #endif
 #endif
+		//each snapshot covers the interval since the last one
+		if (ZoneProfiler::IsEnabled() && RuleI(Zone, ProfileSnapshotSeconds) > 0) {
+			if (profile_snapshot_timer.GetDuration() != uint32(RuleI(Zone, ProfileSnapshotSeconds) * 1000))
+				profile_snapshot_timer.Start(RuleI(Zone, ProfileSnapshotSeconds) * 1000);
+			if (profile_snapshot_timer.Check()) {
+				WriteZoneProfileSnapshot();
+				ZoneProfiler::Reset();
+			}
+		}
 		}	//end extra profiler block
-		Sleep(ZoneTimerResolution);
+
+		//sleep until the next thing the loop waits on is due
+		Timer::SetCurrentTime();
+		if (ZoneLoaded)
+			loop_scheduler.Deadline(temp_timer);
+		loop_scheduler.Deadline(InterserverTimer);
+		loop_scheduler.Sleep(RuleI(Zone, IdleLoopSleepMS));
 	}
 
 	entity_list.Clear();
@@ -481,6 +559,7 @@ int main(int argc, char** argv) {
 	//Fix for Linux world server problem.
 	eqsf.Close();
 	worldserver.Disconnect();
+	database.FlushInventoryJournal();
 	dbasync->CommitWrites();
 	dbasync->StopThread();
 	safe_delete(taskmanager);
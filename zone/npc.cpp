@@ -51,6 +51,7 @@
 extern Zone* zone;
 extern volatile bool ZoneLoaded;
 extern EntityList entity_list;
+extern TimerWheel timer_wheel;
 
 #include "QuestParserCollection.h"
 
@@ -127,6 +128,11 @@ NPC::NPC(const NPCType* d, Spawn2* in_respawn, float x, float y, float z, float
 	respawn2 = in_respawn;
 	swarm_timer.Disable();
 
+	if(RuleB(Zone, UseTimerWheel)) {
+		sendhpupdate_timer.SetWheel(&timer_wheel);
+		enraged_timer.SetWheel(&timer_wheel);
+	}
+
 	taunting = false;
 	proximity = nullptr;
 	copper = 0;
@@ -486,8 +486,8 @@ protected:
 	Timer	qglobal_purge_timer;
 
 	bool	combat_event;	//true if we are in combat, false otherwise
-	Timer	sendhpupdate_timer;
-	Timer	enraged_timer;
+	WheelTimer	sendhpupdate_timer;
+	WheelTimer	enraged_timer;
 	Timer *reface_timer;
 
 	uint32	npc_spells_id;
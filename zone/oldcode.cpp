@@ -1536,7 +1536,7 @@ Message(0, "Disc packet id=%d, %x,%x,%x", disc_in->disc_id, disc_in->unknown3[0]
 #if 0	// solar: this is old code
 /*void EntityList::AESpell(Mob* caster, Mob* center, float dist, uint16 spell_id, bool group)
 {
-	LinkedListIterator<Mob*> iterator(mob_list);
+	DenseListIterator<Mob*> iterator(mob_list);
 	iterator.Reset();
 	while(iterator.MoreElements()) {
 		Mob* mob = iterator.GetData();
@@ -11,6 +11,9 @@
 #include "doors.h"
 #include "client.h"
 #include "zone.h"
+#include "map_cache.h"
+#include "../common/rulesys.h"
+#include "../common/memory_mapped_file.h"
 
 #ifdef _WINDOWS
 #define snprintf _snprintf
@@ -59,6 +62,19 @@ PathManager* PathManager::LoadPathFile(const char* ZoneName)
 
 	snprintf(ZonePathFileName, 250, MAP_DIR "/%s.path", LowerCaseZoneName);
 
+	bool UseCache = RuleB(Map, UseFileCache);
+	if(UseCache)
+	{
+		Ret = new PathManager();
+
+		if(Ret->loadPathCache(ZonePathFileName))
+		{
+			LogFile->write(EQEMuLog::Status, "Path File %s loaded from its cache.", ZonePathFileName);
+			return Ret;
+		}
+		safe_delete(Ret);
+	}
+
 	if((PathFile = fopen(ZonePathFileName, "rb")))
 	{
 		Ret = new PathManager();
@@ -67,6 +83,19 @@ PathManager* PathManager::LoadPathFile(const char* ZoneName)
 		{
 			LogFile->write(EQEMuLog::Status, "Path File %s loaded.", ZonePathFileName);
 
+			if(UseCache && Ret->savePathCache(ZonePathFileName))
+			{
+				PathManager *Cached = new PathManager();
+				if(Cached->loadPathCache(ZonePathFileName))
+				{
+					safe_delete(Ret);
+					Ret = Cached;
+				}
+				else
+				{
+					safe_delete(Cached);
+				}
+			}
 		}
 		else
 		{
@@ -86,7 +115,13 @@ PathManager* PathManager::LoadPathFile(const char* ZoneName)
 PathManager::PathManager()
 {
 	PathNodes = nullptr;
-	ClosedListFlag = nullptr;
+	PathCache = nullptr;
+	SearchGeneration = 0;
+	RouteCacheBytes = 0;
+	RouteCacheHits = 0;
+	RouteCacheMisses = 0;
+	RouteCacheEvictions = 0;
+	RouteCacheInvalidations = 0;
 	Head.PathNodeCount = 0;
 	Head.version = 2;
 	QuickConnectTarget = -1;
@@ -94,8 +129,55 @@ PathManager::PathManager()
 
 PathManager::~PathManager()
 {
+	if(PathCache)
+	{
+		PathNodes = nullptr;
+		safe_delete(PathCache);
+	}
 	safe_delete_array(PathNodes);
-	safe_delete_array(ClosedListFlag);
+}
+
+bool PathManager::loadPathCache(const char *path_file)
+{
+	EQEmu::MemoryMappedFile *mmf = MapCache::Open(path_file, MapCachePath, sizeof(PathNode));
+	if(mmf == nullptr)
+		return false;
+
+	PathFileHeader CachedHead;
+	memcpy(&CachedHead, MapCache::GetHeader(mmf)->extra, sizeof(CachedHead));
+	const void *Nodes = MapCache::GetSection(mmf, 0, CachedHead.PathNodeCount * sizeof(PathNode));
+	if(Nodes == nullptr)
+	{
+		safe_delete(mmf);
+		return false;
+	}
+
+	PathCache = mmf;
+	Head = CachedHead;
+	PathNodes = (PathNode *) Nodes;
+	return true;
+}
+
+bool PathManager::savePathCache(const char *path_file) const
+{
+	if(PathCache != nullptr || PathNodes == nullptr)
+		return false;
+
+	MapCache Cache(MapCachePath, sizeof(PathNode));
+	Cache.SetExtra(&Head, sizeof(Head));
+	Cache.AddSection(PathNodes, Head.PathNodeCount * sizeof(PathNode));
+	return Cache.Write(path_file);
+}
+
+void PathManager::MakeNodesWritable()
+{
+	if(!PathCache)
+		return;
+
+	PathNode *Copy = new PathNode[Head.PathNodeCount];
+	memcpy(Copy, PathNodes, Head.PathNodeCount * sizeof(PathNode));
+	PathNodes = Copy;
+	safe_delete(PathCache);
 }
 
 bool PathManager::loadPaths(FILE *PathFile)
@@ -126,8 +208,6 @@ bool PathManager::loadPaths(FILE *PathFile)
 
 	fread(PathNodes, sizeof(PathNode), Head.PathNodeCount, PathFile);
 
-	ClosedListFlag = new int[Head.PathNodeCount];
-
 #ifdef PATHDEBUG
 	PrintPathing();
 #endif
@@ -209,130 +289,277 @@ VERTEX PathManager::GetPathNodeCoordinates(int NodeNumber, bool BestZ)
 
 }
 
+void PathManager::ResetSearchPool()
+{
+	SearchNodes.resize(Head.PathNodeCount);
+
+	for(uint32 i = 0; i < SearchNodes.size(); ++i)
+		SearchNodes[i].Generation = 0;
+
+	OpenHeap.clear();
+	OpenHeap.reserve(Head.PathNodeCount);
+
+	SearchGeneration = 0;
+}
+
+void PathManager::OpenHeapSiftUp(int Index)
+{
+	int NodeID = OpenHeap[Index];
+	float FCost = SearchNodes[NodeID].FCost;
+
+	while(Index > 0)
+	{
+		int ParentIndex = (Index - 1) / 2;
+		int ParentID = OpenHeap[ParentIndex];
+
+		if(SearchNodes[ParentID].FCost <= FCost)
+			break;
+
+		OpenHeap[Index] = ParentID;
+		SearchNodes[ParentID].HeapIndex = Index;
+		Index = ParentIndex;
+	}
+
+	OpenHeap[Index] = NodeID;
+	SearchNodes[NodeID].HeapIndex = Index;
+}
+
+void PathManager::OpenHeapSiftDown(int Index)
+{
+	int Count = OpenHeap.size();
+	int NodeID = OpenHeap[Index];
+	float FCost = SearchNodes[NodeID].FCost;
+
+	while(true)
+	{
+		int Child = Index * 2 + 1;
+
+		if(Child >= Count)
+			break;
+
+		if((Child + 1 < Count) && (SearchNodes[OpenHeap[Child + 1]].FCost < SearchNodes[OpenHeap[Child]].FCost))
+			++Child;
+
+		if(FCost <= SearchNodes[OpenHeap[Child]].FCost)
+			break;
+
+		OpenHeap[Index] = OpenHeap[Child];
+		SearchNodes[OpenHeap[Index]].HeapIndex = Index;
+		Index = Child;
+	}
+
+	OpenHeap[Index] = NodeID;
+	SearchNodes[NodeID].HeapIndex = Index;
+}
+
+void PathManager::OpenHeapPush(int NodeID)
+{
+	OpenHeap.push_back(NodeID);
+	OpenHeapSiftUp(OpenHeap.size() - 1);
+}
+
+int PathManager::OpenHeapPop()
+{
+	int NodeID = OpenHeap[0];
+
+	OpenHeap[0] = OpenHeap.back();
+	OpenHeap.pop_back();
+
+	if(OpenHeap.size() > 0)
+		OpenHeapSiftDown(0);
+
+	SearchNodes[NodeID].HeapIndex = -1;
+
+	return NodeID;
+}
+
 std::list<int> PathManager::FindRoute(int startID, int endID)
 {
 	_ZP(Pathing_FindRoute_FromNodes);
 
 	_log(PATHING__DEBUG, "FindRoute from node %i to %i", startID, endID);
 
-	memset(ClosedListFlag, 0, sizeof(int) * Head.PathNodeCount);
+	uint32 CacheLimit = RuleI(Pathing, RouteCacheSize);
 
-	std::list<AStarNode> OpenList, ClosedList;
+	if((CacheLimit == 0) || (startID < 0) || (endID < 0) || ((uint32)startID >= Head.PathNodeCount) || ((uint32)endID >= Head.PathNodeCount))
+	{
+		EvictRoutes(0);
+		return SearchRoute(startID, endID);
+	}
 
-	std::list<int>Route;
+	uint32 Key = ((uint32)startID << 16) | ((uint32)endID & 0xFFFF);
+
+	std::unordered_map<uint32, RouteCacheList::iterator>::iterator Cached = RouteCacheIndex.find(Key);
+
+	if(Cached != RouteCacheIndex.end())
+	{
+		++RouteCacheHits;
+
+		RouteCache.splice(RouteCache.begin(), RouteCache, Cached->second);
+
+		return Cached->second->Route;
+	}
+
+	++RouteCacheMisses;
+
+	std::list<int> Route = SearchRoute(startID, endID);
+
+	// Unreachable pairs are cached too, they cost the most to find.
+	RouteCacheEntry Entry;
+	Entry.Key = Key;
+	Entry.Route = Route;
+	Entry.Size = sizeof(RouteCacheEntry) + 4 * sizeof(void*) + sizeof(Key) + sizeof(RouteCacheList::iterator) +
+		Route.size() * (sizeof(int) + 2 * sizeof(void*));
 
-	AStarNode AStarEntry, CurrentNode;
+	RouteCache.push_front(Entry);
+	RouteCacheIndex[Key] = RouteCache.begin();
+	RouteCacheBytes += Entry.Size;
 
-	AStarEntry.PathNodeID = startID;
-	AStarEntry.Parent = -1;
-	AStarEntry.HCost = 0;
-	AStarEntry.GCost = 0;
-	AStarEntry.Teleport = false;
+	EvictRoutes(CacheLimit);
 
-	OpenList.push_back(AStarEntry);
+	return Route;
+}
 
-	while(OpenList.size() > 0)
+void PathManager::EvictRoutes(uint32 Limit)
+{
+	while((RouteCacheBytes > Limit) && !RouteCache.empty())
 	{
-		// The OpenList is maintained in sorted order, lowest to highest cost.
+		RouteCacheEntry &Oldest = RouteCache.back();
+
+		RouteCacheBytes -= Oldest.Size;
+		RouteCacheIndex.erase(Oldest.Key);
+		RouteCache.pop_back();
+
+		++RouteCacheEvictions;
+	}
+}
 
-		CurrentNode = (*OpenList.begin());
+void PathManager::ClearRouteCache()
+{
+	if(!RouteCache.empty())
+		++RouteCacheInvalidations;
 
-		ClosedList.push_back(CurrentNode);
+	RouteCache.clear();
+	RouteCacheIndex.clear();
+	RouteCacheBytes = 0;
+}
 
-		ClosedListFlag[CurrentNode.PathNodeID] = true;
+void PathManager::ShowRouteCache(Client *c)
+{
+	if(!c)
+		return;
+
+	uint32 Lookups = RouteCacheHits + RouteCacheMisses;
+
+	c->Message(0, "Route cache: %u routes, %u of %u bytes.", (uint32)RouteCache.size(), RouteCacheBytes,
+			(uint32)RuleI(Pathing, RouteCacheSize));
+	c->Message(0, "Hits: %u, Misses: %u (%.1f%% hit rate), Evictions: %u, Invalidations: %u",
+			RouteCacheHits, RouteCacheMisses, Lookups ? (100.0f * RouteCacheHits / Lookups) : 0.0f,
+			RouteCacheEvictions, RouteCacheInvalidations);
+}
+
+std::list<int> PathManager::SearchRoute(int startID, int endID)
+{
+	std::list<int>Route;
+
+	if((startID < 0) || (endID < 0) || ((uint32)startID >= Head.PathNodeCount) || ((uint32)endID >= Head.PathNodeCount))
+		return Route;
+
+	// Node state is stamped with the search generation, so nothing has to be
+	// cleared between searches unless the node count changed or the stamp wrapped.
+	if(SearchNodes.size() != Head.PathNodeCount)
+		ResetSearchPool();
+
+	if(++SearchGeneration == 0)
+	{
+		ResetSearchPool();
+		SearchGeneration = 1;
+	}
+
+	OpenHeap.clear();
+
+	AStarNode &StartNode = SearchNodes[startID];
+
+	StartNode.Generation = SearchGeneration;
+	StartNode.Parent = -1;
+	StartNode.GCost = 0;
+	StartNode.FCost = 0;
+	StartNode.Teleport = false;
+
+	OpenHeapPush(startID);
+
+	while(OpenHeap.size() > 0)
+	{
+		// The open heap keeps the lowest FCost node at the top.
+		int CurrentID = OpenHeapPop();
 
-		OpenList.pop_front();
+		AStarNode &CurrentNode = SearchNodes[CurrentID];
 
 		for(int i = 0; i < PATHNODENEIGHBOURS; ++i)
 		{
-			if(PathNodes[CurrentNode.PathNodeID].Neighbours[i].id == -1)
+			NeighbourNode &Neighbour = PathNodes[CurrentID].Neighbours[i];
+
+			if(Neighbour.id == -1)
 				break;
 
-			if(PathNodes[CurrentNode.PathNodeID].Neighbours[i].id == CurrentNode.Parent)
+			if(Neighbour.id == CurrentNode.Parent)
 				continue;
 
-			if(PathNodes[CurrentNode.PathNodeID].Neighbours[i].id == endID)
+			if(Neighbour.id == endID)
 			{
-				Route.push_back(CurrentNode.PathNodeID);
+				Route.push_back(CurrentID);
 
 				Route.push_back(endID);
 
-				std::list<AStarNode>::iterator RouteIterator;
+				int RouteNode = CurrentID;
 
-				while(CurrentNode.PathNodeID != startID)
+				while(RouteNode != startID)
 				{
-					for(RouteIterator = ClosedList.begin(); RouteIterator != ClosedList.end(); ++RouteIterator)
-					{
-						if((*RouteIterator).PathNodeID == CurrentNode.Parent)
-						{
-							if(CurrentNode.Teleport)
-								Route.insert(Route.begin(), -1);
+					if(SearchNodes[RouteNode].Teleport)
+						Route.insert(Route.begin(), -1);
 
-							CurrentNode = (*RouteIterator);
+					RouteNode = SearchNodes[RouteNode].Parent;
 
-							Route.insert(Route.begin(), CurrentNode.PathNodeID);
-
-							break;
-						}
-					}
+					Route.insert(Route.begin(), RouteNode);
 				}
 
 				return Route;
 			}
-			if(ClosedListFlag[PathNodes[CurrentNode.PathNodeID].Neighbours[i].id])
-				continue;
 
-			AStarEntry.PathNodeID = PathNodes[CurrentNode.PathNodeID].Neighbours[i].id;
+			AStarNode &Entry = SearchNodes[Neighbour.id];
 
-			AStarEntry.Parent = CurrentNode.PathNodeID;
+			float GCostToNode = CurrentNode.GCost + Neighbour.distance;
 
-			AStarEntry.Teleport = PathNodes[CurrentNode.PathNodeID].Neighbours[i].Teleport;
+			if(Entry.Generation == SearchGeneration)
+			{
+				// Closed, or already open by a route that is at least as cheap.
+				if((Entry.HeapIndex < 0) || (GCostToNode >= Entry.GCost))
+					continue;
 
-			// HCost is the estimated cost to get from this node to the end.
-			AStarEntry.HCost = VertexDistance(PathNodes[PathNodes[CurrentNode.PathNodeID].Neighbours[i].id].v,
-											PathNodes[endID].v);
+				Entry.FCost -= (Entry.GCost - GCostToNode);
+				Entry.GCost = GCostToNode;
+				Entry.Parent = CurrentID;
+				Entry.Teleport = Neighbour.Teleport;
 
-			AStarEntry.GCost = CurrentNode.GCost + PathNodes[CurrentNode.PathNodeID].Neighbours[i].distance;
+				OpenHeapSiftUp(Entry.HeapIndex);
 
-			float FCost = AStarEntry.HCost + AStarEntry.GCost;
+				continue;
+			}
+
+			// HCost is the estimated cost to get from this node to the end.
+			float HCost = VertexDistance(PathNodes[Neighbour.id].v, PathNodes[endID].v);
 #ifdef PATHDEBUG
 			printf("Node: %i, Open Neighbour %i has HCost %8.3f, GCost %8.3f (Total Cost: %8.3f)\n",
-					CurrentNode.PathNodeID,
-					PathNodes[CurrentNode.PathNodeID].Neighbours[i].id,
-					AStarEntry.HCost,
-					AStarEntry.GCost,
-					AStarEntry.HCost + AStarEntry.GCost);
+					CurrentID, Neighbour.id, HCost, GCostToNode, HCost + GCostToNode);
 #endif
 
-			bool AlreadyInOpenList = false;
-
-			std::list<AStarNode>::iterator OpenListIterator, InsertionPoint = OpenList.end();
+			Entry.Generation = SearchGeneration;
+			Entry.Parent = CurrentID;
+			Entry.GCost = GCostToNode;
+			Entry.FCost = GCostToNode + HCost;
+			Entry.Teleport = Neighbour.Teleport;
 
-			for(OpenListIterator = OpenList.begin(); OpenListIterator != OpenList.end(); ++OpenListIterator)
-			{
-				if((*OpenListIterator).PathNodeID == PathNodes[CurrentNode.PathNodeID].Neighbours[i].id)
-				{
-					AlreadyInOpenList = true;
-
-					float GCostToNode = CurrentNode.GCost + PathNodes[CurrentNode.PathNodeID].Neighbours[i].distance;
-
-					if(GCostToNode < (*OpenListIterator).GCost)
-					{
-						(*OpenListIterator).Parent = CurrentNode.PathNodeID;
-
-						(*OpenListIterator).GCost = GCostToNode;
-
-						(*OpenListIterator).Teleport = PathNodes[CurrentNode.PathNodeID].Neighbours[i].Teleport;
-					}
-					break;
-				}
-				else if((InsertionPoint == OpenList.end()) && (((*OpenListIterator).HCost + (*OpenListIterator).GCost) > FCost))
-				{
-					InsertionPoint = OpenListIterator;
-				}
-			}
-			if(!AlreadyInOpenList)
-				OpenList.insert(InsertionPoint, AStarEntry);
+			OpenHeapPush(Neighbour.id);
 		}
 
 	}
@@ -1485,6 +1712,9 @@ void PathManager::DumpPath(std::string filename)
 
 int32 PathManager::AddNode(float x, float y, float z, float best_z, int32 requested_id)
 {
+	ClearRouteCache();
+	MakeNodesWritable();
+
 	int32 new_id = -1;
 	if(requested_id != 0)
 	{
@@ -1601,8 +1831,6 @@ int32 PathManager::AddNode(float x, float y, float z, float best_z, int32 reques
 		npc->GiveNPCTypeData(npc_type);
 		entity_list.AddNPC(npc, true, true);
 
-		safe_delete_array(ClosedListFlag);
-		ClosedListFlag = new int[Head.PathNodeCount];
 		return new_id;
 	}
 	else
@@ -1661,8 +1889,6 @@ int32 PathManager::AddNode(float x, float y, float z, float best_z, int32 reques
 		npc->GiveNPCTypeData(npc_type);
 		entity_list.AddNPC(npc, true, true);
 
-		ClosedListFlag = new int[Head.PathNodeCount];
-
 		return new_id;
 	}
 }
@@ -1691,6 +1917,9 @@ bool PathManager::DeleteNode(Client *c)
 
 bool PathManager::DeleteNode(int32 id)
 {
+	ClearRouteCache();
+	MakeNodesWritable();
+
 	//if the current list is > 1 in size create a new list of size current size - 1
 	//transfer all but the current node to this new list and delete our current list
 	//set this new list to be our current list
@@ -1737,8 +1966,6 @@ bool PathManager::DeleteNode(int32 id)
 				}
 			}
 		}
-		safe_delete_array(ClosedListFlag);
-		ClosedListFlag = new int[Head.PathNodeCount];
 	}
 	else
 	{
@@ -1777,6 +2004,9 @@ void PathManager::ConnectNodeToNode(Client *c, int32 Node2, int32 teleport, int3
 
 void PathManager::ConnectNodeToNode(int32 Node1, int32 Node2, int32 teleport, int32 doorid)
 {
+	ClearRouteCache();
+	MakeNodesWritable();
+
 	PathNode *a = nullptr;
 	PathNode *b = nullptr;
 	for(uint32 x = 0; x < Head.PathNodeCount; ++x)
@@ -1867,6 +2097,9 @@ void PathManager::ConnectNode(Client *c, int32 Node2, int32 teleport, int32 door
 
 void PathManager::ConnectNode(int32 Node1, int32 Node2, int32 teleport, int32 doorid)
 {
+	ClearRouteCache();
+	MakeNodesWritable();
+
 	PathNode *a = nullptr;
 	PathNode *b = nullptr;
 	for(uint32 x = 0; x < Head.PathNodeCount; ++x)
@@ -1932,6 +2165,9 @@ void PathManager::DisconnectNodeToNode(Client *c, int32 Node2)
 
 void PathManager::DisconnectNodeToNode(int32 Node1, int32 Node2)
 {
+	ClearRouteCache();
+	MakeNodesWritable();
+
 	PathNode *a = nullptr;
 	PathNode *b = nullptr;
 	for(uint32 x = 0; x < Head.PathNodeCount; ++x)
@@ -2005,12 +2241,15 @@ void PathManager::MoveNode(Client *c)
 		return;
 	}
 
+	MakeNodesWritable();
 	PathNode *Node = zone->pathing->FindPathNodeByCoordinates(c->GetTarget()->GetX(), c->GetTarget()->GetY(), c->GetTarget()->GetZ());
 	if(!Node)
 	{
 		return;
 	}
 
+	ClearRouteCache();
+
 	Node->v.x = c->GetX();
 	Node->v.y = c->GetY();
 	Node->v.z = c->GetZ();
@@ -2039,12 +2278,15 @@ void PathManager::DisconnectAll(Client *c)
 		return;
 	}
 
+	MakeNodesWritable();
 	PathNode *Node = zone->pathing->FindPathNodeByCoordinates(c->GetTarget()->GetX(), c->GetTarget()->GetY(), c->GetTarget()->GetZ());
 	if(!Node)
 	{
 		return;
 	}
 
+	ClearRouteCache();
+
 	for(int x = 0; x < PATHNODENEIGHBOURS; ++x)
 	{
 		Node->Neighbours[x].distance = 0;
@@ -2116,6 +2358,8 @@ bool PathManager::CheckLosFN(VERTEX a, VERTEX b)
 
 void PathManager::ProcessNodesAndSave(std::string filename)
 {
+	MakeNodesWritable();
+
 	if(zone->zonemap)
 	{
 		for(uint32 i = 0; i < Head.PathNodeCount; ++i)
@@ -2157,6 +2401,9 @@ void PathManager::ProcessNodesAndSave(std::string filename)
 
 void PathManager::ResortConnections()
 {
+	ClearRouteCache();
+	MakeNodesWritable();
+
 	NeighbourNode Neigh[PATHNODENEIGHBOURS];
 	for(uint32 x = 0; x < Head.PathNodeCount; ++x)
 	{
@@ -2240,6 +2487,9 @@ struct InternalPathSort
 
 void PathManager::SortNodes()
 {
+	ClearRouteCache();
+	MakeNodesWritable();
+
 	std::vector<InternalPathSort> sorted_vals;
 	for(uint32 x = 0; x < Head.PathNodeCount; ++x)
 	{
@@ -6,22 +6,18 @@
 #include <list>
 #include <vector>
 #include <algorithm>
+#include <unordered_map>
 
 class Client;
 
+namespace EQEmu {
+	class MemoryMappedFile;
+}
+
 #define PATHNODENEIGHBOURS 50
 
 #pragma pack(1)
 
-struct AStarNode
-{
-	int PathNodeID;
-	int Parent;
-	float HCost;
-	float GCost;
-	bool Teleport;
-};
-
 struct NeighbourNode {
 	int16 id;
 	float distance;
@@ -43,6 +39,18 @@ struct PathFileHeader {
 
 #pragma pack()
 
+//per node A* search state. Only valid while Generation matches the search
+//in progress, so starting a new search doesn't have to clear anything.
+struct AStarNode
+{
+	uint32 Generation;
+	int Parent;
+	int HeapIndex;		//position in the open heap, -1 once closed
+	float GCost;
+	float FCost;
+	bool Teleport;
+};
+
 struct PathNodeSortStruct
 {
 	int id;
@@ -77,6 +85,9 @@ public:
 	PathNode* FindPathNodeByCoordinates(float x, float y, float z);
 	void ShowPathNodeNeighbours(Client *c);
 	int GetRandomPathNode();
+	uint32 GetNodeCount() const { return Head.PathNodeCount; }
+	void ClearRouteCache();
+	void ShowRouteCache(Client *c);
 
 	void NodeInfo(Client *c);
 	int32 AddNode(float x, float y, float z, float best_z, int32 requested_id = 0); //return -1 on failure, else returns the id of this node
@@ -100,9 +111,47 @@ public:
 private:
 	PathFileHeader Head;
 	PathNode *PathNodes;
+	EQEmu::MemoryMappedFile *PathCache;	//PathNodes points into this when set
 	int QuickConnectTarget;
 
-	int *ClosedListFlag;
+	//zero parse load from the .mmf beside the path file, see MapCache
+	bool loadPathCache(const char *path_file);
+	bool savePathCache(const char *path_file) const;
+	//the cache is read only, so the editing commands take a heap copy first
+	void MakeNodesWritable();
+
+	std::list<int> SearchRoute(int startID, int endID);
+
+	//A* scratch space, reused by every FindRoute call
+	void ResetSearchPool();
+	void OpenHeapPush(int NodeID);
+	int OpenHeapPop();
+	void OpenHeapSiftUp(int Index);
+	void OpenHeapSiftDown(int Index);
+
+	std::vector<AStarNode> SearchNodes;
+	std::vector<int> OpenHeap;
+	uint32 SearchGeneration;
+
+	//FindRoute(int, int) results, most recently used first, capped at
+	//Pathing:RouteCacheSize bytes. Any edit to the nodes clears it.
+	struct RouteCacheEntry
+	{
+		uint32 Key;
+		uint32 Size;
+		std::list<int> Route;
+	};
+	typedef std::list<RouteCacheEntry> RouteCacheList;
+
+	void EvictRoutes(uint32 Limit);
+
+	RouteCacheList RouteCache;
+	std::unordered_map<uint32, RouteCacheList::iterator> RouteCacheIndex;
+	uint32 RouteCacheBytes;
+	uint32 RouteCacheHits;
+	uint32 RouteCacheMisses;
+	uint32 RouteCacheEvictions;
+	uint32 RouteCacheInvalidations;
 };
 
 
@@ -25,6 +25,7 @@
 #include "zonedb.h"
 #include "../common/MiscFunctions.h"
 #include "../common/StringUtil.h"
+#include "../common/spawngroup_table.h"
 
 extern EntityList entity_list;
 
@@ -47,6 +48,22 @@ SpawnGroup::SpawnGroup( uint32 in_id, char* name, int in_group_spawn_limit, floa
 	delay=delay_in;
 	despawn=despawn_in;
 	despawn_timer=despawn_timer_in;
+	shared_ = nullptr;
+}
+
+SpawnGroup::SpawnGroup( uint32 in_id, const SpawnGroup_Struct* in_shared ) {
+	id = in_id;
+	strn0cpy( name_, in_shared->name, 120);
+	group_spawn_limit = in_shared->spawn_limit;
+	roambox[0]=in_shared->max_x;
+	roambox[1]=in_shared->min_x;
+	roambox[2]=in_shared->max_y;
+	roambox[3]=in_shared->min_y;
+	roamdist=in_shared->dist;
+	delay=in_shared->delay;
+	despawn=in_shared->despawn;
+	despawn_timer=in_shared->despawn_timer;
+	shared_ = in_shared;
 }
 
 uint32 SpawnGroup::GetNPCType() {
@@ -60,6 +77,9 @@ uint32 SpawnGroup::GetNPCType() {
 	if(!entity_list.LimitCheckGroup(id, group_spawn_limit))
 		return(0);
 
+	if(shared_)
+		return(GetSharedNPCType());
+
 	std::list<SpawnEntry*>::iterator cur,end;
 	std::list<SpawnEntry*> possible;
 	cur = list_.begin();
@@ -96,6 +116,52 @@ uint32 SpawnGroup::GetNPCType() {
 	return npcType;
 }
 
+//two rolls against the alias table, unless an entry is at its spawn limit.
+//then the rest are walked the same way as a group loaded from the database.
+uint32 SpawnGroup::GetSharedNPCType() {
+	const SpawnGroup_Struct *sg = shared_;
+	if(sg->total_chance == 0)
+		return 0;
+
+	uint32 r;
+	bool all_allowed = true;
+	for(r = 0; r < sg->NumEntries && sg->limited_entries > 0; r++) {
+		const SpawnGroupEntries_Struct &se = sg->Entries[r];
+		if(se.npc_spawn_limit > 0 && se.chance > 0 && !entity_list.LimitCheckType(se.npc_type, se.npc_spawn_limit)) {
+			all_allowed = false;
+			break;
+		}
+	}
+
+	if(all_allowed) {
+		uint32 slot = MakeRandomInt(0, sg->NumEntries-1);
+		uint32 roll = MakeRandomInt(0, sg->total_chance-1);
+		return sg->Entries[PickSpawnGroupEntry(sg, slot, roll)].npc_type;
+	}
+
+	int totalchance = 0;
+	std::list<const SpawnGroupEntries_Struct*> possible;
+	for(r = 0; r < sg->NumEntries; r++) {
+		const SpawnGroupEntries_Struct *se = &sg->Entries[r];
+		if(se->chance <= 0 || !entity_list.LimitCheckType(se->npc_type, se->npc_spawn_limit))
+			continue;
+
+		totalchance += se->chance;
+		possible.push_back(se);
+	}
+	if(totalchance == 0)
+		return 0;
+
+	int32 roll = MakeRandomInt(0, totalchance-1);
+	std::list<const SpawnGroupEntries_Struct*>::iterator cur;
+	for(cur = possible.begin(); cur != possible.end(); cur++) {
+		if(roll < (*cur)->chance)
+			return (*cur)->npc_type;
+		roll -= (*cur)->chance;
+	}
+	return 0;
+}
+
 void SpawnGroup::AddSpawnEntry( SpawnEntry* newEntry ) {
 	list_.push_back( newEntry );
 }
@@ -129,9 +195,18 @@ void SpawnGroupList::AddSpawnGroup(SpawnGroup* newGroup) {
 }
 
 SpawnGroup* SpawnGroupList::GetSpawnGroup(uint32 in_id) {
-	if(groups.count(in_id) != 1)
+	std::map<uint32, SpawnGroup*>::iterator found = groups.find(in_id);
+	if(found != groups.end())
+		return(found->second);
+
+	//anything loaded from the database wins, otherwise wrap the shared copy the first time it's asked for
+	const SpawnGroup_Struct *shared = database.GetSharedSpawnGroup(in_id);
+	if(shared == nullptr)
 		return nullptr;
-	return(groups[in_id]);
+
+	SpawnGroup *sg = new SpawnGroup(in_id, shared);
+	groups[in_id] = sg;
+	return(sg);
 }
 
 bool SpawnGroupList::RemoveSpawnGroup(uint32 in_id) {
@@ -24,6 +24,8 @@
 #include <map>
 #include <list>
 
+struct SpawnGroup_Struct;
+
 class SpawnEntry
 {
 public:
@@ -40,6 +42,7 @@ class SpawnGroup
 {
 public:
 	SpawnGroup(uint32 in_id, char* name, int in_group_spawn_limit, float dist, float maxx, float minx, float maxy, float miny, int delay_in, int despawn_in, uint32 despawn_timer_in );
+	SpawnGroup(uint32 in_id, const SpawnGroup_Struct* in_shared );	//reads its entries straight out of shared memory
 	~SpawnGroup();
 	uint32 GetNPCType();
 	void AddSpawnEntry( SpawnEntry* newEntry );
@@ -50,8 +53,11 @@ public:
 	int despawn;
 	uint32 despawn_timer;
 private:
+	uint32 GetSharedNPCType();
+
 	char name_[120];
 	std::list<SpawnEntry*> list_;
+	const SpawnGroup_Struct* shared_;	//entries and alias table, when this came from shared memory
 	uint8 group_spawn_limit; //max # of this entry which can be spawned by this group
 };
 
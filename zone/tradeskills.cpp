@@ -1321,128 +1321,86 @@ bool ZoneDatabase::GetTradeRecipe(uint32 recipe_id, uint8 c_type, uint32 some_id
 	uint32 char_id, DBTradeskillRecipe_Struct *spec)
 {
 	char errbuf[MYSQL_ERRMSG_SIZE];
-	MYSQL_RES *result;
-	MYSQL_ROW row;
-	char *query = 0;
-
-	uint32 qcount = 0;
-	uint32 qlen;
-
-	// make where clause segment for container(s)
-	char containers[30];
-	if (some_id == 0) {
-		// world combiner so no item number
-		snprintf(containers,29, "= %u", c_type);
-	} else {
-		// container in inventory
-		snprintf(containers,29, "in (%u,%u)", c_type, some_id);
-	}
+	uint32 r;
 
-	qlen = MakeAnyLenString(&query, "SELECT tr.id, tr.tradeskill, tr.skillneeded,"
+	// world combiners have no item number, the container type goes in twice
+	const char *query = "SELECT tr.id, tr.tradeskill, tr.skillneeded,"
 	" tr.trivial, tr.nofail, tr.replace_container, tr.name, tr.must_learn, tr.quest, crl.madecount"
 	" FROM tradeskill_recipe AS tr inner join tradeskill_recipe_entries as tre"
 	" ON tr.id = tre.recipe_id"
-	" LEFT JOIN (SELECT recipe_id, madecount from char_recipe_list WHERE char_id = %u) AS crl "
+	" LEFT JOIN (SELECT recipe_id, madecount from char_recipe_list WHERE char_id = ?) AS crl "
 	" ON tr.id = crl.recipe_id "
-	" WHERE tr.id = %lu AND tre.item_id %s"
-	" GROUP BY tr.id", char_id, (unsigned long)recipe_id, containers);
-
-	if (!RunQuery(query, qlen, errbuf, &result)) {
+	" WHERE tr.id = ? AND tre.item_id IN (?,?)"
+	" GROUP BY tr.id";
+	DBParams recipe_params;
+	DBResultSet recipe;
+	recipe_params.AddUInt(char_id);
+	recipe_params.AddUInt(recipe_id);
+	recipe_params.AddUInt(c_type);
+	recipe_params.AddUInt(some_id == 0 ? c_type : some_id);
+
+	if (!RunPreparedQuery(query, strlen(query), recipe_params, recipe, errbuf)) {
 		LogFile->write(EQEMuLog::Error, "Error in GetTradeRecipe, query: %s", query);
-		safe_delete_array(query);
 		LogFile->write(EQEMuLog::Error, "Error in GetTradeRecipe, error: %s", errbuf);
 		return(false);
 	}
-	safe_delete_array(query);
 
-	qcount = mysql_num_rows(result);
-	if(qcount != 1) {
+	if(recipe.RowCount() != 1) {
 		//just not found i guess..
 		return(false);
 	}
 
-	row = mysql_fetch_row(result);
-	spec->tradeskill			= (SkillType)atoi(row[1]);
-	spec->skill_needed		= (int16)atoi(row[2]);
-	spec->trivial			= (uint16)atoi(row[3]);
-	spec->nofail			= atoi(row[4]) ? true : false;
-	spec->replace_container	= atoi(row[5]) ? true : false;
-	spec->name = row[6];
-	spec->must_learn = (uint8)atoi(row[7]);
-	spec->quest = atoi(row[8]) ? true : false;
-	if (row[9] == nullptr) {
+	spec->tradeskill			= (SkillType)recipe.GetInt(0, 1);
+	spec->skill_needed		= (int16)recipe.GetInt(0, 2);
+	spec->trivial			= (uint16)recipe.GetInt(0, 3);
+	spec->nofail			= recipe.GetInt(0, 4) ? true : false;
+	spec->replace_container	= recipe.GetInt(0, 5) ? true : false;
+	spec->name = recipe.GetString(0, 6);
+	spec->must_learn = (uint8)recipe.GetInt(0, 7);
+	spec->quest = recipe.GetInt(0, 8) ? true : false;
+	if (recipe.IsNull(0, 9)) {
 		spec->has_learnt = false;
 		spec->madecount = 0;
 	} else {
 		spec->has_learnt = true;
-		spec->madecount = (uint32)atoul(row[9]);
+		spec->madecount = recipe.GetUInt(0, 9);
 	}
 	spec->recipe_id = recipe_id;
-	mysql_free_result(result);
 
-	//Pull the on-success items...
-	qlen = MakeAnyLenString(&query, "SELECT item_id,successcount FROM tradeskill_recipe_entries"
-	 " WHERE successcount>0 AND recipe_id=%u", recipe_id);
+	//Pull the on-success, on-fail and salvage items in one go
+	const char *entries_query = "SELECT item_id,successcount,failcount,salvagecount"
+		" FROM tradeskill_recipe_entries WHERE recipe_id=?";
+	DBParams params;
+	DBResultSet entries;
+	params.AddUInt(recipe_id);
 
-	if (!RunQuery(query, qlen, errbuf, &result)) {
-		LogFile->write(EQEMuLog::Error, "Error in GetTradeRecept success query '%s': %s", query, errbuf);
-		safe_delete_array(query);
+	if (!RunPreparedQuery(entries_query, strlen(entries_query), params, entries, errbuf)) {
+		LogFile->write(EQEMuLog::Error, "Error in GetTradeRecept entries query '%s': %s", entries_query, errbuf);
 		return(false);
 	}
-	safe_delete_array(query);
 
-	qcount = mysql_num_rows(result);
-	if(qcount < 1) {
-		LogFile->write(EQEMuLog::Error, "Error in GetTradeRecept success: no success items returned");
-		return(false);
-	}
-	uint8 r;
 	spec->onsuccess.clear();
-	for(r = 0; r < qcount; r++) {
-		row = mysql_fetch_row(result);
-		uint32 item = (uint32)atoi(row[0]);
-		uint8 num = (uint8) atoi(row[1]);
-		spec->onsuccess.push_back(std::pair<uint32,uint8>(item, num));
-	}
-	mysql_free_result(result);
-
-	//Pull the on-fail items...
-	qlen = MakeAnyLenString(&query, "SELECT item_id,failcount FROM tradeskill_recipe_entries"
-	 " WHERE failcount>0 AND recipe_id=%u", recipe_id);
-
 	spec->onfail.clear();
-	if (RunQuery(query, qlen, errbuf, &result)) {
-
-		qcount = mysql_num_rows(result);
-		uint8 r;
-		for(r = 0; r < qcount; r++) {
-			row = mysql_fetch_row(result);
-			uint32 item = (uint32)atoi(row[0]);
-			uint8 num = (uint8) atoi(row[1]);
-			spec->onfail.push_back(std::pair<uint32,uint8>(item, num));
-		}
-		mysql_free_result(result);
-	}
-
-	// Pull the salvage list
-	qlen = MakeAnyLenString(&query, "SELECT item_id,salvagecount FROM tradeskill_recipe_entries WHERE salvagecount>0 AND recipe_id=%u", recipe_id);
-
 	spec->salvage.clear();
-	// Don't bother with the query if TS is nofail
-	if (!spec->nofail && RunQuery(query, qlen, errbuf, &result)) {
-		qcount = mysql_num_rows(result);
-		uint8 r;
-		for(r = 0; r < qcount; r++) {
-			row = mysql_fetch_row(result);
-			uint32 item = (uint32)atoi(row[0]);
-			uint8 num = (uint8)atoi(row[1]);
-			spec->salvage.push_back(std::pair<uint32,uint8>(item, num));
-		}
-		mysql_free_result(result);
+	for(r = 0; r < entries.RowCount(); r++) {
+		uint32 item = entries.GetUInt(r, 0);
+		int32 success = entries.GetInt(r, 1);
+		int32 fail = entries.GetInt(r, 2);
+		int32 salvage = entries.GetInt(r, 3);
+		if(success > 0)
+			spec->onsuccess.push_back(std::pair<uint32,uint8>(item, (uint8)success));
+		if(fail > 0)
+			spec->onfail.push_back(std::pair<uint32,uint8>(item, (uint8)fail));
+		// Don't bother with salvage if TS is nofail
+		if(salvage > 0 && !spec->nofail)
+			spec->salvage.push_back(std::pair<uint32,uint8>(item, (uint8)salvage));
+	}
+
+	if(spec->onsuccess.empty()) {
+		LogFile->write(EQEMuLog::Error, "Error in GetTradeRecept success: no success items returned");
+		return(false);
 	}
 
-	safe_delete_array(query);
-
 	return(true);
 }
 
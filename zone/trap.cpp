@@ -203,7 +203,7 @@ void Trap::Trigger(Mob* trigger)
 }
 
 Trap* EntityList::FindNearbyTrap(Mob* searcher, float max_dist) {
-	LinkedListIterator<Trap*> iterator(trap_list);
+	DenseListIterator<Trap*> iterator(trap_list);
 	iterator.Reset();
 	float dist = 999999;
 	Trap* current_trap = nullptr;
@@ -234,7 +234,7 @@ Trap* EntityList::FindNearbyTrap(Mob* searcher, float max_dist) {
 }
 
 Mob* EntityList::GetTrapTrigger(Trap* trap) {
-	LinkedListIterator<Client*> iterator(client_list);
+	DenseListIterator<Client*> iterator(client_list);
 
 	Mob* savemob = 0;
 	iterator.Reset();
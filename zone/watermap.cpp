@@ -23,7 +23,10 @@
 #include <float.h>
 
 #include "watermap.h"
+#include "map_cache.h"
 #include "../common/StringUtil.h"
+#include "../common/rulesys.h"
+#include "../common/memory_mapped_file.h"
 
 #ifdef _WINDOWS
 #define snprintf _snprintf
@@ -33,11 +36,17 @@
 
 
 WaterMap::WaterMap()
-: BSP_Root(nullptr)
+: BSP_Root(nullptr),
+  BSP_NodeCount(0),
+  BSP_Cache(nullptr)
 {
 }
 
 WaterMap::~WaterMap() {
+	if(BSP_Cache) {
+		BSP_Root = nullptr;
+		safe_delete(BSP_Cache);
+	}
 	safe_delete_array(BSP_Root);
 }
 
@@ -126,11 +135,30 @@ WaterMap* WaterMap::LoadWaterMapfile(const char* in_zonename, const char *direct
 		directory = MAP_DIR;
 	snprintf(cWork, 250, "%s/%s.wtr", directory, strlwr(zBuf));
 
+	bool use_cache = RuleB(Map, UseFileCache);
+	if(use_cache) {
+		ret = new WaterMap();
+		if(ret->loadWaterMapCache(cWork)) {
+			printf("Water Map %s loaded from its cache.\n", cWork);
+			return ret;
+		}
+		safe_delete(ret);
+	}
+
 	if ((fp = fopen( cWork, "rb" ))) {
 		ret = new WaterMap();
 		if(ret != nullptr) {
 			if(ret->loadWaterMap(fp)) {
 				printf("Water Map %s loaded.\n", cWork);
+				if(use_cache && ret->saveWaterMapCache(cWork)) {
+					WaterMap *cached = new WaterMap();
+					if(cached->loadWaterMapCache(cWork)) {
+						safe_delete(ret);
+						ret = cached;
+					} else {
+						safe_delete(cached);
+					}
+				}
 			} else {
 				safe_delete(ret);
 				printf("Water Map %s exists but could not be processed.\n", cWork);
@@ -187,8 +215,38 @@ bool WaterMap::loadWaterMap(FILE *fp) {
 		return(false);
 	}
 
+	BSP_NodeCount = BSPTreeSize;
 	printf("Water region map has %d nodes.\n", BSPTreeSize);
 	return(true);
 }
 
+bool WaterMap::loadWaterMapCache(const char *water_file) {
+	EQEmu::MemoryMappedFile *mmf = MapCache::Open(water_file, MapCacheWater, sizeof(ZBSP_Node));
+	if(mmf == nullptr)
+		return(false);
+
+	uint32 count;
+	memcpy(&count, MapCache::GetHeader(mmf)->extra, sizeof(count));
+	const void *nodes = MapCache::GetSection(mmf, 0, count * sizeof(ZBSP_Node));
+	if(nodes == nullptr) {
+		safe_delete(mmf);
+		return(false);
+	}
+
+	BSP_Cache = mmf;
+	BSP_Root = (ZBSP_Node *) nodes;
+	BSP_NodeCount = count;
+	return(true);
+}
+
+bool WaterMap::saveWaterMapCache(const char *water_file) const {
+	if(BSP_Cache != nullptr || BSP_Root == nullptr)
+		return(false);
+
+	MapCache cache(MapCacheWater, sizeof(ZBSP_Node));
+	cache.SetExtra(&BSP_NodeCount, sizeof(BSP_NodeCount));
+	cache.AddSection(BSP_Root, BSP_NodeCount * sizeof(ZBSP_Node));
+	return(cache.Write(water_file));
+}
+
 
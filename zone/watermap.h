@@ -43,6 +43,10 @@ typedef enum {
 	RegionTypeVWater =7
 } WaterRegionType;
 
+namespace EQEmu {
+	class MemoryMappedFile;
+}
+
 class WaterMap {
 
 public:
@@ -58,8 +62,13 @@ public:
 
 private:
 	bool loadWaterMap(FILE *fp);
+	//zero parse load from the .mmf beside the water map, see MapCache
+	bool loadWaterMapCache(const char *water_file);
+	bool saveWaterMapCache(const char *water_file) const;
 
 	ZBSP_Node* BSP_Root;
+	uint32 BSP_NodeCount;
+	EQEmu::MemoryMappedFile *BSP_Cache;	//BSP_Root points into this when set
 };
 
 #endif
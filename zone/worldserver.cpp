@@ -1814,6 +1814,25 @@ void WorldServer::Process() {
 			}
 			break;
 		}
+		case ServerOP_ZoneProfile:
+		{
+			ServerZoneProfile_Struct* zp = (ServerZoneProfile_Struct*) pack->pBuffer;
+			switch(zp->Option) {
+				case ZoneProfileOff:
+					ZoneProfiler::Enable(false);
+					break;
+				case ZoneProfileOn:
+					ZoneProfiler::Enable(true);
+					break;
+				case ZoneProfileReset:
+					ZoneProfiler::Reset();
+					break;
+				case ZoneProfileSnapshot:
+					WriteZoneProfileSnapshot();
+					break;
+			}
+			break;
+		}
 		default: {
 			std::cout << " Unknown ZSopcode:" << (int)pack->opcode;
 			std::cout << " size:" << pack->size << std::endl;
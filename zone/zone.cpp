@@ -108,9 +108,6 @@ bool Zone::Bootup(uint32 iZoneID, uint32 iInstanceID, bool iStaticZone) {
 		worldserver.SetZone(0);
 		return false;
 	}
-	zone->zonemap = Map::LoadMapfile(zone->map_name);
-	zone->watermap = WaterMap::LoadWaterMapfile(zone->map_name);
-	zone->pathing = PathManager::LoadPathFile(zone->map_name);
 
 	char tmp[10];
 	//PlayerProfile_Struct* pp;
@@ -631,7 +628,7 @@ void Zone::GetMerchantDataForZoneLoad(){
 */
 }
 
-void Zone::LoadMercTemplates(){
+void Zone::LoadMercTemplates(ZoneDatabase &db){
 
 	std::string errorMessage;
 	char* Query = 0;
@@ -641,7 +638,7 @@ void Zone::LoadMercTemplates(){
 	std::list<MercStanceInfo> merc_stances;
 	merc_templates.clear();
 
-	if(!database.RunQuery(Query, MakeAnyLenString(&Query, "SELECT `class_id`, `proficiency_id`, `stance_id`, `isdefault` FROM `merc_stance_entries` order by `class_id`, `proficiency_id`, `stance_id`"), TempErrorMessageBuffer, &DatasetResult)) {
+	if(!db.RunQuery(Query, MakeAnyLenString(&Query, "SELECT `class_id`, `proficiency_id`, `stance_id`, `isdefault` FROM `merc_stance_entries` order by `class_id`, `proficiency_id`, `stance_id`"), TempErrorMessageBuffer, &DatasetResult)) {
 		errorMessage = std::string(TempErrorMessageBuffer);
 	}
 	else {
@@ -659,7 +656,7 @@ void Zone::LoadMercTemplates(){
 		mysql_free_result(DatasetResult);
 	}
 
-	if(!database.RunQuery(Query, MakeAnyLenString(&Query, "SELECT DISTINCT MTem.merc_template_id, MTyp.dbstring AS merc_type_id, MTem.dbstring AS merc_subtype_id, MTyp.race_id, MS.class_id, MTyp.proficiency_id, MS.tier_id, 0 AS CostFormula, MTem.clientversion, MTem.merc_npc_type_id FROM merc_types MTyp, merc_templates MTem, merc_subtypes MS WHERE MTem.merc_type_id = MTyp.merc_type_id AND MTem.merc_subtype_id = MS.merc_subtype_id ORDER BY MTyp.race_id, MS.class_id, MTyp.proficiency_id;"), TempErrorMessageBuffer, &DatasetResult)) {
+	if(!db.RunQuery(Query, MakeAnyLenString(&Query, "SELECT DISTINCT MTem.merc_template_id, MTyp.dbstring AS merc_type_id, MTem.dbstring AS merc_subtype_id, MTyp.race_id, MS.class_id, MTyp.proficiency_id, MS.tier_id, 0 AS CostFormula, MTem.clientversion, MTem.merc_npc_type_id FROM merc_types MTyp, merc_templates MTem, merc_subtypes MS WHERE MTem.merc_type_id = MTyp.merc_type_id AND MTem.merc_subtype_id = MS.merc_subtype_id ORDER BY MTyp.race_id, MS.class_id, MTyp.proficiency_id;"), TempErrorMessageBuffer, &DatasetResult)) {
 		errorMessage = std::string(TempErrorMessageBuffer);
 	}
 	else {
@@ -705,7 +702,7 @@ void Zone::LoadMercTemplates(){
 }
 
 
-void Zone::LoadLevelEXPMods(){
+void Zone::LoadLevelEXPMods(ZoneDatabase &db){
 	std::string errorMessage;
 	char* Query = 0;
 	char TempErrorMessageBuffer[MYSQL_ERRMSG_SIZE];
@@ -713,7 +710,7 @@ void Zone::LoadLevelEXPMods(){
 	MYSQL_ROW DataRow;
 	level_exp_mod.clear();
 
-	if(!database.RunQuery(Query, MakeAnyLenString(&Query, "SELECT level, exp_mod, aa_exp_mod FROM level_exp_mods"), TempErrorMessageBuffer, &DatasetResult)) {
+	if(!db.RunQuery(Query, MakeAnyLenString(&Query, "SELECT level, exp_mod, aa_exp_mod FROM level_exp_mods"), TempErrorMessageBuffer, &DatasetResult)) {
 		errorMessage = std::string(TempErrorMessageBuffer);
 	}
 	else {
@@ -734,7 +731,7 @@ void Zone::LoadLevelEXPMods(){
 		LogFile->write(EQEMuLog::Error, "Error in ZoneDatabase::LoadEXPLevelMods()");
 	}
 }
-void Zone::LoadMercSpells(){
+void Zone::LoadMercSpells(ZoneDatabase &db){
 
 	std::string errorMessage;
 	char* Query = 0;
@@ -743,7 +740,7 @@ void Zone::LoadMercSpells(){
 	MYSQL_ROW DataRow;
 	merc_spells_list.clear();
 
-	if(!database.RunQuery(Query, MakeAnyLenString(&Query, "SELECT msl.class_id, msl.proficiency_id, msle.spell_id, msle.spell_type, msle.stance_id, msle.minlevel, msle.maxlevel, msle.slot, msle.procChance FROM merc_spell_lists msl, merc_spell_list_entries msle WHERE msle.merc_spell_list_id = msl.merc_spell_list_id ORDER BY msl.class_id, msl.proficiency_id, msle.spell_type, msle.minlevel, msle.slot;"), TempErrorMessageBuffer, &DatasetResult)) {
+	if(!db.RunQuery(Query, MakeAnyLenString(&Query, "SELECT msl.class_id, msl.proficiency_id, msle.spell_id, msle.spell_type, msle.stance_id, msle.minlevel, msle.maxlevel, msle.slot, msle.procChance FROM merc_spell_lists msl, merc_spell_list_entries msle WHERE msle.merc_spell_list_id = msl.merc_spell_list_id ORDER BY msl.class_id, msl.proficiency_id, msle.spell_type, msle.minlevel, msle.slot;"), TempErrorMessageBuffer, &DatasetResult)) {
 		errorMessage = std::string(TempErrorMessageBuffer);
 	}
 	else {
@@ -976,6 +973,7 @@ Zone::Zone(uint32 in_zoneid, uint32 in_instanceid, const char* in_short_name)
 	aas = nullptr;
 	totalAAs = 0;
 	gottime = false;
+	boot_ms = 0.0f;
 
 	Instance_Shutdown_Timer = nullptr;
 	bool is_perma = false;
@@ -1054,123 +1052,231 @@ Zone::~Zone() {
 bool Zone::Init(bool iStaticZone) {
 	SetStaticZone(iStaticZone);
 
-	LogFile->write(EQEMuLog::Status, "Loading spawn conditions...");
-	if(!spawn_conditions.LoadSpawnConditions(short_name, instanceid)) {
-		LogFile->write(EQEMuLog::Error, "Loading spawn conditions failed, continuing without them.");
-	}
+	//load the zone config file first, the map files are named in it
+	if (!LoadZoneCFG(zone->GetShortName(), zone->GetInstanceVersion(), true)) // try loading the zone name...
+		LoadZoneCFG(zone->GetFileName(), zone->GetInstanceVersion()); // if that fails, try the file name, then load defaults
 
-	LogFile->write(EQEMuLog::Status, "Loading static zone points...");
-	if (!database.LoadStaticZonePoints(&zone_point_list, short_name, GetInstanceVersion())) {
-		LogFile->write(EQEMuLog::Error, "Loading static zone points failed.");
-		return false;
+	ZoneBoot boot(this);
+	boot.Add(ZoneBoot_SpawnConditions);
+	boot.Add(ZoneBoot_ZonePoints);
+	boot.Add(ZoneBoot_SpawnGroups);
+	boot.Add(ZoneBoot_Spawn2);
+	boot.Add(ZoneBoot_Corpses);
+	boot.Add(ZoneBoot_Traps);
+	boot.Add(ZoneBoot_AdventureFlavor);
+	boot.Add(ZoneBoot_GroundSpawns);
+	boot.Add(ZoneBoot_Objects);
+	boot.Add(ZoneBoot_Doors);
+	boot.Add(ZoneBoot_BlockedSpells);
+	//clear trader items if we are loading the bazaar
+	if(strncasecmp(short_name,"bazaar",6)==0)
+		boot.Add(ZoneBoot_Bazaar);
+	boot.Add(ZoneBoot_LDoNTraps);
+	boot.Add(ZoneBoot_VeteranRewards);
+	boot.Add(ZoneBoot_AltCurrencies);
+	boot.Add(ZoneBoot_NPCEmotes);
+	boot.Add(ZoneBoot_AAs);
+	boot.Add(ZoneBoot_Merchants);
+	if (RuleB(Mercs, AllowMercs))
+		boot.Add(ZoneBoot_Mercs);
+	if (RuleB(Zone, LevelBasedEXPMods))
+		boot.Add(ZoneBoot_LevelEXPMods);
+	boot.Add(ZoneBoot_Petitions);
+	if (map_name) {
+		boot.Add(ZoneBoot_Map);
+		boot.Add(ZoneBoot_WaterMap);
+		boot.Add(ZoneBoot_PathFile);
 	}
 
-	LogFile->write(EQEMuLog::Status, "Loading spawn groups...");
-	if (!database.LoadSpawnGroups(short_name, GetInstanceVersion(), &spawn_group_list)) {
-		LogFile->write(EQEMuLog::Error, "Loading spawn groups failed.");
-		return false;
-	}
+	boot.Run(RuleI(Zone, BootDBWorkers));
+	boot_timings = boot.GetTimings();
+	boot_ms = boot.GetTotalMS();
+	boot.Report(short_name);
 
-	LogFile->write(EQEMuLog::Status, "Loading spawn2 points...");
-	if (!database.PopulateZoneSpawnList(zoneid, spawn2_list, GetInstanceVersion()))
-	{
-		LogFile->write(EQEMuLog::Error, "Loading spawn2 points failed.");
+	if (!boot.Succeeded(ZoneBoot_ZonePoints) || !boot.Succeeded(ZoneBoot_SpawnGroups)
+		|| !boot.Succeeded(ZoneBoot_Spawn2) || !boot.Succeeded(ZoneBoot_Corpses) || !boot.Succeeded(ZoneBoot_Traps))
 		return false;
-	}
 
-	LogFile->write(EQEMuLog::Status, "Loading player corpses...");
-	if (!database.LoadPlayerCorpses(zoneid, instanceid)) {
-		LogFile->write(EQEMuLog::Error, "Loading player corpses failed.");
-		return false;
-	}
+	zonemap = boot.map;
+	watermap = boot.water_map;
+	pathing = boot.path;
+	boot.map = nullptr;
+	boot.water_map = nullptr;
+	boot.path = nullptr;
 
-	LogFile->write(EQEMuLog::Status, "Loading traps...");
-	if (!database.LoadTraps(short_name, GetInstanceVersion()))
+	if(RuleManager::Instance()->GetActiveRulesetID() != default_ruleset)
 	{
-		LogFile->write(EQEMuLog::Error, "Loading traps failed.");
-		return false;
+		std::string r_name = RuleManager::Instance()->GetRulesetName(&database, default_ruleset);
+		if(r_name.size() > 0)
+		{
+			RuleManager::Instance()->LoadRules(&database, r_name.c_str());
+		}
 	}
 
-	LogFile->write(EQEMuLog::Status, "Loading adventure flavor text...");
-	LoadAdventureFlavor();
+	LogFile->write(EQEMuLog::Status, "Loading timezone data...");
+	zone->zone_time.setEQTimeZone(database.GetZoneTZ(zoneid, GetInstanceVersion()));
 
-	LogFile->write(EQEMuLog::Status, "Loading ground spawns...");
-	if (!LoadGroundSpawns())
-	{
-		LogFile->write(EQEMuLog::Error, "Loading ground spawns failed. continuing.");
-	}
+	LogFile->write(EQEMuLog::Status, "Init Finished: ZoneID = %d, Time Offset = %d", zoneid, zone->zone_time.getEQTimeZone());
 
-	LogFile->write(EQEMuLog::Status, "Loading World Objects from DB...");
-	if (!LoadZoneObjects())
-	{
-		LogFile->write(EQEMuLog::Error, "Loading World Objects failed. continuing.");
-	}
+	LoadTickItems();
 
-	//load up the zone's doors (prints inside)
-	zone->LoadZoneDoors(zone->GetShortName(), zone->GetInstanceVersion());
-	zone->LoadBlockedSpells(zone->GetZoneID());
+	//MODDING HOOK FOR ZONE INIT
+	mod_init();
 
-	//clear trader items if we are loading the bazaar
-	if(strncasecmp(short_name,"bazaar",6)==0) {
-		database.DeleteTraderItem(0);
-		database.DeleteBuyLines(0);
-	}
+	return true;
+}
 
-	zone->LoadLDoNTraps();
-	zone->LoadLDoNTrapEntries();
-	zone->LoadVeteranRewards();
-	zone->LoadAlternateCurrencies();
-	zone->LoadNPCEmotes(&NPCEmoteList);
+bool Zone::RunBootStage(ZoneBoot &boot, uint8 stage, ZoneDatabase &db) {
+	switch(stage) {
+	case ZoneBoot_SpawnConditions:
+		LogFile->write(EQEMuLog::Status, "Loading spawn conditions...");
+		if(!spawn_conditions.LoadSpawnConditions(short_name, instanceid)) {
+			LogFile->write(EQEMuLog::Error, "Loading spawn conditions failed, continuing without them.");
+			return false;
+		}
+		return true;
 
-	//Load AA information
-	adverrornum = 500;
-	LoadAAs();
+	case ZoneBoot_ZonePoints:
+		LogFile->write(EQEMuLog::Status, "Loading static zone points...");
+		if (!db.LoadStaticZonePoints(&zone_point_list, short_name, GetInstanceVersion())) {
+			LogFile->write(EQEMuLog::Error, "Loading static zone points failed.");
+			return false;
+		}
+		return true;
 
-	//Load merchant data
-	adverrornum = 501;
-	zone->GetMerchantDataForZoneLoad();
+	case ZoneBoot_SpawnGroups:
+		if (database.HasSharedSpawnGroups()) {
+			LogFile->write(EQEMuLog::Status, "Spawn groups will be read from shared memory.");
+			return true;
+		}
+		LogFile->write(EQEMuLog::Status, "Loading spawn groups...");
+		if (!db.LoadSpawnGroups(short_name, GetInstanceVersion(), &spawn_group_list)) {
+			LogFile->write(EQEMuLog::Error, "Loading spawn groups failed.");
+			return false;
+		}
+		return true;
 
-	//Load temporary merchant data
-	adverrornum = 502;
-	zone->LoadTempMerchantData();
+	case ZoneBoot_Spawn2:
+		LogFile->write(EQEMuLog::Status, "Loading spawn2 points...");
+		if (!database.PopulateZoneSpawnList(zoneid, spawn2_list, GetInstanceVersion())) {
+			LogFile->write(EQEMuLog::Error, "Loading spawn2 points failed.");
+			return false;
+		}
+		return true;
 
-	// Merc data
-	if (RuleB(Mercs, AllowMercs)) {
-		zone->LoadMercTemplates();
-		zone->LoadMercSpells();
-	}
+	case ZoneBoot_Corpses:
+		LogFile->write(EQEMuLog::Status, "Loading player corpses...");
+		if (!database.LoadPlayerCorpses(zoneid, instanceid)) {
+			LogFile->write(EQEMuLog::Error, "Loading player corpses failed.");
+			return false;
+		}
+		return true;
 
-	if (RuleB(Zone, LevelBasedEXPMods))
-		zone->LoadLevelEXPMods();
+	case ZoneBoot_Traps:
+		LogFile->write(EQEMuLog::Status, "Loading traps...");
+		if (!database.LoadTraps(short_name, GetInstanceVersion())) {
+			LogFile->write(EQEMuLog::Error, "Loading traps failed.");
+			return false;
+		}
+		return true;
 
-	adverrornum = 503;
-	petition_list.ClearPetitions();
-	petition_list.ReadDatabase();
+	case ZoneBoot_AdventureFlavor:
+		LogFile->write(EQEMuLog::Status, "Loading adventure flavor text...");
+		LoadAdventureFlavor(db);
+		return true;
 
-	//load the zone config file.
-	if (!LoadZoneCFG(zone->GetShortName(), zone->GetInstanceVersion(), true)) // try loading the zone name...
-		LoadZoneCFG(zone->GetFileName(), zone->GetInstanceVersion()); // if that fails, try the file name, then load defaults
+	case ZoneBoot_GroundSpawns:
+		LogFile->write(EQEMuLog::Status, "Loading ground spawns...");
+		if (!LoadGroundSpawns()) {
+			LogFile->write(EQEMuLog::Error, "Loading ground spawns failed. continuing.");
+			return false;
+		}
+		return true;
 
-	if(RuleManager::Instance()->GetActiveRulesetID() != default_ruleset)
-	{
-		std::string r_name = RuleManager::Instance()->GetRulesetName(&database, default_ruleset);
-		if(r_name.size() > 0)
-		{
-			RuleManager::Instance()->LoadRules(&database, r_name.c_str());
+	case ZoneBoot_Objects:
+		LogFile->write(EQEMuLog::Status, "Loading World Objects from DB...");
+		if (!LoadZoneObjects()) {
+			LogFile->write(EQEMuLog::Error, "Loading World Objects failed. continuing.");
+			return false;
 		}
-	}
+		return true;
 
-	LogFile->write(EQEMuLog::Status, "Loading timezone data...");
-	zone->zone_time.setEQTimeZone(database.GetZoneTZ(zoneid, GetInstanceVersion()));
+	case ZoneBoot_Doors:
+		//load up the zone's doors (prints inside)
+		LoadZoneDoors(GetShortName(), GetInstanceVersion());
+		return true;
 
-	LogFile->write(EQEMuLog::Status, "Init Finished: ZoneID = %d, Time Offset = %d", zoneid, zone->zone_time.getEQTimeZone());
+	case ZoneBoot_BlockedSpells:
+		LoadBlockedSpells(GetZoneID(), db);
+		return true;
 
-	LoadTickItems();
+	case ZoneBoot_Bazaar:
+		database.DeleteTraderItem(0);
+		database.DeleteBuyLines(0);
+		return true;
 
-	//MODDING HOOK FOR ZONE INIT
-	mod_init();
+	case ZoneBoot_LDoNTraps:
+		//entries point at the traps, so these go together
+		LoadLDoNTraps(db);
+		LoadLDoNTrapEntries(db);
+		return true;
 
-	return true;
+	case ZoneBoot_VeteranRewards:
+		LoadVeteranRewards(db);
+		return true;
+
+	case ZoneBoot_AltCurrencies:
+		LoadAlternateCurrencies(db);
+		return true;
+
+	case ZoneBoot_NPCEmotes:
+		LoadNPCEmotes(&NPCEmoteList, db);
+		return true;
+
+	case ZoneBoot_AAs:
+		//Load AA information
+		adverrornum = 500;
+		LoadAAs();
+		return true;
+
+	case ZoneBoot_Merchants:
+		//Load merchant data
+		adverrornum = 501;
+		GetMerchantDataForZoneLoad();
+
+		//Load temporary merchant data
+		adverrornum = 502;
+		LoadTempMerchantData();
+		return true;
+
+	case ZoneBoot_Mercs:
+		LoadMercTemplates(db);
+		LoadMercSpells(db);
+		return true;
+
+	case ZoneBoot_LevelEXPMods:
+		LoadLevelEXPMods(db);
+		return true;
+
+	case ZoneBoot_Petitions:
+		adverrornum = 503;
+		petition_list.ClearPetitions();
+		petition_list.ReadDatabase();
+		return true;
+
+	case ZoneBoot_Map:
+		boot.map = Map::LoadMapfile(map_name);
+		return(boot.map != nullptr);
+
+	case ZoneBoot_WaterMap:
+		boot.water_map = WaterMap::LoadWaterMapfile(map_name);
+		return(boot.water_map != nullptr);
+
+	case ZoneBoot_PathFile:
+		boot.path = PathManager::LoadPathFile(map_name);
+		return(boot.path != nullptr);
+	}
+	return false;
 }
 
 void Zone::ReloadStaticData() {
@@ -1206,10 +1312,10 @@ void Zone::ReloadStaticData() {
 	zone->LoadZoneDoors(zone->GetShortName(), zone->GetInstanceVersion());
 	entity_list.RespawnAllDoors();
 
-	zone->LoadVeteranRewards();
-	zone->LoadAlternateCurrencies();
+	zone->LoadVeteranRewards(database);
+	zone->LoadAlternateCurrencies(database);
 	NPCEmoteList.Clear();
-	zone->LoadNPCEmotes(&NPCEmoteList);
+	zone->LoadNPCEmotes(&NPCEmoteList, database);
 
 	//load the zone config file.
 	if (!LoadZoneCFG(zone->GetShortName(), zone->GetInstanceVersion(), true)) // try loading the zone name...
@@ -1510,7 +1616,8 @@ bool Zone::Depop(bool StartSpawnTimer) {
 std::map<uint32,NPCType *>::iterator itr;
 	entity_list.Depop(StartSpawnTimer);
 
-	// Refresh npctable, getting current info from database.
+	// Refresh npctable, the next spawns copy each type again from the shared
+	// table (with any #reloadnpctype changes) or read it from the database.
 	while(npctable.size()) {
 		itr=npctable.begin();
 		delete itr->second;
@@ -2213,14 +2320,14 @@ void Zone::SetGraveyard(uint32 zoneid, uint32 x, uint32 y, uint32 z, uint32 head
 	pgraveyard_heading = heading;
 }
 
-void Zone::LoadBlockedSpells(uint32 zoneid)
+void Zone::LoadBlockedSpells(uint32 zoneid, ZoneDatabase &db)
 {
 	if(!blocked_spells)
 	{
-		totalBS = database.GetBlockedSpellsCount(zoneid);
+		totalBS = db.GetBlockedSpellsCount(zoneid);
 		if(totalBS > 0){
 			blocked_spells = new ZoneSpellsBlocked[totalBS];
-			if(!database.LoadBlockedSpells(totalBS, blocked_spells, zoneid))
+			if(!db.LoadBlockedSpells(totalBS, blocked_spells, zoneid))
 			{
 				LogFile->write(EQEMuLog::Error, "... Failed to load blocked spells.");
 				ClearBlockedSpells();
@@ -2352,14 +2459,14 @@ void Zone::SetInstanceTimer(uint32 new_duration)
 	}
 }
 
-void Zone::LoadLDoNTraps()
+void Zone::LoadLDoNTraps(ZoneDatabase &db)
 {
 	char errbuf[MYSQL_ERRMSG_SIZE];
 	char* query = 0;
 	MYSQL_RES *result;
 	MYSQL_ROW row;
 
-	if(database.RunQuery(query,MakeAnyLenString(&query,"SELECT id, type, spell_id, "
+	if(db.RunQuery(query,MakeAnyLenString(&query,"SELECT id, type, spell_id, "
 		"skill, locked FROM ldon_trap_templates"), errbuf, &result))
 	{
 		while((row = mysql_fetch_row(result)))
@@ -2384,14 +2491,14 @@ void Zone::LoadLDoNTraps()
 	}
 }
 
-void Zone::LoadLDoNTrapEntries()
+void Zone::LoadLDoNTrapEntries(ZoneDatabase &db)
 {
 	char errbuf[MYSQL_ERRMSG_SIZE];
 	char* query = 0;
 	MYSQL_RES *result;
 	MYSQL_ROW row;
 
-	if(database.RunQuery(query,MakeAnyLenString(&query,"SELECT id, trap_id FROM ldon_trap_entries"),errbuf,&result)) {
+	if(db.RunQuery(query,MakeAnyLenString(&query,"SELECT id, trap_id FROM ldon_trap_entries"),errbuf,&result)) {
 		while((row = mysql_fetch_row(result)))
 		{
 			uint32 id = atoi(row[0]);
@@ -2436,7 +2543,7 @@ void Zone::LoadLDoNTrapEntries()
 	}
 }
 
-void Zone::LoadVeteranRewards()
+void Zone::LoadVeteranRewards(ZoneDatabase &db)
 {
 	VeteranRewards.clear();
 	char errbuf[MYSQL_ERRMSG_SIZE];
@@ -2449,7 +2556,7 @@ void Zone::LoadVeteranRewards()
 	current_reward.claim_id = 0;
 
 
-	if(database.RunQuery(query,MakeAnyLenString(&query,"SELECT claim_id, name, item_id, charges FROM"
+	if(db.RunQuery(query,MakeAnyLenString(&query,"SELECT claim_id, name, item_id, charges FROM"
 		" veteran_reward_templates WHERE reward_slot < 8 and claim_id > 0 ORDER by claim_id, reward_slot"),
 		errbuf,&result))
 	{
@@ -2491,7 +2598,7 @@ void Zone::LoadVeteranRewards()
 	}
 }
 
-void Zone::LoadAlternateCurrencies()
+void Zone::LoadAlternateCurrencies(ZoneDatabase &db)
 {
 	AlternateCurrencies.clear();
 	char errbuf[MYSQL_ERRMSG_SIZE];
@@ -2500,7 +2607,7 @@ void Zone::LoadAlternateCurrencies()
 	MYSQL_ROW row;
 	AltCurrencyDefinition_Struct current_currency;
 
-	if(database.RunQuery(query,MakeAnyLenString(&query,"SELECT id, item_id from alternate_currency"),
+	if(db.RunQuery(query,MakeAnyLenString(&query,"SELECT id, item_id from alternate_currency"),
 		errbuf,&result))
 	{
 		while((row = mysql_fetch_row(result)))
@@ -2550,14 +2657,14 @@ void Zone::DeleteQGlobal(std::string name, uint32 npcID, uint32 charID, uint32 z
 	}
 }
 
-void Zone::LoadAdventureFlavor()
+void Zone::LoadAdventureFlavor(ZoneDatabase &db)
 {
 	char errbuf[MYSQL_ERRMSG_SIZE];
 	char* query = 0;
 	MYSQL_RES *result;
 	MYSQL_ROW row;
 
-	if(database.RunQuery(query,MakeAnyLenString(&query,"SELECT id, text FROM adventure_template_entry_flavor"), errbuf, &result))
+	if(db.RunQuery(query,MakeAnyLenString(&query,"SELECT id, text FROM adventure_template_entry_flavor"), errbuf, &result))
 	{
 		while((row = mysql_fetch_row(result)))
 		{
@@ -2633,7 +2740,7 @@ void Zone::DoAdventureActions()
 
 }
 
-void Zone::LoadNPCEmotes(LinkedList<NPC_Emote_Struct*>* NPCEmoteList)
+void Zone::LoadNPCEmotes(LinkedList<NPC_Emote_Struct*>* NPCEmoteList, ZoneDatabase &db)
 {
 	char errbuf[MYSQL_ERRMSG_SIZE];
 	char* query = 0;
@@ -2641,7 +2748,7 @@ void Zone::LoadNPCEmotes(LinkedList<NPC_Emote_Struct*>* NPCEmoteList)
 	MYSQL_ROW row;
 	NPCEmoteList->Clear();
 
-	if(database.RunQuery(query,MakeAnyLenString(&query,"SELECT emoteid, event_, type, text FROM npc_emotes"), errbuf, &result))
+	if(db.RunQuery(query,MakeAnyLenString(&query,"SELECT emoteid, event_, type, text FROM npc_emotes"), errbuf, &result))
 	{
 		while((row = mysql_fetch_row(result)))
 		{
@@ -2740,3 +2847,17 @@ void Zone::UpdateHotzone()
 	}
 	safe_delete_array(query);
 }
+
+bool WriteZoneProfileSnapshot() {
+	char file[256];
+	bool csv = RuleB(Zone, ProfileSnapshotCSV);
+	if(zone)
+		snprintf(file, sizeof(file), "logs/zoneprofile_%s_%u_%u.%s", zone->GetShortName(), zone->GetInstanceID(), ZoneConfig::get()->ZonePort, csv ? "csv" : "json");
+	else
+		snprintf(file, sizeof(file), "logs/zoneprofile_%u.%s", ZoneConfig::get()->ZonePort, csv ? "csv" : "json");
+	if(!ZoneProfiler::WriteSnapshot(file, csv)) {
+		LogFile->write(EQEMuLog::Error, "Unable to write zone profile snapshot to %s", file);
+		return(false);
+	}
+	return(true);
+}
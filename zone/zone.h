@@ -33,6 +33,7 @@
 #include "tasks.h"
 #include "pathing.h"
 #include "QGlobals.h"
+#include "zone_boot.h"
 #include <unordered_map>
 
 class Map;
@@ -81,6 +82,7 @@ struct item_tick_struct {
 extern EntityList entity_list;
 class database;
 class PathManager;
+class ZoneDatabase;
 struct SendAA_Struct;
 
 class database;
@@ -94,6 +96,10 @@ public:
 	Zone(uint32 in_zoneid, uint32 in_instanceid, const char* in_short_name);
 	~Zone();
 	bool	Init(bool iStaticZone);
+	//one stage of Init, called from whichever thread ZoneBoot runs it on
+	bool	RunBootStage(ZoneBoot &boot, uint8 stage, ZoneDatabase &db);
+	std::vector<ZoneBootTiming> boot_timings;	//from the last Init
+	float	boot_ms;
 	bool	LoadZoneCFG(const char* filename, uint16 instance_id, bool DontLoadDefault = false);
 	bool	SaveZoneCFG();
 	bool	IsLoaded();
@@ -175,15 +181,15 @@ public:
 	void	LoadTempMerchantData_result(MYSQL_RES* result);
 	void	LoadMerchantData_result(MYSQL_RES* result);
 	int		SaveTempItem(uint32 merchantid, uint32 npcid, uint32 item, int32 charges, bool sold=false);
-	void LoadMercTemplates();
-	void LoadMercSpells();
-	void LoadLevelEXPMods();
+	void LoadMercTemplates(ZoneDatabase &db);
+	void LoadMercSpells(ZoneDatabase &db);
+	void LoadLevelEXPMods(ZoneDatabase &db);
 	MercTemplate* GetMercTemplate( uint32 template_id );
 
 	void SetInstanceTimer(uint32 new_duration);
-	void LoadLDoNTraps();
-	void LoadLDoNTrapEntries();
-	void LoadAdventureFlavor();
+	void LoadLDoNTraps(ZoneDatabase &db);
+	void LoadLDoNTrapEntries(ZoneDatabase &db);
+	void LoadAdventureFlavor(ZoneDatabase &db);
 
 	std::map<uint32,NPCType *> npctable;
 	std::map<uint32,NPCType *> merctable;
@@ -204,9 +210,9 @@ public:
 	void	DoAdventureCountIncrease();
 	void	DoAdventureAssassinationCountIncrease();
 	void	DoAdventureActions();
-	void	LoadVeteranRewards();
-	void	LoadAlternateCurrencies();
-	void	LoadNPCEmotes(LinkedList<NPC_Emote_Struct*>* NPCEmoteList);
+	void	LoadVeteranRewards(ZoneDatabase &db);
+	void	LoadAlternateCurrencies(ZoneDatabase &db);
+	void	LoadNPCEmotes(LinkedList<NPC_Emote_Struct*>* NPCEmoteList, ZoneDatabase &db);
 	void	ReloadWorld(uint32 Option);
 
 	Map*	zonemap;
@@ -243,7 +249,7 @@ public:
 	bool	HasGraveyard();
 	void	SetGraveyard(uint32 zoneid, uint32 x, uint32 y, uint32 z, uint32 heading);
 
-	void		LoadBlockedSpells(uint32 zoneid);
+	void		LoadBlockedSpells(uint32 zoneid, ZoneDatabase &db);
 	void		ClearBlockedSpells();
 	bool		IsSpellBlocked(uint32 spell_id, float nx, float ny, float nz);
 	const char *GetSpellBlockedMessage(uint32 spell_id, float nx, float ny, float nz);
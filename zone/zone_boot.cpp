@@ -0,0 +1,208 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#include "../common/debug.h"
+#include "../common/rdtsc.h"
+#include "zone_boot.h"
+#include "zone.h"
+#include "zonedb.h"
+#include "map.h"
+#include "watermap.h"
+#include "pathing.h"
+#ifdef _WINDOWS
+	#include <process.h>
+#else
+	#include <pthread.h>
+#endif
+
+#define ZONE_BOOT_NAME(id, name, on) name,
+static const char *zone_boot_names[ZoneBoot_Count] = {
+	ZONE_BOOT_STAGES(ZONE_BOOT_NAME)
+};
+#undef ZONE_BOOT_NAME
+
+#define ZONE_BOOT_RUNS_ON(id, name, on) on,
+static const uint8 zone_boot_runs_on[ZoneBoot_Count] = {
+	ZONE_BOOT_STAGES(ZONE_BOOT_RUNS_ON)
+};
+#undef ZONE_BOOT_RUNS_ON
+
+ThreadReturnType ZoneBootWorkerLoop(void *arg) {
+	ZoneBoot::Worker *worker = (ZoneBoot::Worker *)arg;
+	ZoneBoot *boot = worker->boot;
+	{
+		ZoneDatabase *db = &database;
+		ZoneDatabase *own_db = nullptr;
+		if(worker->runs_on == BootOnDB) {
+			char errbuf[MYSQL_ERRMSG_SIZE];
+			own_db = new ZoneDatabase;
+			if(own_db->OpenLike(database, 0, errbuf)) {
+				db = own_db;
+			} else {
+				LogFile->write(EQEMuLog::Error, "Zone boot worker %u could not open its own connection (%s), sharing the main one", worker->number, errbuf);
+				safe_delete(own_db);
+			}
+		}
+
+		int32 index;
+		while((index = boot->NextStage(worker->runs_on)) >= 0)
+			boot->RunStage(index, *db, worker->number);
+
+		safe_delete(own_db);
+	}
+	//Run may return and take the boot with it as soon as running hits 0
+	boot->finished.Signal();
+	boot->running--;
+	THREAD_RETURN(nullptr);
+}
+
+ZoneBoot::ZoneBoot(Zone *in_zone)
+: map(nullptr),
+  water_map(nullptr),
+  path(nullptr),
+  zone(in_zone),
+  running(0),
+  start_ticks(0),
+  total_ms(0.0f)
+{
+	for(int r = 0; r < 3; r++)
+		next[r] = 0;
+}
+
+ZoneBoot::~ZoneBoot() {
+	std::vector<Worker *>::iterator cur;
+	for(cur = workers.begin(); cur != workers.end(); ++cur)
+		safe_delete(*cur);
+	safe_delete(map);
+	safe_delete(water_map);
+	safe_delete(path);
+}
+
+const char *ZoneBoot::GetStageName(uint8 stage) {
+	if(stage >= ZoneBoot_Count)
+		return("unknown");
+	return(zone_boot_names[stage]);
+}
+
+uint8 ZoneBoot::GetStageRunsOn(uint8 stage) {
+	if(stage >= ZoneBoot_Count)
+		return(BootOnZone);
+	return(zone_boot_runs_on[stage]);
+}
+
+void ZoneBoot::Add(uint8 stage) {
+	ZoneBootTiming t;
+	t.stage = stage;
+	t.thread = 0;
+	t.ok = false;
+	t.start_ms = 0.0f;
+	t.elapsed_ms = 0.0f;
+	queue[GetStageRunsOn(stage)].push_back(timings.size());
+	timings.push_back(t);
+}
+
+int32 ZoneBoot::NextStage(uint8 runs_on) {
+	uint32 claim = next[runs_on]++;
+	if(claim >= queue[runs_on].size())
+		return(-1);
+	return(queue[runs_on][claim]);
+}
+
+void ZoneBoot::RunStage(uint32 index, ZoneDatabase &db, uint8 thread) {
+	ZoneBootTiming &t = timings[index];
+	double per_ms = double(RDTSC_Timer::ticksPerMS());
+	int64 begin = RDTSC_Timer::rdtsc();
+	t.ok = zone->RunBootStage(*this, t.stage, db);
+	int64 end = RDTSC_Timer::rdtsc();
+	t.thread = thread;
+	t.start_ms = float((begin - start_ticks) / per_ms);
+	t.elapsed_ms = float((end - begin) / per_ms);
+}
+
+void ZoneBoot::StartWorker(uint8 runs_on, uint8 number) {
+	Worker *worker = new Worker;
+	worker->boot = this;
+	worker->runs_on = runs_on;
+	worker->number = number;
+	workers.push_back(worker);
+#ifdef _WINDOWS
+	_beginthread(ZoneBootWorkerLoop, 0, worker);
+#else
+	pthread_t thread;
+	pthread_create(&thread, nullptr, ZoneBootWorkerLoop, worker);
+	pthread_detach(thread);
+#endif
+}
+
+void ZoneBoot::Run(uint32 db_workers) {
+	RDTSC_Timer::calibrate();
+	start_ticks = RDTSC_Timer::rdtsc();
+
+	if(db_workers == 0) {
+		for(uint32 r = 0; r < timings.size(); r++)
+			RunStage(r, database, 0);
+	} else {
+		if(db_workers > queue[BootOnDB].size())
+			db_workers = queue[BootOnDB].size();
+		uint32 file_workers = queue[BootOnFile].size();
+		running = db_workers + file_workers;
+
+		uint8 number = 1;
+		uint32 r;
+		for(r = 0; r < db_workers; r++)
+			StartWorker(BootOnDB, number++);
+		for(r = 0; r < file_workers; r++)
+			StartWorker(BootOnFile, number++);
+
+		int32 index;
+		while((index = NextStage(BootOnZone)) >= 0)
+			RunStage(index, database, 0);
+
+		//a signal can slip in between the check and the wait, so don't wait long
+		while(running > 0)
+			finished.TimedWait(10000);
+	}
+
+	total_ms = float((RDTSC_Timer::rdtsc() - start_ticks) / double(RDTSC_Timer::ticksPerMS()));
+}
+
+bool ZoneBoot::Succeeded(uint8 stage) const {
+	std::vector<ZoneBootTiming>::const_iterator cur;
+	for(cur = timings.begin(); cur != timings.end(); ++cur) {
+		if(cur->stage == stage)
+			return(cur->ok);
+	}
+	return(true);	//never added, nothing to fail
+}
+
+void ZoneBoot::Report(const char *zone_name) const {
+	float serial_ms = 0.0f;
+	std::vector<ZoneBootTiming>::const_iterator cur;
+	for(cur = timings.begin(); cur != timings.end(); ++cur)
+		serial_ms += cur->elapsed_ms;
+
+	LogFile->write(EQEMuLog::Status, "Boot timing for %s: %.1f ms, stages add up to %.1f ms", zone_name, total_ms, serial_ms);
+	for(cur = timings.begin(); cur != timings.end(); ++cur) {
+		char where[16];
+		if(cur->thread == 0)
+			snprintf(where, sizeof(where), "zone");
+		else
+			snprintf(where, sizeof(where), "%s %u", GetStageRunsOn(cur->stage) == BootOnFile ? "file" : "db", cur->thread);
+		LogFile->write(EQEMuLog::Status, "..%s: %.1f ms, from %.1f ms on %s%s", GetStageName(cur->stage),
+			cur->elapsed_ms, cur->start_ms, where, cur->ok ? "" : " (failed)");
+	}
+}
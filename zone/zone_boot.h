@@ -0,0 +1,144 @@
+/*	EQEMu: Everquest Server Emulator
+	Copyright (C) 2001-2013 EQEMu Development Team (http://eqemulator.net)
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; version 2 of the License.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY except by those people which sell it, which
+	are required to give you total support for your newly bought product;
+	without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+	A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#ifndef ZONE_BOOT_H
+#define ZONE_BOOT_H
+
+#include "../common/types.h"
+#include "../common/Condition.h"
+#include <atomic>
+#include <vector>
+
+class Zone;
+class ZoneDatabase;
+class Map;
+class WaterMap;
+class PathManager;
+
+//where a stage runs
+enum ZoneBootRunsOn {
+	BootOnZone,	//the zone thread, in the order added, through the global database
+	BootOnDB,	//a boot worker with its own database connection
+	BootOnFile	//a file thread, no database at all
+};
+
+//every stage of Zone::Init, in the order a serial boot runs them.
+//zone stages add to entity_list or touch globals, so they stay put.
+#define ZONE_BOOT_STAGES(X) \
+	X(SpawnConditions,	"spawn conditions",		BootOnZone) \
+	X(ZonePoints,		"static zone points",	BootOnDB) \
+	X(SpawnGroups,		"spawn groups",			BootOnDB) \
+	X(Spawn2,			"spawn2 points",		BootOnZone) \
+	X(Corpses,			"player corpses",		BootOnZone) \
+	X(Traps,			"traps",				BootOnZone) \
+	X(AdventureFlavor,	"adventure flavor text",	BootOnDB) \
+	X(GroundSpawns,		"ground spawns",		BootOnZone) \
+	X(Objects,			"world objects",		BootOnZone) \
+	X(Doors,			"doors",				BootOnZone) \
+	X(BlockedSpells,	"blocked spells",		BootOnDB) \
+	X(Bazaar,			"bazaar trader reset",	BootOnZone) \
+	X(LDoNTraps,		"ldon traps",			BootOnDB) \
+	X(VeteranRewards,	"veteran rewards",		BootOnDB) \
+	X(AltCurrencies,	"alternate currencies",	BootOnDB) \
+	X(NPCEmotes,		"npc emotes",			BootOnDB) \
+	X(AAs,				"alternate abilities",	BootOnZone) \
+	X(Merchants,		"merchant lists",		BootOnZone) \
+	X(Mercs,			"merc templates",		BootOnDB) \
+	X(LevelEXPMods,		"level exp mods",		BootOnDB) \
+	X(Petitions,		"petitions",			BootOnZone) \
+	X(Map,				"map file",				BootOnFile) \
+	X(WaterMap,			"water map file",		BootOnFile) \
+	X(PathFile,			"path file",			BootOnFile)
+
+#define ZONE_BOOT_ENUM(id, name, on) ZoneBoot_##id,
+enum ZoneBootStage {
+	ZONE_BOOT_STAGES(ZONE_BOOT_ENUM)
+	ZoneBoot_Count
+};
+#undef ZONE_BOOT_ENUM
+
+//how one stage went, times are from the start of the boot
+struct ZoneBootTiming {
+	uint8	stage;
+	uint8	thread;		//0 for the zone thread, else the worker's number
+	bool	ok;
+	float	start_ms;
+	float	elapsed_ms;
+};
+
+/*
+	Runs the stages of Zone::Init that don't depend on each other at the
+	same time. DB stages go to workers that each open their own database
+	connection (sharing the global one if that fails), file stages get a
+	thread each, and the zone thread works through its own stages in the
+	meantime. Run returns once every stage has finished.
+
+	Stages call back into Zone::RunBootStage. Anything a worker stage loads
+	has to land in something only that stage touches until Run returns,
+	which is why the map files are handed back here instead of going
+	straight into zone->zonemap.
+
+	With no DB workers every stage runs on the zone thread in the order
+	they were added, the same as the old serial boot.
+*/
+class ZoneBoot {
+public:
+	ZoneBoot(Zone *zone);
+	~ZoneBoot();	//frees any map files nobody took
+
+	void	Add(uint8 stage);
+	void	Run(uint32 db_workers);
+
+	bool	Succeeded(uint8 stage) const;
+	float	GetTotalMS() const { return(total_ms); }
+	const std::vector<ZoneBootTiming> &GetTimings() const { return(timings); }
+	//logs the total and one line per stage
+	void	Report(const char *zone_name) const;
+
+	static const char *GetStageName(uint8 stage);
+	static uint8 GetStageRunsOn(uint8 stage);
+
+	//set by the file stages
+	Map			*map;
+	WaterMap	*water_map;
+	PathManager	*path;
+
+protected:
+	friend ThreadReturnType ZoneBootWorkerLoop(void *arg);
+	struct Worker {
+		ZoneBoot *boot;
+		uint8 runs_on;
+		uint8 number;
+	};
+
+	void	RunStage(uint32 index, ZoneDatabase &db, uint8 thread);
+	//index into timings of the next stage of this kind nobody has claimed, or -1
+	int32	NextStage(uint8 runs_on);
+	void	StartWorker(uint8 runs_on, uint8 number);
+
+	Zone	*zone;
+	std::vector<ZoneBootTiming> timings;
+	std::vector<uint32> queue[3];	//per ZoneBootRunsOn, indexes into timings
+	std::atomic<uint32> next[3];	//how far into each queue has been claimed
+	std::atomic<uint32> running;
+	std::vector<Worker *> workers;
+	Condition finished;
+	int64	start_ticks;
+	float	total_ms;
+};
+
+#endif
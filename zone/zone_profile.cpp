@@ -17,57 +17,210 @@
 */
 #include "../common/debug.h"
 #include "../common/features.h"
-
-#ifdef EQPROFILE
 #include "zone_profile.h"
 #include "../common/common_profile.h"
-#include "../common/timer.h"
+#include "../common/Mutex.h"
 #include "../common/rdtsc.h"
 
 #include <time.h>
 #include <string.h>
+#include <stdio.h>
 #ifdef WIN32
-	#include <process.h>
-
 	#define snprintf	_snprintf
-	#define vsnprintf	_vsnprintf
-	#define strncasecmp	_strnicmp
-	#define strcasecmp	_stricmp
-#else
-	#include <sys/types.h>
-	#include <unistd.h>
-	#include <stdarg.h>
 #endif
 
+#include <string>
 #include <vector>
 #include <algorithm>
 
 #ifdef COMMON_PROFILE
 CommonProfiler _cp;
 #endif
-#ifdef ZONE_PROFILE
-ZoneProfiler _zp;
-#endif
+
+struct ZoneProfileBlock {
+	uint32 generation;
+	ZoneProfileCounter counters[ZoneProfiler::MaxZoneProfilerId];
+};
+
+bool ZoneProfiler::enabled = false;
+
+static const char *zp_names[ZoneProfiler::MaxZoneProfilerId] = {
+#define ZONE_PROFILER_NAME(name) #name,
+	ZONE_PROFILER_IDS(ZONE_PROFILER_NAME)
+#undef ZONE_PROFILER_NAME
+};
+
+//blocks are never freed, a thread that exits keeps its samples in the totals
+static Mutex MZoneProfile;
+static std::vector<ZoneProfileBlock *> zp_blocks;
+static volatile uint32 zp_generation = 1;
+static THREAD_LOCAL ZoneProfileBlock *zp_local = nullptr;
+static int64 zp_elapsed = 0;
+static int64 zp_enabled_at = 0;
+
+static void ClearBlock(ZoneProfileBlock *b) {
+	int r;
+	for(r = 0; r < ZoneProfiler::MaxZoneProfilerId; r++) {
+		b->counters[r].calls = 0;
+		b->counters[r].ticks = 0;
+		b->counters[r].hist.Clear();
+	}
+}
+
+void ZoneProfiler::Enable(bool on) {
+	LockMutex lock(&MZoneProfile);
+	if(on == enabled)
+		return;
+	RDTSC_Timer::calibrate();
+	if(on)
+		zp_enabled_at = RDTSC_Timer::rdtsc();
+	else
+		zp_elapsed += RDTSC_Timer::rdtsc() - zp_enabled_at;
+	enabled = on;
+}
+
+void ZoneProfiler::Reset() {
+	LockMutex lock(&MZoneProfile);
+	zp_generation++;
+	zp_elapsed = 0;
+	if(enabled)
+		zp_enabled_at = RDTSC_Timer::rdtsc();
+}
+
+void ZoneProfiler::Record(uint32 id, int64 ticks) {
+	if(id >= MaxZoneProfilerId || ticks < 0)
+		return;
+	ZoneProfileBlock *b = zp_local;
+	if(b == nullptr) {
+		b = new ZoneProfileBlock;
+		ClearBlock(b);
+		b->generation = zp_generation;
+		LockMutex lock(&MZoneProfile);
+		zp_blocks.push_back(b);
+		zp_local = b;
+	}
+	uint32 gen = zp_generation;
+	if(b->generation != gen) {
+		ClearBlock(b);
+		b->generation = gen;
+	}
+	ZoneProfileCounter &c = b->counters[id];
+	c.calls++;
+	c.ticks += ticks;
+	c.hist.Add(ticks);
+}
+
+const char *ZoneProfiler::GetName(uint32 id) {
+	if(id >= MaxZoneProfilerId)
+		return("Unknown");
+	return(zp_names[id]);
+}
+
+void ZoneProfiler::Snapshot(std::vector<ZoneProfileCounter> &out) {
+	out.resize(MaxZoneProfilerId);
+	int r;
+	for(r = 0; r < MaxZoneProfilerId; r++) {
+		out[r].calls = 0;
+		out[r].ticks = 0;
+		out[r].hist.Clear();
+	}
+
+	LockMutex lock(&MZoneProfile);
+	std::vector<ZoneProfileBlock *>::iterator cur;
+	for(cur = zp_blocks.begin(); cur != zp_blocks.end(); ++cur) {
+		ZoneProfileBlock *b = *cur;
+		if(b->generation != zp_generation)
+			continue;	//nothing recorded on that thread since the reset
+		for(r = 0; r < MaxZoneProfilerId; r++) {
+			out[r].calls += b->counters[r].calls;
+			out[r].ticks += b->counters[r].ticks;
+			out[r].hist.Merge(b->counters[r].hist);
+		}
+	}
+}
+
+double ZoneProfiler::GetElapsed() {
+	LockMutex lock(&MZoneProfile);
+	int64 ticks = zp_elapsed;
+	if(enabled)
+		ticks += RDTSC_Timer::rdtsc() - zp_enabled_at;
+	return(TicksPerUS() > 0 ? double(ticks) / TicksPerUS() / 1000000.0 : 0);
+}
+
+double ZoneProfiler::TicksPerUS() {
+	RDTSC_Timer::calibrate();
+	return(double(RDTSC_Timer::ticksPerMS()) / 1000.0);
+}
+
+bool ZoneProfiler::WriteSnapshot(const char *file, bool csv) {
+	std::vector<ZoneProfileCounter> counters;
+	Snapshot(counters);
+	double elapsed = GetElapsed();
+	double tpus = TicksPerUS();
+	if(tpus <= 0)
+		tpus = 1;
+
+	FILE *f = fopen(file, "a");
+	if(f == nullptr)
+		return(false);
+	fseek(f, 0, SEEK_END);
+	bool empty = ftell(f) == 0;
+	unsigned long now = (unsigned long)time(nullptr);
+
+	if(csv) {
+		if(empty)
+			fprintf(f, "time,elapsed_s,section,calls,total_ms,mean_us,p50_us,p90_us,p99_us,max_us\n");
+	} else {
+		fprintf(f, "{\"time\":%lu,\"elapsed_s\":%.3f,\"sections\":{", now, elapsed);
+	}
+
+	bool first = true;
+	int r;
+	for(r = 0; r < MaxZoneProfilerId; r++) {
+		const ZoneProfileCounter &c = counters[r];
+		if(c.calls == 0)
+			continue;
+		double total_ms = double(c.ticks) / tpus / 1000.0;
+		double mean = double(c.hist.Mean()) / tpus;
+		double p50 = double(c.hist.Percentile(0.5f)) / tpus;
+		double p90 = double(c.hist.Percentile(0.9f)) / tpus;
+		double p99 = double(c.hist.Percentile(0.99f)) / tpus;
+		double max = double(c.hist.Max()) / tpus;
+		if(csv) {
+			fprintf(f, "%lu,%.3f,%s,%llu,%.3f,%.2f,%.2f,%.2f,%.2f,%.2f\n", now, elapsed, zp_names[r],
+				(unsigned long long)c.calls, total_ms, mean, p50, p90, p99, max);
+		} else {
+			fprintf(f, "%s\"%s\":{\"calls\":%llu,\"total_ms\":%.3f,\"mean_us\":%.2f,\"p50_us\":%.2f,\"p90_us\":%.2f,\"p99_us\":%.2f,\"max_us\":%.2f}",
+				first ? "" : ",", zp_names[r], (unsigned long long)c.calls, total_ms, mean, p50, p90, p99, max);
+		}
+		first = false;
+	}
+
+	if(!csv)
+		fprintf(f, "}}\n");
+	fclose(f);
+	return(true);
+}
 
 class _DZP_Data {
 public:
-	_DZP_Data(const char *_str, unsigned long long _count, double _dur) {
+	_DZP_Data(const char *_str, unsigned long long _count, double _dur, const char *_hist = "") {
 		str = _str;
 		count = _count;
 		dur = _dur;
+		hist = _hist;
 	}
 
 	const char *str;
 	unsigned long long count;
 	double dur;
+	std::string hist;
 };
 
 bool operator<(const _DZP_Data &l, const _DZP_Data &r) {
 	return(l.dur < r.dur);
 }
 
-RDTSC_Collector __DZP_timer(true);
-
 #ifdef COMMON_PROFILE
 /*
 
@@ -113,142 +266,19 @@ const char *__cp_names[CommonProfiler::MaxCommonProfilerId] = {
 };
 #endif
 
-#ifdef ZONE_PROFILE
-const char *__zp_names[ZoneProfiler::MaxZoneProfilerId] = {
-		"Client_Process = 0",
-		"Client_HandlePacket",
-		"Client_QueuePacket",
-		"Client_Save",
-		"Client_Attack",
-		"Client_CalcBonuses",
-		"Client_GetFactionLevel",
-		"Client_SetFactionLevel",
-		"Client_SetFactionLevel2",
-
-		"NPC_Attack",
-		"NPC_GetReverseFactionCon",
-		"NPC_Process",
-		"NPC_Death",
-#ifdef EQBOTS
-		"NPC_BotAttackMelee",
-#endif
-
-		"EntityList_TrapProcess",
-		"EntityList_GroupProcess",
-		"EntityList_QueueToGroupsForNPCHealthAA",
-		"EntityList_DoorProcess",
-		"EntityList_ObjectProcess",
-		"EntityList_CorpseProcess",
-		"EntityList_MobProcess",
-		"EntityList_BeaconProcess",
-		"EntityList_Process",
-		"EntityList_RaidProcess",
-		"EntityList_AICheckCloseAggro",
-		"EntityList_AICheckCloseBeneficialSpells",
-		"EntityList_CheckClientAggro",
-		"EntityList_CheckClientAggro_Loop",
-		"EntityList_AIYellForHelp",
-#ifdef EQBOTS
-		"EntityList_Bot_AICheckCloseBeneficialSpells",
-#endif
-
-		"HateList_Find",
-		"HateList_GetDamageTop",
-		"HateList_GetClosest",
-		"HateList_DoFactionHits",
-		"HateList_GetTop",
-		"HateList_IsEmpty",
-		"HateList_GetMostHate",
-
-		"Mob_CheckWillAggro",
-		"Mob_CheckLosFN",
-		"Mob_Dist",
-		"Mob_DistNoZ",
-		"Mob_DistNoRoot",
-		"Mob_DistNoRootNoZ",
-		"Mob_AICastSpell",
-		"Mob_SpellEffect",
-		"Mob_DoBuffTic",
-		"Mob_CastSpell",
-		"Mob_DoCastSpell",
-		"Mob_CastedSpellFinished",
-		"Mob_SpellFinished",
-		"Mob_IsImmuneToSpell",
-		"Mob_CalculateNewPosition",
-		"Mob_CalculateNewPosition2",
-		"Mob_GetWeaponDamageA",
-		"Mob_GetWeaponDamage",
-		"Mob_GetWeaponDamageBonus",
-		"Mob_TryWeaponProcA",
-		"Mob_TryWeaponProcB",
-#ifdef EQBOTS
-		"NPC_Bot_AICastSpell",
-		"Bot_AI_Process_pursue_cast",
-		"Bot_PET_Process_IsEngaged",
-#endif
-
-		"Map_LineIntersectsZone",
-		"Map_LineIntersectsNode",
-		"Map_FindBestZ",
-
-		"Pathing_FindRoute_FromNodes",
-		"Pathing_CheckTerrainPassable",
-		"Pathing_FindRoute_FromVertices",
-		"Pathing_UpdatePath",
-		"Pathing_NoHazards",
-		"Pathing_OpenDoors",
-		"Pathing_VertexDistance",
-		"Pathing_VertexDistanceNoRoot",
-
-		"Mob_AI_Process",
-		"Mob_AI_Process_engaged",
-		"Mob_AI_Process_engaged_cast",
-		"Mob_AI_Process_pursue_cast",
-		"Mob_AI_Process_autocast",
-		"Mob_AI_Process_scanarea",
-		"Mob_AI_Process_move",
-		"Mob_AI_Process_pet",
-		"Mob_AI_Process_roambox",
-		"Mob_AI_Process_roamer",
-		"Mob_AI_Process_guard",
-#ifdef EQBOTS
-		"Mob_BOT_Process",
-		"Mob_BOT_Process_IsEngaged",
-		"Bot_AI_Process_engaged_cast",
-		"NPC_Bot_AI_IdleCastCheck",
-#endif
-
-		"Database_AddLootTableToNPC",
-
-		"Zone_Bootup",
-		"Zone_Process",
-
-		"WorldServer_Process",
-
-		"Spawn2_Process",
-
-		"PerlembParser_SendCommands",
-		"PerlXSParser_SendCommands",
-
-		"command_realdispatch",
-		"net_main"
-};
-#endif
-
 void DumpZoneProfile() {
-	__DZP_timer.stop();
 	time_t aclock;
 	struct tm *newtime;
 
 	time( &aclock ); /* Get time in seconds */
 	newtime = localtime( &aclock ); /* Convert time to struct */
+	double elapsed = ZoneProfiler::GetElapsed() * 1000.0;
 	LogFile->write(EQEMuLog::Debug, "Profiling dump at: [%02d/%02d - %02d:%02d:%02d] (%.2f ms of data)",
 		newtime->tm_mon+1, newtime->tm_mday, newtime->tm_hour, newtime->tm_min, newtime->tm_sec,
-		__DZP_timer.getTotalDuration());
+		elapsed);
 
 	std::vector<_DZP_Data> data;
 
-
 	int r;
 #ifdef COMMON_PROFILE
 	//Dump common profile
@@ -257,12 +287,15 @@ void DumpZoneProfile() {
 	}
 #endif
 
-#ifdef ZONE_PROFILE
-	//Dump zone profile
+	//Dump zone profile, percentiles in ticks
+	std::vector<ZoneProfileCounter> counters;
+	ZoneProfiler::Snapshot(counters);
+	double tpms = ZoneProfiler::TicksPerUS() * 1000.0;
+	char summary[256];
 	for(r = 0; r < ZoneProfiler::MaxZoneProfilerId; r++) {
-		data.push_back(_DZP_Data(__zp_names[r], _zp.getCount(r), _zp.getTotalDuration(r)));
+		counters[r].hist.Summary(summary, sizeof(summary));
+		data.push_back(_DZP_Data(ZoneProfiler::GetName(r), counters[r].calls, tpms > 0 ? double(counters[r].ticks) / tpms : 0, summary));
 	}
-#endif
 
 	sort(data.begin(), data.end());
 
@@ -274,14 +307,12 @@ void DumpZoneProfile() {
 		if(cur->count == 0)
 			continue;	//dont print empty timers.
 
-		LogFile->write(EQEMuLog::Debug, "..%s: %llu calls, %.4fms", cur->str, (unsigned long long)cur->count, cur->dur);
+		LogFile->write(EQEMuLog::Debug, "..%s: %llu calls, %.4fms %s", cur->str, (unsigned long long)cur->count, cur->dur, cur->hist.c_str());
 	}
 
 	LogFile->write(EQEMuLog::Debug, "End Profiling dump at: [%02d/%02d - %02d:%02d:%02d] (%.2f ms of data)",
 		newtime->tm_mon+1, newtime->tm_mday, newtime->tm_hour, newtime->tm_min, newtime->tm_sec,
-		__DZP_timer.getTotalDuration());
-
-	__DZP_timer.start();
+		elapsed);
 }
 
 void ResetZoneProfile() {
@@ -289,11 +320,5 @@ void ResetZoneProfile() {
 #ifdef COMMON_PROFILE
 	_cp.reset();
 #endif
-#ifdef ZONE_PROFILE
-	_zp.reset();
-#endif
-	__DZP_timer.reset();
+	ZoneProfiler::Reset();
 }
-
-#endif //EQPROFILE
-
@@ -18,148 +18,195 @@
 #ifndef ZONE_PROFILE_H
 #define ZONE_PROFILE_H
 
-#ifdef ZONE	//only possibly profile if we are building zone
-#include "../common/features.h"
-#endif
-
-#ifdef EQPROFILE
-	extern void DumpZoneProfile();
-	extern void ResetZoneProfile();
-	#ifdef PROFILE_DUMP_TIME
-		extern void ProfilerProcess();
-	#endif
-#else
-	#ifdef ZONE_PROFILE	//no EQPROFILE == no zone profile
-	#undef ZONE_PROFILE
-	#endif
-#endif
-
-#ifdef ZONE_PROFILE
+#include "../common/types.h"
+#include "../common/histogram.h"
+#include "../common/rdtsc.h"
+#include <vector>
+
+//every _ZP() section, in dump order
+#define ZONE_PROFILER_IDS(X) \
+	X(Client_Process) \
+	X(Client_HandlePacket) \
+	X(Client_QueuePacket) \
+	X(Client_Save) \
+	X(Client_Attack) \
+	X(Client_CalcBonuses) \
+	X(Client_GetFactionLevel) \
+	X(Client_SetFactionLevel) \
+	X(Client_SetFactionLevel2) \
+	\
+	X(NPC_Attack) \
+	X(NPC_GetReverseFactionCon) \
+	X(NPC_Process) \
+	X(NPC_Death) \
+	X(Bot_Attack) \
+	X(Bot_GetReverseFactionCon) \
+	X(Bot_Process) \
+	\
+	X(EntityList_TrapProcess) \
+	X(EntityList_GroupProcess) \
+	X(EntityList_QueueToGroupsForNPCHealthAA) \
+	X(EntityList_DoorProcess) \
+	X(EntityList_ObjectProcess) \
+	X(EntityList_CorpseProcess) \
+	X(EntityList_MobProcess) \
+	X(EntityList_BeaconProcess) \
+	X(EntityList_Process) \
+	X(EntityList_RaidProcess) \
+	X(EntityList_AICheckCloseAggro) \
+	X(EntityList_AICheckCloseBeneficialSpells) \
+	X(EntityList_CheckClientAggro) \
+	X(EntityList_CheckClientAggro_Loop) \
+	X(EntityList_AIYellForHelp) \
+	X(EntityList_Bot_AICheckCloseBeneficialSpells) \
+	X(EntityList_Merc_AICheckCloseBeneficialSpells) \
+	\
+	X(HateList_Find) \
+	X(HateList_GetDamageTop) \
+	X(HateList_GetClosest) \
+	X(HateList_DoFactionHits) \
+	X(HateList_GetTop) \
+	X(HateList_IsEmpty) \
+	X(HateList_GetMostHate) \
+	\
+	X(Mob_CheckWillAggro) \
+	X(Mob_CheckLosFN) \
+	X(Mob_Dist) \
+	X(Mob_DistNoZ) \
+	X(Mob_DistNoRoot) \
+	X(Mob_DistNoRootNoZ) \
+	X(Mob_AICastSpell) \
+	X(Mob_SpellEffect) \
+	X(Mob_DoBuffTic) \
+	X(Mob_CastSpell) \
+	X(Mob_DoCastSpell) \
+	X(Mob_CastedSpellFinished) \
+	X(Mob_SpellFinished) \
+	X(Mob_IsImmuneToSpell) \
+	X(Mob_CalculateNewPosition) \
+	X(Mob_CalculateNewPosition2) \
+	X(Mob_GetWeaponDamageA) \
+	X(Mob_GetWeaponDamageB) \
+	X(Mob_GetWeaponDamageBonus) \
+	X(Mob_TryWeaponProcA) \
+	X(Mob_TryWeaponProcB) \
+	X(Bot_AICastSpell) \
+	X(Bot_CastSpell) \
+	X(Merc_CalcBonuses) \
+	\
+	X(Map_LineIntersectsZone) \
+	X(Map_LineIntersectsNode) \
+	X(Map_FindBestZ) \
+	\
+	X(Pathing_FindRoute_FromNodes) \
+	X(Pathing_CheckTerrainPassable) \
+	X(Pathing_FindRoute_FromVertices) \
+	X(Pathing_UpdatePath) \
+	X(Pathing_NoHazards) \
+	X(Pathing_OpenDoors) \
+	X(Pathing_VertexDistance) \
+	X(Pathing_VertexDistanceNoRoot) \
+	\
+	X(Mob_AI_Process) \
+	X(Mob_AI_Process_engaged) \
+	X(Mob_AI_Process_engaged_cast) \
+	X(Mob_AI_Process_pursue_cast) \
+	X(Mob_AI_Process_autocast) \
+	X(Mob_AI_Process_scanarea) \
+	X(Mob_AI_Process_move) \
+	X(Mob_AI_Process_pet) \
+	X(Mob_AI_Process_roambox) \
+	X(Mob_AI_Process_roamer) \
+	X(Mob_AI_Process_guard) \
+	X(Mob_BOT_Process) \
+	X(Mob_BOT_Process_IsEngaged) \
+	X(Bot_AI_Process_engaged_cast) \
+	X(Bot_AI_Process_pursue_cast) \
+	X(Bot_AI_IdleCastCheck) \
+	X(Bot_PET_Process) \
+	X(Bot_PET_Process_IsEngaged) \
+	X(Merc_AI_Process_engaged_cast) \
+	X(Merc_AI_IdleCastCheck) \
+	\
+	X(Database_AddLootTableToNPC) \
+	\
+	X(Zone_Bootup) \
+	X(Zone_Process) \
+	\
+	X(WorldServer_Process) \
+	\
+	X(Spawn2_Process) \
+	\
+	X(PerlembParser_SendCommands) \
+	X(PerlXSParser_SendCommands) \
+	\
+	X(command_realdispatch) \
+	\
+	X(net_main)
+
+struct ZoneProfileCounter {
+	uint64 calls;
+	uint64 ticks;
+	LogHistogram hist;	//ticks per call
+};
 
-#include "../common/profiler.h"
+/*
+	Always compiled in, off until enabled by #zprofile, the world console
+	or the Zone:EnableProfiler rule. While off a _ZP() section costs a load
+	and a branch.
 
-class ZoneProfiler : public GeneralProfiler {
+	Each thread records into its own block of counters, so sections on
+	DBAsync workers and the main loop never contend. Snapshot merges the
+	blocks; Reset bumps a generation and each thread clears its own block
+	the next time it records, so nothing is written from two threads.
+*/
+class ZoneProfiler {
 public:
 	enum {
-		Client_Process = 0,
-		Client_HandlePacket,
-		Client_QueuePacket,
-		Client_Save,
-		Client_Attack,
-		Client_CalcBonuses,
-		Client_GetFactionLevel,
-		Client_SetFactionLevel,
-		Client_SetFactionLevel2,
-
-		NPC_Attack,
-		NPC_GetReverseFactionCon,
-		NPC_Process,
-		NPC_Death,
-
-		EntityList_TrapProcess,
-		EntityList_GroupProcess,
-		EntityList_QueueToGroupsForNPCHealthAA,
-		EntityList_DoorProcess,
-		EntityList_ObjectProcess,
-		EntityList_CorpseProcess,
-		EntityList_MobProcess,
-		EntityList_BeaconProcess,
-		EntityList_Process,
-		EntityList_RaidProcess,
-		EntityList_AICheckCloseAggro,
-		EntityList_AICheckCloseBeneficialSpells,
-		EntityList_CheckClientAggro,
-		EntityList_CheckClientAggro_Loop,
-		EntityList_AIYellForHelp,
-
-		HateList_Find,
-		HateList_GetDamageTop,
-		HateList_GetClosest,
-		HateList_DoFactionHits,
-		HateList_GetTop,
-		HateList_IsEmpty,
-		HateList_GetMostHate,
-
-		Mob_CheckWillAggro,
-		Mob_CheckLosFN,
-		Mob_Dist,
-		Mob_DistNoZ,
-		Mob_DistNoRoot,
-		Mob_DistNoRootNoZ,
-		Mob_AICastSpell,
-		Mob_SpellEffect,
-		Mob_DoBuffTic,
-		Mob_CastSpell,
-		Mob_DoCastSpell,
-		Mob_CastedSpellFinished,
-		Mob_SpellFinished,
-		Mob_IsImmuneToSpell,
-		Mob_CalculateNewPosition,
-		Mob_CalculateNewPosition2,
-		Mob_GetWeaponDamageA,
-		Mob_GetWeaponDamageB,
-		Mob_GetWeaponDamageBonus,
-		Mob_TryWeaponProcA,
-		Mob_TryWeaponProcB,
-
-		Map_LineIntersectsZone,
-		Map_LineIntersectsNode,
-		Map_FindBestZ,
-
-		Pathing_FindRoute_FromNodes,
-		Pathing_CheckTerrainPassable,
-		Pathing_FindRoute_FromVertices,
-		Pathing_UpdatePath,
-		Pathing_NoHazards,
-		Pathing_OpenDoors,
-		Pathing_VertexDistance,
-		Pathing_VertexDistanceNoRoot,
-
-		Mob_AI_Process,
-		Mob_AI_Process_engaged,
-		Mob_AI_Process_engaged_cast,
-		Mob_AI_Process_pursue_cast,
-		Mob_AI_Process_autocast,
-		Mob_AI_Process_scanarea,
-		Mob_AI_Process_move,
-		Mob_AI_Process_pet,
-		Mob_AI_Process_roambox,
-		Mob_AI_Process_roamer,
-		Mob_AI_Process_guard,
-
-
-
-		Database_AddLootTableToNPC,
-
-		Zone_Bootup,
-		Zone_Process,
-
-		WorldServer_Process,
-
-		Spawn2_Process,
-
-		PerlembParser_SendCommands,
-		PerlXSParser_SendCommands,
-
-		command_realdispatch,
-
-		net_main,
-
+#define ZONE_PROFILER_ENUM(name) name,
+		ZONE_PROFILER_IDS(ZONE_PROFILER_ENUM)
+#undef ZONE_PROFILER_ENUM
 		MaxZoneProfilerId
 	};
 
-	inline ZoneProfiler() : GeneralProfiler(MaxZoneProfilerId) { }
+	static inline bool IsEnabled() { return(enabled); }
+	static void Enable(bool on);
+	static void Reset();
+	static void Record(uint32 id, int64 ticks);
+
+	static const char *GetName(uint32 id);
+	//MaxZoneProfilerId counters summed over every thread since the last reset
+	static void Snapshot(std::vector<ZoneProfileCounter> &out);
+	//seconds covered by the counters, only advancing while enabled
+	static double GetElapsed();
+	static double TicksPerUS();
+
+	//appends one snapshot to file, a JSON object per line or CSV rows
+	static bool WriteSnapshot(const char *file, bool csv);
 
+private:
+	static bool enabled;
 };
 
-extern ZoneProfiler _zp;
+class ZoneProfileScope {
+public:
+	inline ZoneProfileScope(uint32 _id) : id(_id), start(ZoneProfiler::IsEnabled() ? RDTSC_Timer::rdtsc() : 0) { }
+	inline ~ZoneProfileScope() {
+		if(start != 0)
+			ZoneProfiler::Record(id, RDTSC_Timer::rdtsc() - start);
+	}
+private:
+	uint32 id;
+	int64 start;
+};
 
-#define _ZP(name) _GP(_zp, ZoneProfiler, name)
-#else
-	//no zone profiling, dummy functions
-#define _ZP(name) ;
+#define _ZP(name) ZoneProfileScope __eqemu_zone_profiler(ZoneProfiler::name)
 
-#endif //ZONE_PROFILE
+//writes the counters to the debug log, sorted by total time
+extern void DumpZoneProfile();
+extern void ResetZoneProfile();
+//appends a snapshot to logs/zoneprofile_<zone>_<instance>_<port>.json or .csv,
+//in zone.cpp so the profiler itself doesn't need a Zone
+extern bool WriteZoneProfileSnapshot();
 
 #endif
-
@@ -980,309 +980,27 @@ bool ZoneDatabase::NoRentExpired(const char* name){
 	return false;
 }
 
-/* Searches npctable for matching id, and returns the item if found,
- * or nullptr otherwise. If id passed is 0, loads all npc_types for
- * the current zone, returning the last item added.
+/* Looks for id in this zone's npctable, filling it in from the shared npc_types
+ * table or, if that doesn't have it, from the database. Spawned npcs point at the
+ * npctable entry, so it stays put until the zone depops even if #reloadnpctype
+ * rewrites the shared one.
+ * Returns nullptr if there is no such npc type.
  */
 const NPCType* ZoneDatabase::GetNPCType (uint32 id) {
-	const NPCType *npc=nullptr;
 	std::map<uint32,NPCType *>::iterator itr;
 
 	// If NPC is already in tree, return it.
 	if((itr = zone->npctable.find(id)) != zone->npctable.end())
 		return itr->second;
 
-		// Otherwise, get NPCs from database.
-		char errbuf[MYSQL_ERRMSG_SIZE];
-		char *query = 0;
-		MYSQL_RES *result;
-		MYSQL_ROW row;
-
-
-		// If id is 0, load all npc_types for the current zone,
-		// according to spawn2.
-		const char *basic_query = "SELECT "
-			"npc_types.id,"
-			"npc_types.name,"
-			"npc_types.level,"
-			"npc_types.race,"
-			"npc_types.class,"
-			"npc_types.hp,"
-			"npc_types.mana,"
-			"npc_types.gender,"
-			"npc_types.texture,"
-			"npc_types.helmtexture,"
-			"npc_types.size,"
-			"npc_types.loottable_id,"
-			"npc_types.merchant_id,"
-			"npc_types.alt_currency_id,"
-			"npc_types.adventure_template_id,"
-			"npc_types.trap_template,"
-			"npc_types.attack_speed,"
-			"npc_types.STR,"
-			"npc_types.STA,"
-			"npc_types.DEX,"
-			"npc_types.AGI,"
-			"npc_types._INT,"
-			"npc_types.WIS,"
-			"npc_types.CHA,"
-			"npc_types.MR,"
-			"npc_types.CR,"
-			"npc_types.DR,"
-			"npc_types.FR,"
-			"npc_types.PR,"
-			"npc_types.Corrup,"
-			"npc_types.mindmg,"
-			"npc_types.maxdmg,"
-			"npc_types.attack_count,"
-			"npc_types.npcspecialattks,"
-			"npc_types.npc_spells_id,"
-			"npc_types.d_meele_texture1,"
-			"npc_types.d_meele_texture2,"
-			"npc_types.prim_melee_type,"
-			"npc_types.sec_melee_type,"
-			"npc_types.runspeed,"
-			"npc_types.findable,"
-			"npc_types.trackable,"
-			"npc_types.hp_regen_rate,"
-			"npc_types.mana_regen_rate,"
-			"npc_types.aggroradius,"
-			"npc_types.bodytype,"
-			"npc_types.npc_faction_id,"
-			"npc_types.face,"
-			"npc_types.luclin_hairstyle,"
-			"npc_types.luclin_haircolor,"
-			"npc_types.luclin_eyecolor,"
-			"npc_types.luclin_eyecolor2,"
-			"npc_types.luclin_beardcolor,"
-			"npc_types.luclin_beard,"
-			"npc_types.drakkin_heritage,"
-			"npc_types.drakkin_tattoo,"
-			"npc_types.drakkin_details,"
-			"npc_types.armortint_id,"
-			"npc_types.armortint_red,"
-			"npc_types.armortint_green,"
-			"npc_types.armortint_blue,"
-			"npc_types.see_invis,"
-			"npc_types.see_invis_undead,"
-			"npc_types.lastname,"
-			"npc_types.qglobal,"
-			"npc_types.AC,"
-			"npc_types.npc_aggro,"
-			"npc_types.spawn_limit,"
-			"npc_types.see_hide,"
-			"npc_types.see_improved_hide,"
-			"npc_types.ATK,"
-			"npc_types.Accuracy,"
-			"npc_types.slow_mitigation,"
-			"npc_types.maxlevel,"
-			"npc_types.scalerate,"
-			"npc_types.private_corpse,"
-			"npc_types.unique_spawn_by_name,"
-			"npc_types.underwater,"
-			"npc_types.emoteid,"
-			"npc_types.spellscale,"
-			"npc_types.healscale";
-
-		MakeAnyLenString(&query, "%s FROM npc_types WHERE id=%d", basic_query, id);
-
-		if (RunQuery(query, strlen(query), errbuf, &result)) {
-			// Process each row returned.
-			while((row = mysql_fetch_row(result))) {
-				NPCType *tmpNPCType;
-				tmpNPCType = new NPCType;
-				memset (tmpNPCType, 0, sizeof *tmpNPCType);
-
-				int r = 0;
-				tmpNPCType->npc_id = atoi(row[r++]);
-
-				strn0cpy(tmpNPCType->name, row[r++], 50);
-
-				tmpNPCType->level = atoi(row[r++]);
-				tmpNPCType->race = atoi(row[r++]);
-				tmpNPCType->class_ = atoi(row[r++]);
-				tmpNPCType->max_hp = atoi(row[r++]);
-				tmpNPCType->cur_hp = tmpNPCType->max_hp;
-				tmpNPCType->Mana = atoi(row[r++]);
-				tmpNPCType->gender = atoi(row[r++]);
-				tmpNPCType->texture = atoi(row[r++]);
-				tmpNPCType->helmtexture = atoi(row[r++]);
-				tmpNPCType->size = atof(row[r++]);
-				tmpNPCType->loottable_id = atoi(row[r++]);
-				tmpNPCType->merchanttype = atoi(row[r++]);
-				tmpNPCType->alt_currency_type = atoi(row[r++]);
-				tmpNPCType->adventure_template = atoi(row[r++]);
-				tmpNPCType->trap_template = atoi(row[r++]);
-				tmpNPCType->attack_speed = atof(row[r++]);
-				tmpNPCType->STR = atoi(row[r++]);
-				tmpNPCType->STA = atoi(row[r++]);
-				tmpNPCType->DEX = atoi(row[r++]);
-				tmpNPCType->AGI = atoi(row[r++]);
-				tmpNPCType->INT = atoi(row[r++]);
-				tmpNPCType->WIS = atoi(row[r++]);
-				tmpNPCType->CHA = atoi(row[r++]);
-				tmpNPCType->MR = atoi(row[r++]);
-				tmpNPCType->CR = atoi(row[r++]);
-				tmpNPCType->DR = atoi(row[r++]);
-				tmpNPCType->FR = atoi(row[r++]);
-				tmpNPCType->PR = atoi(row[r++]);
-				tmpNPCType->Corrup = atoi(row[r++]);
-				tmpNPCType->min_dmg = atoi(row[r++]);
-				tmpNPCType->max_dmg = atoi(row[r++]);
-				tmpNPCType->attack_count = atoi(row[r++]);
-				strcpy(tmpNPCType->npc_attacks,row[r++]);
-				tmpNPCType->npc_spells_id = atoi(row[r++]);
-				tmpNPCType->d_meele_texture1 = atoi(row[r++]);
-				tmpNPCType->d_meele_texture2 = atoi(row[r++]);
-				tmpNPCType->prim_melee_type = atoi(row[r++]);
-				tmpNPCType->sec_melee_type = atoi(row[r++]);
-				tmpNPCType->runspeed= atof(row[r++]);
-				tmpNPCType->findable = atoi(row[r++]) == 0? false : true;
-				tmpNPCType->trackable = atoi(row[r++]) == 0? false : true;
-				tmpNPCType->hp_regen = atoi(row[r++]);
-				tmpNPCType->mana_regen = atoi(row[r++]);
-
-				tmpNPCType->aggroradius = (int32)atoi(row[r++]);
-				// set defaultvalue for aggroradius
-				if (tmpNPCType->aggroradius <= 0)
-					tmpNPCType->aggroradius = 70;
-
-				if (row[r] && strlen(row[r]))
-					tmpNPCType->bodytype = (uint8)atoi(row[r]);
-				else
-					tmpNPCType->bodytype = 0;
-				r++;
-
-				tmpNPCType->npc_faction_id = atoi(row[r++]);
-
-				tmpNPCType->luclinface = atoi(row[r++]);
-				tmpNPCType->hairstyle = atoi(row[r++]);
-				tmpNPCType->haircolor = atoi(row[r++]);
-				tmpNPCType->eyecolor1 = atoi(row[r++]);
-				tmpNPCType->eyecolor2 = atoi(row[r++]);
-				tmpNPCType->beardcolor = atoi(row[r++]);
-				tmpNPCType->beard = atoi(row[r++]);
-				tmpNPCType->drakkin_heritage = atoi(row[r++]);
-				tmpNPCType->drakkin_tattoo = atoi(row[r++]);
-				tmpNPCType->drakkin_details = atoi(row[r++]);
-				uint32 armor_tint_id = atoi(row[r++]);
-				tmpNPCType->armor_tint[0] = (atoi(row[r++]) & 0xFF) << 16;
-				tmpNPCType->armor_tint[0] |= (atoi(row[r++]) & 0xFF) << 8;
-				tmpNPCType->armor_tint[0] |= (atoi(row[r++]) & 0xFF);
-				tmpNPCType->armor_tint[0] |= (tmpNPCType->armor_tint[0]) ? (0xFF << 24) : 0;
-
-				int i;
-				if (armor_tint_id > 0)
-				{
-					if (tmpNPCType->armor_tint[0] == 0)
-					{
-						char at_errbuf[MYSQL_ERRMSG_SIZE];
-						char *at_query = nullptr;
-						MYSQL_RES *at_result = nullptr;
-						MYSQL_ROW at_row;
-
-						MakeAnyLenString(&at_query,
-						"SELECT "
-						"red1h,grn1h,blu1h,"
-						"red2c,grn2c,blu2c,"
-						"red3a,grn3a,blu3a,"
-						"red4b,grn4b,blu4b,"
-						"red5g,grn5g,blu5g,"
-						"red6l,grn6l,blu6l,"
-						"red7f,grn7f,blu7f,"
-						"red8x,grn8x,blu8x,"
-						"red9x,grn9x,blu9x "
-						"FROM npc_types_tint WHERE id=%d", armor_tint_id);
-
-						if (RunQuery(at_query, strlen(at_query), at_errbuf, &at_result))
-						{
-							if ((at_row = mysql_fetch_row(at_result)))
-							{
-								for (i = 0; i < MAX_MATERIALS; i++)
-								{
-									tmpNPCType->armor_tint[i] = atoi(at_row[i * 3]) << 16;
-									tmpNPCType->armor_tint[i] |= atoi(at_row[i * 3 + 1]) << 8;
-									tmpNPCType->armor_tint[i] |= atoi(at_row[i * 3 + 2]);
-									tmpNPCType->armor_tint[i] |= (tmpNPCType->armor_tint[i]) ? (0xFF << 24) : 0;
-								}
-							}
-							else
-							{
-								armor_tint_id = 0;
-							}
-						}
-						else
-						{
-							armor_tint_id = 0;
-						}
-
-						if (at_result)
-						{
-							mysql_free_result(at_result);
-						}
-
-						safe_delete_array(at_query);
-					}
-					else
-					{
-						armor_tint_id = 0;
-					}
-				}
-
-				if (armor_tint_id == 0)
-				{
-					for (i = 1; i < MAX_MATERIALS; i++)
-					{
-						tmpNPCType->armor_tint[i] = tmpNPCType->armor_tint[0];
-					}
-				}
-
-				tmpNPCType->see_invis = atoi(row[r++]);
-				tmpNPCType->see_invis_undead = atoi(row[r++])==0?false:true;	// Set see_invis_undead flag
-				if (row[r] != nullptr)
-					strn0cpy(tmpNPCType->lastname, row[r], 32);
-				r++;
-
-				tmpNPCType->qglobal = atoi(row[r++])==0?false:true;	// qglobal
-				tmpNPCType->AC = atoi(row[r++]);
-				tmpNPCType->npc_aggro = atoi(row[r++])==0?false:true;
-				tmpNPCType->spawn_limit = atoi(row[r++]);
-				tmpNPCType->see_hide = atoi(row[r++])==0?false:true;
-				tmpNPCType->see_improved_hide = atoi(row[r++])==0?false:true;
-				tmpNPCType->ATK = atoi(row[r++]);
-				tmpNPCType->accuracy_rating = atoi(row[r++]);
-				tmpNPCType->slow_mitigation = atof(row[r++]);
-				tmpNPCType->maxlevel = atoi(row[r++]);
-				tmpNPCType->scalerate = atoi(row[r++]);
-				tmpNPCType->private_corpse = atoi(row[r++]) == 1 ? true : false;
-				tmpNPCType->unique_spawn_by_name = atoi(row[r++]) == 1 ? true : false;
-				tmpNPCType->underwater = atoi(row[r++]) == 1 ? true : false;
-				tmpNPCType->emoteid = atoi(row[r++]);
-				tmpNPCType->spellscale = atoi(row[r++]);
-				tmpNPCType->healscale = atoi(row[r++]);
-
-				// If NPC with duplicate NPC id already in table,
-				// free item we attempted to add.
-				if (zone->npctable.find(tmpNPCType->npc_id) != zone->npctable.end())
-				{
-					std::cerr << "Error loading duplicate NPC " << tmpNPCType->npc_id << std::endl;
-					delete tmpNPCType;
-					npc = nullptr;
-				} else {
-					zone->npctable[tmpNPCType->npc_id]=tmpNPCType;
-					npc = tmpNPCType;
-				}
-
-//				Sleep(0);
-			}
-
-			if (result) {
-				mysql_free_result(result);
-			}
-		} else
-			std::cerr << "Error loading NPCs from database. Bad query: " << errbuf << std::endl;
-		safe_delete_array(query);
-
+	// Otherwise copy it out of shared memory, or get it from the database if it's
+	// new since shared_memory ran or shared memory isn't loaded.
+	NPCType *npc = new NPCType;
+	if(!GetSharedNPCType(id, *npc) && !GetNPCTypeFromDB(id, *npc)) {
+		delete npc;
+		return nullptr;
+	}
+	zone->npctable[id] = npc;
 	return npc;
 }
 
@@ -3004,17 +2722,17 @@ bool ZoneDatabase::GetFactionData(FactionMods* fm, uint32 class_mod, uint32 race
 
 bool ZoneDatabase::LoadFactionValues(uint32 char_id, faction_map & val_list) {
 	char errbuf[MYSQL_ERRMSG_SIZE];
-	char *query = 0;
-	MYSQL_RES *result;
-	if (RunQuery(query, MakeAnyLenString(&query, "SELECT faction_id,current_value FROM faction_values WHERE char_id = %i",char_id), errbuf, &result)) {
-		safe_delete_array(query);
-		bool ret = LoadFactionValues_result(result, val_list);
-		mysql_free_result(result);
-		return ret;
+	const char *query = "SELECT faction_id,current_value FROM faction_values WHERE char_id = ?";
+	DBParams params;
+	DBResultSet result;
+	params.AddUInt(char_id);
+	if (RunPreparedQuery(query, strlen(query), params, result, errbuf)) {
+		for(uint32 row = 0; row < result.RowCount(); row++)
+			val_list[result.GetInt(row, 0)] = result.GetInt(row, 1);
+		return true;
 	}
 	else {
 		std::cerr << "Error in LoadFactionValues query '" << query << "' " << errbuf << std::endl;
-		safe_delete_array(query);
 	}
 	return false;
 }
@@ -178,6 +178,9 @@ public:
 	ZoneDatabase(const char* host, const char* user, const char* passwd, const char* database,uint32 port);
 	virtual ~ZoneDatabase();
 
+	// Queues the journaled inventory writes on dbasync, one work per character
+	virtual void FlushInventoryJournal(uint32 char_id = 0);
+
 	/*
 	* Objects and World Containers
 	*/
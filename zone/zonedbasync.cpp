@@ -7,6 +7,7 @@
 #include <stdlib.h>
 
 extern EntityList entity_list;
+extern DBAsync *dbasync;
 
 void DispatchFinishedDBAsync(DBAsyncWork* dbaw) {
 	uint32_breakdown workpt;
@@ -125,3 +126,41 @@ bool DBAsyncCB_CharacterBackup(DBAsyncWork* iWork) { // return true means delete
 	}
 	return true;
 }
+
+void ZoneDatabase::FlushInventoryJournal(uint32 char_id) {
+	if (!dbasync) {
+		SharedDatabase::FlushInventoryJournal(char_id);
+		return;
+	}
+	std::vector<InventoryJournalBatch> batches;
+	GetInventoryJournal().Take(char_id, batches);
+	for (size_t b = 0; b < batches.size(); b++) {
+		// WPT is the character, so the callback knows whose batch finished
+		DBAsyncWork* dbaw = new DBAsyncWork(this, &DBAsyncCB_InventoryJournal, batches[b].char_id, DBAsync::Write);
+		for (size_t q = 0; q < batches[b].statements.size(); q++) {
+			const std::string& sql = batches[b].statements[q];
+			char* query = strn0cpy(new char[sql.length() + 1], sql.c_str(), sql.length() + 1);
+			dbaw->AddQuery(q, &query, sql.length(), false);
+		}
+		dbasync->AddWork(&dbaw, 0, batches[b].char_id);
+	}
+}
+
+bool DBAsyncCB_InventoryJournal(DBAsyncWork* iWork) { // return true means delete data
+	char errbuf[MYSQL_ERRMSG_SIZE];
+	uint32 errors = 0;
+	bool failed = false;
+	DBAsyncQuery* dbaq;
+	while ((dbaq = iWork->PopAnswer())) {
+		if (!failed && !dbaq->GetAnswer(errbuf)) {
+			LogFile->write(EQEMuLog::Error, "Journaled inventory write for character %u failed: %s", iWork->WPT(), errbuf);
+			// QPT is the statement's place in the batch. This runs on the worker
+			// while it still holds the character's key, so no later batch can pass
+			// the rows we write again here.
+			errors = database.RunInventoryFallback(iWork->WPT(), dbaq->QPT());
+			failed = true;
+		}
+	}
+	database.GetInventoryJournal().Completed(iWork->WPT(), errors);
+	return true;
+}
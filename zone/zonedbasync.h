@@ -4,6 +4,7 @@
 #include "../common/dbasync.h"
 void DispatchFinishedDBAsync(DBAsyncWork* iDBAW);
 bool DBAsyncCB_CharacterBackup(DBAsyncWork* iWork);
+bool DBAsyncCB_InventoryJournal(DBAsyncWork* iWork);
 
 #define DBA_b4_Main			1
 #define DBA_b4_Worldserver	2
@@ -620,6 +620,7 @@ void Client::ZonePC(uint32 zoneID, uint32 instance_id, float x, float y, float z
 			if(zoneID == this->GetZoneID()) {
 				//properly handle proximities
 				entity_list.ProcessMove(this, x_pos, y_pos, z_pos);
+				entity_list.UpdateGrids(this);
 				proximity_x = x_pos;
 				proximity_y = y_pos;
 				proximity_z = z_pos;